@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisColorSpaceConversionBenchmark.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_paint_layer.h"
+#include "kis_group_layer.h"
+
+namespace {
+
+const int imageSize = 4096;
+const int numLayers = 8;
+
+KisImageSP createImage(int numThreads)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "conversion benchmark");
+
+    /**
+     * Limit the threads of this very image only, the user's
+     * config must not be touched by the benchmark
+     */
+    image->setWorkingThreadsLimit(numThreads);
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(image->bounds(), KoColor(QColor(255 * i / numLayers, 128, 64, 128), cs));
+        image->addNode(layer, image->rootLayer());
+    }
+
+    image->refreshGraphAsync();
+    image->waitForDone();
+
+    return image;
+}
+
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertImage_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+        QTest::newRow(QString("threads-%1").arg(numThreads).toLatin1()) << numThreads;
+    }
+}
+
+void KisColorSpaceConversionBenchmark::benchmarkConvertImage()
+{
+    QFETCH(int, numThreads);
+
+    KisImageSP image = createImage(numThreads);
+
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *rgb16 = KoColorSpaceRegistry::instance()->rgb16();
+
+    QBENCHMARK {
+        image->convertImageColorSpace(rgb16,
+                                      KoColorConversionTransformation::internalRenderingIntent(),
+                                      KoColorConversionTransformation::internalConversionFlags());
+        image->waitForDone();
+
+        image->convertImageColorSpace(rgb8,
+                                      KoColorConversionTransformation::internalRenderingIntent(),
+                                      KoColorConversionTransformation::internalConversionFlags());
+        image->waitForDone();
+    }
+}
+
+QTEST_MAIN(KisColorSpaceConversionBenchmark)
@@ -0,0 +1,210 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisKraSaveBenchmark.h"
+
+#include <QTest>
+#include <QBuffer>
+#include <QThreadPool>
+#include <QTemporaryFile>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoStore.h>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_paint_layer.h"
+#include "kis_group_layer.h"
+#include "kis_store_paintdevice_writer.h"
+
+namespace {
+
+const int imageSize = 2048;
+const int numLayers = 16;
+
+KisImageSP createImage()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "save benchmark");
+
+    QVector<quint8> pixels(imageSize * imageSize * cs->pixelSize());
+    quint32 seed = 1;
+
+    for (int i = 0; i < numLayers; i++) {
+        /**
+         * Smooth gradients with some noise on top, so that the tiles
+         * are neither uniform nor completely incompressible
+         */
+        for (int y = 0; y < imageSize; y++) {
+            quint8 *pixel = pixels.data() + y * imageSize * cs->pixelSize();
+            for (int x = 0; x < imageSize; x++) {
+                seed = seed * 1103515245 + 12345;
+                const quint8 noise = (seed >> 16) & 0x7;
+
+                pixel[0] = quint8(x + i * 16) ^ noise;
+                pixel[1] = quint8(y + i * 8) ^ noise;
+                pixel[2] = quint8((x + y) / 2);
+                pixel[3] = 255;
+                pixel += cs->pixelSize();
+            }
+        }
+
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->writeBytes(pixels.data(), image->bounds());
+        image->addNode(layer, image->rootLayer());
+    }
+
+    return image;
+}
+
+enum ContainerMode {
+    Deflated,
+    DeflatedLevelZero,
+    Stored
+};
+
+void saveLayers(KisImageSP image, KoStore *store, ContainerMode mode)
+{
+    store->setStoredEntriesEnabled(mode == Stored);
+
+    // the tile data is already compressed, the same as in KisKraSaveVisitor
+    store->setCompressionEnabled(mode == Deflated);
+
+    KisStorePaintDeviceWriter writer(store);
+
+    KisNodeSP node = image->rootLayer()->firstChild();
+    int layerIndex = 0;
+
+    while (node) {
+        QVERIFY(store->open(QString("layers/layer%1").arg(layerIndex++)));
+        QVERIFY(node->paintDevice()->write(writer));
+        QVERIFY(store->close());
+
+        node = node->nextSibling();
+    }
+
+    QVERIFY(store->finalize());
+}
+
+void addContainerRows()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("deflated") << int(Deflated);
+    QTest::newRow("deflated-level-0") << int(DeflatedLevelZero);
+    QTest::newRow("stored") << int(Stored);
+}
+
+}
+
+void KisKraSaveBenchmark::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+void KisKraSaveBenchmark::benchmarkSavePaintDevices_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+        QTest::newRow(QString("threads-%1").arg(numThreads).toLatin1()) << numThreads;
+    }
+}
+
+void KisKraSaveBenchmark::benchmarkSavePaintDevices()
+{
+    QFETCH(int, numThreads);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+    KisImageSP image = createImage();
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        QScopedPointer<KoStore> store(
+            KoStore::createStore(&buffer, KoStore::Write, "application/x-krita", KoStore::Zip));
+
+        saveLayers(image, store.data(), DeflatedLevelZero);
+    }
+}
+
+void KisKraSaveBenchmark::benchmarkSaveContainer_data()
+{
+    addContainerRows();
+}
+
+void KisKraSaveBenchmark::benchmarkSaveContainer()
+{
+    QFETCH(int, mode);
+
+    KisImageSP image = createImage();
+
+    QBENCHMARK {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+
+        QScopedPointer<KoStore> store(
+            KoStore::createStore(&file, KoStore::Write, "application/x-krita", KoStore::Zip));
+
+        saveLayers(image, store.data(), ContainerMode(mode));
+    }
+}
+
+void KisKraSaveBenchmark::benchmarkLoadContainer_data()
+{
+    addContainerRows();
+}
+
+void KisKraSaveBenchmark::benchmarkLoadContainer()
+{
+    QFETCH(int, mode);
+
+    KisImageSP image = createImage();
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    {
+        QScopedPointer<KoStore> store(
+            KoStore::createStore(&file, KoStore::Write, "application/x-krita", KoStore::Zip));
+
+        saveLayers(image, store.data(), ContainerMode(mode));
+    }
+
+    file.close();
+
+    QBENCHMARK {
+        QScopedPointer<KoStore> store(
+            KoStore::createStore(file.fileName(), KoStore::Read, "", KoStore::Zip));
+        QVERIFY(!store->bad());
+
+        for (int i = 0; i < numLayers; i++) {
+            KisPaintDeviceSP dev = new KisPaintDevice(image->colorSpace());
+
+            QVERIFY(store->open(QString("layers/layer%1").arg(i)));
+            QVERIFY(dev->read(store->device()));
+            QVERIFY(store->close());
+        }
+    }
+}
+
+QTEST_MAIN(KisKraSaveBenchmark)
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KISKRASAVEBENCHMARK_H
+#define KISKRASAVEBENCHMARK_H
+
+#include <QtTest>
+
+/**
+ * Measures how serialization of the layers' pixel data into
+ * a .kra store scales with the number of threads, and how
+ * the container format affects save and load times
+ */
+class KisKraSaveBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cleanupTestCase();
+
+    void benchmarkSavePaintDevices_data();
+    void benchmarkSavePaintDevices();
+
+    void benchmarkSaveContainer_data();
+    void benchmarkSaveContainer();
+
+    void benchmarkLoadContainer_data();
+    void benchmarkLoadContainer();
+};
+
+#endif // KISKRASAVEBENCHMARK_H
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisUpdateSchedulerBenchmark.h"
+
+#include <atomic>
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_image.h"
+#include "kis_image_config.h"
+#include "kis_paint_device.h"
+#include "kis_paint_layer.h"
+#include "kis_group_layer.h"
+#include "kis_simple_stroke_strategy.h"
+
+namespace {
+
+const int imageSize = 4096;
+const int numLayers = 8;
+const int numStrokeJobs = 4096;
+
+/**
+ * Emulates a stroke producing lots of small concurrent
+ * jobs, like a brush with multithreaded dab rendering
+ */
+class ComputeStrokeStrategy : public KisSimpleStrokeStrategy
+{
+public:
+    ComputeStrokeStrategy()
+        : KisSimpleStrokeStrategy(QLatin1String("compute-stroke-benchmark"))
+    {
+        enableJob(JOB_DOSTROKE, true, KisStrokeJobData::CONCURRENT);
+    }
+
+    void doStrokeCallback(KisStrokeJobData *data) override {
+        Q_UNUSED(data);
+
+        quint32 value = 0;
+        for (int i = 0; i < 20000; i++) {
+            value = value * 1664525 + 1013904223;
+        }
+
+        m_sink.store(value, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<quint32> m_sink {0};
+};
+
+KisImageSP createImage(int numThreads, bool useWorkStealing)
+{
+    {
+        KisImageConfig cfg(false);
+        cfg.setMaxNumberOfThreads(numThreads);
+        cfg.setUseWorkStealingScheduler(useWorkStealing);
+    }
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageSize, imageSize, cs, "scheduler benchmark");
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(image->bounds(), KoColor(QColor(255 * i / numLayers, 128, 64, 128), cs));
+        image->addNode(layer, image->rootLayer());
+    }
+
+    image->refreshGraphAsync();
+    image->waitForDone();
+
+    return image;
+}
+
+}
+
+void KisUpdateSchedulerBenchmark::populateThreadsData()
+{
+    QTest::addColumn<int>("numThreads");
+    QTest::addColumn<bool>("useWorkStealing");
+
+    for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+        QTest::newRow(QString("pool-%1").arg(numThreads).toLatin1()) << numThreads << false;
+        QTest::newRow(QString("stealing-%1").arg(numThreads).toLatin1()) << numThreads << true;
+    }
+}
+
+void KisUpdateSchedulerBenchmark::cleanupTestCase()
+{
+    KisImageConfig cfg(false);
+    cfg.setMaxNumberOfThreads(cfg.maxNumberOfThreads(true));
+    cfg.setUseWorkStealingScheduler(cfg.useWorkStealingScheduler(true));
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkMergeJobs_data()
+{
+    populateThreadsData();
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkMergeJobs()
+{
+    QFETCH(int, numThreads);
+    QFETCH(bool, useWorkStealing);
+
+    KisImageSP image = createImage(numThreads, useWorkStealing);
+
+    QBENCHMARK {
+        image->refreshGraphAsync();
+        image->waitForDone();
+    }
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkStrokeJobs_data()
+{
+    populateThreadsData();
+}
+
+void KisUpdateSchedulerBenchmark::benchmarkStrokeJobs()
+{
+    QFETCH(int, numThreads);
+    QFETCH(bool, useWorkStealing);
+
+    KisImageSP image = createImage(numThreads, useWorkStealing);
+
+    QBENCHMARK {
+        KisStrokeId id = image->startStroke(new ComputeStrokeStrategy());
+
+        for (int i = 0; i < numStrokeJobs; i++) {
+            image->addJob(id, new KisStrokeJobData(KisStrokeJobData::CONCURRENT));
+        }
+
+        image->endStroke(id);
+        image->waitForDone();
+    }
+}
+
+QTEST_MAIN(KisUpdateSchedulerBenchmark)
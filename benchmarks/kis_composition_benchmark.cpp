@@ -48,6 +48,9 @@
 #include <KoColorSpaceTraits.h>
 #include <KoCompositeOpAlphaDarken.h>
 #include <KoCompositeOpOver.h>
+#include <KoCompositeOpCopy2.h>
+#include <KoCompositeOpGeneric.h>
+#include <KoCompositeOpRegistry.h>
 #include <KoOptimizedCompositeOpFactory.h>
 #include <KoAlphaDarkenParamsWrapper.h>
 
@@ -127,6 +130,27 @@ struct RandomGenerator<quint8>
     boost::mt11213b m_rnd;
 };
 
+template <>
+struct RandomGenerator<quint16>
+{
+    RandomGenerator(int seed)
+        : m_smallint(0,65535),
+          m_rnd(seed)
+    {
+    }
+
+    quint16 operator() () {
+        return m_smallint(m_rnd);
+    }
+
+    quint16 unit() {
+        return KoColorSpaceMathsTraits<quint16>::unitValue;
+    }
+
+    boost::uniform_smallint<int> m_smallint;
+    boost::mt11213b m_rnd;
+};
+
 template <>
 struct RandomGenerator<float>
 {
@@ -255,6 +279,8 @@ QVector<Tile> generateTiles(int size,
 
         if (pixelSize == 4) {
             generateDataLine<quint8>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
+        } else if (pixelSize == 8) {
+            generateDataLine<quint16>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else if (pixelSize == 16) {
             generateDataLine<float>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else {
@@ -281,6 +307,13 @@ inline bool fuzzyCompare(channel_type a, channel_type b, channel_type prec) {
     return qAbs(a - b) <= prec;
 }
 
+template <>
+inline bool fuzzyCompare(float a, float b, float prec) {
+    // some blend modes (e.g. Color Dodge) can produce huge values
+    // in floating point colorspaces, so compare them relatively
+    return qAbs(a - b) <= prec * qMax(1.0f, qAbs(b));
+}
+
 template <typename channel_type>
 inline bool comparePixels(channel_type *p1, channel_type *p2, channel_type prec) {
     return (p1[3] == p2[3] && p1[3] == 0) ||
@@ -322,7 +355,7 @@ bool compareTwoOpsPixels(QVector<Tile> &tiles, channel_type prec) {
     return true;
 }
 
-bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2)
+bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2, float floatPrecision = 2e-7)
 {
     Q_ASSERT(op1->colorSpace()->pixelSize() == op2->colorSpace()->pixelSize());
     const quint32 pixelSize = op1->colorSpace()->pixelSize();
@@ -354,8 +387,12 @@ bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp
     if (pixelSize == 4) {
         compareResult = compareTwoOpsPixels<quint8>(tiles, 10);
     }
+    else if (pixelSize == 8) {
+        // the optimized ops calculate in floats, the legacy ones in integers
+        compareResult = compareTwoOpsPixels<quint16>(tiles, 10 * 257);
+    }
     else if (pixelSize == 16) {
-        compareResult = compareTwoOpsPixels<float>(tiles, 2e-7);
+        compareResult = compareTwoOpsPixels<float>(tiles, floatPrecision);
     }
     else {
         qFatal("Pixel size %i is not implemented", pixelSize);
@@ -710,6 +747,49 @@ void KisCompositionBenchmark::compareRgbF32OverOps()
     delete opAct;
 }
 
+void KisCompositionBenchmark::compareRgbU16Ops_data()
+{
+    QTest::addColumn<QString>("compositeOpId");
+    QTest::addColumn<bool>("haveMask");
+
+    QStringList ids;
+    ids << COMPOSITE_OVER << "alphadarken-hard" << "alphadarken-creamy" << COMPOSITE_COPY;
+
+    Q_FOREACH (const QString &id, ids) {
+        QTest::newRow(QString("%1-mask").arg(id).toLatin1().data()) << id << true;
+        QTest::newRow(QString("%1-nomask").arg(id).toLatin1().data()) << id << false;
+    }
+}
+
+void KisCompositionBenchmark::compareRgbU16Ops()
+{
+    QFETCH(QString, compositeOpId);
+    QFETCH(bool, haveMask);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *opAct = 0;
+    KoCompositeOp *opExp = 0;
+
+    if (compositeOpId == COMPOSITE_OVER) {
+        opAct = KoOptimizedCompositeOpFactory::createOverOpU16(cs);
+        opExp = new KoCompositeOpOver<KoBgrU16Traits>(cs);
+    } else if (compositeOpId == "alphadarken-hard") {
+        opAct = KoOptimizedCompositeOpFactory::createAlphaDarkenOpHardU16(cs);
+        opExp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>(cs);
+    } else if (compositeOpId == "alphadarken-creamy") {
+        opAct = KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamyU16(cs);
+        opExp = new KoCompositeOpAlphaDarken<KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>(cs);
+    } else {
+        opAct = KoOptimizedCompositeOpFactory::createCopyOpU16(cs);
+        opExp = new KoCompositeOpCopy2<KoBgrU16Traits>(cs);
+    }
+
+    QVERIFY(compareTwoOps(haveMask, opAct, opExp));
+
+    delete opExp;
+    delete opAct;
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenLegacy()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -795,6 +875,172 @@ void KisCompositionBenchmark::testRgb8CompositeCopyLegacy()
     benchmarkCompositeOp(op, "Copy");
 }
 
+/**
+ * The composite ops that have a vectorized implementation
+ * in KoOptimizedCompositeOpFactory::createGenericOp32/128()
+ */
+QStringList optimizedGenericOpIds()
+{
+    return QStringList()
+        << COMPOSITE_MULT << COMPOSITE_SCREEN << COMPOSITE_DARKEN
+        << COMPOSITE_LIGHTEN << COMPOSITE_DIFF << COMPOSITE_EQUIVALENCE
+        << COMPOSITE_EXCLUSION << COMPOSITE_HARD_LIGHT << COMPOSITE_OVERLAY
+        << COMPOSITE_SOFT_LIGHT_PHOTOSHOP << COMPOSITE_SOFT_LIGHT_SVG
+        << COMPOSITE_DODGE << COMPOSITE_BURN << COMPOSITE_ADD
+        << COMPOSITE_LINEAR_DODGE << COMPOSITE_LINEAR_BURN
+        << COMPOSITE_SUBTRACT << COMPOSITE_INVERSE_SUBTRACT
+        << COMPOSITE_DIVIDE << COMPOSITE_LINEAR_LIGHT << COMPOSITE_PIN_LIGHT
+        << COMPOSITE_GRAIN_MERGE << COMPOSITE_GRAIN_EXTRACT
+        << COMPOSITE_ALLANON << COMPOSITE_GEOMETRIC_MEAN
+        << COMPOSITE_COLOR << COMPOSITE_HUE << COMPOSITE_SATURATION
+        << COMPOSITE_LUMINIZE << COMPOSITE_INC_LUMINOSITY
+        << COMPOSITE_DEC_LUMINOSITY;
+}
+
+template<class Traits>
+KoCompositeOp* createLegacyGenericOp(const KoColorSpace *cs, const QString &id)
+{
+    typedef typename Traits::channels_type T;
+
+#define LEGACY_SC_OP(compositeId, func) \
+    if (id == compositeId) return new KoCompositeOpGenericSC<Traits, &func<T>>(cs, id, id, KoCompositeOp::categoryMisc());
+#define LEGACY_HSL_OP(compositeId, func) \
+    if (id == compositeId) return new KoCompositeOpGenericHSL<Traits, &func<HSYType, float>>(cs, id, id, KoCompositeOp::categoryMisc());
+
+    LEGACY_SC_OP(COMPOSITE_MULT, cfMultiply);
+    LEGACY_SC_OP(COMPOSITE_SCREEN, cfScreen);
+    LEGACY_SC_OP(COMPOSITE_DARKEN, cfDarkenOnly);
+    LEGACY_SC_OP(COMPOSITE_LIGHTEN, cfLightenOnly);
+    LEGACY_SC_OP(COMPOSITE_DIFF, cfDifference);
+    LEGACY_SC_OP(COMPOSITE_EQUIVALENCE, cfEquivalence);
+    LEGACY_SC_OP(COMPOSITE_EXCLUSION, cfExclusion);
+    LEGACY_SC_OP(COMPOSITE_HARD_LIGHT, cfHardLight);
+    LEGACY_SC_OP(COMPOSITE_OVERLAY, cfOverlay);
+    LEGACY_SC_OP(COMPOSITE_SOFT_LIGHT_PHOTOSHOP, cfSoftLight);
+    LEGACY_SC_OP(COMPOSITE_SOFT_LIGHT_SVG, cfSoftLightSvg);
+    LEGACY_SC_OP(COMPOSITE_DODGE, cfColorDodge);
+    LEGACY_SC_OP(COMPOSITE_BURN, cfColorBurn);
+    LEGACY_SC_OP(COMPOSITE_ADD, cfAddition);
+    LEGACY_SC_OP(COMPOSITE_LINEAR_DODGE, cfAddition);
+    LEGACY_SC_OP(COMPOSITE_LINEAR_BURN, cfLinearBurn);
+    LEGACY_SC_OP(COMPOSITE_SUBTRACT, cfSubtract);
+    LEGACY_SC_OP(COMPOSITE_INVERSE_SUBTRACT, cfInverseSubtract);
+    LEGACY_SC_OP(COMPOSITE_DIVIDE, cfDivide);
+    LEGACY_SC_OP(COMPOSITE_LINEAR_LIGHT, cfLinearLight);
+    LEGACY_SC_OP(COMPOSITE_PIN_LIGHT, cfPinLight);
+    LEGACY_SC_OP(COMPOSITE_GRAIN_MERGE, cfGrainMerge);
+    LEGACY_SC_OP(COMPOSITE_GRAIN_EXTRACT, cfGrainExtract);
+    LEGACY_SC_OP(COMPOSITE_ALLANON, cfAllanon);
+    LEGACY_SC_OP(COMPOSITE_GEOMETRIC_MEAN, cfGeometricMean);
+
+    LEGACY_HSL_OP(COMPOSITE_COLOR, cfColor);
+    LEGACY_HSL_OP(COMPOSITE_HUE, cfHue);
+    LEGACY_HSL_OP(COMPOSITE_SATURATION, cfSaturation);
+    LEGACY_HSL_OP(COMPOSITE_LUMINIZE, cfLightness);
+    LEGACY_HSL_OP(COMPOSITE_INC_LUMINOSITY, cfIncreaseLightness);
+    LEGACY_HSL_OP(COMPOSITE_DEC_LUMINOSITY, cfDecreaseLightness);
+
+#undef LEGACY_SC_OP
+#undef LEGACY_HSL_OP
+
+    qFatal("Unknown generic composite op: %s", qPrintable(id));
+    return 0;
+}
+
+void KisCompositionBenchmark::compareGenericOps_data()
+{
+    QTest::addColumn<QString>("id");
+
+    Q_FOREACH (const QString &id, optimizedGenericOpIds()) {
+        QTest::newRow(id.toLatin1().data()) << id;
+    }
+}
+
+void KisCompositionBenchmark::compareGenericOps()
+{
+#ifdef HAVE_VC
+    QFETCH(QString, id);
+
+    {
+        const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+        KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createGenericOp32(cs, id, id, KoCompositeOp::categoryMisc());
+        KoCompositeOp *opExp = createLegacyGenericOp<KoBgrU8Traits>(cs, id);
+
+        QVERIFY(opAct);
+        QVERIFY(compareTwoOps(true, opAct, opExp));
+        QVERIFY(compareTwoOps(false, opAct, opExp));
+
+        delete opExp;
+        delete opAct;
+    }
+
+    {
+        const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+        KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createGenericOp128(cs, id, id, KoCompositeOp::categoryMisc());
+        KoCompositeOp *opExp = createLegacyGenericOp<KoRgbF32Traits>(cs, id);
+
+        QVERIFY(opAct);
+        QVERIFY(compareTwoOps(true, opAct, opExp, 1e-5));
+        QVERIFY(compareTwoOps(false, opAct, opExp, 1e-5));
+
+        delete opExp;
+        delete opAct;
+    }
+#endif
+}
+
+void KisCompositionBenchmark::testRgb8CompositeGenericOps_data()
+{
+    compareGenericOps_data();
+}
+
+void KisCompositionBenchmark::testRgb8CompositeGenericOps()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KoCompositeOp *opLegacy = createLegacyGenericOp<KoBgrU8Traits>(cs, id);
+    KoCompositeOp *opOptimized = KoOptimizedCompositeOpFactory::createGenericOp32(cs, id, id, KoCompositeOp::categoryMisc());
+
+    Q_FOREACH (KoCompositeOp *op, QList<KoCompositeOp*>() << opLegacy << opOptimized) {
+        if (!op) continue;
+
+        qDebug() << "Testing Composite Op:" << op->id() << "(" << (op == opLegacy ? "Legacy" : "Optimized") << ")";
+        benchmarkCompositeOp(op, true, 0.5, 0.3, 0, 0, ALPHA_RANDOM, ALPHA_RANDOM);
+        benchmarkCompositeOp(op, false, 1.0, 1.0, 0, 0, ALPHA_RANDOM, ALPHA_UNIT);
+    }
+
+    delete opLegacy;
+    delete opOptimized;
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeGenericOps_data()
+{
+    compareGenericOps_data();
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeGenericOps()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+
+    KoCompositeOp *opLegacy = createLegacyGenericOp<KoRgbF32Traits>(cs, id);
+    KoCompositeOp *opOptimized = KoOptimizedCompositeOpFactory::createGenericOp128(cs, id, id, KoCompositeOp::categoryMisc());
+
+    Q_FOREACH (KoCompositeOp *op, QList<KoCompositeOp*>() << opLegacy << opOptimized) {
+        if (!op) continue;
+
+        qDebug() << "Testing Composite Op:" << op->id() << "(" << (op == opLegacy ? "RGBF32 Legacy" : "RGBF32 Optimized") << ")";
+        benchmarkCompositeOp(op, true, 0.5, 0.3, 0, 0, ALPHA_RANDOM, ALPHA_RANDOM);
+        benchmarkCompositeOp(op, false, 1.0, 1.0, 0, 0, ALPHA_RANDOM, ALPHA_UNIT);
+    }
+
+    delete opLegacy;
+    delete opOptimized;
+}
+
 void KisCompositionBenchmark::benchmarkMemcpy()
 {
     QVector<Tile> tiles =
@@ -46,6 +46,9 @@ private Q_SLOTS:
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
 
+    void compareRgbU16Ops_data();
+    void compareRgbU16Ops();
+
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
 
@@ -63,6 +66,15 @@ private Q_SLOTS:
 
     void testRgb8CompositeCopyLegacy();
 
+    void compareGenericOps_data();
+    void compareGenericOps();
+
+    void testRgb8CompositeGenericOps_data();
+    void testRgb8CompositeGenericOps();
+
+    void testRgbF32CompositeGenericOps_data();
+    void testRgbF32CompositeGenericOps();
+
     void benchmarkMemcpy();
 
     void benchmarkUintFloat();
@@ -22,6 +22,8 @@
 #include <QTest>
 #include <kis_datamanager.h>
 
+#include "tiles3/kis_tile_data_store.h"
+
 // RGBA
 #define PIXEL_SIZE 4
 //#define CYCLES 100
@@ -198,5 +200,69 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+static void reportTilesMemory(const QString &title)
+{
+    KisTileDataStore::MemoryStatistics stats =
+        KisTileDataStore::instance()->memoryStatistics();
+
+    qDebug() << title;
+    qDebug() << "    tiles memory:" << stats.totalMemorySize / 1024 << "KiB";
+    qDebug() << "    uniform tiles:" << stats.numUniformTiles
+             << "saved:" << stats.uniformTilesSize / 1024 << "KiB";
+}
+
+void KisDatamanagerBenchmark::benchmarkUniformFill()
+{
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    // a non-default color, so the tiles cannot be just dropped
+    quint8 *fillPixel = new quint8[PIXEL_SIZE];
+    memset(fillPixel, 128, PIXEL_SIZE);
+
+    QBENCHMARK {
+        dm.clear(0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, fillPixel);
+    }
+
+    reportTilesMemory("After filling with a uniform color:");
+
+    quint8 *bytes = new quint8[PIXEL_SIZE * TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT];
+    dm.readBytes(bytes, 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    reportTilesMemory("After reading the uniform tiles:");
+
+    delete[] bytes;
+    delete[] fillPixel;
+    delete[] p;
+}
+
+void KisDatamanagerBenchmark::benchmarkUniformTilesCompaction()
+{
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+
+    quint8 *bytes = new quint8[PIXEL_SIZE * TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT];
+    memset(bytes, 128, PIXEL_SIZE * TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT);
+
+    dm.writeBytes(bytes, 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    reportTilesMemory("Before compaction:");
+
+    QBENCHMARK_ONCE {
+        KisTileDataStore::instance()->testingCompactUniformTiles();
+    }
+
+    reportTilesMemory("After compaction:");
+
+    QBENCHMARK {
+        dm.readBytes(bytes, 0, 0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+    }
+
+    delete[] bytes;
+    delete[] p;
+}
+
 
 QTEST_MAIN(KisDatamanagerBenchmark)
@@ -38,7 +38,10 @@
 
 #include "KisGlobalResourcesInterface.h"
 
+#include "tiles3/kis_tile_data.h"
 #include "tiles3/kis_tile_data_store.h"
+#include "tiles3/swap/kis_swapped_data_store.h"
+#include "tiles3/swap/kis_swap_compression_factory.h"
 #include "kis_surrogate_undo_adapter.h"
 #include "kis_image_config.h"
 #define LOAD_PRESET_OR_RETURN(preset, fileName)                         \
@@ -230,4 +233,128 @@ void KisLowMemoryBenchmark::memory2000History100Pool500HugeBrush()
                       2000, 600, 500, 0);
 }
 
+/**
+ * Measures the throughput of the swapper for a particular compression
+ * backend. The tiles are taken from a canvas painted with a real brush,
+ * so the ratio is close to what the user will see in practice.
+ */
+void KisLowMemoryBenchmark::benchmarkSwapCompression(const QString &compression, int level)
+{
+    const KisSwapCompressionFactory::Type type =
+        KisSwapCompressionFactory::stringToType(compression);
+
+    if (!KisSwapCompressionFactory::isAvailable(type)) {
+        QSKIP("The compression backend is not available in this build");
+    }
+
+    QString presetFileName = "autobrush_300px.kpp";
+    KisPaintOpPresetSP preset(new KisPaintOpPreset(QString(FILES_DATA_DIR) + '/' + presetFileName));
+    LOAD_PRESET_OR_RETURN(preset, presetFileName);
+
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect imageRect(0, 0, 4096, 4096);
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), colorSpace, "swap sample image");
+    KisLayerSP layer = new KisPaintLayer(image, "swap sample layer", OPACITY_OPAQUE_U8, colorSpace);
+    image->addNode(layer, image->root());
+
+    KisPaintDeviceSP dev = layer->paintDevice();
+
+    {
+        KisPainter painter(dev);
+        painter.setPaintColor(KoColor(Qt::black, colorSpace));
+        painter.setPaintOpPreset(preset, layer, image);
+
+        KisDistanceInformation currentDistance;
+        for (int y = 150; y < imageRect.height(); y += 400) {
+            KisPaintInformation pi1(QPointF(150, y), 0.0);
+            KisPaintInformation pi2(QPointF(imageRect.width() - 150, y + 200), 1.0);
+            painter.paintLine(pi1, pi2, &currentDistance);
+        }
+    }
+
+    /**
+     * Copy the canvas into standalone tile data objects
+     */
+    const int pixelSize = colorSpace->pixelSize();
+    const int tileDataSize = KisTileData::WIDTH * KisTileData::HEIGHT * pixelSize;
+    const KoColor defaultPixel = dev->defaultPixel();
+
+    QVector<KisTileData*> tiles;
+    QVector<QByteArray> referenceData;
+
+    for (int y = 0; y < imageRect.height(); y += KisTileData::HEIGHT) {
+        for (int x = 0; x < imageRect.width(); x += KisTileData::WIDTH) {
+            KisTileData *td = new KisTileData(pixelSize, defaultPixel.data(), KisTileDataStore::instance());
+            dev->readBytes(td->data(), x, y, KisTileData::WIDTH, KisTileData::HEIGHT);
+
+            tiles << td;
+            referenceData << QByteArray((const char*)td->data(), tileDataSize);
+        }
+    }
+
+    KisImageConfig config(false);
+    const QString oldCompression = config.swapCompression();
+    const int oldLevel = config.swapCompressionLevel();
+    config.setSwapCompression(compression);
+    config.setSwapCompressionLevel(level);
+
+    qint64 swapOutTime = 0;
+    qint64 swapInTime = 0;
+    quint64 compressedSize = 0;
+
+    {
+        KisSwappedDataStore store;
+        QElapsedTimer timer;
+
+        timer.start();
+        Q_FOREACH (KisTileData *td, tiles) {
+            QVERIFY(store.trySwapOutTileData(td));
+        }
+        swapOutTime = timer.nsecsElapsed();
+
+        Q_FOREACH (KisTileData *td, tiles) {
+            compressedSize += td->swapChunk().size();
+        }
+
+        timer.restart();
+        Q_FOREACH (KisTileData *td, tiles) {
+            store.swapInTileData(td);
+        }
+        swapInTime = timer.nsecsElapsed();
+    }
+
+    config.setSwapCompression(oldCompression);
+    config.setSwapCompressionLevel(oldLevel);
+
+    for (int i = 0; i < tiles.size(); i++) {
+        QVERIFY(!memcmp(tiles[i]->data(), referenceData[i].constData(), tileDataSize));
+    }
+
+    qDeleteAll(tiles);
+
+    const qreal totalMiB = qreal(tiles.size()) * tileDataSize / MiB;
+
+    qDebug() << "Swap compression:" << compression << "level" << level;
+    qDebug() << "    swap-out:" << totalMiB / (swapOutTime / 1e9) << "MiB/s";
+    qDebug() << "    swap-in: " << totalMiB / (swapInTime / 1e9) << "MiB/s";
+    qDebug() << "    ratio:   " << qreal(compressedSize) / (tiles.size() * tileDataSize);
+}
+
+void KisLowMemoryBenchmark::benchmarkSwapCompressionLzf()
+{
+    benchmarkSwapCompression("lzf", 0);
+}
+
+void KisLowMemoryBenchmark::benchmarkSwapCompressionLz4()
+{
+    benchmarkSwapCompression("lz4", 0);
+}
+
+void KisLowMemoryBenchmark::benchmarkSwapCompressionZstd()
+{
+    for (int level = 1; level <= 9; level += 4) {
+        benchmarkSwapCompression("zstd", level);
+    }
+}
+
 QTEST_MAIN(KisLowMemoryBenchmark)
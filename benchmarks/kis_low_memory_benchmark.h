@@ -31,7 +31,13 @@ private Q_SLOTS:
 
     void memory2000History100Pool500HugeBrush();
 
+    void benchmarkSwapCompressionLzf();
+    void benchmarkSwapCompressionLz4();
+    void benchmarkSwapCompressionZstd();
+
 private:
+    void benchmarkSwapCompression(const QString &compression, int level);
+
     void benchmarkWideArea(const QString presetFileName,
                            const QRectF &rect, qreal vstep,
                            int numCycles,
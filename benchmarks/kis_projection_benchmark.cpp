@@ -27,6 +27,37 @@
 #include <KisDocument.h>
 #include <kis_image.h>
 #include <KisPart.h>
+#include <kis_datamanager.h>
+#include <kis_paint_layer.h>
+#include <kis_async_merger.h>
+#include <kis_full_refresh_walker.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoCompositeOpRegistry.h>
+
+namespace {
+
+KisImageSP createLayeredImage(const QRect &imageRect, int numLayers,
+                              const QString &compositeOpId, quint8 opacity,
+                              qint32 tileSize = 0)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "layers benchmark");
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintDeviceSP device = new KisPaintDevice(cs, tileSize);
+        const QColor color = QColor::fromHsv((i * 37) % 360, 128, 255, 32 + (i * 7) % 200);
+        device->fill(imageRect.adjusted(i, i, -i, -i), KoColor(color, cs));
+
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("layer %1").arg(i), opacity, device);
+        layer->setCompositeOpId(i == 0 ? COMPOSITE_OVER : compositeOpId);
+        image->addNode(layer, image->rootLayer());
+    }
+
+    return image;
+}
+
+}
 
 void KisProjectionBenchmark::initTestCase()
 {
@@ -58,5 +89,59 @@ void KisProjectionBenchmark::benchmarkLoading()
     }
 }
 
+void KisProjectionBenchmark::benchmarkProjection50Layers_data()
+{
+    QTest::addColumn<QString>("compositeOpId");
+    QTest::addColumn<int>("opacity");
+
+    // Normal and Multiply layers at 100% are composited in fused batches,
+    // layers at 99% are composited one by one, like before
+    QTest::newRow("normal-100") << COMPOSITE_OVER << int(OPACITY_OPAQUE_U8);
+    QTest::newRow("normal-99") << COMPOSITE_OVER << 252;
+    QTest::newRow("multiply-100") << COMPOSITE_MULT << int(OPACITY_OPAQUE_U8);
+    QTest::newRow("multiply-99") << COMPOSITE_MULT << 252;
+}
+
+void KisProjectionBenchmark::benchmarkProjection50Layers()
+{
+    QFETCH(QString, compositeOpId);
+    QFETCH(int, opacity);
+
+    const QRect imageRect(0, 0, NO_TILE_EXACT_BOUNDARY_WIDTH, NO_TILE_EXACT_BOUNDARY_HEIGHT);
+    KisImageSP image = createLayeredImage(imageRect, 50, compositeOpId, quint8(opacity));
+
+    KisAsyncMerger merger;
+
+    QBENCHMARK {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+}
+
+void KisProjectionBenchmark::benchmarkProjectionTileSizes_data()
+{
+    QTest::addColumn<int>("tileSize");
+
+    QTest::newRow("64") << 64;
+    QTest::newRow("128") << 128;
+    QTest::newRow("256") << 256;
+}
+
+void KisProjectionBenchmark::benchmarkProjectionTileSizes()
+{
+    QFETCH(int, tileSize);
+
+    const QRect imageRect(0, 0, NO_TILE_EXACT_BOUNDARY_WIDTH, NO_TILE_EXACT_BOUNDARY_HEIGHT);
+    KisImageSP image = createLayeredImage(imageRect, 50, COMPOSITE_OVER, OPACITY_OPAQUE_U8, tileSize);
+
+    KisAsyncMerger merger;
+
+    QBENCHMARK {
+        KisFullRefreshWalker walker(imageRect);
+        walker.collectRects(image->rootLayer(), imageRect);
+        merger.startMerge(walker);
+    }
+}
 
 QTEST_MAIN(KisProjectionBenchmark)
@@ -32,6 +32,12 @@ private Q_SLOTS:
 
     void benchmarkProjection();
     void benchmarkLoading();
+
+    void benchmarkProjection50Layers_data();
+    void benchmarkProjection50Layers();
+
+    void benchmarkProjectionTileSizes_data();
+    void benchmarkProjectionTileSizes();
 };
 
 #endif
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_hash_table_benchmark.h"
+
+#include <QTest>
+#include <QThread>
+
+#include "tiles3/kis_tile.h"
+#include "tiles3/kis_tile_hash_table2.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "kis_legacy_tile_hash_table.h"
+
+/**
+ * The size of the tested area in tiles. It is big enough
+ * for the threads not to hit the same tiles all the time.
+ */
+static const qint32 NUM_COLS = 64;
+static const qint32 NUM_ROWS = 64;
+static const qint32 NUM_PASSES = 8;
+
+enum AccessType {
+    ExistingTile,
+    ReadOnlyTileLazy,
+    TileLazy
+};
+
+template <class HashTable>
+class HashTableAccessThread : public QThread
+{
+public:
+    HashTableAccessThread(AccessType type, int seed, HashTable *table)
+        : m_type(type),
+          m_seed(seed),
+          m_table(table)
+    {
+    }
+
+    void run() override {
+        // every thread walks the tiles in its own order
+        const int step = 2 * m_seed + 1;
+        const int numTiles = NUM_COLS * NUM_ROWS;
+
+        for (int pass = 0; pass < NUM_PASSES; pass++) {
+            for (int i = 0; i < numTiles; i++) {
+                const int index = (m_seed + i * step) % numTiles;
+                const qint32 col = index % NUM_COLS;
+                const qint32 row = index / NUM_COLS;
+
+                KisTileSP tile;
+                bool flag = false;
+
+                switch (m_type) {
+                case ExistingTile:
+                    tile = m_table->getExistingTile(col, row);
+                    break;
+                case ReadOnlyTileLazy:
+                    tile = m_table->getReadOnlyTileLazy(col, row + NUM_ROWS, flag);
+                    break;
+                case TileLazy:
+                    tile = m_table->getTileLazy(col, row, flag);
+                    break;
+                }
+
+                Q_ASSERT(tile);
+            }
+        }
+    }
+
+private:
+    AccessType m_type;
+    int m_seed;
+    HashTable *m_table;
+};
+
+template <class HashTable>
+static void runAccessBenchmark(AccessType type, int numThreads)
+{
+    const quint8 defaultPixel = 0;
+    KisTileData *defaultTileData =
+        KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel);
+
+    HashTable table(0);
+    table.setDefaultTileData(defaultTileData);
+
+    for (qint32 row = 0; row < NUM_ROWS; row++) {
+        for (qint32 col = 0; col < NUM_COLS; col++) {
+            bool newTile = false;
+            table.getTileLazy(col, row, newTile);
+        }
+    }
+
+    QVector<HashTableAccessThread<HashTable>*> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads << new HashTableAccessThread<HashTable>(type, i, &table);
+    }
+
+    QBENCHMARK_ONCE {
+        Q_FOREACH (HashTableAccessThread<HashTable> *thread, threads) {
+            thread->start();
+        }
+
+        Q_FOREACH (HashTableAccessThread<HashTable> *thread, threads) {
+            thread->wait();
+        }
+    }
+
+    qDeleteAll(threads);
+
+    table.clear();
+    table.setDefaultTileData(0);
+}
+
+static void runAccessBenchmark(AccessType type)
+{
+    QFETCH(int, numThreads);
+    QFETCH(bool, legacy);
+
+    if (legacy) {
+        runAccessBenchmark<KisLegacyTileHashTableTraits2<KisTile>>(type, numThreads);
+    } else {
+        runAccessBenchmark<KisTileHashTableTraits2<KisTile>>(type, numThreads);
+    }
+}
+
+void KisTileHashTableBenchmark::addThreadsData()
+{
+    QTest::addColumn<int>("numThreads");
+    QTest::addColumn<bool>("legacy");
+
+    for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+        QTest::newRow(QString("%1 threads").arg(numThreads).toLatin1()) << numThreads << false;
+        QTest::newRow(QString("%1 threads, legacy").arg(numThreads).toLatin1()) << numThreads << true;
+    }
+}
+
+void KisTileHashTableBenchmark::benchmarkExistingTiles_data()
+{
+    addThreadsData();
+}
+
+void KisTileHashTableBenchmark::benchmarkExistingTiles()
+{
+    runAccessBenchmark(ExistingTile);
+}
+
+void KisTileHashTableBenchmark::benchmarkReadOnlyTileLazy_data()
+{
+    addThreadsData();
+}
+
+void KisTileHashTableBenchmark::benchmarkReadOnlyTileLazy()
+{
+    // the requested tiles are absent, so every access goes
+    // through the default tile data
+    runAccessBenchmark(ReadOnlyTileLazy);
+}
+
+void KisTileHashTableBenchmark::benchmarkTileLazy_data()
+{
+    addThreadsData();
+}
+
+void KisTileHashTableBenchmark::benchmarkTileLazy()
+{
+    runAccessBenchmark(TileLazy);
+}
+
+QTEST_MAIN(KisTileHashTableBenchmark)
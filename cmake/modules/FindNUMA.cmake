@@ -0,0 +1,34 @@
+# - Try to find the NUMA policy library (libnuma)
+# Once done this will define
+#
+#  NUMA_FOUND - system has libnuma
+#  NUMA_INCLUDE_DIRS - the libnuma include directories
+#  NUMA_LIBRARIES - the libraries needed to use libnuma
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+#
+
+include(LibFindMacros)
+libfind_pkg_check_modules(NUMA_PKGCONF numa)
+
+find_path(NUMA_INCLUDE_DIR
+    NAMES numa.h
+    HINTS ${NUMA_PKGCONF_INCLUDE_DIRS} ${NUMA_PKGCONF_INCLUDEDIR}
+)
+
+find_library(NUMA_LIBRARY
+    NAMES numa libnuma
+    HINTS ${NUMA_PKGCONF_LIBRARY_DIRS} ${NUMA_PKGCONF_LIBDIR}
+    DOC "Libraries to link against for NUMA Support"
+)
+
+set(NUMA_PROCESS_LIBS NUMA_LIBRARY)
+set(NUMA_PROCESS_INCLUDES NUMA_INCLUDE_DIR)
+libfind_process(NUMA)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(NUMA
+    REQUIRED_VARS
+        NUMA_INCLUDE_DIR
+        NUMA_LIBRARY
+)
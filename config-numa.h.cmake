@@ -0,0 +1,4 @@
+/* config-numa.h.  Generated by cmake from config-numa.h.cmake */
+
+/* Define if you have libnuma, the NUMA policy library */
+#cmakedefine HAVE_NUMA 1
@@ -14,6 +14,7 @@
 #include <QVector>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
 #include <tiles3/kis_lockless_stack.h>
 
 #define CALL_MEMBER(obj, pmf) ((obj).*(pmf))
@@ -39,24 +40,57 @@ private:
         }
     };
 
-    QAtomicInt m_rawPointerUsers;
+    /**
+     * The number of raw pointer users is split into several counters,
+     * each one living in its own cache line. A thread always uses the
+     * same counter, so the readers running on different cores do not
+     * bounce a single cache line between each other.
+     */
+    static const int NumRawPointerCounters = 16;
+
+    struct RawPointerCounter {
+        QAtomicInt value;
+        char padding[64 - sizeof(QAtomicInt)];
+    };
+
+    RawPointerCounter m_rawPointerUsers[NumRawPointerCounters];
     KisLocklessStack<Action> m_pendingActions;
     KisLocklessStack<Action> m_migrationReclaimActions;
 
+    static inline int currentCounterIndex() {
+        // thread ids are usually aligned, so mix the bits up a bit
+        const quint64 id = quint64(quintptr(QThread::currentThreadId()));
+        return int((id * Q_UINT64_C(0x9E3779B97F4A7C15)) >> 60) & (NumRawPointerCounters - 1);
+    }
+
+    inline bool hasRawPointerUsers() const {
+        for (int i = 0; i < NumRawPointerCounters; i++) {
+            if (m_rawPointerUsers[i].value.loadAcquire()) return true;
+        }
+        return false;
+    }
+
     void releasePoolSafely(KisLocklessStack<Action> *pool, bool force = false) {
+        /**
+         * Don't touch the pool's head when there is nothing to release.
+         * update() is called on every read access to the map, and an
+         * atomic exchange on the shared head would cause contention.
+         */
+        if (pool->isEmpty()) return;
+
         KisLocklessStack<Action> tmp;
         tmp.mergeFrom(*pool);
         if (tmp.isEmpty()) return;
 
         if (force || tmp.size() > 4096) {
-            while (m_rawPointerUsers.loadAcquire());
+            while (hasRawPointerUsers());
 
             Action action;
             while (tmp.pop(action)) {
                 action();
             }
         } else {
-            if (!m_rawPointerUsers.loadAcquire()) {
+            if (!hasRawPointerUsers()) {
                 Action action;
                 while (tmp.pop(action)) {
                     action();
@@ -107,16 +141,16 @@ public:
 
     void lockRawPointerAccess()
     {
-        m_rawPointerUsers.ref();
+        m_rawPointerUsers[currentCounterIndex()].value.ref();
     }
 
     void unlockRawPointerAccess()
     {
-        m_rawPointerUsers.deref();
+        m_rawPointerUsers[currentCounterIndex()].value.deref();
     }
 
     bool sanityRawPointerAccessLocked() const {
-        return m_rawPointerUsers.loadAcquire();
+        return m_rawPointerUsers[currentCounterIndex()].value.loadAcquire();
     }
 };
 
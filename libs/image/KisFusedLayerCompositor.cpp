@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisFusedLayerCompositor.h"
+
+#include <KoCompositeOp.h>
+#include <KoCompositeOpRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+
+
+namespace {
+
+void compositeBlock(KisRandomConstAccessorSP srcIt,
+                    KisRandomAccessorSP dstIt,
+                    const KoCompositeOp *op,
+                    const QRect &rect)
+{
+    KoCompositeOp::ParameterInfo params;
+
+    qint32 y = rect.y();
+    qint32 rowsRemaining = rect.height();
+
+    while (rowsRemaining > 0) {
+        const qint32 rows = qMin(srcIt->numContiguousRows(y), rowsRemaining);
+
+        qint32 x = rect.x();
+        qint32 columnsRemaining = rect.width();
+
+        while (columnsRemaining > 0) {
+            const qint32 columns = qMin(srcIt->numContiguousColumns(x), columnsRemaining);
+
+            srcIt->moveTo(x, y);
+            dstIt->moveTo(x, y);
+
+            params.dstRowStart  = dstIt->rawData();
+            params.dstRowStride = dstIt->rowStride(x, y);
+            params.srcRowStart  = srcIt->rawDataConst();
+            params.srcRowStride = srcIt->rowStride(x, y);
+            params.rows         = rows;
+            params.cols         = columns;
+
+            op->composite(params);
+
+            x += columns;
+            columnsRemaining -= columns;
+        }
+
+        y += rows;
+        rowsRemaining -= rows;
+    }
+}
+
+}
+
+void KisFusedLayerCompositor::addSource(KisPaintDeviceSP device, const KoCompositeOp *op, const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    m_sources.append({device, op, rect});
+    m_totalRect |= rect;
+}
+
+bool KisFusedLayerCompositor::isEmpty() const
+{
+    return m_sources.isEmpty();
+}
+
+int KisFusedLayerCompositor::numSources() const
+{
+    return m_sources.size();
+}
+
+void KisFusedLayerCompositor::composite(KisPaintDeviceSP dst)
+{
+    if (m_sources.isEmpty()) return;
+
+    KisRandomAccessorSP dstIt = dst->createRandomAccessorNG();
+
+    QVector<KisRandomConstAccessorSP> srcIts;
+    srcIts.reserve(m_sources.size());
+
+    Q_FOREACH (const Source &source, m_sources) {
+        srcIts.append(source.device->createRandomConstAccessorNG());
+    }
+
+    QVector<KisTileOpacitySummary> summaries(m_sources.size());
+
+    const QRect &rc = m_totalRect;
+
+    qint32 y = rc.y();
+    qint32 rowsRemaining = rc.height();
+
+    while (rowsRemaining > 0) {
+        const qint32 rows = qMin(dstIt->numContiguousRows(y), rowsRemaining);
+
+        qint32 x = rc.x();
+        qint32 columnsRemaining = rc.width();
+
+        while (columnsRemaining > 0) {
+            const qint32 columns = qMin(dstIt->numContiguousColumns(x), columnsRemaining);
+            const QRect dstBlock(x, y, columns, rows);
+
+            /**
+             * A source that is fully opaque over the whole block and
+             * is composited with Normal blending overwrites everything
+             * below it, so start from the topmost such source
+             */
+            int firstSource = 0;
+
+            for (int i = m_sources.size() - 1; i >= 0; i--) {
+                const Source &source = m_sources[i];
+                const QRect srcBlock = dstBlock & source.rect;
+
+                summaries[i] = srcBlock.isEmpty() ?
+                    KisTileOpacitySummary::Transparent :
+                    source.device->opacitySummary(srcBlock);
+
+                if (srcBlock == dstBlock &&
+                    source.op->id() == COMPOSITE_OVER &&
+                    summaries[i] == KisTileOpacitySummary::Opaque) {
+
+                    firstSource = i;
+                    break;
+                }
+            }
+
+            /**
+             * The destination block belongs to a single tile, so it
+             * stays in the cache while the whole stack is applied to it.
+             * Fully transparent sources are skipped the same way
+             * KisPainter skips the areas outside the source's extent.
+             * It is done for Normal blending only, other blending modes
+             * (e.g. Multiply) may still change the destination by a
+             * rounding step even when the source is transparent.
+             */
+            for (int i = firstSource; i < m_sources.size(); i++) {
+                if (summaries[i] == KisTileOpacitySummary::Transparent &&
+                    m_sources[i].op->id() == COMPOSITE_OVER) {
+
+                    continue;
+                }
+
+                const QRect srcBlock = dstBlock & m_sources[i].rect;
+                compositeBlock(srcIts[i], dstIt, m_sources[i].op, srcBlock);
+            }
+
+            x += columns;
+            columnsRemaining -= columns;
+        }
+
+        y += rows;
+        rowsRemaining -= rows;
+    }
+
+    clear();
+}
+
+void KisFusedLayerCompositor::clear()
+{
+    m_sources.clear();
+    m_totalRect = QRect();
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_FUSED_LAYER_COMPOSITOR_H
+#define __KIS_FUSED_LAYER_COMPOSITOR_H
+
+#include <QRect>
+#include <QVector>
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+class KoCompositeOp;
+
+/**
+ * Composites a stack of source devices into a destination device in a
+ * single pass over the destination.
+ *
+ * Compositing the layers one by one streams the whole destination rect
+ * through memory once per layer. Instead, KisFusedLayerCompositor walks
+ * over the destination tile by tile and applies all the sources to a tile
+ * before moving to the next one, so the destination tile stays in the cache
+ * while the stack is being composited.
+ *
+ * The opacity summaries of the source tiles (see
+ * KisPaintDevice::opacitySummary()) let the compositor skip the sources
+ * that are fully transparent in a tile, as well as all the sources
+ * occluded by a fully opaque Normal-mode source above them.
+ *
+ * Only the simplest form of bitBlt is supported: no selection, full
+ * opacity and flow, all channels enabled and the source color space
+ * equal to the destination one. It is the responsibility of the caller to
+ * check these conditions (see KisAsyncMerger).
+ */
+class KRITAIMAGE_EXPORT KisFusedLayerCompositor
+{
+public:
+    /**
+     * Adds \p device on top of the stack. Only \p rect of the device will
+     * be composited with \p op.
+     */
+    void addSource(KisPaintDeviceSP device, const KoCompositeOp *op, const QRect &rect);
+
+    bool isEmpty() const;
+    int numSources() const;
+
+    /**
+     * Composites all the added sources into \p dst in the order they have
+     * been added and resets the stack
+     */
+    void composite(KisPaintDeviceSP dst);
+
+    void clear();
+
+private:
+    struct Source {
+        KisPaintDeviceSP device;
+        const KoCompositeOp *op;
+        QRect rect;
+    };
+
+    QVector<Source> m_sources;
+    QRect m_totalRect;
+};
+
+#endif /* __KIS_FUSED_LAYER_COMPOSITOR_H */
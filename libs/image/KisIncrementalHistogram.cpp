@@ -0,0 +1,395 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisIncrementalHistogram.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <KoColorSpace.h>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+#include "kis_image_config.h"
+#include "kis_spontaneous_job.h"
+#include "kis_assert.h"
+
+
+namespace {
+
+/**
+ * Every cell covers kTilesPerCell x kTilesPerCell tiles. Storing
+ * a partial histogram per tile would cost more memory than the
+ * tiles themselves for large images.
+ */
+const int kTilesPerCell = 4;
+const int kNumBins = 256;
+
+inline int divideRoundDown(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+}
+
+struct KisIncrementalHistogram::CellJob
+{
+    int generation = 0;
+    int cellIndex = 0;
+    int version = 0;
+    QRect rect;
+};
+
+struct KisIncrementalHistogram::Private
+{
+    struct Cell {
+        std::vector<quint32> bins;
+        int version = 0;
+        bool dirty = true;
+    };
+
+    mutable QMutex mutex;
+
+    const KoColorSpace *colorSpace = 0;
+    QRect bounds;
+    int cellWidth = 0;
+    int cellHeight = 0;
+
+    /// the grid of cells in cell coordinates
+    QRect gridRect;
+    QVector<Cell> cells;
+
+    /// sum of the bins of all the cells, kNumBins per channel
+    std::vector<quint32> total;
+
+    /// incremented on every reset to drop the results of outdated jobs
+    int generation = 0;
+    int pendingJobs = 0;
+
+    void reset(const KoColorSpace *cs, const QRect &_bounds, int tileWidth, int tileHeight);
+    Cell* cellAt(int col, int row);
+};
+
+void KisIncrementalHistogram::Private::reset(const KoColorSpace *cs, const QRect &_bounds, int tileWidth, int tileHeight)
+{
+    colorSpace = cs;
+    bounds = _bounds;
+    cellWidth = tileWidth * kTilesPerCell;
+    cellHeight = tileHeight * kTilesPerCell;
+
+    if (!bounds.isEmpty()) {
+        gridRect = QRect(QPoint(divideRoundDown(bounds.left(), cellWidth),
+                                divideRoundDown(bounds.top(), cellHeight)),
+                         QPoint(divideRoundDown(bounds.right(), cellWidth),
+                                divideRoundDown(bounds.bottom(), cellHeight)));
+    } else {
+        gridRect = QRect();
+    }
+
+    cells.clear();
+    cells.resize(gridRect.width() * gridRect.height());
+
+    total.assign(cs ? cs->channelCount() * kNumBins : 0, 0);
+
+    generation++;
+}
+
+KisIncrementalHistogram::Private::Cell* KisIncrementalHistogram::Private::cellAt(int col, int row)
+{
+    return &cells[(row - gridRect.top()) * gridRect.width() + (col - gridRect.left())];
+}
+
+
+class KisIncrementalHistogramJob : public KisSpontaneousJob
+{
+public:
+    KisIncrementalHistogramJob(KisIncrementalHistogramSP histogram,
+                               KisPaintDeviceSP device,
+                               const QVector<KisIncrementalHistogram::CellJob> &jobs)
+        : m_histogram(histogram),
+          m_device(device),
+          m_jobs(jobs)
+    {
+    }
+
+    bool overrides(const KisSpontaneousJob *otherJob) override {
+        Q_UNUSED(otherJob);
+        return false;
+    }
+
+    void run() override {
+        Q_FOREACH (const KisIncrementalHistogram::CellJob &job, m_jobs) {
+            m_histogram->processCellJob(job, m_device);
+        }
+        m_histogram->notifyJobFinished();
+    }
+
+    int levelOfDetail() const override {
+        return 0;
+    }
+
+    QString debugName() const override {
+        return "KisIncrementalHistogramJob";
+    }
+
+private:
+    KisIncrementalHistogramSP m_histogram;
+    KisPaintDeviceSP m_device;
+    QVector<KisIncrementalHistogram::CellJob> m_jobs;
+};
+
+
+KisIncrementalHistogram::KisIncrementalHistogram()
+    : m_d(new Private)
+{
+}
+
+KisIncrementalHistogram::~KisIncrementalHistogram()
+{
+}
+
+void KisIncrementalHistogram::addDirtyRect(const QRect &rc)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    const QRect dirtyRect = rc & m_d->bounds;
+    if (dirtyRect.isEmpty()) return;
+
+    const int firstCol = divideRoundDown(dirtyRect.left(), m_d->cellWidth);
+    const int lastCol = divideRoundDown(dirtyRect.right(), m_d->cellWidth);
+    const int firstRow = divideRoundDown(dirtyRect.top(), m_d->cellHeight);
+    const int lastRow = divideRoundDown(dirtyRect.bottom(), m_d->cellHeight);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            Private::Cell *cell = m_d->cellAt(col, row);
+            cell->dirty = true;
+            cell->version++;
+        }
+    }
+}
+
+void KisIncrementalHistogram::invalidateAll()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->reset(0, QRect(), 0, 0);
+}
+
+bool KisIncrementalHistogram::hasDirtyCells() const
+{
+    QMutexLocker l(&m_d->mutex);
+
+    if (!m_d->colorSpace) return true;
+
+    Q_FOREACH (const Private::Cell &cell, m_d->cells) {
+        if (cell.dirty) return true;
+    }
+
+    return false;
+}
+
+QVector<KisIncrementalHistogram::CellJob>
+KisIncrementalHistogram::prepareUpdate(KisPaintDeviceSP device, const QRect &bounds)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    const KoColorSpace *cs = device->colorSpace();
+    const int tileWidth = device->dataManager()->tileWidth();
+    const int tileHeight = device->dataManager()->tileHeight();
+
+    if (!m_d->colorSpace || !(*m_d->colorSpace == *cs) ||
+        m_d->bounds != bounds ||
+        m_d->cellWidth != tileWidth * kTilesPerCell ||
+        m_d->cellHeight != tileHeight * kTilesPerCell) {
+
+        m_d->reset(cs, bounds, tileWidth, tileHeight);
+    }
+
+    QVector<CellJob> jobs;
+
+    for (int row = m_d->gridRect.top(); row <= m_d->gridRect.bottom(); row++) {
+        for (int col = m_d->gridRect.left(); col <= m_d->gridRect.right(); col++) {
+            Private::Cell *cell = m_d->cellAt(col, row);
+            if (!cell->dirty) continue;
+
+            cell->dirty = false;
+
+            CellJob job;
+            job.generation = m_d->generation;
+            job.cellIndex = cell - m_d->cells.data();
+            job.version = cell->version;
+            job.rect = QRect(col * m_d->cellWidth, row * m_d->cellHeight,
+                             m_d->cellWidth, m_d->cellHeight) & bounds;
+
+            jobs.append(job);
+        }
+    }
+
+    return jobs;
+}
+
+void KisIncrementalHistogram::processCellJob(const CellJob &job, KisPaintDeviceSP device)
+{
+    const KoColorSpace *cs = device->colorSpace();
+    const int channelCount = cs->channelCount();
+    const int pixelSize = cs->pixelSize();
+    const int tileWidth = device->dataManager()->tileWidth();
+    const int tileHeight = device->dataManager()->tileHeight();
+
+    std::vector<quint32> bins(channelCount * kNumBins, 0);
+
+    /**
+     * Walk the cell tile-by-tile to skip the transparent tiles
+     * without reading a single pixel of them. Transparent pixels
+     * of the other tiles are skipped as well, otherwise the result
+     * would depend on how the content is aligned to the tile grid.
+     */
+    for (int y = job.rect.top(); y <= job.rect.bottom(); y += tileHeight) {
+        for (int x = job.rect.left(); x <= job.rect.right(); x += tileWidth) {
+            const QRect tileRect = QRect(x, y, tileWidth, tileHeight) & job.rect;
+
+            if (device->opacitySummary(tileRect) == KisTileOpacitySummary::Transparent) {
+                continue;
+            }
+
+            KisSequentialConstIterator it(device, tileRect);
+
+            int numConseqPixels = it.nConseqPixels();
+            while (it.nextPixels(numConseqPixels)) {
+                numConseqPixels = it.nConseqPixels();
+
+                const quint8 *pixel = it.rawDataConst();
+                for (int i = 0; i < numConseqPixels; i++) {
+                    if (cs->opacityU8(pixel) == OPACITY_TRANSPARENT_U8) {
+                        pixel += pixelSize;
+                        continue;
+                    }
+
+                    for (int chan = 0; chan < channelCount; chan++) {
+                        bins[chan * kNumBins + cs->scaleToU8(pixel, chan)]++;
+                    }
+                    pixel += pixelSize;
+                }
+            }
+        }
+    }
+
+    QMutexLocker l(&m_d->mutex);
+
+    if (job.generation != m_d->generation) return;
+
+    Private::Cell &cell = m_d->cells[job.cellIndex];
+
+    /**
+     * The cell has been changed while we were calculating it,
+     * it is already marked as dirty, so just drop the result
+     */
+    if (cell.version != job.version) return;
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN(bins.size() == m_d->total.size());
+
+    if (!cell.bins.empty()) {
+        for (size_t i = 0; i < bins.size(); i++) {
+            m_d->total[i] -= cell.bins[i];
+        }
+    }
+
+    for (size_t i = 0; i < bins.size(); i++) {
+        m_d->total[i] += bins[i];
+    }
+
+    cell.bins.swap(bins);
+}
+
+void KisIncrementalHistogram::notifyJobFinished()
+{
+    bool lastJob = false;
+
+    {
+        QMutexLocker l(&m_d->mutex);
+        lastJob = !--m_d->pendingJobs;
+    }
+
+    if (lastJob) {
+        emit sigHistogramUpdated();
+    }
+}
+
+void KisIncrementalHistogram::startUpdate(KisImageSP image, KisPaintDeviceSP device, const QRect &bounds)
+{
+    const QVector<CellJob> jobs = prepareUpdate(device, bounds);
+
+    if (jobs.isEmpty()) {
+        emit sigHistogramUpdated();
+        return;
+    }
+
+    /**
+     * Group the cells into a few jobs per updater thread, so that the
+     * update queue would not have to process thousands of them
+     */
+    const int numThreads = KisImageConfig(true).maxNumberOfThreads();
+    const int cellsPerJob = qMax(1, jobs.size() / (4 * numThreads));
+
+    QVector<KisIncrementalHistogramJob*> spontaneousJobs;
+    for (int i = 0; i < jobs.size(); i += cellsPerJob) {
+        spontaneousJobs.append(
+            new KisIncrementalHistogramJob(this, device, jobs.mid(i, cellsPerJob)));
+    }
+
+    {
+        QMutexLocker l(&m_d->mutex);
+        m_d->pendingJobs += spontaneousJobs.size();
+    }
+
+    Q_FOREACH (KisIncrementalHistogramJob *job, spontaneousJobs) {
+        image->addSpontaneousJob(job);
+    }
+}
+
+void KisIncrementalHistogram::updateSynchronously(KisPaintDeviceSP device, const QRect &bounds)
+{
+    const QVector<CellJob> jobs = prepareUpdate(device, bounds);
+
+    Q_FOREACH (const CellJob &job, jobs) {
+        processCellJob(job, device);
+    }
+}
+
+KisIncrementalHistogram::HistVector KisIncrementalHistogram::histogram() const
+{
+    QMutexLocker l(&m_d->mutex);
+
+    const int channelCount = m_d->total.size() / kNumBins;
+
+    HistVector result(channelCount);
+    for (int chan = 0; chan < channelCount; chan++) {
+        result[chan].assign(m_d->total.begin() + chan * kNumBins,
+                            m_d->total.begin() + (chan + 1) * kNumBins);
+    }
+
+    return result;
+}
+
+const KoColorSpace* KisIncrementalHistogram::colorSpace() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->colorSpace;
+}
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISINCREMENTALHISTOGRAM_H
+#define KISINCREMENTALHISTOGRAM_H
+
+#include <QObject>
+#include <QRect>
+#include <QScopedPointer>
+#include <vector>
+
+#include "kis_types.h"
+#include "kis_shared.h"
+#include "kritaimage_export.h"
+
+class KoColorSpace;
+class KisIncrementalHistogram;
+typedef KisSharedPtr<KisIncrementalHistogram> KisIncrementalHistogramSP;
+
+
+/**
+ * KisIncrementalHistogram keeps an 8-bit per-channel histogram of a
+ * paint device (usually, the image projection) that can be updated
+ * incrementally.
+ *
+ * The bounds are split into a grid of cells, aligned to the tile grid
+ * of the device, and a partial histogram is stored for every cell.
+ * The total histogram is just a sum of the partial ones, so when some
+ * area of the device changes, only the cells intersecting the dirty
+ * rect are recalculated.
+ *
+ * Usage:
+ *
+ * 1) Report every change of the device with addDirtyRect()
+ *
+ * 2) Call startUpdate() to recalculate the dirty cells on the updater
+ *    threads of the image. sigHistogramUpdated() is emitted when all
+ *    the jobs are completed. updateSynchronously() does the same in
+ *    the calling thread.
+ *
+ * 3) Fetch the result with histogram()
+ *
+ * Fully transparent pixels are not counted, so the result does not
+ * depend on the alignment of the content to the tile grid. Fully
+ * transparent tiles are skipped without reading their pixels.
+ *
+ * The object is thread-safe.
+ */
+class KRITAIMAGE_EXPORT KisIncrementalHistogram : public QObject, public KisShared
+{
+    Q_OBJECT
+public:
+    typedef std::vector<std::vector<quint32>> HistVector;
+
+public:
+    KisIncrementalHistogram();
+    ~KisIncrementalHistogram() override;
+
+    /**
+     * Marks the cells intersecting \p rc as dirty
+     */
+    void addDirtyRect(const QRect &rc);
+
+    /**
+     * Marks all the cells as dirty
+     */
+    void invalidateAll();
+
+    /**
+     * @return true if there are dirty cells that need recalculation
+     */
+    bool hasDirtyCells() const;
+
+    /**
+     * Starts recalculation of the dirty cells of \p bounds on the
+     * updater threads of \p image. If the color space of \p device
+     * or \p bounds differ from the ones used previously, the whole
+     * histogram is reset.
+     *
+     * \p device should not change while the jobs are running, so
+     * pass a copy of the projection, not the projection itself.
+     * Copying a device is cheap, the tiles are copied-on-write.
+     */
+    void startUpdate(KisImageSP image, KisPaintDeviceSP device, const QRect &bounds);
+
+    /**
+     * Same as startUpdate(), but calculates the dirty cells in the
+     * calling thread. sigHistogramUpdated() is not emitted.
+     */
+    void updateSynchronously(KisPaintDeviceSP device, const QRect &bounds);
+
+    /**
+     * @return the current state of the histogram: 256 bins per
+     *         channel of the color space of the device
+     */
+    HistVector histogram() const;
+
+    /**
+     * @return the color space the histogram has been calculated in
+     */
+    const KoColorSpace* colorSpace() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted from the updater thread when the last job started by
+     * startUpdate() has finished
+     */
+    void sigHistogramUpdated();
+
+private:
+    friend class KisIncrementalHistogramJob;
+
+    struct CellJob;
+    QVector<CellJob> prepareUpdate(KisPaintDeviceSP device, const QRect &bounds);
+    void processCellJob(const CellJob &job, KisPaintDeviceSP device);
+    void notifyJobFinished();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISINCREMENTALHISTOGRAM_H
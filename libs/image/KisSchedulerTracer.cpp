@@ -0,0 +1,310 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisSchedulerTracer.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGlobalStatic>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadStorage>
+
+#include "kis_debug.h"
+#include "kis_image_config.h"
+#include "kis_stroke_job_strategy.h"
+
+Q_GLOBAL_STATIC(KisSchedulerTracer, s_instance)
+
+const int KisSchedulerTracer::eventsPerThread = 16384;
+
+namespace {
+
+struct ThreadBuffer
+{
+    ThreadBuffer(int _tid, const QString &_threadName)
+        : tid(_tid),
+          threadName(_threadName)
+    {
+        events.resize(KisSchedulerTracer::eventsPerThread);
+    }
+
+    void push(const KisSchedulerTracer::Event &event) {
+        QMutexLocker l(&lock);
+
+        events[next] = event;
+        next = (next + 1) % events.size();
+        wrapped |= !next;
+    }
+
+    QVector<KisSchedulerTracer::Event> snapshot() {
+        QMutexLocker l(&lock);
+
+        QVector<KisSchedulerTracer::Event> result;
+
+        if (wrapped) {
+            result = events.mid(next);
+        }
+        result += events.mid(0, next);
+
+        return result;
+    }
+
+    void clear() {
+        QMutexLocker l(&lock);
+        next = 0;
+        wrapped = false;
+    }
+
+    /**
+     * The lock is taken by the owner thread only, so it is
+     * contended only while somebody is dumping the trace
+     */
+    QMutex lock;
+    QVector<KisSchedulerTracer::Event> events;
+    int next = 0;
+    bool wrapped = false;
+
+    const int tid;
+    const QString threadName;
+};
+
+typedef QSharedPointer<ThreadBuffer> ThreadBufferSP;
+
+QString jobTypeToString(KisSchedulerTracer::JobType type)
+{
+    switch (type) {
+    case KisSchedulerTracer::MergeJob:
+        return "merge";
+    case KisSchedulerTracer::StrokeJob:
+        return "stroke";
+    case KisSchedulerTracer::SpontaneousJob:
+        return "spontaneous";
+    }
+
+    return "unknown";
+}
+
+QString sequentialityToString(int sequentiality)
+{
+    switch (sequentiality) {
+    case KisStrokeJobData::SEQUENTIAL:
+        return "sequential";
+    case KisStrokeJobData::CONCURRENT:
+        return "concurrent";
+    case KisStrokeJobData::BARRIER:
+        return "barrier";
+    case KisStrokeJobData::UNIQUELY_CONCURRENT:
+        return "uniquely-concurrent";
+    }
+
+    return QString();
+}
+
+}
+
+struct KisSchedulerTracer::Private
+{
+    QElapsedTimer timer;
+    QString dumpFileName;
+    bool enabledByEnvironment = false;
+
+    QMutex buffersLock;
+    QVector<ThreadBufferSP> buffers;
+
+    /**
+     * The thread storage holds an extra reference to the buffer,
+     * so the events of the finished threads are still available
+     * to the dump
+     */
+    QThreadStorage<ThreadBufferSP> threadBuffers;
+
+    ThreadBuffer* currentThreadBuffer();
+    QVector<ThreadBufferSP> buffersSnapshot();
+};
+
+ThreadBuffer* KisSchedulerTracer::Private::currentThreadBuffer()
+{
+    if (!threadBuffers.hasLocalData()) {
+        QThread *thread = QThread::currentThread();
+
+        QString threadName = thread->objectName();
+        if (threadName.isEmpty()) {
+            threadName = QString("thread 0x%1").arg(quintptr(QThread::currentThreadId()), 0, 16);
+        }
+
+        QMutexLocker l(&buffersLock);
+        ThreadBufferSP buffer(new ThreadBuffer(buffers.size() + 1, threadName));
+        buffers.append(buffer);
+        threadBuffers.setLocalData(buffer);
+    }
+
+    return threadBuffers.localData().data();
+}
+
+QVector<ThreadBufferSP> KisSchedulerTracer::Private::buffersSnapshot()
+{
+    QMutexLocker l(&buffersLock);
+    return buffers;
+}
+
+KisSchedulerTracer::KisSchedulerTracer()
+    : m_d(new Private)
+{
+    m_d->timer.start();
+
+    const QByteArray envValue = qgetenv("KRITA_SCHEDULER_TRACE");
+    if (!envValue.isEmpty() && envValue != "0") {
+        m_d->enabledByEnvironment = true;
+
+        if (envValue != "1") {
+            m_d->dumpFileName = QString::fromLocal8Bit(envValue);
+        }
+    }
+
+    updateSettings();
+}
+
+KisSchedulerTracer::~KisSchedulerTracer()
+{
+    if (!m_d->dumpFileName.isEmpty()) {
+        dumpChromeTrace(m_d->dumpFileName);
+    }
+}
+
+KisSchedulerTracer* KisSchedulerTracer::instance()
+{
+    return s_instance;
+}
+
+void KisSchedulerTracer::setEnabled(bool value)
+{
+    m_enabled = value;
+}
+
+void KisSchedulerTracer::updateSettings()
+{
+    m_enabled = m_d->enabledByEnvironment ||
+        KisImageConfig(true).enableSchedulerTracing();
+}
+
+qint64 KisSchedulerTracer::timestamp() const
+{
+    return m_d->timer.nsecsElapsed() / 1000;
+}
+
+void KisSchedulerTracer::recordEvent(const Event &event)
+{
+    m_d->currentThreadBuffer()->push(event);
+}
+
+void KisSchedulerTracer::clear()
+{
+    Q_FOREACH (ThreadBufferSP buffer, m_d->buffersSnapshot()) {
+        buffer->clear();
+    }
+}
+
+QVector<KisSchedulerTracer::Event> KisSchedulerTracer::events() const
+{
+    QVector<Event> result;
+
+    Q_FOREACH (ThreadBufferSP buffer, m_d->buffersSnapshot()) {
+        result += buffer->snapshot();
+    }
+
+    std::sort(result.begin(), result.end(),
+              [] (const Event &lhs, const Event &rhs) {
+                  return lhs.start < rhs.start;
+              });
+
+    return result;
+}
+
+QByteArray KisSchedulerTracer::chromeTraceJson() const
+{
+    QJsonArray traceEvents;
+
+    Q_FOREACH (ThreadBufferSP buffer, m_d->buffersSnapshot()) {
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = 1;
+        threadName["tid"] = buffer->tid;
+        threadName["args"] = QJsonObject({{"name", buffer->threadName}});
+        traceEvents.append(threadName);
+
+        Q_FOREACH (const Event &event, buffer->snapshot()) {
+            QJsonObject args;
+            args["lod"] = event.levelOfDetail;
+            args["lockWait"] = double(event.lockWait);
+            args["exclusive"] = event.exclusive;
+
+            if (event.queueWait >= 0) {
+                args["queueWait"] = double(event.queueWait);
+            }
+
+            if (event.sequentiality >= 0) {
+                args["sequentiality"] = sequentialityToString(event.sequentiality);
+            }
+
+            if (!event.changeRect.isEmpty()) {
+                const QRect &rc = event.changeRect;
+                args["changeRect"] = QString("%1,%2 %3x%4")
+                    .arg(rc.x()).arg(rc.y()).arg(rc.width()).arg(rc.height());
+            }
+
+            QJsonObject object;
+            object["name"] = event.name.isEmpty() ? jobTypeToString(event.type) : event.name;
+            object["cat"] = jobTypeToString(event.type);
+            object["ph"] = "X";
+            object["ts"] = double(event.start);
+            object["dur"] = double(event.duration);
+            object["pid"] = 1;
+            object["tid"] = buffer->tid;
+            object["args"] = args;
+
+            traceEvents.append(object);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool KisSchedulerTracer::dumpChromeTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        warnKrita << "KisSchedulerTracer: failed to open" << fileName << "for writing";
+        return false;
+    }
+
+    return file.write(chromeTraceJson()) >= 0;
+}
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_SCHEDULER_TRACER_H
+#define __KIS_SCHEDULER_TRACER_H
+
+#include <atomic>
+
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QScopedPointer>
+
+#include "kritaimage_export.h"
+
+/**
+ * Records every job executed by the update scheduler (merge walkers,
+ * stroke jobs and spontaneous jobs) and exports them in Chrome trace-event
+ * format, which can be opened by chrome://tracing or ui.perfetto.dev.
+ *
+ * Every thread writes into its own fixed-size ring buffer, so the tracer
+ * never blocks the workers on a shared lock. When the buffer is full, the
+ * oldest events are overwritten.
+ *
+ * The tracer is enabled either by "enableSchedulerTracing" option of
+ * KisImageConfig or by KRITA_SCHEDULER_TRACE environment variable. If
+ * the variable contains anything except "1", it is treated as a file
+ * name the trace is dumped to on exit.
+ */
+class KRITAIMAGE_EXPORT KisSchedulerTracer
+{
+public:
+    enum JobType {
+        MergeJob = 0,
+        StrokeJob,
+        SpontaneousJob
+    };
+
+    struct Event {
+        JobType type = MergeJob;
+        QString name;
+        int levelOfDetail = 0;
+
+        /// job start time and duration, in microseconds
+        qint64 start = 0;
+        qint64 duration = 0;
+
+        /// time the job spent in KisStrokesQueue, -1 if unknown
+        qint64 queueWait = -1;
+
+        /// time spent waiting for the exclusive job lock
+        qint64 lockWait = 0;
+
+        /// sequentiality of a stroke job, -1 for other jobs
+        int sequentiality = -1;
+        bool exclusive = false;
+
+        QRect changeRect;
+    };
+
+    static const int eventsPerThread;
+
+public:
+    KisSchedulerTracer();
+    ~KisSchedulerTracer();
+
+    static KisSchedulerTracer* instance();
+
+    inline bool isEnabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool value);
+
+    /**
+     * Re-reads "enableSchedulerTracing" option from the config. The
+     * tracer enabled by the environment variable stays enabled.
+     */
+    void updateSettings();
+
+    /**
+     * Monotonic time in microseconds since the creation of the tracer
+     */
+    qint64 timestamp() const;
+
+    /**
+     * Save \p event into the ring buffer of the current thread
+     */
+    void recordEvent(const Event &event);
+
+    /**
+     * Drop all the recorded events
+     */
+    void clear();
+
+    /**
+     * All the events recorded so far, sorted by their start time
+     */
+    QVector<Event> events() const;
+
+    QByteArray chromeTraceJson() const;
+    bool dumpChromeTrace(const QString &fileName) const;
+
+private:
+    std::atomic<bool> m_enabled {false};
+
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_SCHEDULER_TRACER_H */
@@ -0,0 +1,36 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_TILE_OPACITY_SUMMARY_H
+#define __KIS_TILE_OPACITY_SUMMARY_H
+
+/**
+ * Describes the alpha channel of all the pixels of a tile (or of
+ * a group of tiles)
+ *
+ * \see KisPaintDevice::opacitySummary()
+ */
+enum class KisTileOpacitySummary : int {
+    Unknown = 0,     ///< the summary has not been calculated yet
+    Transparent = 1, ///< all the pixels are fully transparent
+    Opaque = 2,      ///< all the pixels are fully opaque
+    Mixed = 3        ///< anything else
+};
+
+#endif /* __KIS_TILE_OPACITY_SUMMARY_H */
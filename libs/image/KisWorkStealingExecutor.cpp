@@ -0,0 +1,330 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisWorkStealingExecutor.h"
+
+#include <atomic>
+#include <deque>
+#include <iterator>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "kis_assert.h"
+
+
+struct KisWorkStealingExecutor::Worker : public QThread
+{
+    Worker(KisWorkStealingExecutor::Private *_executor, int _index)
+        : executor(_executor),
+          index(_index)
+    {
+    }
+
+    void run() override;
+
+    void push(QRunnable *job) {
+        QMutexLocker l(&lock);
+        jobs.push_back(job);
+    }
+
+    /**
+     * The owner takes the jobs in FIFO order to keep the order
+     * the scheduler has queued them in...
+     */
+    QRunnable* popLocal() {
+        QMutexLocker l(&lock);
+        if (jobs.empty()) return 0;
+
+        QRunnable *job = jobs.front();
+        jobs.pop_front();
+        return job;
+    }
+
+    /**
+     * ... and the thieves take them from the opposite end, so the owner
+     * and a thief collide only when the deque has a single job left.
+     * The jobs rejected by \p filter are left for the owner.
+     */
+    QRunnable* steal(const std::function<bool(QRunnable*)> &filter) {
+        QMutexLocker l(&lock);
+
+        for (auto it = jobs.rbegin(); it != jobs.rend(); ++it) {
+            QRunnable *job = *it;
+
+            if (!filter || filter(job)) {
+                jobs.erase(std::next(it).base());
+                return job;
+            }
+        }
+
+        return 0;
+    }
+
+    bool isIdle() {
+        QMutexLocker l(&lock);
+        return !busy && jobs.empty();
+    }
+
+    KisWorkStealingExecutor::Private *executor;
+    const int index;
+
+    QMutex lock;
+    std::deque<QRunnable*> jobs;
+    std::atomic<bool> busy {false};
+};
+
+struct KisWorkStealingExecutor::Private
+{
+    int maxThreadCount = 0;
+    QVector<Worker*> workers;
+
+    /**
+     * The counters use sequential consistency on purpose: the
+     * pendingJobs/sleepingWorkers pair is used in a Dekker-like
+     * fashion to avoid losing wakeups without taking sleepLock
+     * on every start().
+     */
+    std::atomic<int> pendingJobs {0};
+    std::atomic<int> activeJobs {0};
+    std::atomic<int> sleepingWorkers {0};
+    std::atomic<unsigned int> nextWorker {0};
+    std::atomic<unsigned int> pushedJobs {0};
+    std::atomic<int> stolenJobs {0};
+
+    std::function<bool(QRunnable*)> stealingFilter;
+
+    QMutex sleepLock;
+    QWaitCondition wakeCondition;
+    bool quit = false;
+
+    QMutex doneLock;
+    QWaitCondition doneCondition;
+
+    void startWorkers();
+    void stopWorkers();
+
+    Worker* pickWorker();
+    QRunnable* takeJob(Worker *self);
+    void jobFinished();
+};
+
+void KisWorkStealingExecutor::Worker::run()
+{
+    while (1) {
+        const unsigned int lastPushedJobs = executor->pushedJobs;
+        QRunnable *job = executor->takeJob(this);
+
+        if (job) {
+            busy = true;
+            job->run();
+            busy = false;
+            executor->jobFinished();
+            continue;
+        }
+
+        QMutexLocker l(&executor->sleepLock);
+        if (executor->quit) break;
+
+        /**
+         * The pending jobs may be the ones we are not allowed to steal,
+         * so sleep until a new job is pushed, not until all of them
+         * are taken
+         */
+        executor->sleepingWorkers++;
+        if (executor->pendingJobs <= 0 || executor->pushedJobs == lastPushedJobs) {
+            executor->wakeCondition.wait(&executor->sleepLock);
+        }
+        executor->sleepingWorkers--;
+    }
+}
+
+void KisWorkStealingExecutor::Private::startWorkers()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(workers.isEmpty());
+
+    // all the workers must be registered before any of them starts stealing
+    for (int i = 0; i < maxThreadCount; i++) {
+        workers.append(new Worker(this, i));
+    }
+
+    Q_FOREACH (Worker *worker, workers) {
+        worker->start();
+    }
+}
+
+void KisWorkStealingExecutor::Private::stopWorkers()
+{
+    {
+        QMutexLocker l(&sleepLock);
+        quit = true;
+        wakeCondition.wakeAll();
+    }
+
+    Q_FOREACH (Worker *worker, workers) {
+        worker->wait();
+        KIS_SAFE_ASSERT_RECOVER_NOOP(worker->jobs.empty());
+        delete worker;
+    }
+
+    workers.clear();
+    quit = false;
+}
+
+KisWorkStealingExecutor::Worker* KisWorkStealingExecutor::Private::pickWorker()
+{
+    const int numWorkers = workers.size();
+    const unsigned int first = nextWorker++;
+
+    /**
+     * Prefer an idle worker, so that a job that cannot be stolen
+     * doesn't wait for a busy one
+     */
+    for (int i = 0; i < numWorkers; i++) {
+        Worker *worker = workers[(first + i) % numWorkers];
+        if (worker->isIdle()) return worker;
+    }
+
+    return workers[first % numWorkers];
+}
+
+QRunnable* KisWorkStealingExecutor::Private::takeJob(Worker *self)
+{
+    if (pendingJobs <= 0) return 0;
+
+    QRunnable *job = self->popLocal();
+
+    if (!job) {
+        const int numWorkers = workers.size();
+
+        for (int i = 1; i < numWorkers && !job; i++) {
+            Worker *victim = workers[(self->index + i) % numWorkers];
+            job = victim->steal(stealingFilter);
+        }
+
+        if (job) {
+            stolenJobs++;
+        }
+    }
+
+    if (job) {
+        pendingJobs--;
+    }
+
+    return job;
+}
+
+void KisWorkStealingExecutor::Private::jobFinished()
+{
+    if (--activeJobs == 0) {
+        QMutexLocker l(&doneLock);
+        doneCondition.wakeAll();
+    }
+}
+
+KisWorkStealingExecutor::KisWorkStealingExecutor()
+    : m_d(new Private)
+{
+}
+
+KisWorkStealingExecutor::~KisWorkStealingExecutor()
+{
+    waitForDone();
+    m_d->stopWorkers();
+}
+
+void KisWorkStealingExecutor::setMaxThreadCount(int value)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(value >= 0);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_d->activeJobs);
+
+    if (value == m_d->maxThreadCount) return;
+
+    m_d->stopWorkers();
+    m_d->maxThreadCount = value;
+    m_d->startWorkers();
+}
+
+int KisWorkStealingExecutor::maxThreadCount() const
+{
+    return m_d->maxThreadCount;
+}
+
+void KisWorkStealingExecutor::setStealingFilter(std::function<bool(QRunnable*)> filter)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_d->activeJobs);
+    m_d->stealingFilter = filter;
+}
+
+void KisWorkStealingExecutor::start(QRunnable *runnable)
+{
+    KIS_SAFE_ASSERT_RECOVER(!m_d->workers.isEmpty()) {
+        runnable->run();
+        return;
+    }
+
+    m_d->activeJobs++;
+
+    Worker *worker = dynamic_cast<Worker*>(QThread::currentThread());
+    const bool isLocalJob = worker && worker->executor == m_d.data();
+
+    if (!isLocalJob) {
+        worker = m_d->pickWorker();
+    }
+
+    const bool canBeStolen = !m_d->stealingFilter || m_d->stealingFilter(runnable);
+
+    worker->push(runnable);
+    m_d->pendingJobs++;
+    m_d->pushedJobs++;
+
+    /**
+     * A sleeping worker increments sleepingWorkers *before* checking
+     * pushedJobs under sleepLock, so either it sees our job, or we see
+     * it sleeping and wake it up. A job that cannot be stolen can be
+     * taken by its own worker only, so we cannot choose whom to wake.
+     */
+    if (m_d->sleepingWorkers > 0 && (canBeStolen || !isLocalJob)) {
+        QMutexLocker l(&m_d->sleepLock);
+
+        if (canBeStolen) {
+            m_d->wakeCondition.wakeOne();
+        } else {
+            m_d->wakeCondition.wakeAll();
+        }
+    }
+}
+
+void KisWorkStealingExecutor::waitForDone()
+{
+    QMutexLocker l(&m_d->doneLock);
+
+    while (m_d->activeJobs > 0) {
+        m_d->doneCondition.wait(&m_d->doneLock);
+    }
+}
+
+int KisWorkStealingExecutor::stolenJobsCount() const
+{
+    return m_d->stolenJobs;
+}
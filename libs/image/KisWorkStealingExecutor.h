@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_WORK_STEALING_EXECUTOR_H
+#define __KIS_WORK_STEALING_EXECUTOR_H
+
+#include <functional>
+#include <QScopedPointer>
+#include "kritaimage_export.h"
+
+class QRunnable;
+
+/**
+ * A thread pool replacement for KisUpdaterContext that keeps a separate
+ * job deque for every worker thread instead of a single global queue.
+ *
+ * When a job is started from inside one of the workers (which is the
+ * common case, since KisUpdateJobItem refills the context right after
+ * finishing its own job), the job is pushed into the local deque of that
+ * worker without touching any shared lock. Idle workers steal jobs from
+ * the opposite end of other workers' deques. Jobs started from an
+ * external thread are distributed in a round-robin manner.
+ *
+ * The executor does *not* check whether the jobs may run concurrently,
+ * it is the responsibility of the caller (KisUpdaterContext) to queue
+ * only the jobs that can be executed in any order.
+ *
+ * Runnables are never deleted by the executor, autoDelete() is ignored.
+ */
+class KRITAIMAGE_EXPORT KisWorkStealingExecutor
+{
+public:
+    KisWorkStealingExecutor();
+    ~KisWorkStealingExecutor();
+
+    /**
+     * Set the number of worker threads. The workers are (re)created
+     * right away, zero value stops all of them.
+     *
+     * WARNING: the executor must be idle, that is, waitForDone()
+     *          must have been called before changing the limit.
+     */
+    void setMaxThreadCount(int value);
+    int maxThreadCount() const;
+
+    /**
+     * Only the jobs accepted by \p filter can be stolen by other
+     * workers, the rest are executed by the worker they have been
+     * queued to. The filter is called by start() and with the
+     * victim's deque locked, so it must not block. By default,
+     * any job can be stolen.
+     *
+     * WARNING: the executor must be idle
+     */
+    void setStealingFilter(std::function<bool(QRunnable*)> filter);
+
+    /**
+     * Queue \p runnable for execution on one of the workers
+     */
+    void start(QRunnable *runnable);
+
+    /**
+     * Block the caller until all the queued and running jobs are finished
+     */
+    void waitForDone();
+
+    /**
+     * The number of jobs executed by a worker different from the one
+     * they have been queued to. Used for statistics and tests only.
+     */
+    int stolenJobsCount() const;
+
+private:
+    struct Worker;
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_WORK_STEALING_EXECUTOR_H */
@@ -24,6 +24,7 @@
 
 #include <KoChannelInfo.h>
 #include <KoCompositeOpRegistry.h>
+#include <KoColorSpace.h>
 
 #include "kis_node_visitor.h"
 #include "kis_painter.h"
@@ -239,6 +240,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
         QRect applyRect = item.m_applyRect;
 
         if (currentLeaf->isRoot()) {
+            flushFusedComposition();
             currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
             continue;
         }
@@ -247,6 +249,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
             // The type of layers that will not go to projection.
 
             DEBUG_NODE_ACTION("Updating", "N_EXTRA", currentLeaf, applyRect);
+            flushFusedComposition();
             KisUpdateOriginalVisitor originalVisitor(applyRect,
                                                      m_currentProjection,
                                                      walker.cropRect());
@@ -268,6 +271,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
         if(item.m_position & KisMergeWalker::N_FILTHY) {
             DEBUG_NODE_ACTION("Updating", "N_FILTHY", currentLeaf, applyRect);
             if (currentLeaf->visible() || currentLeaf->hasClones()) {
+                flushFusedComposition();
                 currentLeaf->accept(originalVisitor);
                 currentLeaf->projectionPlane()->recalculate(applyRect, walker.startNode());
             }
@@ -276,6 +280,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
             DEBUG_NODE_ACTION("Updating", "N_ABOVE_FILTHY", currentLeaf, applyRect);
             if(currentLeaf->dependsOnLowerNodes()) {
                 if (currentLeaf->visible() || currentLeaf->hasClones()) {
+                    flushFusedComposition();
                     currentLeaf->accept(originalVisitor);
                     currentLeaf->projectionPlane()->recalculate(applyRect, currentLeaf->node());
                 }
@@ -295,6 +300,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
         compositeWithProjection(currentLeaf, applyRect);
 
         if(item.m_position & KisMergeWalker::N_TOPMOST) {
+            flushFusedComposition();
             writeProjection(currentLeaf, useTempProjections, applyRect);
             resetProjection();
         }
@@ -319,6 +325,7 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
 }
 
 void KisAsyncMerger::resetProjection() {
+    m_fusedCompositor.clear();
     m_currentProjection = 0;
     m_finalProjection = 0;
 }
@@ -367,6 +374,18 @@ bool KisAsyncMerger::compositeWithProjection(KisProjectionLeafSP leaf, const QRe
     if (!m_currentProjection) return true;
     if (!leaf->visible()) return true;
 
+    if (canFuseComposition(leaf)) {
+        KisPaintDeviceSP device = leaf->projection();
+        const KoCompositeOp *op = m_currentProjection->colorSpace()->compositeOp(leaf->node()->compositeOpId());
+
+        m_fusedCompositor.addSource(device, op, rect & device->extent());
+
+        DEBUG_NODE_ACTION("Deferring projection", "", leaf, rect);
+        return true;
+    }
+
+    flushFusedComposition();
+
     KisPainter gc(m_currentProjection);
     leaf->projectionPlane()->apply(&gc, rect);
 
@@ -374,6 +393,44 @@ bool KisAsyncMerger::compositeWithProjection(KisProjectionLeafSP leaf, const QRe
     return true;
 }
 
+bool KisAsyncMerger::canFuseComposition(KisProjectionLeafSP leaf) const {
+    KisLayer *layer = qobject_cast<KisLayer*>(leaf->node().data());
+    if (!layer) return false;
+
+    /**
+     * Layer styles and pass-through groups have their own projection
+     * planes, which do much more than a simple bitBlt()
+     */
+    if (layer->projectionPlane().data() != layer->internalProjectionPlane().data()) return false;
+
+    const QString compositeOpId = layer->compositeOpId();
+    if (compositeOpId != COMPOSITE_OVER && compositeOpId != COMPOSITE_MULT) return false;
+
+    if (leaf->opacity() != OPACITY_OPAQUE_U8) return false;
+
+    const QBitArray channelFlags = leaf->channelFlags();
+    if (!channelFlags.isEmpty() && channelFlags.count(true) != channelFlags.size()) return false;
+
+    KisPaintDeviceSP device = leaf->projection();
+    if (!device) return false;
+
+    const KoColorSpace *dstCs = m_currentProjection->colorSpace();
+    if (!(*device->colorSpace() == *dstCs) || !dstCs->hasCompositeOp(compositeOpId)) return false;
+
+    return true;
+}
+
+void KisAsyncMerger::flushFusedComposition() {
+    if (m_fusedCompositor.isEmpty()) return;
+
+    KIS_SAFE_ASSERT_RECOVER(m_currentProjection) {
+        m_fusedCompositor.clear();
+        return;
+    }
+
+    m_fusedCompositor.composite(m_currentProjection);
+}
+
 void KisAsyncMerger::doNotifyClones(KisBaseRectsWalker &walker) {
     KisBaseRectsWalker::CloneNotificationsVector &vector =
         walker.cloneNotifications();
@@ -21,6 +21,7 @@
 
 #include "kritaimage_export.h"
 #include "kis_types.h"
+#include "KisFusedLayerCompositor.h"
 
 class QRect;
 class KisBaseRectsWalker;
@@ -35,6 +36,8 @@ private:
     inline void setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection);
     inline void writeProjection(KisProjectionLeafSP topmostLeaf, bool useTempProjection, const QRect &rect);
     inline bool compositeWithProjection(KisProjectionLeafSP leaf, const QRect &rect);
+    inline bool canFuseComposition(KisProjectionLeafSP leaf) const;
+    inline void flushFusedComposition();
     inline void doNotifyClones(KisBaseRectsWalker &walker);
 
 private:
@@ -62,6 +65,15 @@ private:
      * setupProjection()
      */
     KisPaintDeviceSP m_cachedPaintDevice;
+
+    /**
+     * Consecutive layers with trivial composition (Normal or Multiply
+     * at full opacity with all the channels enabled) are not composited
+     * one by one. They are collected here and composited in a single
+     * pass when a layer with any other kind of composition arrives or
+     * the projection is going to be read.
+     */
+    KisFusedLayerCompositor m_fusedCompositor;
 };
 
 
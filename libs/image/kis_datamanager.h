@@ -53,8 +53,10 @@ public:
      *
      * Note that if pixelSize > size of the defPixel array, we will happily read beyond the
      * defPixel array.
+     *
+     * The tiles are \p tileSize pixels wide, zero means the default size.
      */
-KisDataManager(quint32 pixelSize, const quint8 *defPixel) : ACTUAL_DATAMGR(pixelSize, defPixel) {}
+KisDataManager(quint32 pixelSize, const quint8 *defPixel, qint32 tileSize = 0) : ACTUAL_DATAMGR(pixelSize, defPixel, tileSize) {}
     KisDataManager(const KisDataManager& dm) : ACTUAL_DATAMGR(dm) { }
 
     ~KisDataManager() override {
@@ -125,8 +127,8 @@ public:
         return ACTUAL_DATAMGR::write(writer);
     }
 
-    inline bool read(QIODevice *io) {
-        return ACTUAL_DATAMGR::read(io);
+    inline bool read(QIODevice *io, bool lazy = false) {
+        return ACTUAL_DATAMGR::read(io, lazy);
     }
 
     inline void purge(const QRect& area) {
@@ -90,6 +90,17 @@ void KisImageConfig::setEnablePerfLog(bool value)
     m_config.writeEntry("enablePerfLog", value);
 }
 
+bool KisImageConfig::enableSchedulerTracing(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableSchedulerTracing", false) : false;
+}
+
+void KisImageConfig::setEnableSchedulerTracing(bool value)
+{
+    m_config.writeEntry("enableSchedulerTracing", value);
+}
+
 qreal KisImageConfig::transformMaskOffBoundsReadArea() const
 {
     return m_config.readEntry("transformMaskOffBoundsReadArea", 0.5);
@@ -174,6 +185,61 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+QString KisImageConfig::swapCompression(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompression", QString("lzf")) : QString("lzf");
+}
+
+void KisImageConfig::setSwapCompression(const QString &value)
+{
+    m_config.writeEntry("swapCompression", value);
+}
+
+int KisImageConfig::swapCompressionLevel(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompressionLevel", 3) : 3;
+}
+
+void KisImageConfig::setSwapCompressionLevel(int value)
+{
+    m_config.writeEntry("swapCompressionLevel", value);
+}
+
+bool KisImageConfig::enableTileDeduplication(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableTileDeduplication", false) : false;
+}
+
+void KisImageConfig::setEnableTileDeduplication(bool value)
+{
+    m_config.writeEntry("enableTileDeduplication", value);
+}
+
+bool KisImageConfig::enableUniformTileCompaction(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableUniformTileCompaction", false) : false;
+}
+
+void KisImageConfig::setEnableUniformTileCompaction(bool value)
+{
+    m_config.writeEntry("enableUniformTileCompaction", value);
+}
+
+bool KisImageConfig::useColorConversionLookupTables(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useColorConversionLookupTables", false) : false;
+}
+
+void KisImageConfig::setUseColorConversionLookupTables(bool value)
+{
+    m_config.writeEntry("useColorConversionLookupTables", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -541,6 +607,16 @@ void KisImageConfig::setMaxNumberOfThreads(int value)
     }
 }
 
+bool KisImageConfig::useWorkStealingScheduler(bool defaultValue) const
+{
+    return defaultValue ? false : m_config.readEntry("useWorkStealingScheduler", false);
+}
+
+void KisImageConfig::setUseWorkStealingScheduler(bool value)
+{
+    m_config.writeEntry("useWorkStealingScheduler", value);
+}
+
 int KisImageConfig::frameRenderingClones(bool defaultValue) const
 {
     const int defaultClonesCount = qMax(1, maxNumberOfThreads(defaultValue) / 2);
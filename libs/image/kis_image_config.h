@@ -36,6 +36,9 @@ public:
     bool enablePerfLog(bool requestDefault = false) const;
     void setEnablePerfLog(bool value);
 
+    bool enableSchedulerTracing(bool requestDefault = false) const;
+    void setEnableSchedulerTracing(bool value);
+
     qreal transformMaskOffBoundsReadArea() const;
 
     int updatePatchHeight() const;
@@ -58,6 +61,30 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    /**
+     * The name of the compression used for the tiles in the swap
+     * file: "lzf", "lz4" or "zstd". \see KisSwapCompressionFactory
+     */
+    QString swapCompression(bool requestDefault = false) const;
+    void setSwapCompression(const QString &value);
+
+    int swapCompressionLevel(bool requestDefault = false) const; // used by zstd only
+    void setSwapCompressionLevel(int value);
+
+    bool enableTileDeduplication(bool requestDefault = false) const;
+    void setEnableTileDeduplication(bool value);
+
+    bool enableUniformTileCompaction(bool requestDefault = false) const;
+    void setEnableUniformTileCompaction(bool value);
+
+    /**
+     * The lookup tables make RGB color conversions several times faster,
+     * but the result may differ from the exact conversion by up to 2 LSB,
+     * so they are disabled by default. See KoColorConversionLut.
+     */
+    bool useColorConversionLookupTables(bool requestDefault = false) const;
+    void setUseColorConversionLookupTables(bool value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
@@ -114,6 +141,9 @@ public:
     int maxNumberOfThreads(bool defaultValue = false) const;
     void setMaxNumberOfThreads(int value);
 
+    bool useWorkStealingScheduler(bool defaultValue = false) const;
+    void setUseWorkStealingScheduler(bool value);
+
     int frameRenderingClones(bool defaultValue = false) const;
     void setFrameRenderingClones(int value);
 
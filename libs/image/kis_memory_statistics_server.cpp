@@ -157,6 +157,20 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
 
     stats.swapSize = tileStats.swapSize;
 
+    stats.swapBytesWritten = tileStats.swapBytesWritten;
+    stats.numSwappedOutTiles = tileStats.numSwappedOutTiles;
+    stats.numSwappedInTiles = tileStats.numSwappedInTiles;
+    stats.numSwapOutBatches = tileStats.numSwapOutBatches;
+
+    stats.deduplicatedSize = tileStats.deduplicatedSize;
+    stats.numDeduplicatedTiles = tileStats.numDeduplicatedTiles;
+
+    stats.uniformTilesSize = tileStats.uniformTilesSize;
+    stats.numUniformTiles = tileStats.numUniformTiles;
+
+    stats.packedTilesSize = tileStats.packedTilesSize;
+    stats.numPackedTiles = tileStats.numPackedTiles;
+
     KisImageConfig cfg(true);
 
     stats.tilesHardLimit = cfg.tilesHardLimit() * MiB;
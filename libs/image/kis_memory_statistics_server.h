@@ -46,6 +46,18 @@ public:
 
               swapSize(0),
 
+              swapBytesWritten(0),
+              numSwappedOutTiles(0),
+              numSwappedInTiles(0),
+              numSwapOutBatches(0),
+
+              deduplicatedSize(0),
+              numDeduplicatedTiles(0),
+              uniformTilesSize(0),
+              numUniformTiles(0),
+              packedTilesSize(0),
+              numPackedTiles(0),
+
               totalMemoryLimit(0),
               tilesHardLimit(0),
               tilesSoftLimit(0),
@@ -65,6 +77,33 @@ public:
 
         qint64 swapSize;
 
+        /**
+         * Cumulative counters of the swapper since the start
+         * of the application
+         */
+        qint64 swapBytesWritten;
+        qint64 numSwappedOutTiles;
+        qint64 numSwappedInTiles;
+        qint64 numSwapOutBatches;
+
+        /**
+         * Memory saved by sharing identical tiles
+         */
+        qint64 deduplicatedSize;
+        qint64 numDeduplicatedTiles;
+
+        /**
+         * Memory saved by keeping single-colored tiles as one pixel
+         */
+        qint64 uniformTilesSize;
+        qint64 numUniformTiles;
+
+        /**
+         * Memory saved by keeping the lazily loaded tiles compressed
+         */
+        qint64 packedTilesSize;
+        qint64 numPackedTiles;
+
         qint64 totalMemoryLimit;
         qint64 tilesHardLimit;
         qint64 tilesSoftLimit;
@@ -25,6 +25,7 @@
 #include <QList>
 #include <QHash>
 #include <QIODevice>
+#include <QVarLengthArray>
 #include <qmath.h>
 #include <KisRegion.h>
 
@@ -68,6 +69,8 @@
 #include "kis_transform_worker.h"
 #include "kis_filter_strategy.h"
 #include "krita_utils.h"
+#include "KisRunnableStrokeJobData.h"
+#include "KisRunnableStrokeJobUtils.h"
 
 
 struct KisPaintDeviceSPStaticRegistrar {
@@ -111,8 +114,9 @@ public:
 
     KisPaintDeviceStrategy* currentStrategy();
 
-    void init(const KoColorSpace *cs, const quint8 *defaultPixel);
+    void init(const KoColorSpace *cs, const quint8 *defaultPixel, qint32 tileSize);
     void convertColorSpace(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand);
+    void convertColorSpaceInPatches(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, QVector<KisRunnableStrokeJobData*> &jobs, KoUpdater *progressUpdater);
     bool assignProfile(const KoColorProfile * profile, KUndo2Command *parentCommand);
 
     KUndo2Command* reincarnateWithDetachedHistory(bool copyContent);
@@ -373,11 +377,11 @@ public:
         return m_frames.keys();
     }
 
-    bool readFrame(QIODevice *stream, int frameId)
+    bool readFrame(QIODevice *stream, int frameId, bool lazy)
     {
         bool retval = false;
         DataSP data = m_frames[frameId];
-        retval = data->dataManager()->read(stream);
+        retval = data->dataManager()->read(stream, lazy);
         data->cache()->invalidate();
         return retval;
     }
@@ -977,6 +981,87 @@ void KisPaintDevice::Private::convertColorSpace(const KoColorSpace * dstColorSpa
     q->emitColorSpaceChanged();
 }
 
+void KisPaintDevice::Private::convertColorSpaceInPatches(const KoColorSpace * dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, QVector<KisRunnableStrokeJobData*> &jobs, KoUpdater *progressUpdater)
+{
+    KIS_SAFE_ASSERT_RECOVER(parentCommand) {
+        convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand);
+        return;
+    }
+
+    QList<Data*> dataObjects = allDataObjects();
+    if (dataObjects.isEmpty()) return;
+
+    KUndo2Command *mainCommand = new DeviceChangeColorSpaceCommand(q, parentCommand);
+
+    struct Patch {
+        Data *data;
+        Data::ChangeColorSpaceCommand *command;
+        QRect rect;
+    };
+
+    const QSize patchSize = KritaUtils::optimalPatchSize();
+
+    QVector<Patch> patches;
+    QVector<Data::ChangeColorSpaceCommand*> switchCommands;
+
+    Q_FOREACH (Data *data, dataObjects) {
+        if (!data) continue;
+
+        QVector<QRect> rects;
+        Data::ChangeColorSpaceCommand *cmd =
+            data->prepareDataColorSpaceConversion(dstColorSpace, renderingIntent, conversionFlags,
+                                                  patchSize, &rects, mainCommand);
+        if (!cmd) continue;
+
+        switchCommands << cmd;
+
+        Q_FOREACH (const QRect &rc, rects) {
+            patches.append({data, cmd, rc});
+        }
+    }
+
+    KisPaintDeviceSP device(q);
+    const KoColorSpace *srcColorSpace = colorSpace();
+
+    const int numPatches = patches.size();
+    QSharedPointer<QAtomicInt> numConvertedPatches(new QAtomicInt(0));
+    KoUpdaterPtr updater(progressUpdater);
+
+    if (updater) {
+        updater->setRange(0, numPatches);
+    }
+
+    Q_FOREACH (const Patch &patch, patches) {
+        KritaUtils::addJobConcurrent(jobs,
+            [device, patch, srcColorSpace, dstColorSpace, renderingIntent, conversionFlags, numConvertedPatches, updater] () {
+                Q_UNUSED(device); // just keeps the device alive
+
+                patch.data->convertDataRect(patch.command->oldDataManager(),
+                                            patch.command->newDataManager(),
+                                            patch.rect,
+                                            srcColorSpace, dstColorSpace,
+                                            renderingIntent, conversionFlags);
+
+                const int numConverted = numConvertedPatches->fetchAndAddOrdered(1) + 1;
+                if (updater) {
+                    updater->setValue(numConverted);
+                }
+        });
+    }
+
+    KritaUtils::addJobSequential(jobs, [device, switchCommands, updater] () {
+        Q_FOREACH (Data::ChangeColorSpaceCommand *cmd, switchCommands) {
+            cmd->forcedRedo();
+        }
+
+        device->emitColorSpaceChanged();
+
+        if (updater) {
+            updater->setProgress(100);
+        }
+    });
+}
+
 bool KisPaintDevice::Private::assignProfile(const KoColorProfile * profile, KUndo2Command *parentCommand)
 {
     if (!profile) return false;
@@ -1007,13 +1092,13 @@ KUndo2Command *KisPaintDevice::Private::reincarnateWithDetachedHistory(bool copy
     return mainCommand;
 }
 
-void KisPaintDevice::Private::init(const KoColorSpace *cs, const quint8 *defaultPixel)
+void KisPaintDevice::Private::init(const KoColorSpace *cs, const quint8 *defaultPixel, qint32 tileSize)
 {
     QList<Data*> dataObjects = allDataObjects();
     Q_FOREACH (Data *data, dataObjects) {
         if (!data) continue;
 
-        KisDataManagerSP dataManager = new KisDataManager(cs->pixelSize(), defaultPixel);
+        KisDataManagerSP dataManager = new KisDataManager(cs->pixelSize(), defaultPixel, tileSize);
         data->init(cs, dataManager);
     }
 }
@@ -1025,6 +1110,13 @@ KisPaintDevice::KisPaintDevice(const KoColorSpace * colorSpace, const QString& n
     init(colorSpace, new KisDefaultBounds(), 0, name);
 }
 
+KisPaintDevice::KisPaintDevice(const KoColorSpace * colorSpace, qint32 tileSize, const QString& name)
+    : QObject(0)
+    , m_d(new Private(this))
+{
+    init(colorSpace, new KisDefaultBounds(), 0, name, tileSize);
+}
+
 KisPaintDevice::KisPaintDevice(KisNodeWSP parent, const KoColorSpace * colorSpace, KisDefaultBoundsBaseSP defaultBounds, const QString& name)
     : QObject(0)
     , m_d(new Private(this))
@@ -1034,7 +1126,8 @@ KisPaintDevice::KisPaintDevice(KisNodeWSP parent, const KoColorSpace * colorSpac
 
 void KisPaintDevice::init(const KoColorSpace *colorSpace,
                           KisDefaultBoundsBaseSP defaultBounds,
-                          KisNodeWSP parent, const QString& name)
+                          KisNodeWSP parent, const QString& name,
+                          qint32 tileSize)
 {
     Q_ASSERT(colorSpace);
     setObjectName(name);
@@ -1050,7 +1143,7 @@ void KisPaintDevice::init(const KoColorSpace *colorSpace,
 
     QScopedArrayPointer<quint8> defaultPixel(new quint8[colorSpace->pixelSize()]);
     colorSpace->fromQColor(Qt::transparent, defaultPixel.data());
-    m_d->init(colorSpace, defaultPixel.data());
+    m_d->init(colorSpace, defaultPixel.data(), tileSize);
 
     Q_ASSERT(m_d->colorSpace());
 
@@ -1251,6 +1344,150 @@ QRect KisPaintDevice::nonDefaultPixelArea() const
     return m_d->cache()->nonDefaultPixelArea();
 }
 
+namespace {
+
+template <typename T>
+KisTileOpacitySummary calculateTileOpacitySummary(const quint8 *data, int numPixels, int pixelSize,
+                                                  int alphaOffset, T opaqueAlpha, T transparentAlpha)
+{
+    data += alphaOffset;
+
+    T firstAlpha;
+    memcpy(&firstAlpha, data, sizeof(T));
+
+    if (firstAlpha != opaqueAlpha && firstAlpha != transparentAlpha) {
+        return KisTileOpacitySummary::Mixed;
+    }
+
+    for (int i = 1; i < numPixels; i++) {
+        data += pixelSize;
+
+        T alpha;
+        memcpy(&alpha, data, sizeof(T));
+
+        if (alpha != firstAlpha) {
+            return KisTileOpacitySummary::Mixed;
+        }
+    }
+
+    return firstAlpha == opaqueAlpha ?
+        KisTileOpacitySummary::Opaque : KisTileOpacitySummary::Transparent;
+}
+
+template <typename T>
+KisTileOpacitySummary calculateTileOpacitySummary(const quint8 *data, int numPixels, int pixelSize,
+                                                  int alphaOffset,
+                                                  const quint8 *opaquePixel, const quint8 *transparentPixel)
+{
+    T opaqueAlpha;
+    T transparentAlpha;
+
+    memcpy(&opaqueAlpha, opaquePixel + alphaOffset, sizeof(T));
+    memcpy(&transparentAlpha, transparentPixel + alphaOffset, sizeof(T));
+
+    return calculateTileOpacitySummary<T>(data, numPixels, pixelSize, alphaOffset, opaqueAlpha, transparentAlpha);
+}
+
+inline qint32 divideRoundDown(qint32 x, qint32 y)
+{
+    return x >= 0 ? x / y : -(((-x - 1) / y) + 1);
+}
+
+}
+
+KisTileOpacitySummary KisPaintDevice::opacitySummary(const QRect &rect) const
+{
+    if (rect.isEmpty() || defaultBounds()->wrapAroundMode()) {
+        return KisTileOpacitySummary::Mixed;
+    }
+
+    const KoColorSpace *cs = colorSpace();
+    const int pixelSize = cs->pixelSize();
+
+    int alphaOffset = -1;
+    int alphaSize = 0;
+
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelType() == KoChannelInfo::ALPHA) {
+            alphaOffset = channel->pos();
+            alphaSize = channel->size();
+            break;
+        }
+    }
+
+    if (alphaOffset < 0 || (alphaSize != 1 && alphaSize != 2 && alphaSize != 4)) {
+        return KisTileOpacitySummary::Mixed;
+    }
+
+    /**
+     * Compare raw alpha values with the ones the color space itself
+     * writes for fully opaque and fully transparent pixels, so that
+     * e.g. 0.9999 is not treated as opaque in floating point spaces
+     */
+    QVarLengthArray<quint8, 64> opaquePixel(pixelSize);
+    QVarLengthArray<quint8, 64> transparentPixel(pixelSize);
+    memset(opaquePixel.data(), 0, pixelSize);
+    memset(transparentPixel.data(), 0, pixelSize);
+
+    cs->setOpacity(opaquePixel.data(), OPACITY_OPAQUE_U8, 1);
+    cs->setOpacity(transparentPixel.data(), OPACITY_TRANSPARENT_U8, 1);
+
+    KisDataManagerSP dm = dataManager();
+    const QRect dmRect = rect.translated(-x(), -y());
+
+    const qint32 firstCol = divideRoundDown(dmRect.left(), dm->tileWidth());
+    const qint32 lastCol = divideRoundDown(dmRect.right(), dm->tileWidth());
+    const qint32 firstRow = divideRoundDown(dmRect.top(), dm->tileHeight());
+    const qint32 lastRow = divideRoundDown(dmRect.bottom(), dm->tileHeight());
+
+    KisTileOpacitySummary result = KisTileOpacitySummary::Unknown;
+
+    for (qint32 row = firstRow; row <= lastRow; row++) {
+        for (qint32 col = firstCol; col <= lastCol; col++) {
+            bool existingTile = false;
+            KisTileSP tile = dm->getReadOnlyTileLazy(col, row, existingTile);
+
+            tile->lockForRead();
+
+            KisTileData *td = tile->tileData();
+
+            int cookie = 0;
+            KisTileOpacitySummary summary = td->cachedOpacitySummary(&cookie);
+
+            if (summary == KisTileOpacitySummary::Unknown) {
+                const int numPixels = td->width() * td->height();
+
+                switch (alphaSize) {
+                case 1:
+                    summary = calculateTileOpacitySummary<quint8>(tile->data(), numPixels, pixelSize, alphaOffset,
+                                                                  opaquePixel.constData(), transparentPixel.constData());
+                    break;
+                case 2:
+                    summary = calculateTileOpacitySummary<quint16>(tile->data(), numPixels, pixelSize, alphaOffset,
+                                                                   opaquePixel.constData(), transparentPixel.constData());
+                    break;
+                default:
+                    summary = calculateTileOpacitySummary<quint32>(tile->data(), numPixels, pixelSize, alphaOffset,
+                                                                   opaquePixel.constData(), transparentPixel.constData());
+                    break;
+                }
+
+                td->setCachedOpacitySummary(cookie, summary);
+            }
+
+            tile->unlockForRead();
+
+            if (result != KisTileOpacitySummary::Unknown && result != summary) {
+                return KisTileOpacitySummary::Mixed;
+            }
+
+            result = summary;
+        }
+    }
+
+    return result;
+}
+
 QRect KisPaintDevice::exactBounds() const
 {
     return m_d->cache()->exactBounds();
@@ -1525,11 +1762,11 @@ bool KisPaintDevice::write(KisPaintDeviceWriter &store)
     return m_d->dataManager()->write(store);
 }
 
-bool KisPaintDevice::read(QIODevice *stream)
+bool KisPaintDevice::read(QIODevice *stream, bool lazy)
 {
     bool retval;
 
-    retval = m_d->dataManager()->read(stream);
+    retval = m_d->dataManager()->read(stream, lazy);
     m_d->cache()->invalidate();
 
     return retval;
@@ -1550,6 +1787,11 @@ void KisPaintDevice::convertTo(const KoColorSpace * dstColorSpace, KoColorConver
     m_d->convertColorSpace(dstColorSpace, renderingIntent, conversionFlags, parentCommand);
 }
 
+void KisPaintDevice::convertTo(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand, QVector<KisRunnableStrokeJobData*> &jobs, KoUpdater *progressUpdater)
+{
+    m_d->convertColorSpaceInPatches(dstColorSpace, renderingIntent, conversionFlags, parentCommand, jobs, progressUpdater);
+}
+
 bool KisPaintDevice::setProfile(const KoColorProfile * profile, KUndo2Command *parentCommand)
 {
     return m_d->assignProfile(profile, parentCommand);
@@ -2208,12 +2450,12 @@ bool KisPaintDeviceFramesInterface::writeFrame(KisPaintDeviceWriter &store, int
     return q->m_d->writeFrame(store, frameId);
 }
 
-bool KisPaintDeviceFramesInterface::readFrame(QIODevice *stream, int frameId)
+bool KisPaintDeviceFramesInterface::readFrame(QIODevice *stream, int frameId, bool lazy)
 {
     KIS_ASSERT_RECOVER(frameId >= 0) {
         return false;
     }
-    return q->m_d->readFrame(stream, frameId);
+    return q->m_d->readFrame(stream, frameId, lazy);
 }
 
 int KisPaintDeviceFramesInterface::currentFrameId() const
@@ -30,10 +30,13 @@
 #include "kis_types.h"
 #include "kis_shared.h"
 #include "kis_default_bounds_base.h"
+#include "KisTileOpacitySummary.h"
 
 #include <kritaimage_export.h>
 
 class KUndo2Command;
+class KoUpdater;
+class KisRunnableStrokeJobData;
 class QRect;
 class QImage;
 class QPoint;
@@ -87,6 +90,17 @@ public:
      */
     explicit KisPaintDevice(const KoColorSpace * colorSpace, const QString& name = QString());
 
+    /**
+     * Create a new paint device with the specified colorspace and
+     * tiles of \p tileSize x \p tileSize pixels. Zero means the
+     * default tile size.
+     *
+     * @param colorSpace the colorspace of this paint device
+     * @param tileSize the size of the tiles, see KisTiledDataManager
+     * @param name for debugging purposes
+     */
+    KisPaintDevice(const KoColorSpace * colorSpace, qint32 tileSize, const QString& name = QString());
+
     /**
      * Create a new paint device with the specified colorspace. The
      * parent node will be notified of changes to this paint device.
@@ -132,8 +146,10 @@ public:
 
     /**
      * Fill this paint device with the pixels from the specified file store.
+     * When \p lazy is true, the tiles are unpacked only when they are
+     * accessed for the first time.
      */
-    bool read(QIODevice *stream);
+    bool read(QIODevice *stream, bool lazy = false);
 
 public:
 
@@ -249,6 +265,18 @@ public:
      */
     QRect nonDefaultPixelArea() const;
 
+    /**
+     * Returns the opacity summary of the tiles covering \p rect. The
+     * summary is conservative: it is calculated for the whole tiles,
+     * so KisTileOpacitySummary::Mixed may be returned even when all
+     * the pixels of \p rect are opaque.
+     *
+     * The per-tile summaries are cached in the tile data and reset on
+     * every write, so the call is cheap unless the device is being
+     * painted on.
+     */
+    KisTileOpacitySummary opacitySummary(const QRect &rect) const;
+
 
     /**
      * Returns a rough approximation of region covered by device.
@@ -489,6 +517,26 @@ public:
                    KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags(),
                    KUndo2Command *parentCommand = 0);
 
+    /**
+     * Converts the paint device to a different colorspace using stroke
+     * jobs. Concurrent jobs converting the device in patches and a sequential
+     * job switching the device to the converted data are appended to \p jobs.
+     *
+     * The device keeps its old color space until the final job is executed,
+     * so nobody should access it until the jobs are done.
+     *
+     * @param parentCommand the command that will own the undo information,
+     *        must not be null
+     * @param progressUpdater if not null, it will receive the progress of the
+     *        conversion, it must be alive until the jobs are done
+     */
+    void convertTo(const KoColorSpace * dstColorSpace,
+                   KoColorConversionTransformation::Intent renderingIntent,
+                   KoColorConversionTransformation::ConversionFlags conversionFlags,
+                   KUndo2Command *parentCommand,
+                   QVector<KisRunnableStrokeJobData*> &jobs,
+                   KoUpdater *progressUpdater = 0);
+
     /**
      * Changes the profile of the colorspace of this paint device to the given
      * profile. If the given profile is 0, nothing happens.
@@ -898,7 +946,8 @@ private:
     KisPaintDevice& operator=(const KisPaintDevice&);
     void init(const KoColorSpace *colorSpace,
               KisDefaultBoundsBaseSP defaultBounds,
-              KisNodeWSP parent, const QString& name);
+              KisNodeWSP parent, const QString& name,
+              qint32 tileSize = 0);
 
     // Only KisPainter is allowed to have access to these low-level methods
     friend class KisPainter;
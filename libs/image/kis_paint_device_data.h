@@ -22,6 +22,7 @@
 #include "KoAlwaysInline.h"
 #include "kundo2command.h"
 #include "kis_command_utils.h"
+#include "krita_utils.h"
 
 
 struct DirectDataAccessPolicy {
@@ -65,7 +66,7 @@ public:
     KisPaintDeviceData(KisPaintDevice *paintDevice, const KisPaintDeviceData *rhs, bool cloneContent)
         : m_dataManager(cloneContent ?
                         new KisDataManager(*rhs->m_dataManager) :
-                        new KisDataManager(rhs->m_dataManager->pixelSize(), rhs->m_dataManager->defaultPixel())),
+                        new KisDataManager(rhs->m_dataManager->pixelSize(), rhs->m_dataManager->defaultPixel(), rhs->m_dataManager->tileWidth())),
           m_cache(paintDevice),
           m_x(rhs->m_x),
           m_y(rhs->m_y),
@@ -148,6 +149,14 @@ public:
             ChangeProfileCommand::undo();
         }
 
+        KisDataManagerSP oldDataManager() const {
+            return m_oldDm;
+        }
+
+        KisDataManagerSP newDataManager() const {
+            return m_newDm;
+        }
+
     private:
         KisDataManagerSP m_oldDm;
         KisDataManagerSP m_newDm;
@@ -168,48 +177,61 @@ public:
         }
     }
 
-    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand) {
-        typedef KisSequentialIteratorBase<ReadOnlyIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialConstIterator;
-        typedef KisSequentialIteratorBase<WritableIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialIterator;
-
-        if (m_colorSpace == dstColorSpace || *m_colorSpace == *dstColorSpace) {
-            return;
-        }
-
-        QRect rc = m_dataManager->region().boundingRect();
-
+    KisDataManagerSP createConvertedDataManager(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags) const {
         const int dstPixelSize = dstColorSpace->pixelSize();
         QScopedArrayPointer<quint8> dstDefaultPixel(new quint8[dstPixelSize]);
         memset(dstDefaultPixel.data(), 0, dstPixelSize);
         m_colorSpace->convertPixelsTo(m_dataManager->defaultPixel(), dstDefaultPixel.data(), dstColorSpace, 1, renderingIntent, conversionFlags);
 
-        KisDataManagerSP dstDataManager = new KisDataManager(dstPixelSize, dstDefaultPixel.data());
+        return new KisDataManager(dstPixelSize, dstDefaultPixel.data(), m_dataManager->tileWidth());
+    }
+
+    /**
+     * Converts pixels of \p rc into \p dstDataManager. Different rects can
+     * be converted concurrently.
+     */
+    void convertDataRect(KisDataManagerSP srcDataManager, KisDataManagerSP dstDataManager, const QRect &rc,
+                         const KoColorSpace *srcColorSpace, const KoColorSpace *dstColorSpace,
+                         KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags) {
+        typedef KisSequentialIteratorBase<ReadOnlyIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialConstIterator;
+        typedef KisSequentialIteratorBase<WritableIteratorPolicy<DirectDataAccessPolicy>, DirectDataAccessPolicy> InternalSequentialIterator;
+
+        if (rc.isEmpty()) return;
 
+        InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(srcDataManager.data(), cacheInvalidator()), rc);
+        InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), cacheInvalidator()), rc);
 
-        if (!rc.isEmpty()) {
-            InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(m_dataManager.data(), cacheInvalidator()), rc);
-            InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), cacheInvalidator()), rc);
+        int nConseqPixels = srcIt.nConseqPixels();
 
-            int nConseqPixels = srcIt.nConseqPixels();
+        // since we are accessing data managers directly, the columns are always aligned
+        KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
 
-            // since we are accessing data managers directly, the columns are always aligned
-            KIS_SAFE_ASSERT_RECOVER_NOOP(srcIt.nConseqPixels() == dstIt.nConseqPixels());
+        while(srcIt.nextPixels(nConseqPixels) &&
+              dstIt.nextPixels(nConseqPixels)) {
 
-            while(srcIt.nextPixels(nConseqPixels) &&
-                  dstIt.nextPixels(nConseqPixels)) {
+            nConseqPixels = srcIt.nConseqPixels();
 
-                nConseqPixels = srcIt.nConseqPixels();
+            const quint8 *srcData = srcIt.rawDataConst();
+            quint8 *dstData = dstIt.rawData();
 
-                const quint8 *srcData = srcIt.rawDataConst();
-                quint8 *dstData = dstIt.rawData();
+            srcColorSpace->convertPixelsTo(srcData, dstData,
+                                           dstColorSpace,
+                                           nConseqPixels,
+                                           renderingIntent, conversionFlags);
+        }
+    }
 
-                m_colorSpace->convertPixelsTo(srcData, dstData,
-                                              dstColorSpace,
-                                              nConseqPixels,
-                                              renderingIntent, conversionFlags);
-            }
+    void convertDataColorSpace(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags, KUndo2Command *parentCommand) {
+        if (m_colorSpace == dstColorSpace || *m_colorSpace == *dstColorSpace) {
+            return;
         }
 
+        KisDataManagerSP dstDataManager = createConvertedDataManager(dstColorSpace, renderingIntent, conversionFlags);
+
+        convertDataRect(m_dataManager, dstDataManager, m_dataManager->region().boundingRect(),
+                        m_colorSpace, dstColorSpace,
+                        renderingIntent, conversionFlags);
+
         // becomes owned by the parent
         ChangeColorSpaceCommand *cmd =
             new ChangeColorSpaceCommand(this,
@@ -222,6 +244,30 @@ public:
         }
     }
 
+    /**
+     * Prepares conversion of the data that is split into \p patches
+     * and executed concurrently with convertDataRect(). The returned
+     * command is owned by \p parentCommand and is *not* executed: the
+     * caller should call forcedRedo() on it when all the patches are
+     * converted into its newDataManager(). Returns null if no conversion
+     * is needed.
+     */
+    ChangeColorSpaceCommand* prepareDataColorSpaceConversion(const KoColorSpace *dstColorSpace, KoColorConversionTransformation::Intent renderingIntent, KoColorConversionTransformation::ConversionFlags conversionFlags,
+                                                             const QSize &patchSize, QVector<QRect> *patches,
+                                                             KUndo2Command *parentCommand) {
+        if (m_colorSpace == dstColorSpace || *m_colorSpace == *dstColorSpace) {
+            return 0;
+        }
+
+        KisDataManagerSP dstDataManager = createConvertedDataManager(dstColorSpace, renderingIntent, conversionFlags);
+        *patches = KritaUtils::splitRegionIntoPatches(m_dataManager->region(), patchSize);
+
+        return new ChangeColorSpaceCommand(this,
+                                           m_dataManager, dstDataManager,
+                                           m_colorSpace, dstColorSpace,
+                                           parentCommand);
+    }
+
     void reincarnateWithDetachedHistory(bool copyContent, KUndo2Command *parentCommand) {
         struct SwitchDataManager : public KUndo2Command
         {
@@ -256,7 +302,7 @@ public:
                 KisDataManagerSP newDm =
                     copyContent ?
                     new KisDataManager(*this->dataManager()) :
-                    new KisDataManager(this->dataManager()->pixelSize(), this->dataManager()->defaultPixel());
+                    new KisDataManager(this->dataManager()->pixelSize(), this->dataManager()->defaultPixel(), this->dataManager()->tileWidth());
                 return new SwitchDataManager(this, this->dataManager(), newDm);
             });
     }
@@ -268,11 +314,13 @@ public:
         if (copyContent) {
             m_dataManager = new KisDataManager(*srcData->dataManager());
         } else if (m_dataManager->pixelSize() !=
-                   srcData->dataManager()->pixelSize()) {
+                   srcData->dataManager()->pixelSize() ||
+                   m_dataManager->tileWidth() !=
+                   srcData->dataManager()->tileWidth()) {
             // NOTE: we don't check default pixel value! it is the task of
             //       the higher level!
 
-            m_dataManager = new KisDataManager(srcData->dataManager()->pixelSize(), srcData->dataManager()->defaultPixel());
+            m_dataManager = new KisDataManager(srcData->dataManager()->pixelSize(), srcData->dataManager()->defaultPixel(), srcData->dataManager()->tileWidth());
             m_cache.setupCache();
         } else {
             m_dataManager->clear();
@@ -104,8 +104,10 @@ public:
      *
      * NOTE: the frame must be created manually with createFrame()
      *       beforehand!
+     *
+     * \see KisPaintDevice::read() for the meaning of \p lazy
      */
-    bool readFrame(QIODevice *stream, int frameId);
+    bool readFrame(QIODevice *stream, int frameId, bool lazy = false);
 
 
     /**
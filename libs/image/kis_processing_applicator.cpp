@@ -183,6 +183,7 @@ KisProcessingApplicator::KisProcessingApplicator(KisImageWSP image,
       m_node(node),
       m_flags(flags),
       m_emitSignals(emitSignals),
+      m_runnableJobsInterface(0),
       m_finalSignalsEmitted(false),
       m_sharedAllFramesToken(new bool(false))
 {
@@ -199,6 +200,10 @@ KisProcessingApplicator::KisProcessingApplicator(KisImageWSP image,
 
     strategy->setMacroId(macroId);
 
+    // the strategy is owned by the stroke, so the interface is valid
+    // while any of our jobs are running
+    m_runnableJobsInterface = strategy->runnableJobsInterface();
+
     m_strokeId = m_image->startStroke(strategy);
     if(!m_emitSignals.isEmpty()) {
         applyCommand(new EmitImageSignalsCommand(m_image, m_emitSignals, false), KisStrokeJobData::BARRIER);
@@ -224,6 +229,8 @@ void KisProcessingApplicator::applyVisitor(KisProcessingVisitorSP visitor,
                                            KisStrokeJobData::Sequentiality sequentiality,
                                            KisStrokeJobData::Exclusivity exclusivity)
 {
+    visitor->setRunnableJobsInterface(m_runnableJobsInterface);
+
     KUndo2Command *initCommand = visitor->createInitCommand();
     if (initCommand) {
         applyCommand(initCommand,
@@ -243,6 +250,8 @@ void KisProcessingApplicator::applyVisitorAllFrames(KisProcessingVisitorSP visit
                                                     KisStrokeJobData::Sequentiality sequentiality,
                                                     KisStrokeJobData::Exclusivity exclusivity)
 {
+    visitor->setRunnableJobsInterface(m_runnableJobsInterface);
+
     *m_sharedAllFramesToken = true;
 
     KUndo2Command *initCommand = visitor->createInitCommand();
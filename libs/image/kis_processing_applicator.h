@@ -27,6 +27,7 @@
 #include "kundo2magicstring.h"
 #include "kundo2commandextradata.h"
 
+class KisRunnableStrokeJobsInterface;
 
 class KRITAIMAGE_EXPORT KisProcessingApplicator
 {
@@ -104,6 +105,7 @@ private:
     ProcessingFlags m_flags;
     KisImageSignalVector m_emitSignals;
     KisStrokeId m_strokeId;
+    KisRunnableStrokeJobsInterface *m_runnableJobsInterface;
     bool m_finalSignalsEmitted;
     QSharedPointer<bool> m_sharedAllFramesToken;
 };
@@ -61,3 +61,13 @@ KUndo2Command *KisProcessingVisitor::createInitCommand()
 {
     return 0;
 }
+
+void KisProcessingVisitor::setRunnableJobsInterface(KisRunnableStrokeJobsInterface *interface)
+{
+    m_runnableJobsInterface = interface;
+}
+
+KisRunnableStrokeJobsInterface *KisProcessingVisitor::runnableJobsInterface() const
+{
+    return m_runnableJobsInterface;
+}
@@ -40,6 +40,7 @@ class KisSelectionMask;
 class KisGeneratorLayer;
 class KisColorizeMask;
 class KUndo2Command;
+class KisRunnableStrokeJobsInterface;
 
 /**
  * A visitor that processes a single layer; it does not recurse into the
@@ -71,6 +72,15 @@ public:
      */
     virtual KUndo2Command* createInitCommand();
 
+    /**
+     * Set the interface of the stroke the visitor is executed in. Visitors
+     * may use it to split heavy processing of a node into concurrent jobs.
+     * The interface is set by KisProcessingApplicator before the processing
+     * starts, so it may be null if the visitor is used outside an applicator.
+     */
+    void setRunnableJobsInterface(KisRunnableStrokeJobsInterface *interface);
+    KisRunnableStrokeJobsInterface* runnableJobsInterface() const;
+
 public:
     class KRITAIMAGE_EXPORT ProgressHelper {
     public:
@@ -82,6 +92,9 @@ public:
         KoProgressUpdater *m_progressUpdater;
         mutable QMutex m_progressMutex;
     };
+
+private:
+    KisRunnableStrokeJobsInterface *m_runnableJobsInterface = 0;
 };
 
 #endif /* __KIS_PROCESSING_VISITOR_H */
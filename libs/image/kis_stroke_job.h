@@ -21,6 +21,7 @@
 
 #include "kis_runnable_with_debug_name.h"
 #include "kis_stroke_job_strategy.h"
+#include "KisSchedulerTracer.h"
 
 class KisStrokeJob : public KisRunnableWithDebugName
 {
@@ -34,6 +35,8 @@ public:
           m_levelOfDetail(levelOfDetail),
           m_isOwnJob(isOwnJob)
     {
+        KisSchedulerTracer *tracer = KisSchedulerTracer::instance();
+        m_queuedTime = tracer->isEnabled() ? tracer->timestamp() : -1;
     }
 
     ~KisStrokeJob() override {
@@ -80,6 +83,14 @@ public:
         return m_dabStrategy->debugId();
     }
 
+    /**
+     * The time the job has been added to the stroke, as
+     * reported by KisSchedulerTracer, -1 if tracing is disabled
+     */
+    qint64 queuedTime() const {
+        return m_queuedTime;
+    }
+
 private:
     // for testing use only, do not use in real code
     friend QString getJobName(KisStrokeJob *job);
@@ -103,6 +114,7 @@ private:
 
     int m_levelOfDetail;
     bool m_isOwnJob;
+    qint64 m_queuedTime;
 };
 
 #endif /* __KIS_STROKE_JOB_H */
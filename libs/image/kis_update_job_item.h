@@ -29,6 +29,7 @@
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
 #include "kis_updater_context.h"
+#include "KisSchedulerTracer.h"
 
 //#define DEBUG_JOBS_SEQUENCE
 
@@ -76,12 +77,21 @@ public:
         while (1) {
             KIS_SAFE_ASSERT_RECOVER_RETURN(isRunning());
 
+            KisSchedulerTracer *tracer = KisSchedulerTracer::instance();
+            const bool tracingEnabled = tracer->isEnabled();
+            const qint64 lockRequestTime = tracingEnabled ? tracer->timestamp() : 0;
+
             if(m_exclusive) {
                 m_updaterContext->m_exclusiveJobLock.lockForWrite();
             } else {
                 m_updaterContext->m_exclusiveJobLock.lockForRead();
             }
 
+            KisSchedulerTracer::Event traceEvent;
+            if (tracingEnabled) {
+                initTraceEvent(traceEvent, lockRequestTime);
+            }
+
             if(m_atomicType == Type::MERGE) {
                 runMergeJob();
             } else {
@@ -103,6 +113,11 @@ public:
                 }
             }
 
+            if (tracingEnabled) {
+                traceEvent.duration = tracer->timestamp() - traceEvent.start;
+                tracer->recordEvent(traceEvent);
+            }
+
             setDone();
 
             m_updaterContext->doSomeUsefulWork();
@@ -138,6 +153,32 @@ public:
         m_updaterContext->continueUpdate(changeRect);
     }
 
+    inline void initTraceEvent(KisSchedulerTracer::Event &event, qint64 lockRequestTime) {
+        event.start = KisSchedulerTracer::instance()->timestamp();
+        event.lockWait = event.start - lockRequestTime;
+        event.exclusive = m_exclusive;
+
+        if (m_atomicType == Type::MERGE) {
+            event.type = KisSchedulerTracer::MergeJob;
+            event.levelOfDetail = m_walker ? m_walker->levelOfDetail() : 0;
+            event.changeRect = m_changeRect;
+        } else if (m_atomicType == Type::STROKE && m_runnableJob) {
+            KisStrokeJob *job = static_cast<KisStrokeJob*>(m_runnableJob);
+
+            event.type = KisSchedulerTracer::StrokeJob;
+            event.name = job->debugName();
+            event.levelOfDetail = job->levelOfDetail();
+            event.sequentiality = m_strokeJobSequentiality;
+            event.queueWait = job->queuedTime() >= 0 ? event.start - job->queuedTime() : -1;
+        } else if (m_runnableJob) {
+            KisSpontaneousJob *job = static_cast<KisSpontaneousJob*>(m_runnableJob);
+
+            event.type = KisSchedulerTracer::SpontaneousJob;
+            event.name = job->debugName();
+            event.levelOfDetail = job->levelOfDetail();
+        }
+    }
+
     // return true if the thread should actually be started
     inline bool setWalker(KisBaseRectsWalkerSP walker) {
         KIS_ASSERT(m_atomicType <= Type::WAITING);
@@ -29,6 +29,7 @@
 
 #include "kis_queues_progress_updater.h"
 #include "KisImageConfigNotifier.h"
+#include "KisSchedulerTracer.h"
 
 #include <QReadWriteLock>
 #include "kis_lazy_wait_condition.h"
@@ -115,6 +116,26 @@ int KisUpdateScheduler::threadsLimit() const
     return m_d->updaterContext.threadsLimit();
 }
 
+void KisUpdateScheduler::setUseWorkStealing(bool value)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!m_d->processingBlocked);
+
+    {
+        std::lock_guard<KisUpdaterContext> l(m_d->updaterContext);
+        if (m_d->updaterContext.useWorkStealing() == value) return;
+    }
+
+    /**
+     * The same as with setThreadsLimit(), we should just ensure
+     * there are no jobs in the updater context.
+     */
+    lock();
+    m_d->updaterContext.lock();
+    m_d->updaterContext.setUseWorkStealing(value);
+    m_d->updaterContext.unlock();
+    unlock(false);
+}
+
 void KisUpdateScheduler::connectSignals()
 {
     connect(KisImageConfigNotifier::instance(), SIGNAL(configChanged()),
@@ -307,6 +328,8 @@ void KisUpdateScheduler::updateSettings()
     KisImageConfig config(true);
     m_d->defaultBalancingRatio = config.schedulerBalancingRatio();
     setThreadsLimit(config.maxNumberOfThreads());
+    setUseWorkStealing(config.useWorkStealingScheduler());
+    KisSchedulerTracer::instance()->updateSettings();
 }
 
 void KisUpdateScheduler::lock()
@@ -52,6 +52,13 @@ public:
      */
     int threadsLimit() const;
 
+    /**
+     * Switch the updater context to the work-stealing executor
+     *
+     * \see KisUpdaterContext::setUseWorkStealing()
+     */
+    void setUseWorkStealing(bool value);
+
     /**
      * Sets the proxy that is going to be notified about the progress
      * of processing of the queues. If you want to switch the proxy
@@ -25,6 +25,7 @@
 #include "kis_stroke_job.h"
 
 const int KisUpdaterContext::useIdealThreadCountTag = -1;
+const int KisUpdaterContext::workStealingJobsPerThread = 2;
 
 KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
     : QObject(parent), m_scheduler(qobject_cast<KisUpdateScheduler *>(parent))
@@ -34,12 +35,28 @@ KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
         threadCount = threadCount > 0 ? threadCount : 1;
     }
 
+    /**
+     * Only the merge jobs can be stolen. Every job has been checked with
+     * isJobAllowed() before entering the context, and a queued job item
+     * is "running" for all the later checks, so a queued merge job never
+     * intersects with any running or queued one (see walkerIntersectsJob()).
+     * Its walker and rects don't change until it is executed, so it is
+     * safe to run it on any worker, and checking the intersection once
+     * again here would need m_lock, which the producer holds while
+     * pushing the jobs. Stroke and spontaneous jobs stay on the worker
+     * they were queued to, in the order they were queued in.
+     */
+    m_workStealingExecutor.setStealingFilter(
+        [] (QRunnable *job) {
+            return static_cast<KisUpdateJobItem*>(job)->type() == KisUpdateJobItem::Type::MERGE;
+        });
+
     setThreadsLimit(threadCount);
 }
 
 KisUpdaterContext::~KisUpdaterContext()
 {
-    m_threadPool.waitForDone();
+    waitForDone();
     for(qint32 i = 0; i < m_jobs.size(); i++)
         delete m_jobs[i];
 }
@@ -144,7 +161,7 @@ void KisUpdaterContext::addMergeJob(KisBaseRectsWalkerSP walker)
     // it might happen that we call this function from within
     // the thread itself, right when it finished its work
     if (shouldStartThread) {
-        m_threadPool.start(m_jobs[jobIndex]);
+        startJob(m_jobs[jobIndex]);
     }
 }
 
@@ -174,7 +191,7 @@ void KisUpdaterContext::addStrokeJob(KisStrokeJob *strokeJob)
     // it might happen that we call this function from within
     // the thread itself, right when it finished its work
     if (shouldStartThread) {
-        m_threadPool.start(m_jobs[jobIndex]);
+        startJob(m_jobs[jobIndex]);
     }
 }
 
@@ -204,7 +221,7 @@ void KisUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneousJob)
     // it might happen that we call this function from within
     // the thread itself, right when it finished its work
     if (shouldStartThread) {
-        m_threadPool.start(m_jobs[jobIndex]);
+        startJob(m_jobs[jobIndex]);
     }
 }
 
@@ -226,6 +243,7 @@ void KisUpdaterContext::addSpontaneousJobTest(KisSpontaneousJob *spontaneousJob)
 void KisUpdaterContext::waitForDone()
 {
     m_threadPool.waitForDone();
+    m_workStealingExecutor.waitForDone();
 }
 
 bool KisUpdaterContext::walkerIntersectsJob(KisBaseRectsWalkerSP walker,
@@ -244,6 +262,15 @@ qint32 KisUpdaterContext::findSpareThread()
     return -1;
 }
 
+void KisUpdaterContext::startJob(KisUpdateJobItem *job)
+{
+    if (m_useWorkStealing) {
+        m_workStealingExecutor.start(job);
+    } else {
+        m_threadPool.start(job);
+    }
+}
+
 void KisUpdaterContext::lock()
 {
     m_lock.lock();
@@ -256,18 +283,20 @@ void KisUpdaterContext::unlock()
 
 void KisUpdaterContext::setThreadsLimit(int value)
 {
-    m_threadPool.setMaxThreadCount(value);
-
     for (int i = 0; i < m_jobs.size(); i++) {
         KIS_SAFE_ASSERT_RECOVER_RETURN(!m_jobs[i]->isRunning());
         // don't delete the jobs until all of them are checked!
     }
 
+    m_threadsLimit = value;
+    m_threadPool.setMaxThreadCount(value);
+    m_workStealingExecutor.setMaxThreadCount(m_useWorkStealing ? value : 0);
+
     for (int i = 0; i < m_jobs.size(); i++) {
         delete m_jobs[i];
     }
 
-    m_jobs.resize(value);
+    m_jobs.resize(m_useWorkStealing ? value * workStealingJobsPerThread : value);
 
     for(qint32 i = 0; i < m_jobs.size(); i++) {
         m_jobs[i] = new KisUpdateJobItem(this);
@@ -276,8 +305,25 @@ void KisUpdaterContext::setThreadsLimit(int value)
 
 int KisUpdaterContext::threadsLimit() const
 {
-    KIS_SAFE_ASSERT_RECOVER_NOOP(m_jobs.size() == m_threadPool.maxThreadCount());
-    return m_jobs.size();
+    KIS_SAFE_ASSERT_RECOVER_NOOP(m_threadsLimit == m_threadPool.maxThreadCount());
+    return m_threadsLimit;
+}
+
+void KisUpdaterContext::setUseWorkStealing(bool value)
+{
+    if (m_useWorkStealing == value) return;
+
+    for (int i = 0; i < m_jobs.size(); i++) {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(!m_jobs[i]->isRunning());
+    }
+
+    m_useWorkStealing = value;
+    setThreadsLimit(m_threadsLimit);
+}
+
+bool KisUpdaterContext::useWorkStealing() const
+{
+    return m_useWorkStealing;
 }
 
 void KisUpdaterContext::continueUpdate(const QRect& rc)
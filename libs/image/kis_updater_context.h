@@ -27,6 +27,7 @@
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
 #include "kis_lock_free_lod_counter.h"
+#include "KisWorkStealingExecutor.h"
 
 #include "KisUpdaterContextSnapshotEx.h"
 #include "kis_update_scheduler.h"
@@ -41,6 +42,13 @@ class KRITAIMAGE_EXPORT KisUpdaterContext : public QObject
 public:
     static const int useIdealThreadCountTag;
 
+    /**
+     * The number of job slots per thread when the work-stealing
+     * executor is used. The extra slots let the workers pick up
+     * the next job without waiting for the scheduler.
+     */
+    static const int workStealingJobsPerThread;
+
 public:
     KisUpdaterContext(qint32 threadCount = useIdealThreadCountTag, QObject *parent = 0);
     ~KisUpdaterContext() override;
@@ -64,7 +72,9 @@ public:
 
     /**
      * Check whether there is a spare thread for running
-     * one more job
+     * one more job. When the work-stealing executor is used,
+     * a spare slot may mean that the job will be queued behind
+     * another one and picked up by the first worker that gets idle.
      */
     bool hasSpareThread();
 
@@ -139,6 +149,21 @@ public:
      */
     int threadsLimit() const;
 
+    /**
+     * Switch between the default QThreadPool-based executor and
+     * KisWorkStealingExecutor. The same preconditions as for
+     * setThreadsLimit() apply.
+     *
+     * In the work-stealing mode the context has workStealingJobsPerThread
+     * job slots per thread. Every job added to the context has already
+     * been checked with isJobAllowed(), that is, it doesn't intersect
+     * with any other running or queued job (see walkerIntersectsJob()),
+     * therefore the queued merge jobs can be stolen by any worker. The
+     * other jobs are executed by the worker they were queued to.
+     */
+    void setUseWorkStealing(bool value);
+    bool useWorkStealing() const;
+
     void continueUpdate(const QRect& rc);
     void doSomeUsefulWork();
     void jobFinished();
@@ -147,6 +172,7 @@ protected:
     static bool walkerIntersectsJob(KisBaseRectsWalkerSP walker,
                                     const KisUpdateJobItem* job);
     qint32 findSpareThread();
+    void startJob(KisUpdateJobItem *job);
 
 protected:
     /**
@@ -160,6 +186,9 @@ protected:
     QMutex m_lock;
     QVector<KisUpdateJobItem*> m_jobs;
     QThreadPool m_threadPool;
+    KisWorkStealingExecutor m_workStealingExecutor;
+    bool m_useWorkStealing = false;
+    int m_threadsLimit = 0;
     KisLockFreeLodCounter m_lodCounter;
     KisUpdateScheduler *m_scheduler;
 
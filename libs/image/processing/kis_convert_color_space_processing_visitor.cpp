@@ -32,6 +32,9 @@
 #include "kis_time_range.h"
 #include <commands_new/KisChangeChannelFlagsCommand.h>
 #include <commands_new/KisChangeChannelLockFlagsCommand.h>
+#include "KisRunnableStrokeJobData.h"
+#include "KisRunnableStrokeJobUtils.h"
+#include "KisRunnableStrokeJobsInterface.h"
 
 
 KisConvertColorSpaceProcessingVisitor::KisConvertColorSpaceProcessingVisitor(const KoColorSpace *srcColorSpace,
@@ -74,17 +77,42 @@ void KisConvertColorSpaceProcessingVisitor::visitNodeWithPaintDevice(KisNode *no
         }
     }
 
+    // original, paint device and projection are often the same device
+    const QVector<KisPaintDeviceSP> layerDevices({layer->original(), layer->paintDevice(), layer->projection()});
 
-    if (layer->original()) {
-        layer->original()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+    QVector<KisPaintDeviceSP> devices;
+    Q_FOREACH (KisPaintDeviceSP device, layerDevices) {
+        if (device && !devices.contains(device)) {
+            devices << device;
+        }
     }
 
-    if (layer->paintDevice()) {
-        layer->paintDevice()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
-    }
+    KisRunnableStrokeJobsInterface *jobsInterface = runnableJobsInterface();
 
-    if (layer->projection()) {
-        layer->projection()->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+    /**
+     * When converted in jobs, the layer keeps the old color space until the
+     * jobs are finished, so the channel flags cannot be restored right after
+     * the conversion. Such layers are rare, so just convert them in place.
+     */
+    if (jobsInterface && !alphaDisabled && !alphaLock) {
+        QSharedPointer<ProgressHelper> progressHelper(new ProgressHelper(node));
+        QVector<KisRunnableStrokeJobData*> jobs;
+
+        Q_FOREACH (KisPaintDeviceSP device, devices) {
+            device->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags,
+                              parentConversionCommand, jobs, progressHelper->updater());
+        }
+
+        // the progress updaters should be alive until all the jobs are done
+        KritaUtils::addJobSequential(jobs, [progressHelper] () {
+            Q_UNUSED(progressHelper);
+        });
+
+        jobsInterface->addRunnableJobs(jobs);
+    } else {
+        Q_FOREACH (KisPaintDeviceSP device, devices) {
+            device->convertTo(m_dstColorSpace, m_renderingIntent, m_conversionFlags, parentConversionCommand);
+        }
     }
 
     if (layer && alphaDisabled) {
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KisSchedulerTracerTest.h"
+
+#include <QTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <KoColorSpaceRegistry.h>
+
+#include "KisSchedulerTracer.h"
+#include "kis_updater_context.h"
+#include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_paint_device.h"
+
+#include "scheduler_utils.h"
+
+
+void KisSchedulerTracerTest::init()
+{
+    KisSchedulerTracer::instance()->clear();
+    KisSchedulerTracer::instance()->setEnabled(true);
+}
+
+void KisSchedulerTracerTest::cleanup()
+{
+    KisSchedulerTracer::instance()->setEnabled(false);
+    KisSchedulerTracer::instance()->clear();
+}
+
+void KisSchedulerTracerTest::testStrokeJobs()
+{
+    KisUpdaterContext context(2);
+    QScopedPointer<KisStrokeJobStrategy> strategy(new KisNoopDabStrategy("dab"));
+
+    context.lock();
+    context.addStrokeJob(new KisStrokeJob(strategy.data(),
+                                          new KisStrokeJobData(KisStrokeJobData::CONCURRENT),
+                                          1, true));
+    context.unlock();
+
+    context.waitForDone();
+
+    QVector<KisSchedulerTracer::Event> events = KisSchedulerTracer::instance()->events();
+    QCOMPARE(events.size(), 1);
+
+    const KisSchedulerTracer::Event &event = events.first();
+    QCOMPARE(event.type, KisSchedulerTracer::StrokeJob);
+    QCOMPARE(event.name, QString("KisNoopDabStrategy"));
+    QCOMPARE(event.levelOfDetail, 1);
+    QCOMPARE(event.sequentiality, int(KisStrokeJobData::CONCURRENT));
+    QVERIFY(!event.exclusive);
+    QVERIFY(event.queueWait >= 0);
+    QVERIFY(event.duration >= 0);
+}
+
+void KisSchedulerTracerTest::testMergeJobs()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 200, 200, cs, "tracer test");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+    image->addNode(layer, image->rootLayer());
+    image->waitForDone();
+
+    // the scheduler of the new image has re-read the config
+    KisSchedulerTracer::instance()->setEnabled(true);
+    KisSchedulerTracer::instance()->clear();
+
+    image->refreshGraphAsync();
+    image->waitForDone();
+
+    bool hasMergeJob = false;
+
+    Q_FOREACH (const KisSchedulerTracer::Event &event, KisSchedulerTracer::instance()->events()) {
+        if (event.type == KisSchedulerTracer::MergeJob) {
+            QVERIFY(!event.changeRect.isEmpty());
+            QVERIFY(image->bounds().contains(event.changeRect));
+            QCOMPARE(event.queueWait, qint64(-1));
+            hasMergeJob = true;
+        }
+    }
+
+    QVERIFY(hasMergeJob);
+}
+
+void KisSchedulerTracerTest::testRingBufferOverflow()
+{
+    KisSchedulerTracer *tracer = KisSchedulerTracer::instance();
+    const int numExtraEvents = 10;
+
+    for (int i = 0; i < KisSchedulerTracer::eventsPerThread + numExtraEvents; i++) {
+        KisSchedulerTracer::Event event;
+        event.name = "overflow";
+        event.start = i;
+        tracer->recordEvent(event);
+    }
+
+    QVector<KisSchedulerTracer::Event> events;
+    Q_FOREACH (const KisSchedulerTracer::Event &event, tracer->events()) {
+        if (event.name == "overflow") {
+            events << event;
+        }
+    }
+
+    QCOMPARE(events.size(), KisSchedulerTracer::eventsPerThread);
+    QCOMPARE(events.first().start, qint64(numExtraEvents));
+    QCOMPARE(events.last().start, qint64(KisSchedulerTracer::eventsPerThread + numExtraEvents - 1));
+}
+
+void KisSchedulerTracerTest::testChromeTraceExport()
+{
+    KisSchedulerTracer *tracer = KisSchedulerTracer::instance();
+
+    KisSchedulerTracer::Event event;
+    event.type = KisSchedulerTracer::MergeJob;
+    event.start = 100;
+    event.duration = 50;
+    event.changeRect = QRect(0, 0, 64, 64);
+    tracer->recordEvent(event);
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(tracer->chromeTraceJson(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    QJsonArray traceEvents = doc.object()["traceEvents"].toArray();
+
+    bool hasThreadName = false;
+    bool hasMergeEvent = false;
+
+    Q_FOREACH (const QJsonValue &value, traceEvents) {
+        QJsonObject object = value.toObject();
+
+        if (object["ph"].toString() == "M") {
+            hasThreadName |= object["name"].toString() == "thread_name";
+        } else if (object["ph"].toString() == "X") {
+            QCOMPARE(object["cat"].toString(), QString("merge"));
+            QCOMPARE(object["ts"].toDouble(), 100.0);
+            QCOMPARE(object["dur"].toDouble(), 50.0);
+            QCOMPARE(object["args"].toObject()["changeRect"].toString(), QString("0,0 64x64"));
+            hasMergeEvent = true;
+        }
+    }
+
+    QVERIFY(hasThreadName);
+    QVERIFY(hasMergeEvent);
+}
+
+QTEST_MAIN(KisSchedulerTracerTest)
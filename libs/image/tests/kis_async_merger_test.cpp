@@ -33,6 +33,7 @@
 #include "kis_filter_mask.h"
 #include "kis_selection.h"
 #include "kis_paint_device_debug_utils.h"
+#include "kis_painter.h"
 #include <KisGlobalResourcesInterface.h>
 
 #include "filter/kis_filter.h"
@@ -508,6 +509,93 @@ void KisAsyncMergerTest::testFilterMaskOnFilterLayer()
                                   "async_merger_test", "mask_on_adj", "initial", 3));
 }
 
+struct FusedLayerInfo {
+    QRect fillRect;
+    QColor color;
+    QString compositeOpId;
+    quint8 opacity;
+    QPoint offset;
+};
+
+void testFusedCompositionImpl(const QVector<FusedLayerInfo> &layers)
+{
+    const QRect imageRect = QRect(0, 0, 200, 150);
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), colorSpace, "fused composition test");
+
+    KisPaintDeviceSP referenceDevice = new KisPaintDevice(colorSpace);
+
+    int index = 0;
+    Q_FOREACH (const FusedLayerInfo &info, layers) {
+        KisPaintDeviceSP device = new KisPaintDevice(colorSpace);
+        device->fill(info.fillRect, KoColor(info.color, colorSpace));
+
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("paint%1").arg(index++), info.opacity, device);
+        layer->setCompositeOpId(info.compositeOpId);
+        layer->setX(info.offset.x());
+        layer->setY(info.offset.y());
+        image->addNode(layer, image->rootLayer());
+
+        const QRect rc = imageRect & device->extent();
+
+        KisPainter gc(referenceDevice);
+        gc.setCompositeOp(info.compositeOpId);
+        gc.setOpacity(info.opacity);
+        gc.bitBlt(rc.topLeft(), device, rc);
+    }
+
+    KisFullRefreshWalker walker(imageRect);
+    KisAsyncMerger merger;
+
+    walker.collectRects(image->rootLayer(), imageRect);
+    merger.startMerge(walker);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, image->projection(), referenceDevice));
+}
+
+void KisAsyncMergerTest::testFusedComposition()
+{
+    const QRect imageRect = QRect(0, 0, 200, 150);
+
+    /**
+     * The layers with non-trivial opacity split the stack into several
+     * fused batches, and non-tile-aligned offsets make the tiles of the
+     * sources and the projection misaligned
+     */
+    QVector<FusedLayerInfo> layers;
+    layers << FusedLayerInfo{imageRect, QColor(240, 230, 220, 255), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+    layers << FusedLayerInfo{QRect(10, 20, 100, 90), QColor(255, 0, 0, 128), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint(13, 7)};
+    layers << FusedLayerInfo{QRect(50, 0, 120, 140), QColor(80, 120, 250, 200), COMPOSITE_MULT, OPACITY_OPAQUE_U8, QPoint(-5, 3)};
+    layers << FusedLayerInfo{QRect(0, 60, 200, 40), QColor(0, 255, 0, 255), COMPOSITE_OVER, 128, QPoint()};
+    layers << FusedLayerInfo{QRect(70, 30, 64, 64), QColor(20, 200, 100, 100), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint(1, 1)};
+    layers << FusedLayerInfo{QRect(0, 0, 150, 150), QColor(200, 200, 0, 180), COMPOSITE_MULT, OPACITY_OPAQUE_U8, QPoint(33, 0)};
+    layers << FusedLayerInfo{QRect(100, 100, 90, 40), QColor(0, 0, 0, 60), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+
+    testFusedCompositionImpl(layers);
+}
+
+void KisAsyncMergerTest::testFusedCompositionOcclusion()
+{
+    /**
+     * The opaque layer covers some of the tiles completely, so the
+     * layers below it are skipped there, and some tiles only partially
+     * and misaligned, so they are composited as usual
+     */
+    QVector<FusedLayerInfo> layers;
+    layers << FusedLayerInfo{QRect(0, 0, 200, 150), QColor(240, 230, 220, 255), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+    layers << FusedLayerInfo{QRect(10, 20, 180, 90), QColor(255, 0, 0, 128), COMPOSITE_MULT, OPACITY_OPAQUE_U8, QPoint()};
+    layers << FusedLayerInfo{QRect(0, 0, 128, 128), QColor(10, 20, 30, 255), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+    layers << FusedLayerInfo{QRect(0, 0, 64, 64), QColor(0, 0, 255, 255), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint(100, 70)};
+    layers << FusedLayerInfo{QRect(30, 30, 100, 100), QColor(20, 200, 100, 100), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+
+    // fully transparent, but allocated areas
+    layers << FusedLayerInfo{QRect(0, 0, 128, 64), QColor(200, 200, 0, 0), COMPOSITE_OVER, OPACITY_OPAQUE_U8, QPoint()};
+    layers << FusedLayerInfo{QRect(64, 0, 128, 128), QColor(100, 150, 200, 0), COMPOSITE_MULT, OPACITY_OPAQUE_U8, QPoint()};
+
+    testFusedCompositionImpl(layers);
+}
+
 
 QTEST_MAIN(KisAsyncMergerTest)
 
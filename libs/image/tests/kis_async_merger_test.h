@@ -41,6 +41,9 @@ private Q_SLOTS:
 
     void testFilterMaskOnFilterLayer();
 
+    void testFusedComposition();
+    void testFusedCompositionOcclusion();
+
 };
 
 #endif /* KIS_ASYNC_MERGER_TEST_H */
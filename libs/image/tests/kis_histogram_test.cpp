@@ -19,6 +19,8 @@
 #include "kis_histogram_test.h"
 
 #include <QTest>
+#include <QSignalSpy>
+#include <numeric>
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <KoHistogramProducer.h>
@@ -26,6 +28,9 @@
 #include "kis_histogram.h"
 #include "kis_paint_layer.h"
 #include "kis_types.h"
+#include "kis_image.h"
+#include "KisIncrementalHistogram.h"
+#include "kis_iterator_ng.h"
 #include "kistest.h"
 
 void KisHistogramTest::testCreation()
@@ -46,5 +51,121 @@ void KisHistogramTest::testCreation()
     }
 }
 
+KisIncrementalHistogram::HistVector calculateReferenceHistogram(KisPaintDeviceSP dev, const QRect &rc)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+    KisIncrementalHistogram::HistVector bins(cs->channelCount(), std::vector<quint32>(256, 0));
+
+    KisSequentialConstIterator it(dev, rc);
+    while (it.nextPixel()) {
+        if (cs->opacityU8(it.rawDataConst()) == OPACITY_TRANSPARENT_U8) continue;
+
+        for (int chan = 0; chan < int(cs->channelCount()); chan++) {
+            bins[chan][cs->scaleToU8(it.rawDataConst(), chan)]++;
+        }
+    }
+
+    return bins;
+}
+
+void KisHistogramTest::testIncrementalHistogram()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    const QRect bounds(0, 0, 500, 300);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(bounds, KoColor(Qt::white, cs));
+    dev->fill(QRect(10, 20, 200, 100), KoColor(QColor(10, 100, 200), cs));
+
+    KisIncrementalHistogramSP histogram = new KisIncrementalHistogram();
+    QVERIFY(histogram->hasDirtyCells());
+
+    histogram->updateSynchronously(dev, bounds);
+    QVERIFY(!histogram->hasDirtyCells());
+    QCOMPARE(histogram->colorSpace(), cs);
+    QVERIFY(histogram->histogram() == calculateReferenceHistogram(dev, bounds));
+
+    // only the cells under the dirty rect are recalculated
+    const QRect dirtyRect(300, 150, 70, 90);
+    dev->fill(dirtyRect, KoColor(QColor(255, 0, 0, 128), cs));
+    histogram->addDirtyRect(dirtyRect);
+    QVERIFY(histogram->hasDirtyCells());
+
+    histogram->updateSynchronously(dev, bounds);
+    QVERIFY(histogram->histogram() == calculateReferenceHistogram(dev, bounds));
+
+    // changed bounds reset the histogram
+    const QRect newBounds(0, 0, 400, 250);
+    histogram->updateSynchronously(dev, newBounds);
+    QVERIFY(histogram->histogram() == calculateReferenceHistogram(dev, newBounds));
+
+    // fully transparent tiles are not counted
+    KisPaintDeviceSP emptyDev = new KisPaintDevice(cs);
+    histogram->invalidateAll();
+    histogram->updateSynchronously(emptyDev, bounds);
+
+    KisIncrementalHistogram::HistVector result = histogram->histogram();
+    QCOMPARE(int(result.size()), int(cs->channelCount()));
+    Q_FOREACH (const std::vector<quint32> &channel, result) {
+        QCOMPARE(std::accumulate(channel.begin(), channel.end(), quint32(0)), quint32(0));
+    }
+}
+
+void KisHistogramTest::testIncrementalHistogramOnUpdaterThreads()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect bounds(0, 0, 1000, 700);
+
+    KisImageSP image = new KisImage(0, bounds.width(), bounds.height(), cs, "histogram test");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(bounds, KoColor(QColor(30, 40, 50), cs));
+    dev->fill(QRect(100, 100, 600, 300), KoColor(QColor(200, 100, 0), cs));
+
+    KisIncrementalHistogramSP histogram = new KisIncrementalHistogram();
+    QSignalSpy spy(histogram.data(), SIGNAL(sigHistogramUpdated()));
+
+    histogram->startUpdate(image, dev, bounds);
+    image->waitForDone();
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(histogram->histogram() == calculateReferenceHistogram(dev, bounds));
+
+    // modify a copy, the way the histogram docker does
+    KisPaintDeviceSP copy = new KisPaintDevice(*dev);
+    const QRect dirtyRect(650, 350, 200, 200);
+    copy->fill(dirtyRect, KoColor(QColor(0, 255, 0), cs));
+    histogram->addDirtyRect(dirtyRect);
+
+    histogram->startUpdate(image, copy, bounds);
+    image->waitForDone();
+
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(histogram->histogram() == calculateReferenceHistogram(copy, bounds));
+}
+
+void KisHistogramTest::testIncrementalHistogramTileAlignment()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect bounds(0, 0, 600, 400);
+
+    auto calculateHistogram = [cs, bounds] (const QPoint &offset) {
+        KisPaintDeviceSP dev = new KisPaintDevice(cs);
+        dev->fill(QRect(offset, QSize(100, 70)), KoColor(QColor(10, 100, 200), cs));
+        dev->fill(QRect(offset + QPoint(30, 40), QSize(90, 50)), KoColor(QColor(255, 0, 0, 128), cs));
+
+        KisIncrementalHistogramSP histogram = new KisIncrementalHistogram();
+        histogram->updateSynchronously(dev, bounds);
+
+        return histogram->histogram();
+    };
+
+    // the same content must give the same histogram wherever it is placed
+    const KisIncrementalHistogram::HistVector aligned = calculateHistogram(QPoint(64, 64));
+    QVERIFY(aligned == calculateHistogram(QPoint(0, 0)));
+    QVERIFY(aligned == calculateHistogram(QPoint(37, 13)));
+    QVERIFY(aligned == calculateHistogram(QPoint(250, 301)));
+}
+
 
 KISTEST_MAIN(KisHistogramTest)
@@ -27,6 +27,9 @@ class KisHistogramTest : public QObject
 private Q_SLOTS:
 
     void testCreation();
+    void testIncrementalHistogram();
+    void testIncrementalHistogramOnUpdaterThreads();
+    void testIncrementalHistogramTileAlignment();
 
 };
 
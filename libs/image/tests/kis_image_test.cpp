@@ -197,6 +197,61 @@ void KisImageTest::testConvertImageColorSpace()
     image->refreshGraph();
 }
 
+void KisImageTest::testConvertImageColorSpaceInPatches()
+{
+    // the content spans several conversion patches
+    TestUtil::MaskParent p(QRect(0, 0, 1200, 900));
+
+    const KoColorSpace *cs8 = p.image->colorSpace();
+    const KoColorSpace *lab16 = KoColorSpaceRegistry::instance()->lab16();
+
+    p.layer->paintDevice()->fill(QRect(10, 20, 1100, 800), KoColor(QColor(200, 100, 50, 180), cs8));
+    p.layer->paintDevice()->fill(QRect(700, 300, 400, 500), KoColor(QColor(10, 220, 150, 255), cs8));
+
+    // alpha locked layers are converted in place when the model changes
+    KisPaintLayerSP lockedLayer = new KisPaintLayer(p.image, "locked", OPACITY_OPAQUE_U8);
+    lockedLayer->paintDevice()->fill(QRect(100, 100, 700, 600), KoColor(QColor(20, 30, 240, 128), cs8));
+    lockedLayer->setAlphaLocked(true);
+    p.image->addNode(lockedLayer, p.image->root());
+
+    p.image->refreshGraph();
+
+    KisPaintDeviceSP originalDevice = new KisPaintDevice(*p.layer->paintDevice());
+    KisPaintDeviceSP originalLockedDevice = new KisPaintDevice(*lockedLayer->paintDevice());
+
+    KisPaintDeviceSP refDevice = new KisPaintDevice(*originalDevice);
+    refDevice->convertTo(lab16);
+
+    KisPaintDeviceSP refLockedDevice = new KisPaintDevice(*originalLockedDevice);
+    refLockedDevice->convertTo(lab16);
+
+    p.image->convertImageColorSpace(lab16,
+                                    KoColorConversionTransformation::internalRenderingIntent(),
+                                    KoColorConversionTransformation::internalConversionFlags());
+    p.image->waitForDone();
+
+    QPoint pt;
+
+    QVERIFY(*lab16 == *p.image->colorSpace());
+    QVERIFY(*lab16 == *p.layer->colorSpace());
+    QVERIFY(*lab16 == *lockedLayer->colorSpace());
+    QVERIFY(*lab16 == *p.image->root()->projection()->colorSpace());
+    QVERIFY(lockedLayer->alphaLocked());
+
+    QVERIFY(TestUtil::comparePaintDevices(pt, refDevice, p.layer->paintDevice()));
+    QVERIFY(TestUtil::comparePaintDevices(pt, refLockedDevice, lockedLayer->paintDevice()));
+
+    p.undoStore->undo();
+    p.image->waitForDone();
+
+    QVERIFY(*cs8 == *p.layer->colorSpace());
+    QVERIFY(*cs8 == *lockedLayer->colorSpace());
+    QVERIFY(lockedLayer->alphaLocked());
+
+    QVERIFY(TestUtil::comparePaintDevices(pt, originalDevice, p.layer->paintDevice()));
+    QVERIFY(TestUtil::comparePaintDevices(pt, originalLockedDevice, lockedLayer->paintDevice()));
+}
+
 void KisImageTest::testAssignImageProfile()
 {
     const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
@@ -32,6 +32,7 @@ private Q_SLOTS:
     void benchmarkCreation();
     void testBlockLevelOfDetail();
     void testConvertImageColorSpace();
+    void testConvertImageColorSpaceInPatches();
     void testAssignImageProfile();
     void testGlobalSelection();
     void testCloneImage();
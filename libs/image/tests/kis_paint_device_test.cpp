@@ -2285,6 +2285,94 @@ void KisPaintDeviceTest::testCompositionAssociativity()
     }
 }
 
+void KisPaintDeviceTest::testOpacitySummary()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect tileRect(0, 0, 64, 64);
+    const QRect twoTilesRect(0, 0, 128, 64);
+
+    // default tiles are transparent
+    QCOMPARE(dev->opacitySummary(tileRect), KisTileOpacitySummary::Transparent);
+
+    dev->fill(tileRect, KoColor(Qt::red, cs));
+    QCOMPARE(dev->opacitySummary(tileRect), KisTileOpacitySummary::Opaque);
+    QCOMPARE(dev->opacitySummary(QRect(10, 10, 5, 5)), KisTileOpacitySummary::Opaque);
+    QCOMPARE(dev->opacitySummary(twoTilesRect), KisTileOpacitySummary::Mixed);
+
+    // the cached summary must be reset by a write
+    {
+        KisRandomAccessorSP it = dev->createRandomAccessorNG();
+        it->moveTo(20, 20);
+        cs->setOpacity(it->rawData(), quint8(254), 1);
+    }
+    QCOMPARE(dev->opacitySummary(tileRect), KisTileOpacitySummary::Mixed);
+
+    // almost opaque is not opaque
+    dev->clear();
+    KoColor almostOpaque(Qt::red, cs);
+    reinterpret_cast<quint16*>(almostOpaque.data())[3] = 0xFFFE;
+    dev->fill(tileRect, almostOpaque);
+    QCOMPARE(dev->opacitySummary(tileRect), KisTileOpacitySummary::Mixed);
+
+    // the device offset is taken into account
+    dev->clear();
+    dev->fill(tileRect, KoColor(Qt::red, cs));
+    dev->moveTo(64, 0);
+    QCOMPARE(dev->opacitySummary(QRect(64, 0, 64, 64)), KisTileOpacitySummary::Opaque);
+    QCOMPARE(dev->opacitySummary(tileRect), KisTileOpacitySummary::Transparent);
+
+    // the copies share tile data, but a write to one of them must
+    // not affect the summary of the other one
+    KisPaintDeviceSP copy = new KisPaintDevice(*dev);
+    QCOMPARE(copy->opacitySummary(QRect(64, 0, 64, 64)), KisTileOpacitySummary::Opaque);
+    copy->clear(QRect(64, 0, 10, 10));
+    QCOMPARE(copy->opacitySummary(QRect(64, 0, 64, 64)), KisTileOpacitySummary::Mixed);
+    QCOMPARE(dev->opacitySummary(QRect(64, 0, 64, 64)), KisTileOpacitySummary::Opaque);
+}
+
+void KisPaintDeviceTest::testTileSize()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect fillRect(10, 20, 300, 200);
+
+    KisPaintDeviceSP defaultDev = new KisPaintDevice(cs);
+    QCOMPARE(defaultDev->dataManager()->tileWidth(), qint32(KisTileData::WIDTH));
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs, 128);
+    QCOMPARE(dev->dataManager()->tileWidth(), 128);
+    QCOMPARE(dev->dataManager()->tileHeight(), 128);
+
+    dev->fill(fillRect, KoColor(Qt::red, cs));
+    QCOMPARE(dev->exactBounds(), fillRect);
+
+    // the copies keep the tile size of the source
+    KisPaintDeviceSP copy = new KisPaintDevice(*dev);
+    QCOMPARE(copy->dataManager()->tileWidth(), 128);
+
+    KisPaintDeviceSP clone = new KisPaintDevice(cs);
+    clone->makeCloneFromRough(dev, fillRect);
+    QCOMPARE(clone->dataManager()->tileWidth(), 128);
+    QCOMPARE(clone->exactBounds(), fillRect);
+
+    // and so does the color space conversion
+    dev->convertTo(KoColorSpaceRegistry::instance()->rgb16());
+    QCOMPARE(dev->dataManager()->tileWidth(), 128);
+    QCOMPARE(dev->exactBounds(), fillRect);
+
+    // the pixels are copied between devices with different tile sizes
+    defaultDev->makeCloneFrom(copy, fillRect);
+    QCOMPARE(defaultDev->dataManager()->tileWidth(), 128);
+
+    KisPaintDeviceSP smallTilesDev = new KisPaintDevice(cs);
+    KisPainter::copyAreaOptimized(fillRect.topLeft(), copy, smallTilesDev, fillRect);
+    QCOMPARE(smallTilesDev->dataManager()->tileWidth(), qint32(KisTileData::WIDTH));
+    QImage srcImage = copy->convertToQImage(0, fillRect);
+    QImage dstImage = smallTilesDev->convertToQImage(0, fillRect);
+    QCOMPARE(dstImage, srcImage);
+}
+
 #include <kundo2stack.h>
 
 struct FillWorker : public QRunnable
@@ -80,6 +80,10 @@ private Q_SLOTS:
 
     void testCompositionAssociativity();
 
+    void testOpacitySummary();
+
+    void testTileSize();
+
     void stressTestMemoryFragmentation();
 };
 
@@ -20,6 +20,7 @@
 #include <QTest>
 
 #include <QAtomicInt>
+#include <QSemaphore>
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 
@@ -212,9 +213,10 @@ private:
     QAtomicInt &m_hadConcurrency;
 };
 
-void KisUpdaterContextTest::stressTestExclusiveJobs()
+void KisUpdaterContextTest::stressTestExclusiveJobsImpl(bool useWorkStealing)
 {
     KisUpdaterContext context(NUM_THREADS);
+    context.setUseWorkStealing(useWorkStealing);
     QAtomicInt counter;
     QAtomicInt hadConcurrency;
 
@@ -245,5 +247,103 @@ void KisUpdaterContextTest::stressTestExclusiveJobs()
              << "/" << NUM_CHECKS * NUM_JOBS;
 }
 
+void KisUpdaterContextTest::stressTestExclusiveJobs()
+{
+    stressTestExclusiveJobsImpl(false);
+}
+
+void KisUpdaterContextTest::stressTestExclusiveJobsWorkStealing()
+{
+    stressTestExclusiveJobsImpl(true);
+}
+
+void KisUpdaterContextTest::testWorkStealingThreadsLimit()
+{
+    KisTestableUpdaterContext context(3);
+
+    QCOMPARE(context.threadsLimit(), 3);
+    QCOMPARE(context.getJobs().size(), 3);
+
+    context.lock();
+    context.setUseWorkStealing(true);
+    context.unlock();
+
+    QCOMPARE(context.threadsLimit(), 3);
+    QCOMPARE(context.getJobs().size(), 3 * KisUpdaterContext::workStealingJobsPerThread);
+
+    context.lock();
+    context.setThreadsLimit(5);
+    context.unlock();
+
+    QCOMPARE(context.threadsLimit(), 5);
+    QCOMPARE(context.getJobs().size(), 5 * KisUpdaterContext::workStealingJobsPerThread);
+
+    context.lock();
+    context.setUseWorkStealing(false);
+    context.unlock();
+
+    QCOMPARE(context.threadsLimit(), 5);
+    QCOMPARE(context.getJobs().size(), 5);
+}
+
+struct ThreadRecordingJob : public QRunnable
+{
+    ThreadRecordingJob(bool _canBeStolen) : canBeStolen(_canBeStolen) {
+        setAutoDelete(false);
+    }
+
+    void run() override {
+        thread = QThread::currentThread();
+        done.release();
+    }
+
+    const bool canBeStolen;
+    QThread *thread = 0;
+    QSemaphore done;
+};
+
+struct SpawningJob : public QRunnable
+{
+    SpawningJob(KisWorkStealingExecutor *_executor) : executor(_executor) {
+        setAutoDelete(false);
+    }
+
+    void run() override {
+        thread = QThread::currentThread();
+
+        executor->start(&localJob);
+        executor->start(&stealableJob);
+
+        // we are busy, so only another worker can execute the job
+        stealableJobDone = stealableJob.done.tryAcquire(1, 5000);
+    }
+
+    KisWorkStealingExecutor *executor;
+    ThreadRecordingJob localJob {false};
+    ThreadRecordingJob stealableJob {true};
+    QThread *thread = 0;
+    bool stealableJobDone = false;
+};
+
+void KisUpdaterContextTest::testWorkStealingFilter()
+{
+    KisWorkStealingExecutor executor;
+    executor.setMaxThreadCount(2);
+    executor.setStealingFilter(
+        [] (QRunnable *job) {
+            ThreadRecordingJob *recordingJob = dynamic_cast<ThreadRecordingJob*>(job);
+            return recordingJob && recordingJob->canBeStolen;
+        });
+
+    SpawningJob job(&executor);
+    executor.start(&job);
+    executor.waitForDone();
+
+    QVERIFY(job.stealableJobDone);
+    QVERIFY(job.stealableJob.thread != job.thread);
+    QCOMPARE(job.localJob.thread, job.thread);
+    QCOMPARE(executor.stolenJobsCount(), 1);
+}
+
 QTEST_MAIN(KisUpdaterContextTest)
 
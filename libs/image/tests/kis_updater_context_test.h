@@ -25,10 +25,16 @@ class KisUpdaterContextTest : public QObject
 {
     Q_OBJECT
 
+private:
+    void stressTestExclusiveJobsImpl(bool useWorkStealing);
+
 private Q_SLOTS:
     void testJobInterference();
     void testSnapshot();
     void stressTestExclusiveJobs();
+    void stressTestExclusiveJobsWorkStealing();
+    void testWorkStealingThreadsLimit();
+    void testWorkStealingFilter();
 };
 
 #endif /* KIS_UPDATER_CONTEXT_TEST_H */
@@ -256,11 +256,19 @@ void KisTiledExtentManager::Data::updateMax()
 }
 
 KisTiledExtentManager::KisTiledExtentManager()
+    : m_tileWidth(KisTileData::WIDTH),
+      m_tileHeight(KisTileData::HEIGHT)
 {
     QWriteLocker l(&m_extentLock);
     m_currentExtent = QRect();
 }
 
+void KisTiledExtentManager::setTileSize(qint32 tileWidth, qint32 tileHeight)
+{
+    m_tileWidth = tileWidth;
+    m_tileHeight = tileHeight;
+}
+
 void KisTiledExtentManager::notifyTileAdded(qint32 col, qint32 row)
 {
     bool needsUpdateExtent = false;
@@ -326,8 +334,8 @@ void KisTiledExtentManager::updateExtent()
             minX = 0;
             width = 0;
         } else {
-            minX = m_colsData.min() * KisTileData::WIDTH;
-            width = (m_colsData.max() + 1) * KisTileData::WIDTH - minX;
+            minX = m_colsData.min() * m_tileWidth;
+            width = (m_colsData.max() + 1) * m_tileWidth - minX;
         }
     }
 
@@ -338,8 +346,8 @@ void KisTiledExtentManager::updateExtent()
             minY = 0;
             height = 0;
         } else {
-            minY = m_rowsData.min() * KisTileData::HEIGHT;
-            height = (m_rowsData.max() + 1) * KisTileData::HEIGHT - minY;
+            minY = m_rowsData.min() * m_tileHeight;
+            height = (m_rowsData.max() + 1) * m_tileHeight - minY;
         }
     }
 
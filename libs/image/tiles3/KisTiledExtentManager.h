@@ -68,6 +68,12 @@ class KRITAIMAGE_EXPORT KisTiledExtentManager
 public:
     KisTiledExtentManager();
 
+    /**
+     * Sets the size of the tiles of the data manager. Should be
+     * called before any tiles are added.
+     */
+    void setTileSize(qint32 tileWidth, qint32 tileHeight);
+
     void notifyTileAdded(qint32 col, qint32 row);
     void notifyTileRemoved(qint32 col, qint32 row);
     void replaceTileStats(const QVector<QPoint> &indexes);
@@ -81,6 +87,8 @@ private:
 private:
     mutable QReadWriteLock m_extentLock;
     QRect m_currentExtent;
+    qint32 m_tileWidth;
+    qint32 m_tileHeight;
     Data m_colsData;
     Data m_rowsData;
 };
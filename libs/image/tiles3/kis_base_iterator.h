@@ -72,12 +72,24 @@ protected:
         return m_dataManager ? m_dataManager->yToRow(y) : 0;
     }
 
+    inline void prefetchTiles(qint32 leftCol, qint32 topRow, qint32 rightCol, qint32 bottomRow) {
+        m_dataManager->prefetchTiles(leftCol, topRow, rightCol, bottomRow);
+    }
+
+    inline qint32 tileWidth() const {
+        return m_dataManager->tileWidth();
+    }
+
+    inline qint32 tileHeight() const {
+        return m_dataManager->tileHeight();
+    }
+
     inline qint32 calcXInTile(qint32 x, qint32 col) const {
-        return x - col * KisTileData::WIDTH;
+        return x - col * tileWidth();
     }
 
     inline qint32 calcYInTile(qint32 y, qint32 row) const {
-        return y - row * KisTileData::HEIGHT;
+        return y - row * tileHeight();
     }
     
 private:
@@ -136,7 +136,7 @@ void KisMementoManager::registerTileChange(KisTile *tile)
         m_index.addTile(mi);
 
         if(namedTransactionInProgress())
-            m_currentMemento->updateExtent(mi->col(), mi->row());
+            m_currentMemento->updateExtent(tile->extent());
     }
     else {
         mi->reset();
@@ -158,7 +158,7 @@ void KisMementoManager::registerTileDeleted(KisTile *tile)
         m_index.addTile(mi);
 
         if(namedTransactionInProgress())
-            m_currentMemento->updateExtent(mi->col(), mi->row());
+            m_currentMemento->updateExtent(tile->extent());
     }
     else {
         mi->reset();
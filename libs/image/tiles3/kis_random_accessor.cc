@@ -29,6 +29,8 @@ KisRandomAccessor2::KisRandomAccessor2(KisTiledDataManager *ktm, qint32 offsetX,
         m_tilesCache(new KisTileInfo*[CACHESIZE]),
         m_tilesCacheSize(0),
         m_pixelSize(m_ktm->pixelSize()),
+        m_tileWidth(m_ktm->tileWidth()),
+        m_tileHeight(m_ktm->tileHeight()),
         m_data(0),
         m_oldData(0),
         m_writable(writable),
@@ -68,7 +70,7 @@ void KisRandomAccessor2::moveTo(qint32 x, qint32 y)
         if (x >= m_tilesCache[i]->area_x1 && x <= m_tilesCache[i]->area_x2 &&
                 y >= m_tilesCache[i]->area_y1 && y <= m_tilesCache[i]->area_y2) {
             KisTileInfo* kti = m_tilesCache[i];
-            quint32 offset = x - kti->area_x1 + (y - kti->area_y1) * KisTileData::WIDTH;
+            quint32 offset = x - kti->area_x1 + (y - kti->area_y1) * m_tileWidth;
             offset *= m_pixelSize;
             m_data = kti->data + offset;
             m_oldData = kti->oldData + offset;
@@ -90,7 +92,7 @@ void KisRandomAccessor2::moveTo(qint32 x, qint32 y)
     quint32 col = xToCol(x);
     quint32 row = yToRow(y);
     KisTileInfo* kti = fetchTileData(col, row);
-    quint32 offset = x - kti->area_x1 + (y - kti->area_y1) * KisTileData::WIDTH;
+    quint32 offset = x - kti->area_x1 + (y - kti->area_y1) * m_tileWidth;
     offset *= m_pixelSize;
     m_data = kti->data + offset;
     m_oldData = kti->oldData + offset;
@@ -130,10 +132,10 @@ KisRandomAccessor2::KisTileInfo* KisRandomAccessor2::fetchTileData(qint32 col, q
     lockOldTile(kti->oldtile);
     kti->oldData = kti->oldtile->data();
 
-    kti->area_x1 = col * KisTileData::HEIGHT;
-    kti->area_y1 = row * KisTileData::WIDTH;
-    kti->area_x2 = kti->area_x1 + KisTileData::HEIGHT - 1;
-    kti->area_y2 = kti->area_y1 + KisTileData::WIDTH - 1;
+    kti->area_x1 = col * m_tileWidth;
+    kti->area_y1 = row * m_tileHeight;
+    kti->area_x2 = kti->area_x1 + m_tileWidth - 1;
+    kti->area_y2 = kti->area_y1 + m_tileHeight - 1;
 
     return kti;
 }
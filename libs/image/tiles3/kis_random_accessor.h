@@ -96,6 +96,8 @@ private:
     KisTileInfo** m_tilesCache;
     quint32 m_tilesCacheSize;
     qint32 m_pixelSize;
+    qint32 m_tileWidth;
+    qint32 m_tileHeight;
     quint8* m_data;
     const quint8* m_oldData;
     bool m_writable;
@@ -32,8 +32,10 @@ void KisTile::init(qint32 col, qint32 row,
     m_row = row;
     m_lockCounter = 0;
 
-    m_extent = QRect(m_col * KisTileData::WIDTH, m_row * KisTileData::HEIGHT,
-                     KisTileData::WIDTH, KisTileData::HEIGHT);
+    const qint32 width = defaultTileData->width();
+    const qint32 height = defaultTileData->height();
+
+    m_extent = QRect(m_col * width, m_row * height, width, height);
 
     m_tileData = defaultTileData;
     m_tileData->acquire();
@@ -216,6 +218,32 @@ inline void KisTile::safeReleaseOldTileData(KisTileData *td)
     }
 }
 
+void KisTile::prefetchTileData() const
+{
+    /**
+     * m_tileData can be changed by COW only while the tile is locked,
+     * and the locked tile data is guaranteed to be present in memory,
+     * so holding the barrier lock is enough to keep the pointer valid.
+     */
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    if (!m_lockCounter && m_tileData) {
+        m_tileData->m_store->prefetchTileData(m_tileData);
+    }
+}
+
+bool KisTile::copyPackedData(QByteArray *buffer) const
+{
+    /**
+     * The same as in prefetchTileData(), m_tileData cannot be
+     * changed while we hold the barrier lock and the tile is not
+     * locked. The locked tile data is never packed.
+     */
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    return !m_lockCounter && m_tileData->copyPackedData(buffer);
+}
+
 void KisTile::lockForRead() const
 {
 #ifdef DEAD_TILES_SANITY_CHECK
@@ -269,11 +297,20 @@ void KisTile::lockForWrite()
 #endif
     }
 
+    m_tileData->invalidateContentHash();
+    m_tileData->invalidateOpacitySummary();
+
     DEBUG_LOG_ACTION("lock [W]");
 }
 
 void KisTile::unlockForWrite()
 {
+    /**
+     * Someone might have calculated the opacity summary while we
+     * were writing, so invalidate it once again
+     */
+    m_tileData->invalidateOpacitySummary();
+
     unblockSwapping();
     DEBUG_LOG_ACTION("unlock [W]");
 
@@ -310,9 +347,9 @@ void KisTile::debugDumpTile()
     lockForRead();
     quint8 *data = this->data();
 
-    for (int i = 0; i < KisTileData::HEIGHT; i++) {
-        for (int j = 0; j < KisTileData::WIDTH; j++) {
-            dbgTiles << data[(i*KisTileData::WIDTH+j)*pixelSize()];
+    for (int i = 0; i < m_extent.height(); i++) {
+        for (int j = 0; j < m_extent.width(); j++) {
+            dbgTiles << data[(i * m_extent.width() + j) * pixelSize()];
         }
     }
     unlockForRead();
@@ -92,6 +92,21 @@ public:
     void unlockForWrite();
     void unlockForRead() const;
 
+    /**
+     * If the tile data has been swapped out, asks the store to
+     * load it back asynchronously. It is a hint for the tile
+     * data store only, the tile should still be locked before
+     * accessing its data.
+     */
+    void prefetchTileData() const;
+
+    /**
+     * If the tile data is still packed after lazy loading, copies
+     * the packed data into \p buffer and returns true. It doesn't
+     * unpack the data and doesn't need the tile to be locked.
+     */
+    bool copyPackedData(QByteArray *buffer) const;
+
 
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
@@ -21,60 +21,88 @@
 #include "kis_tile_data.h"
 #include "kis_tile_data_store.h"
 
+#include <QSet>
+
 #include <kis_debug.h>
 
-#include <boost/pool/singleton_pool.hpp>
+#include "kis_tile_data_arena.h"
 #include "kis_tile_data_store_iterators.h"
 
-// BPP == bytes per pixel
-#define TILE_SIZE_4BPP (4 * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
-#define TILE_SIZE_8BPP (8 * __TILE_DATA_WIDTH * __TILE_DATA_HEIGHT)
-
-typedef boost::singleton_pool<KisTileData, TILE_SIZE_4BPP, boost::default_user_allocator_new_delete, boost::details::pool::default_mutex, 256, 4096> BoostPool4BPP;
-typedef boost::singleton_pool<KisTileData, TILE_SIZE_8BPP, boost::default_user_allocator_new_delete, boost::details::pool::default_mutex, 128, 2048> BoostPool8BPP;
-
 const qint32 KisTileData::WIDTH = __TILE_DATA_WIDTH;
 const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
-SimpleCache KisTileData::m_cache;
+namespace {
 
-SimpleCache::~SimpleCache()
+/**
+ * Returns the arenas the blobs of the most common sizes are
+ * allocated in: 4, 8 and 16 bytes per pixel for every supported
+ * tile size.
+ *
+ * The arenas are never destroyed: the threads return their caches
+ * to the arenas when they exit, which may happen after the static
+ * objects have already been destroyed.
+ */
+const QVector<KisTileDataArena*>& tileDataArenas()
 {
-    clear();
+    static const QVector<KisTileDataArena*> arenas =
+        [] () {
+            QVector<KisTileDataArena*> result;
+
+            const qint32 tileSizes[] = {64, 128, 256};
+            const qint32 pixelSizes[] = {4, 8, 16};
+
+            QSet<qint32> blobSizes;
+
+            for (qint32 tileSize : tileSizes) {
+                for (qint32 pixelSize : pixelSizes) {
+                    // e.g. 16 bpp 64x64 tiles have the same size as 4 bpp 128x128 ones
+                    blobSizes.insert(pixelSize * tileSize * tileSize);
+                }
+            }
+
+            Q_FOREACH (qint32 blobSize, blobSizes) {
+                result << new KisTileDataArena(blobSize);
+            }
+
+            return result;
+        } ();
+
+    return arenas;
 }
 
-void SimpleCache::clear()
+/**
+ * Returns the arena the blobs of \p dataSize are allocated in or
+ * null if such blobs are allocated with malloc directly.
+ */
+KisTileDataArena* arenaForDataSize(qint32 dataSize)
 {
-    QWriteLocker l(&m_cacheLock);
-    quint8 *ptr = 0;
-
-    while (m_4Pool.pop(ptr)) {
-        BoostPool4BPP::free(ptr);
+    Q_FOREACH (KisTileDataArena *arena, tileDataArenas()) {
+        if (arena->blobSize() == dataSize) {
+            return arena;
+        }
     }
 
-    while (m_8Pool.pop(ptr)) {
-        BoostPool8BPP::free(ptr);
-    }
+    return 0;
+}
 
-    while (m_16Pool.pop(ptr)) {
-        free(ptr);
-    }
 }
 
 
-KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory)
+KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory, qint32 tileSize)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(pixelSize),
+      m_width(tileSize),
+      m_height(tileSize),
       m_store(store)
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
     }
-    m_data = allocateData(m_pixelSize);
+    m_data = allocateData(dataSize());
 
     fillWithPixel(defPixel);
 }
@@ -98,27 +126,49 @@ KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(rhs.m_pixelSize),
+      m_width(rhs.m_width),
+      m_height(rhs.m_height),
       m_store(rhs.m_store)
 {
     if (checkFreeMemory) {
         m_store->checkFreeMemory();
     }
-    m_data = allocateData(m_pixelSize);
+    m_data = allocateData(dataSize());
 
-    memcpy(m_data, rhs.data(), m_pixelSize * WIDTH * HEIGHT);
+    memcpy(m_data, rhs.data(), dataSize());
 }
 
 
+KisTileData::KisTileData(qint32 pixelSize, const quint8 *packedData, qint32 packedDataSize,
+                         KisTileDataStore *store, qint32 tileSize)
+    : m_state(NORMAL),
+      m_mementoFlag(0),
+      m_age(0),
+      m_data(0),
+      m_usersCount(0),
+      m_refCount(0),
+      m_pixelSize(pixelSize),
+      m_width(tileSize),
+      m_height(tileSize),
+      m_store(store)
+{
+    m_packedData = new quint8[packedDataSize];
+    m_packedDataSize = packedDataSize;
+    memcpy(m_packedData, packedData, packedDataSize);
+}
+
 KisTileData::~KisTileData()
 {
     releaseMemory();
+    delete[] m_uniformPixel;
+    delete[] m_packedData;
 }
 
 void KisTileData::fillWithPixel(const quint8 *defPixel)
 {
     quint8 *it = m_data;
 
-    for (int i = 0; i < WIDTH * HEIGHT; i++, it += m_pixelSize) {
+    for (int i = 0; i < m_width * m_height; i++, it += m_pixelSize) {
         memcpy(it, defPixel, m_pixelSize);
     }
 }
@@ -126,7 +176,7 @@ void KisTileData::fillWithPixel(const quint8 *defPixel)
 void KisTileData::releaseMemory()
 {
     if (m_data) {
-        freeData(m_data, m_pixelSize);
+        freeData(m_data, dataSize());
         m_data = 0;
     }
 
@@ -141,44 +191,26 @@ void KisTileData::releaseMemory()
 void KisTileData::allocateMemory()
 {
     Q_ASSERT(!m_data);
-    m_data = allocateData(m_pixelSize);
+    m_data = allocateData(dataSize());
 }
 
-quint8* KisTileData::allocateData(const qint32 pixelSize)
+quint8* KisTileData::allocateData(const qint32 dataSize)
 {
-    quint8 *ptr = 0;
-
-    if (!m_cache.pop(pixelSize, ptr)) {
-        switch (pixelSize) {
-        case 4:
-            ptr = (quint8*)BoostPool4BPP::malloc();
-            break;
-        case 8:
-            ptr = (quint8*)BoostPool8BPP::malloc();
-            break;
-        default:
-            ptr = (quint8*) malloc(pixelSize * WIDTH * HEIGHT);
-            break;
-        }
-    }
+    KisTileDataArena *arena = arenaForDataSize(dataSize);
 
-    return ptr;
+    return arena ?
+        arena->allocate() :
+        (quint8*) malloc(dataSize);
 }
 
-void KisTileData::freeData(quint8* ptr, const qint32 pixelSize)
+void KisTileData::freeData(quint8* ptr, const qint32 dataSize)
 {
-    if (!m_cache.push(pixelSize, ptr)) {
-        switch (pixelSize) {
-        case 4:
-            BoostPool4BPP::free(ptr);
-            break;
-        case 8:
-            BoostPool8BPP::free(ptr);
-            break;
-        default:
-            free(ptr);
-            break;
-        }
+    KisTileDataArena *arena = arenaForDataSize(dataSize);
+
+    if (arena) {
+        arena->free(ptr);
+    } else {
+        free(ptr);
     }
 }
 
@@ -210,9 +242,7 @@ void KisTileData::releaseInternalPools()
             }
 
             // check if the tile data has actually been pooled
-            if (item->m_pixelSize != 4 &&
-                item->m_pixelSize != 8) {
-
+            if (!arenaForDataSize(item->dataSize())) {
                 continue;
             }
 
@@ -224,7 +254,7 @@ void KisTileData::releaseInternalPools()
                     break;
                 }
 
-                const int chunkSize = item->m_pixelSize * WIDTH * HEIGHT;
+                const int chunkSize = item->dataSize();
                 dataObjects << item;
                 memoryChunks << QByteArray((const char*)item->m_data, chunkSize);
             }
@@ -232,19 +262,25 @@ void KisTileData::releaseInternalPools()
         }
 
         if (!failedToLock) {
+            Q_FOREACH (KisTileData *item, dataObjects) {
+                freeData(item->m_data, item->dataSize());
+                item->m_data = 0;
+            }
+
             // purge the pools memory
-            m_cache.clear();
-            BoostPool4BPP::purge_memory();
-            BoostPool8BPP::purge_memory();
+            Q_FOREACH (KisTileDataArena *arena, tileDataArenas()) {
+                arena->flushThreadCaches();
+                arena->purge();
+            }
 
             auto it = dataObjects.begin();
             auto chunkIt = memoryChunks.constBegin();
 
             for (; it != dataObjects.end(); ++it, ++chunkIt) {
                 KisTileData *item = *it;
-                const int chunkSize = item->m_pixelSize * WIDTH * HEIGHT;
+                const int chunkSize = item->dataSize();
 
-                item->m_data = allocateData(item->m_pixelSize);
+                item->m_data = allocateData(chunkSize);
                 memcpy(item->m_data, chunkIt->data(), chunkSize);
 
                 item->m_swapLock.unlock();
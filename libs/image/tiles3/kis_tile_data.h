@@ -37,13 +37,31 @@ inline quint8* KisTileData::data() const {
 
 void KisTileData::setData(const quint8 *data) {
     Q_ASSERT(m_data);
-    memcpy(m_data, data, m_pixelSize*WIDTH*HEIGHT);
+    invalidateContentHash();
+    invalidateOpacitySummary();
+    memcpy(m_data, data, dataSize());
 }
 
 inline quint32 KisTileData::pixelSize() const {
     return m_pixelSize;
 }
 
+inline qint32 KisTileData::width() const {
+    return m_width;
+}
+
+inline qint32 KisTileData::height() const {
+    return m_height;
+}
+
+inline qint32 KisTileData::dataSize() const {
+    return m_pixelSize * m_width * m_height;
+}
+
+inline qint32 KisTileData::memoryMetric() const {
+    return m_pixelSize * (m_width * m_height / (__TILE_DATA_WIDTH * __TILE_DATA_HEIGHT));
+}
+
 inline bool KisTileData::acquire() {
     /**
      * We need to ensure the clones in the stack are
@@ -133,5 +151,43 @@ inline qint32 KisTileData::numUsers() const {
     return m_usersCount;
 }
 
+inline void KisTileData::invalidateContentHash() {
+    m_contentHashValid = 0;
+}
+
+inline KisTileOpacitySummary KisTileData::cachedOpacitySummary(int *cookie) const {
+    const int generation = m_writeGeneration.loadAcquire();
+    const uint value = uint(m_opacitySummary.loadAcquire());
+
+    *cookie = generation;
+
+    return (value >> 2) == (uint(generation) & 0x3FFFFFFF) ?
+        KisTileOpacitySummary(value & 0x3) : KisTileOpacitySummary::Unknown;
+}
+
+inline void KisTileData::setCachedOpacitySummary(int cookie, KisTileOpacitySummary summary) {
+    if (m_writeGeneration.loadAcquire() != cookie) return;
+    m_opacitySummary.storeRelease(int((uint(cookie) << 2) | uint(summary)));
+}
+
+inline void KisTileData::invalidateOpacitySummary() {
+    m_writeGeneration.ref();
+}
+
+inline bool KisTileData::copyPackedData(QByteArray *buffer) {
+    /**
+     * A packed tile data never has any memory, so we can
+     * avoid taking the lock in the most common case
+     */
+    if (m_data) return false;
+
+    QReadLocker locker(&m_swapLock);
+
+    if (!m_packedData) return false;
+
+    *buffer = QByteArray((const char*)m_packedData, m_packedDataSize);
+    return true;
+}
+
 #endif /* KIS_TILE_DATA_H_ */
 
@@ -0,0 +1,393 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_data_arena.h"
+
+#include <config-numa.h>
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#include <sched.h>
+#endif
+
+#include <QHash>
+#include <QSet>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+
+#include <kis_debug.h>
+
+namespace {
+/**
+ * The size of a chunk of memory the blobs are allocated in
+ */
+const int SLAB_SIZE = 1024 * 1024;
+
+/**
+ * The amount of memory a thread moves between its cache
+ * and the node lists at once. A thread keeps at most twice
+ * as much memory in its cache.
+ */
+const int CACHE_BATCH_SIZE = 256 * 1024;
+}
+
+struct KisTileDataArena::Node
+{
+    QMutex lock;
+    QVector<quint8*> freeBlobs;
+};
+
+/**
+ * The cache is used by its thread only, except for the moments when
+ * someone flushes all the caches. So its lock is almost never
+ * contended.
+ */
+struct KisTileDataArena::ThreadCache
+{
+    ThreadCache(KisTileDataArena *_arena)
+        : arena(_arena)
+    {
+        blobs.reserve(2 * arena->m_cacheBatchSize);
+    }
+
+    ~ThreadCache()
+    {
+        // the arena might have been destroyed before the thread exited
+        if (!arena) return;
+
+        {
+            QMutexLocker l(&arena->m_cachesLock);
+            arena->m_caches.removeOne(this);
+        }
+
+        arena->returnBlobs(blobs.data(), blobs.size());
+    }
+
+    KisTileDataArena *arena;
+    QMutex lock;
+    QVector<quint8*> blobs;
+};
+
+inline KisTileDataArena::ThreadCache* KisTileDataArena::localCache()
+{
+    ThreadCache *cache = m_threadCaches.localData();
+
+    if (!cache) {
+        cache = new ThreadCache(this);
+        m_threadCaches.setLocalData(cache);
+
+        QMutexLocker l(&m_cachesLock);
+        m_caches.append(cache);
+    }
+
+    return cache;
+}
+
+inline QMap<quint8*, KisTileDataArena::Slab>::const_iterator KisTileDataArena::findSlab(quint8 *ptr) const
+{
+    auto it = m_slabs.upperBound(ptr);
+    KIS_ASSERT(it != m_slabs.constBegin());
+    --it;
+
+    KIS_ASSERT(ptr < it->data + m_blobSize * m_blobsPerSlab);
+    return it;
+}
+
+
+KisTileDataArena::KisTileDataArena(int blobSize)
+    : m_blobSize(blobSize),
+      m_blobsPerSlab(qMax(1, SLAB_SIZE / blobSize)),
+      m_cacheBatchSize(qMax(2, CACHE_BATCH_SIZE / blobSize)),
+      m_useNuma(false)
+{
+    int numNodes = 1;
+
+#ifdef HAVE_NUMA
+    if (numa_available() >= 0 && numa_max_node() > 0) {
+        m_useNuma = true;
+        numNodes = numa_max_node() + 1;
+    }
+#endif
+
+    for (int i = 0; i < numNodes; i++) {
+        m_nodes << new Node();
+    }
+}
+
+KisTileDataArena::~KisTileDataArena()
+{
+    /**
+     * The caches of other threads are deleted when the threads
+     * exit, so all the threads using the arena should be finished
+     * by now. Delete the cache of the current thread explicitly and
+     * detach the rest, so that they don't access the arena later.
+     */
+    m_threadCaches.setLocalData(0);
+
+    {
+        QMutexLocker l(&m_cachesLock);
+        Q_FOREACH (ThreadCache *cache, m_caches) {
+            QMutexLocker cacheLocker(&cache->lock);
+            cache->arena = 0;
+        }
+        m_caches.clear();
+    }
+
+    Q_FOREACH (const Slab &slab, m_slabs) {
+        freeSlab(slab);
+    }
+
+    qDeleteAll(m_nodes);
+}
+
+quint8* KisTileDataArena::allocate()
+{
+    ThreadCache *cache = localCache();
+    QMutexLocker l(&cache->lock);
+
+    if (cache->blobs.isEmpty()) {
+        refillCache(cache);
+
+        if (cache->blobs.isEmpty()) {
+            return 0;
+        }
+    }
+
+    return cache->blobs.takeLast();
+}
+
+void KisTileDataArena::free(quint8 *ptr)
+{
+    ThreadCache *cache = localCache();
+    QMutexLocker l(&cache->lock);
+
+    cache->blobs.append(ptr);
+
+    if (cache->blobs.size() >= 2 * m_cacheBatchSize) {
+        const int newSize = cache->blobs.size() - m_cacheBatchSize;
+        returnBlobs(cache->blobs.data() + newSize, m_cacheBatchSize);
+        cache->blobs.resize(newSize);
+    }
+}
+
+void KisTileDataArena::flushThreadCaches()
+{
+    QMutexLocker l(&m_cachesLock);
+
+    Q_FOREACH (ThreadCache *cache, m_caches) {
+        QMutexLocker cacheLocker(&cache->lock);
+
+        returnBlobs(cache->blobs.data(), cache->blobs.size());
+        cache->blobs.clear();
+    }
+}
+
+qint64 KisTileDataArena::purge()
+{
+    QWriteLocker slabsLocker(&m_slabsLock);
+    qint64 releasedBytes = 0;
+
+    for (int nodeIndex = 0; nodeIndex < m_nodes.size(); nodeIndex++) {
+        Node *node = m_nodes[nodeIndex];
+        QMutexLocker nodeLocker(&node->lock);
+
+        QHash<quint8*, int> numFreeBlobs;
+        Q_FOREACH (quint8 *ptr, node->freeBlobs) {
+            numFreeBlobs[findSlab(ptr).key()]++;
+        }
+
+        QSet<quint8*> unusedSlabs;
+        for (auto it = numFreeBlobs.constBegin(); it != numFreeBlobs.constEnd(); ++it) {
+            if (it.value() == m_blobsPerSlab) {
+                unusedSlabs.insert(it.key());
+            }
+        }
+
+        if (unusedSlabs.isEmpty()) continue;
+
+        QVector<quint8*> freeBlobs;
+        freeBlobs.reserve(node->freeBlobs.size() - unusedSlabs.size() * m_blobsPerSlab);
+
+        Q_FOREACH (quint8 *ptr, node->freeBlobs) {
+            if (!unusedSlabs.contains(findSlab(ptr).key())) {
+                freeBlobs.append(ptr);
+            }
+        }
+        node->freeBlobs.swap(freeBlobs);
+
+        Q_FOREACH (quint8 *slabData, unusedSlabs) {
+            auto it = m_slabs.find(slabData);
+            freeSlab(*it);
+            m_slabs.erase(it);
+            m_numSlabs.deref();
+
+            releasedBytes += qint64(m_blobSize) * m_blobsPerSlab;
+        }
+    }
+
+    return releasedBytes;
+}
+
+int KisTileDataArena::blobSize() const
+{
+    return m_blobSize;
+}
+
+qint64 KisTileDataArena::allocatedMemory() const
+{
+    return qint64(m_numSlabs.load()) * m_blobSize * m_blobsPerSlab;
+}
+
+int KisTileDataArena::numNodes() const
+{
+    return m_nodes.size();
+}
+
+int KisTileDataArena::currentNode() const
+{
+#ifdef HAVE_NUMA
+    if (m_useNuma) {
+        const int cpu = sched_getcpu();
+        const int node = cpu >= 0 ? numa_node_of_cpu(cpu) : -1;
+
+        if (node >= 0 && node < m_nodes.size()) {
+            return node;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+int KisTileDataArena::nodeOf(quint8 *ptr)
+{
+    QReadLocker l(&m_slabsLock);
+    return findSlab(ptr)->node;
+}
+
+void KisTileDataArena::refillCache(ThreadCache *cache)
+{
+    const int nodeIndex = currentNode();
+    Node *node = m_nodes[nodeIndex];
+
+    do {
+        QMutexLocker l(&node->lock);
+
+        if (!node->freeBlobs.isEmpty()) {
+            const int numBlobs = qMin(m_cacheBatchSize, node->freeBlobs.size());
+            const int newSize = node->freeBlobs.size() - numBlobs;
+
+            std::copy(node->freeBlobs.constBegin() + newSize,
+                      node->freeBlobs.constEnd(),
+                      std::back_inserter(cache->blobs));
+
+            node->freeBlobs.resize(newSize);
+            return;
+        }
+
+        // the slab is allocated with no node lock held, see purge()
+    } while (allocateSlab(nodeIndex));
+}
+
+void KisTileDataArena::returnBlobs(quint8 **blobs, int numBlobs)
+{
+    if (!numBlobs) return;
+
+    if (m_nodes.size() == 1) {
+        Node *node = m_nodes.first();
+        QMutexLocker l(&node->lock);
+        std::copy(blobs, blobs + numBlobs, std::back_inserter(node->freeBlobs));
+        return;
+    }
+
+    QVarLengthArray<int, 64> nodeIndexes(numBlobs);
+
+    {
+        QReadLocker l(&m_slabsLock);
+        for (int i = 0; i < numBlobs; i++) {
+            nodeIndexes[i] = findSlab(blobs[i])->node;
+        }
+    }
+
+    for (int nodeIndex = 0; nodeIndex < m_nodes.size(); nodeIndex++) {
+        Node *node = m_nodes[nodeIndex];
+        QMutexLocker l(&node->lock);
+
+        for (int i = 0; i < numBlobs; i++) {
+            if (nodeIndexes[i] == nodeIndex) {
+                node->freeBlobs.append(blobs[i]);
+            }
+        }
+    }
+}
+
+bool KisTileDataArena::allocateSlab(int nodeIndex)
+{
+    const size_t slabSize = size_t(m_blobSize) * m_blobsPerSlab;
+
+    Slab slab;
+    slab.data = 0;
+    slab.node = nodeIndex;
+    slab.isNumaAllocated = false;
+
+#ifdef HAVE_NUMA
+    if (m_useNuma) {
+        slab.data = static_cast<quint8*>(numa_alloc_onnode(slabSize, nodeIndex));
+        slab.isNumaAllocated = slab.data != 0;
+    }
+#endif
+
+    if (!slab.data) {
+        slab.data = static_cast<quint8*>(::malloc(slabSize));
+    }
+
+    if (!slab.data) {
+        warnKrita << "WARNING: KisTileDataArena failed to allocate a slab of" << slabSize << "bytes";
+        return false;
+    }
+
+    {
+        QWriteLocker l(&m_slabsLock);
+        m_slabs.insert(slab.data, slab);
+    }
+    m_numSlabs.ref();
+
+    Node *node = m_nodes[nodeIndex];
+    QMutexLocker l(&node->lock);
+
+    for (int i = 0; i < m_blobsPerSlab; i++) {
+        node->freeBlobs.append(slab.data + i * m_blobSize);
+    }
+
+    return true;
+}
+
+void KisTileDataArena::freeSlab(const Slab &slab)
+{
+#ifdef HAVE_NUMA
+    if (slab.isNumaAllocated) {
+        numa_free(slab.data, size_t(m_blobSize) * m_blobsPerSlab);
+        return;
+    }
+#endif
+
+    ::free(slab.data);
+}
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TILE_DATA_ARENA_H
+#define __KIS_TILE_DATA_ARENA_H
+
+#include <QVector>
+#include <QMap>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QThreadStorage>
+#include <QAtomicInt>
+
+#include "kritaimage_export.h"
+
+/**
+ * An allocator for the blobs of the tile data objects of one size.
+ *
+ * The blobs are allocated in big slabs. Every NUMA node has its own
+ * list of free blobs and its own slabs, which are placed in the
+ * memory of the node (when Krita is built with libnuma and the system
+ * has more than one node). Without libnuma all the threads share a
+ * single node.
+ *
+ * Every thread keeps a small cache of free blobs, so allocating and
+ * freeing of the blobs doesn't touch any shared memory most of the
+ * time. The cache is refilled from (and drained to) the node lists in
+ * batches.
+ *
+ * A freed blob always returns to the node it has been allocated on,
+ * even if it is freed by a thread running on a different node.
+ */
+class KRITAIMAGE_EXPORT KisTileDataArena
+{
+public:
+    KisTileDataArena(int blobSize);
+    ~KisTileDataArena();
+
+    quint8* allocate();
+    void free(quint8 *ptr);
+
+    /**
+     * Returns the blobs cached by all the threads to the node lists,
+     * including the threads that don't use the arena at the moment
+     */
+    void flushThreadCaches();
+
+    /**
+     * Frees all the slabs, whose blobs are not used anymore. Call
+     * flushThreadCaches() beforehand to release the blobs kept in
+     * the thread caches as well.
+     *
+     * Returns the number of bytes released.
+     */
+    qint64 purge();
+
+    int blobSize() const;
+
+    /**
+     * The amount of memory allocated by the slabs
+     */
+    qint64 allocatedMemory() const;
+
+    int numNodes() const;
+
+    /**
+     * Returns the NUMA node the calling thread is running on
+     */
+    int currentNode() const;
+
+    /**
+     * Returns the NUMA node \p ptr has been allocated on
+     */
+    int nodeOf(quint8 *ptr);
+
+private:
+    struct Slab {
+        quint8 *data;
+        int node;
+        bool isNumaAllocated;
+    };
+
+    struct Node;
+    struct ThreadCache;
+
+    void refillCache(ThreadCache *cache);
+    void returnBlobs(quint8 **blobs, int numBlobs);
+    bool allocateSlab(int nodeIndex);
+    void freeSlab(const Slab &slab);
+
+    inline ThreadCache* localCache();
+
+    /**
+     * LOCKING: m_slabsLock should be locked by the caller
+     */
+    inline QMap<quint8*, Slab>::const_iterator findSlab(quint8 *ptr) const;
+
+private:
+    const int m_blobSize;
+    const int m_blobsPerSlab;
+    const int m_cacheBatchSize;
+    bool m_useNuma;
+
+    QVector<Node*> m_nodes;
+
+    QReadWriteLock m_slabsLock;
+    QMap<quint8*, Slab> m_slabs;
+
+    QAtomicInt m_numSlabs;
+
+    QThreadStorage<ThreadCache*> m_threadCaches;
+
+    /**
+     * All the thread caches alive, so that they could be flushed
+     * from any thread. \see flushThreadCaches()
+     */
+    QMutex m_cachesLock;
+    QVector<ThreadCache*> m_caches;
+};
+
+#endif /* __KIS_TILE_DATA_ARENA_H */
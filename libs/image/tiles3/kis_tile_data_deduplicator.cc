@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "kis_tile_data_deduplicator.h"
+
+#include "kis_tile_data.h"
+#include "kis_image_config.h"
+
+
+KisTileDataDeduplicator::KisTileDataDeduplicator()
+    : m_numDeduplicatedTiles(0),
+      m_savedMemoryMetric(0)
+{
+    testingRereadConfig();
+}
+
+KisTileDataDeduplicator::~KisTileDataDeduplicator()
+{
+}
+
+bool KisTileDataDeduplicator::isEnabled() const
+{
+    return m_enabled;
+}
+
+uint KisTileDataDeduplicator::contentHash(KisTileData *td)
+{
+    // tiles of different color spaces or sizes should never be mixed up
+    return qHashBits(td->data(), td->dataSize(), td->pixelSize() ^ td->width());
+}
+
+void KisTileDataDeduplicator::removeFromIndex(KisTileData *td)
+{
+    auto it = m_index.find(td->m_contentHash);
+    if (it != m_index.end() && it.value() == td) {
+        m_index.erase(it);
+    }
+    td->m_dedupIndexed = false;
+}
+
+bool KisTileDataDeduplicator::tryDeduplicate(KisTileData *td, int &hashingBudget)
+{
+    Q_ASSERT(td->data());
+    QMutexLocker locker(&m_lock);
+
+    if (!td->m_contentHashValid) {
+        if (td->m_dedupIndexed) {
+            removeFromIndex(td);
+        }
+
+        if (hashingBudget <= 0) return false;
+
+        td->m_contentHash = contentHash(td);
+        td->m_contentHashValid = 1;
+        hashingBudget--;
+
+    } else if (td->m_dedupIndexed) {
+        return false;
+    }
+
+    KisTileData *source = m_index.value(td->m_contentHash, 0);
+    if (!source) {
+        m_index.insert(td->m_contentHash, td);
+        td->m_dedupIndexed = true;
+        return false;
+    }
+
+    /**
+     * The source can be accessed by someone else at the moment,
+     * just skip it then. We will have another chance on the
+     * next pass.
+     */
+    if (!source->m_swapLock.tryLockForWrite()) return false;
+
+    bool result = false;
+
+    if (!source->m_contentHashValid) {
+        // the source has been modified since it was hashed
+        removeFromIndex(source);
+        m_index.insert(td->m_contentHash, td);
+        td->m_dedupIndexed = true;
+
+    } else if (source->data() &&
+               source->pixelSize() == td->pixelSize() &&
+               source->width() == td->width() &&
+               source->height() == td->height() &&
+               !memcmp(source->data(), td->data(), td->dataSize())) {
+
+        source->acquire();
+        td->m_dedupSource = source;
+        td->releaseMemory();
+
+        m_numDeduplicatedTiles.ref();
+        m_savedMemoryMetric.fetchAndAddOrdered(td->memoryMetric());
+        result = true;
+    }
+
+    source->m_swapLock.unlock();
+
+    return result;
+}
+
+void KisTileDataDeduplicator::notifyTileDataRestored(KisTileData *td)
+{
+    m_numDeduplicatedTiles.deref();
+    m_savedMemoryMetric.fetchAndAddOrdered(-td->memoryMetric());
+}
+
+void KisTileDataDeduplicator::forgetTileData(KisTileData *td)
+{
+    if (td->m_dedupSource) {
+        notifyTileDataRestored(td);
+    }
+
+    if (td->m_dedupIndexed) {
+        QMutexLocker locker(&m_lock);
+        removeFromIndex(td);
+    }
+}
+
+qint32 KisTileDataDeduplicator::numDeduplicatedTiles() const
+{
+    return m_numDeduplicatedTiles.loadAcquire();
+}
+
+qint64 KisTileDataDeduplicator::savedMemoryMetric() const
+{
+    return m_savedMemoryMetric.loadAcquire();
+}
+
+void KisTileDataDeduplicator::clear()
+{
+    QMutexLocker locker(&m_lock);
+
+    Q_FOREACH (KisTileData *td, m_index) {
+        td->m_dedupIndexed = false;
+    }
+    m_index.clear();
+
+    m_numDeduplicatedTiles = 0;
+    m_savedMemoryMetric = 0;
+}
+
+void KisTileDataDeduplicator::testingRereadConfig()
+{
+    m_enabled = KisImageConfig(true).enableTileDeduplication();
+}
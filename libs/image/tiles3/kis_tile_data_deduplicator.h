@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __KIS_TILE_DATA_DEDUPLICATOR_H
+#define __KIS_TILE_DATA_DEDUPLICATOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "kritaimage_export.h"
+
+class KisTileData;
+
+/**
+ * Keeps an index of the content hashes of the tile data objects and
+ * lets byte-identical tile data objects share the same memory.
+ *
+ * When a duplicate is found, the duplicated tile data releases its
+ * memory and starts referencing the tile data found in the index
+ * (the "source"). The source is acquired by the duplicate, exactly
+ * like a tile acquires it, so any attempt to write into the source
+ * will trigger the usual COW and the shared data never changes.
+ *
+ * From the point of view of the store a deduplicated tile data
+ * looks like a swapped-out one: it is not registered in the list of
+ * the tiles in memory and its data is restored (copied from the
+ * source) in KisTileDataStore::ensureTileDataLoaded(). The tiles
+ * never see the source, their m_tileData is changed only by COW.
+ *
+ * The index is filled in by a background pass started by the
+ * swapper thread, see KisTileDataStore::compactTileData().
+ */
+class KRITAIMAGE_EXPORT KisTileDataDeduplicator
+{
+public:
+    KisTileDataDeduplicator();
+    ~KisTileDataDeduplicator();
+
+    /**
+     * Returns true if the background pass is enabled in the config
+     */
+    bool isEnabled() const;
+
+    /**
+     * Hashes the content of \p td (if it has not been hashed yet)
+     * and looks for an identical tile data in the index. If found,
+     * \p td releases its memory and starts referencing the found one.
+     *
+     * \p hashingBudget is the number of tiles the pass is still
+     * allowed to hash. It is decreased every time a hash is computed.
+     *
+     * Returns true if \p td has been deduplicated. In such a case
+     * the caller must unregister it from the list of tiles in memory.
+     *
+     * LOCKING: the store's iterator lock should be held by the caller,
+     *          td->m_swapLock should be locked for write
+     */
+    bool tryDeduplicate(KisTileData *td, int &hashingBudget);
+
+    /**
+     * Should be called when the data of a deduplicated \p td has
+     * been restored from its source
+     */
+    void notifyTileDataRestored(KisTileData *td);
+
+    /**
+     * Should be called before deleting the tile data. Removes the
+     * tile data from the index or updates statistics if it has been
+     * deduplicated.
+     *
+     * LOCKING: td->m_swapLock should be locked for write
+     */
+    void forgetTileData(KisTileData *td);
+
+    /**
+     * Number of tile data objects that share memory with other ones
+     */
+    qint32 numDeduplicatedTiles() const;
+
+    /**
+     * The metric of the memory saved by the deduplication
+     * \see KisTileDataStore::m_memoryMetric
+     */
+    qint64 savedMemoryMetric() const;
+
+    void clear();
+    void testingRereadConfig();
+
+private:
+    static uint contentHash(KisTileData *td);
+    void removeFromIndex(KisTileData *td);
+
+private:
+    QMutex m_lock;
+    QHash<uint, KisTileData*> m_index;
+
+    QAtomicInt m_numDeduplicatedTiles;
+    QAtomicInt m_savedMemoryMetric;
+
+    bool m_enabled;
+};
+
+#endif /* __KIS_TILE_DATA_DEDUPLICATOR_H */
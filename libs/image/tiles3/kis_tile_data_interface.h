@@ -22,8 +22,10 @@
 
 #include <QReadWriteLock>
 #include <QAtomicInt>
+#include <QByteArray>
 
 #include "kis_lockless_stack.h"
+#include "KisTileOpacitySummary.h"
 #include "swap/kis_chunk_allocator.h"
 
 class KisTileData;
@@ -43,68 +45,24 @@ typedef KisTileDataList::iterator KisTileDataListIterator;
 typedef KisTileDataList::const_iterator KisTileDataListConstIterator;
 
 
-class SimpleCache
-{
-public:
-    SimpleCache() = default;
-    ~SimpleCache();
-
-    bool push(int pixelSize, quint8 *&ptr)
-    {
-        QReadLocker l(&m_cacheLock);
-        switch (pixelSize) {
-        case 4:
-            m_4Pool.push(ptr);
-            break;
-        case 8:
-            m_8Pool.push(ptr);
-            break;
-        case 16:
-            m_16Pool.push(ptr);
-            break;
-        default:
-            return false;
-        }
-
-        return true;
-    }
-
-    bool pop(int pixelSize, quint8 *&ptr)
-    {
-        QReadLocker l(&m_cacheLock);
-        switch (pixelSize) {
-        case 4:
-            return m_4Pool.pop(ptr);
-        case 8:
-            return m_8Pool.pop(ptr);
-        case 16:
-            return m_16Pool.pop(ptr);
-        default:
-            return false;
-        }
-    }
-
-    void clear();
-
-private:
-    QReadWriteLock m_cacheLock;
-    KisLocklessStack<quint8*> m_4Pool;
-    KisLocklessStack<quint8*> m_8Pool;
-    KisLocklessStack<quint8*> m_16Pool;
-};
-
-
 /**
  * Stores actual tile's data
  */
 class KRITAIMAGE_EXPORT KisTileData
 {
 public:
-    KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory = true);
+    KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store, bool checkFreeMemory = true, qint32 tileSize = WIDTH);
 
 private:
     KisTileData(const KisTileData& rhs, bool checkFreeMemory = true);
 
+    /**
+     * Creates a tile data without any memory allocated, which keeps
+     * \p packedData instead. \see KisTileDataStore::createPackedTileData()
+     */
+    KisTileData(qint32 pixelSize, const quint8 *packedData, qint32 packedDataSize,
+                KisTileDataStore *store, qint32 tileSize);
+
 public:
     ~KisTileData();
 
@@ -121,6 +79,28 @@ public:
     inline void setData(const quint8 *data);
     inline quint32 pixelSize() const;
 
+    /**
+     * The size of the tile in pixels. All the tiles of a data
+     * manager have the same size, but it may differ between
+     * the data managers, see KisTiledDataManager::tileWidth()
+     */
+    inline qint32 width() const;
+    inline qint32 height() const;
+
+    /**
+     * The size of the pixel data in bytes
+     */
+    inline qint32 dataSize() const;
+
+    /**
+     * The amount of memory occupied by the data in the units of
+     * the store's memory metric, that is the number of bytes
+     * divided by the area of a tile of the default size.
+     *
+     * \see KisTileDataStore::m_memoryMetric
+     */
+    inline qint32 memoryMetric() const;
+
     /**
      * Increments usersCount of a TD and refs shared pointer counter
      * Used by KisTile for COW
@@ -192,6 +172,49 @@ public:
      */
     inline bool historical() const;
 
+    /**
+     * Should be called by the writers before changing the data,
+     * the content hash is recalculated by the deduplication pass
+     * after that.
+     *
+     * \see KisTileDataDeduplicator
+     */
+    inline void invalidateContentHash();
+
+    /**
+     * Returns the opacity summary calculated for the current content
+     * of the tile data or KisTileOpacitySummary::Unknown if there was
+     * a write since then. The returned \p cookie should be passed to
+     * setCachedOpacitySummary() after the summary has been calculated.
+     *
+     * The summary depends on the pixel layout, so it is valid only
+     * for the color space of the device owning the tile data.
+     */
+    inline KisTileOpacitySummary cachedOpacitySummary(int *cookie) const;
+
+    /**
+     * Caches the opacity summary calculated by the caller. If the tile
+     * data has been written to since \p cookie was fetched, the
+     * value is dropped.
+     */
+    inline void setCachedOpacitySummary(int cookie, KisTileOpacitySummary summary);
+
+    /**
+     * Should be called by the writers before and after changing the
+     * data
+     */
+    inline void invalidateOpacitySummary();
+
+    /**
+     * If the tile data has been loaded lazily and no one has
+     * accessed it since then, copies its packed data into \p buffer
+     * and returns true. The data is in the format produced by
+     * KisTileCompressor2::compressTileData().
+     *
+     * \see KisTileDataStore::createPackedTileData()
+     */
+    inline bool copyPackedData(QByteArray *buffer);
+
     /**
      * Used for swapping purposes only.
      * Frees the memory occupied by the tile data.
@@ -213,7 +236,7 @@ public:
     /**
      * Releases internal pools, which keep blobs where the tiles are
      * stored.  The point is that we don't allocate the tiles from
-     * glibc directly, but use pools (implemented via boost) to
+     * glibc directly, but use arenas (see KisTileDataArena) to
      * allocate bigger chunks. This method should be called when one
      * knows that we have just free'd quite a lot of memory and we
      * won't need it anymore. E.g. when a document has been closed.
@@ -223,8 +246,8 @@ public:
 private:
     void fillWithPixel(const quint8 *defPixel);
 
-    static quint8* allocateData(const qint32 pixelSize);
-    static void freeData(quint8 *ptr, const qint32 pixelSize);
+    static quint8* allocateData(const qint32 dataSize);
+    static void freeData(quint8 *ptr, const qint32 dataSize);
 private:
     friend class KisTileDataPooler;
     friend class KisTileDataPoolerTest;
@@ -238,6 +261,7 @@ private:
 private:
     friend class KisTile;
     friend class KisTileDataStore;
+    friend class KisTileDataDeduplicator;
 
     friend class KisTileDataStoreIterator;
     friend class KisTileDataStoreReverseIterator;
@@ -292,6 +316,57 @@ private:
      */
     QReadWriteLock m_swapLock;
 
+    /**
+     * The tile data whose memory is shared with this one. Non-null
+     * only when the tile data has been deduplicated, in which case
+     * m_data is null. Guarded by m_swapLock.
+     *
+     * \see KisTileDataDeduplicator
+     */
+    KisTileData *m_dedupSource = 0;
+
+    /**
+     * The hash of the content of the tile data. It is valid only
+     * while m_contentHashValid is set, every writer resets the flag.
+     */
+    uint m_contentHash = 0;
+    QAtomicInt m_contentHashValid;
+
+    /**
+     * Every write increments m_writeGeneration. The cached opacity
+     * summary keeps the generation it has been calculated for in the
+     * upper bits, so it is ignored as soon as someone writes to the
+     * tile data, even when the summary has been calculated
+     * concurrently with the write.
+     */
+    QAtomicInt m_writeGeneration;
+    QAtomicInt m_opacitySummary;
+
+    /**
+     * Set when the tile data is present in the deduplicator's
+     * index. Guarded by the deduplicator's lock.
+     */
+    bool m_dedupIndexed = false;
+
+    /**
+     * When all the pixels of the tile data are the same, the store
+     * may free m_data and keep only a single pixel here. The data
+     * is filled back on the first access. Guarded by m_swapLock.
+     *
+     * \see KisTileDataStore::compactTileData()
+     */
+    quint8 *m_uniformPixel = 0;
+
+    /**
+     * The tile data loaded lazily from a file keeps the compressed
+     * data here instead of m_data. It is unpacked on the first
+     * access. Guarded by m_swapLock.
+     *
+     * \see KisTileDataStore::createPackedTileData()
+     */
+    quint8 *m_packedData = 0;
+    qint32 m_packedDataSize = 0;
+
 private:
     friend class KisLowMemoryTests;
 
@@ -314,10 +389,11 @@ private:
 
 
     qint32 m_pixelSize;
+    qint32 m_width;
+    qint32 m_height;
     //qint32 m_timeStamp;
 
     KisTileDataStore *m_store;
-    static SimpleCache m_cache;
 
 public:
     static const qint32 WIDTH;
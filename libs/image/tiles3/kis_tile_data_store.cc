@@ -21,12 +21,18 @@
 #include "config-memory-leak-tracker.h"
 
 #include <QGlobalStatic>
+#include <QRunnable>
+#include <QThread>
+
+#include <limits>
 
 #include "kis_tile_data_store.h"
 #include "kis_tile_data.h"
 #include "kis_debug.h"
 
 #include "kis_tile_data_store_iterators.h"
+#include "kis_image_config.h"
+#include "swap/kis_tile_compressor_2.h"
 
 Q_GLOBAL_STATIC(KisTileDataStore, s_instance)
 
@@ -67,23 +73,75 @@ qint64 __preclone_miss_age = 0;
 #define DEBUG_REPORT_PRECLONE_EFFICIENCY()
 #endif
 
+namespace {
+
+/**
+ * Loads a single tile data into memory on a prefetch thread. The job
+ * holds a reference to the tile data, so it cannot be destroyed while
+ * the job is waiting in the queue.
+ */
+class KisTileDataPrefetchJob : public QRunnable
+{
+public:
+    KisTileDataPrefetchJob(KisTileDataStore *store, KisTileData *td)
+        : m_store(store),
+          m_td(td)
+    {
+        m_td->ref();
+    }
+
+    void run() override {
+        // the tile might have already been loaded by the painting thread
+        if (m_store->isTileDataSwappedOut(m_td)) {
+            m_td->blockSwapping();
+            m_td->unblockSwapping();
+        }
+
+        m_td->deref();
+    }
+
+private:
+    KisTileDataStore *m_store;
+    KisTileData *m_td;
+};
+
+}
+
 KisTileDataStore::KisTileDataStore()
     : m_pooler(this),
       m_swapper(this),
       m_numTiles(0),
       m_memoryMetric(0),
       m_counter(1),
-      m_clockIndex(1)
+      m_clockIndex(1),
+      m_compactionClockIndex(1),
+      m_numUniformTiles(0),
+      m_uniformMemoryMetric(0),
+      m_numPackedTiles(0),
+      m_packedMemoryMetric(0),
+      m_packedDataSize(0),
+      m_numBrokenPackedTiles(0)
 {
+    m_compactUniformTiles = KisImageConfig(true).enableUniformTileCompaction();
+
+    m_prefetchPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
     m_pooler.start();
     m_swapper.start();
 }
 
 KisTileDataStore::~KisTileDataStore()
 {
+    m_prefetchPool.waitForDone();
+
     m_pooler.terminatePooler();
     m_swapper.terminateSwapper();
 
+    KisTileCompressor2 *decompressor = 0;
+    while (m_packedDecompressors.pop(decompressor)) {
+        delete decompressor;
+    }
+
     if (numTiles() > 0) {
         errKrita << "Warning: some tiles have leaked:";
         errKrita << "\tTiles in memory:" << numTilesInMemory() << "\n"
@@ -118,6 +176,22 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
 
+    stats.swapBytesWritten = m_swappedStore.bytesWritten();
+    stats.numSwappedOutTiles = m_swappedStore.numSwappedOut();
+    stats.numSwappedInTiles = m_swappedStore.numSwappedIn();
+    stats.numSwapOutBatches = m_swappedStore.numSwapOutBatches();
+
+    stats.deduplicatedSize = m_deduplicator.savedMemoryMetric() * metricCoeff;
+    stats.numDeduplicatedTiles = m_deduplicator.numDeduplicatedTiles();
+
+    stats.uniformTilesSize = m_uniformMemoryMetric.loadAcquire() * metricCoeff;
+    stats.numUniformTiles = m_numUniformTiles.loadAcquire();
+
+    stats.packedTilesSize = m_packedMemoryMetric.loadAcquire() * metricCoeff -
+        m_packedDataSize.loadAcquire();
+    stats.numPackedTiles = m_numPackedTiles.loadAcquire();
+    stats.numBrokenPackedTiles = m_numBrokenPackedTiles.loadAcquire();
+
     return stats;
 }
 
@@ -134,7 +208,7 @@ inline void KisTileDataStore::registerTileDataImp(KisTileData *td)
     m_tileDataMap.getGC().unlockRawPointerAccess();
 
     m_numTiles.ref();
-    m_memoryMetric += td->pixelSize();
+    m_memoryMetric += td->memoryMetric();
 }
 
 void KisTileDataStore::registerTileData(KisTileData *td)
@@ -143,6 +217,15 @@ void KisTileDataStore::registerTileData(KisTileData *td)
     registerTileDataImp(td);
 }
 
+inline void KisTileDataStore::advanceClockIndex(QAtomicInt &clockIndex, int removedTileNumber)
+{
+    if (clockIndex == removedTileNumber) {
+        do {
+            clockIndex.ref();
+        } while (!m_tileDataMap.get(clockIndex.loadAcquire()) && clockIndex < m_counter);
+    }
+}
+
 inline void KisTileDataStore::unregisterTileDataImp(KisTileData *td)
 {
     // make sure that access to the hash table is guarded by GC block
@@ -150,17 +233,14 @@ inline void KisTileDataStore::unregisterTileDataImp(KisTileData *td)
     // migrations)
     m_tileDataMap.getGC().lockRawPointerAccess();
 
-    if (m_clockIndex == td->m_tileNumber) {
-        do {
-            m_clockIndex.ref();
-        } while (!m_tileDataMap.get(m_clockIndex.loadAcquire()) && m_clockIndex < m_counter);
-    }
+    advanceClockIndex(m_clockIndex, td->m_tileNumber);
+    advanceClockIndex(m_compactionClockIndex, td->m_tileNumber);
 
     int index = td->m_tileNumber;
     td->m_tileNumber = -1;
     m_tileDataMap.erase(index);
     m_numTiles.deref();
-    m_memoryMetric -= td->pixelSize();
+    m_memoryMetric -= td->memoryMetric();
 
     m_tileDataMap.getGC().unlockRawPointerAccess();
 }
@@ -171,13 +251,38 @@ void KisTileDataStore::unregisterTileData(KisTileData *td)
     unregisterTileDataImp(td);
 }
 
-KisTileData *KisTileDataStore::allocTileData(qint32 pixelSize, const quint8 *defPixel)
+KisTileData *KisTileDataStore::allocTileData(qint32 pixelSize, const quint8 *defPixel, qint32 tileSize)
 {
-    KisTileData *td = new KisTileData(pixelSize, defPixel, this);
+    KisTileData *td = new KisTileData(pixelSize, defPixel, this, true, tileSize);
     registerTileData(td);
     return td;
 }
 
+KisTileData *KisTileDataStore::createPackedTileData(qint32 pixelSize,
+                                                    const quint8 *packedData, qint32 packedDataSize,
+                                                    qint32 tileSize)
+{
+    KisTileData *td = new KisTileData(pixelSize, packedData, packedDataSize, this, tileSize);
+
+    m_numPackedTiles.ref();
+    m_packedMemoryMetric.fetchAndAddOrdered(td->memoryMetric());
+    m_packedDataSize.fetchAndAddOrdered(packedDataSize);
+
+    checkFreeMemory();
+
+    return td;
+}
+
+inline void KisTileDataStore::makeTileDataUniform(KisTileData *td)
+{
+    td->m_uniformPixel = new quint8[td->pixelSize()];
+    memcpy(td->m_uniformPixel, td->data(), td->pixelSize());
+    td->releaseMemory();
+
+    m_numUniformTiles.ref();
+    m_uniformMemoryMetric.fetchAndAddOrdered(td->memoryMetric());
+}
+
 KisTileData *KisTileDataStore::duplicateTileData(KisTileData *rhs)
 {
     KisTileData *td = 0;
@@ -206,7 +311,19 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     m_iteratorLock.lockForRead();
     td->m_swapLock.lockForWrite();
 
-    if (!td->data()) {
+    KisTileData *dedupSource = td->m_dedupSource;
+    m_deduplicator.forgetTileData(td);
+
+    if (dedupSource) {
+        td->m_dedupSource = 0;
+    } else if (td->m_uniformPixel) {
+        m_numUniformTiles.deref();
+        m_uniformMemoryMetric.fetchAndAddOrdered(-td->memoryMetric());
+    } else if (td->m_packedData) {
+        m_numPackedTiles.deref();
+        m_packedMemoryMetric.fetchAndAddOrdered(-td->memoryMetric());
+        m_packedDataSize.fetchAndAddOrdered(-td->m_packedDataSize);
+    } else if (!td->data()) {
         m_swappedStore.forgetTileData(td);
     } else {
         unregisterTileDataImp(td);
@@ -216,6 +333,14 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     m_iteratorLock.unlock();
 
     delete td;
+
+    /**
+     * The source may be freed as well, so release it only
+     * after all the locks are released
+     */
+    if (dedupSource) {
+        dedupSource->release();
+    }
 }
 
 void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
@@ -226,8 +351,24 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
     td->m_swapLock.lockForRead();
 
     while (!td->data()) {
+        /**
+         * A deduplicated tile data is restored from its source. The
+         * source itself may be swapped out, so it should be loaded
+         * before we take m_iteratorLock, because loading needs the
+         * lock as well. The extra reference guarantees the source
+         * will not be deleted until we finish.
+         */
+        KisTileData *dedupSource = td->m_dedupSource;
+        if (dedupSource) {
+            dedupSource->ref();
+        }
+
         td->m_swapLock.unlock();
 
+        if (dedupSource) {
+            dedupSource->blockSwapping();
+        }
+
         /**
          * The order of this heavy locking is very important.
          * Change it only in case, you really know what you are doing.
@@ -247,16 +388,120 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
          * m_listLock.
          */
 
-        if (!td->data()) {
+        if (!td->data() && td->m_dedupSource) {
             td->m_swapLock.lockForWrite();
 
-            m_swappedStore.swapInTileData(td);
+            if (td->m_dedupSource == dedupSource) {
+                td->allocateMemory();
+                memcpy(td->m_data, dedupSource->data(),
+                       td->dataSize());
+                td->m_dedupSource = 0;
+
+                m_deduplicator.notifyTileDataRestored(td);
+                registerTileDataImp(td);
+
+                // we still hold an extra reference, so it will not be freed
+                dedupSource->release();
+            }
+
+            td->m_swapLock.unlock();
+            m_iteratorLock.unlock();
+
+        } else if (!td->data() && td->m_uniformPixel) {
+            td->m_swapLock.lockForWrite();
+
+            if (!td->data()) {
+                td->allocateMemory();
+                td->fillWithPixel(td->m_uniformPixel);
+
+                m_numUniformTiles.deref();
+                m_uniformMemoryMetric.fetchAndAddOrdered(-td->memoryMetric());
+
+                delete[] td->m_uniformPixel;
+                td->m_uniformPixel = 0;
+
+                registerTileDataImp(td);
+            }
+
+            td->m_swapLock.unlock();
+            m_iteratorLock.unlock();
+
+        } else if (!td->data() && td->m_packedData) {
+            td->m_swapLock.lockForWrite();
+
+            if (!td->data()) {
+                td->allocateMemory();
+
+                m_numPackedTiles.deref();
+                m_packedMemoryMetric.fetchAndAddOrdered(-td->memoryMetric());
+
+                registerTileDataImp(td);
+                m_iteratorLock.unlock();
+
+                /**
+                 * The same as with the swapped tiles, unpack the data
+                 * without holding m_iteratorLock. The swap lock of
+                 * the tile data is still held.
+                 */
+                KisTileCompressor2 *decompressor = 0;
+                if (!m_packedDecompressors.pop(decompressor)) {
+                    decompressor = new KisTileCompressor2();
+                }
+
+                /**
+                 * readTileLazily() checks only the size of the packed
+                 * data, the stream itself is checked here, when it is
+                 * unpacked for the first time. The file cannot be
+                 * rejected anymore, so the broken tile is reported,
+                 * counted in the memory statistics and reset to zero.
+                 */
+                if (!decompressor->decompressTileData(td->m_packedData, td->m_packedDataSize, td)) {
+                    const int numBrokenTiles = m_numBrokenPackedTiles.fetchAndAddOrdered(1) + 1;
+                    errKrita << "ERROR: failed to unpack lazily loaded tile data, the tile is cleared"
+                             << ppVar(td->m_packedDataSize) << ppVar(numBrokenTiles);
+
+                    memset(td->m_data, 0, td->dataSize());
+                }
+
+                m_packedDecompressors.push(decompressor);
+
+                m_packedDataSize.fetchAndAddOrdered(-td->m_packedDataSize);
+                delete[] td->m_packedData;
+                td->m_packedData = 0;
+                td->m_packedDataSize = 0;
+            } else {
+                m_iteratorLock.unlock();
+            }
+
+            td->m_swapLock.unlock();
+
+        } else if (!td->data()) {
+            td->m_swapLock.lockForWrite();
+
+            QByteArray compressedData;
+            m_swappedStore.fetchTileData(td, compressedData);
             registerTileDataImp(td);
 
+            m_iteratorLock.unlock();
+
+            /**
+             * The data is decompressed without holding m_iteratorLock,
+             * so several threads (e.g. the prefetch ones) can unpack
+             * different tiles in parallel. The swap lock of the tile
+             * data is still held, so no one can read the not yet
+             * initialized data in the meantime.
+             */
+            m_swappedStore.unpackTileData(td, compressedData);
+
             td->m_swapLock.unlock();
+        } else {
+            m_iteratorLock.unlock();
         }
 
-        m_iteratorLock.unlock();
+        if (dedupSource) {
+            dedupSource->unblockSwapping();
+            dedupSource->deref();
+        }
 
         /**
          * <-- In theory, livelock is possible here...
@@ -266,6 +511,13 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
     }
 }
 
+void KisTileDataStore::prefetchTileData(KisTileData *td)
+{
+    if (!isTileDataSwappedOut(td)) return;
+
+    m_prefetchPool.start(new KisTileDataPrefetchJob(this, td));
+}
+
 bool KisTileDataStore::trySwapTileData(KisTileData *td)
 {
     /**
@@ -286,6 +538,105 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+qint64 KisTileDataStore::trySwapTileDataBatch(const QVector<KisTileData*> &tiles)
+{
+    /**
+     * This function is called with m_listLock acquired
+     */
+
+    QVector<KisTileData*> lockedTiles;
+    lockedTiles.reserve(tiles.size());
+
+    Q_FOREACH (KisTileData *td, tiles) {
+        if (!td->m_swapLock.tryLockForWrite()) continue;
+
+        if (td->data()) {
+            lockedTiles.append(td);
+        } else {
+            td->m_swapLock.unlock();
+        }
+    }
+
+    m_swappedStore.trySwapOutTileDataBatch(lockedTiles);
+
+    qint64 freedMetric = 0;
+
+    Q_FOREACH (KisTileData *td, lockedTiles) {
+        if (!td->data()) {
+            unregisterTileDataImp(td);
+            freedMetric += td->memoryMetric();
+        }
+        td->m_swapLock.unlock();
+    }
+
+    return freedMetric;
+}
+
+void KisTileDataStore::compactTileData(int maxCheckedTiles)
+{
+    if (!m_compactUniformTiles && !m_deduplicator.isEnabled()) return;
+
+    compactTileDataImpl(maxCheckedTiles, m_compactUniformTiles, m_deduplicator.isEnabled(), true);
+}
+
+namespace {
+inline bool isUniform(const quint8 *data, int pixelSize, int dataSize)
+{
+    /**
+     * If every byte equals to the byte one pixel further,
+     * all the pixels are the same
+     */
+    return !memcmp(data, data + pixelSize, dataSize - pixelSize);
+}
+}
+
+void KisTileDataStore::compactTileDataImpl(int budget, bool compactUniform, bool deduplicate, bool skipRecentTiles)
+{
+    QWriteLocker locker(&m_iteratorLock);
+
+    if (!m_numTiles) return;
+
+    /**
+     * The store is locked while we walk through it, so we check only
+     * \p budget tiles per call and continue from the same position
+     * the next time, like the swapper's clock does
+     */
+    KisTileDataStoreClockIterator iter(m_tileDataMap, m_compactionClockIndex.loadAcquire(), this);
+
+    while (iter.hasNext() && budget > 0) {
+        KisTileData *item = iter.next();
+        budget--;
+
+        /**
+         * The tiles that have been accessed since the previous visit
+         * are likely to be changed again soon, so don't waste time
+         * on them. Locking the tile data resets its age.
+         */
+        if (skipRecentTiles && item->age() == 0) {
+            item->markOld();
+            continue;
+        }
+
+        // skip the tiles someone is working with right now
+        if (!item->m_swapLock.tryLockForWrite()) continue;
+
+        if (item->data()) {
+            if (compactUniform && isUniform(item->data(), item->pixelSize(), item->dataSize())) {
+                m_deduplicator.forgetTileData(item);
+                unregisterTileDataImp(item);
+                makeTileDataUniform(item);
+
+            } else if (deduplicate && m_deduplicator.tryDeduplicate(item, budget)) {
+                unregisterTileDataImp(item);
+            }
+        }
+
+        item->m_swapLock.unlock();
+    }
+
+    m_compactionClockIndex = iter.getFinalPosition();
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_iteratorLock.lockForWrite();
@@ -357,6 +708,8 @@ void KisTileDataStore::debugSwapAll()
 void KisTileDataStore::debugClear()
 {
     QWriteLocker l(&m_iteratorLock);
+    m_deduplicator.clear();
+
     ConcurrentMap<int, KisTileData*>::Iterator iter(m_tileDataMap);
 
     while (iter.isValid()) {
@@ -366,6 +719,7 @@ void KisTileDataStore::debugClear()
 
     m_counter = 1;
     m_clockIndex = 1;
+    m_compactionClockIndex = 1;
     m_numTiles = 0;
     m_memoryMetric = 0;
 }
@@ -374,6 +728,8 @@ void KisTileDataStore::testingRereadConfig()
 {
     m_pooler.testingRereadConfig();
     m_swapper.testingRereadConfig();
+    m_deduplicator.testingRereadConfig();
+    m_compactUniformTiles = KisImageConfig(true).enableUniformTileCompaction();
     kickPooler();
 }
 
@@ -386,3 +742,18 @@ void KisTileDataStore::testingResumePooler()
 {
     m_pooler.start();
 }
+
+void KisTileDataStore::testingWaitForPrefetch()
+{
+    m_prefetchPool.waitForDone();
+}
+
+void KisTileDataStore::testingDeduplicate()
+{
+    compactTileDataImpl(std::numeric_limits<int>::max(), false, true, false);
+}
+
+void KisTileDataStore::testingCompactUniformTiles()
+{
+    compactTileDataImpl(std::numeric_limits<int>::max(), true, false, false);
+}
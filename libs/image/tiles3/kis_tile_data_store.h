@@ -23,11 +23,13 @@
 #include "kritaimage_export.h"
 
 #include <QReadWriteLock>
+#include <QThreadPool>
 #include "kis_tile_data_interface.h"
 
 #include "kis_tile_data_pooler.h"
 #include "swap/kis_tile_data_swapper.h"
 #include "swap/kis_swapped_data_store.h"
+#include "kis_tile_data_deduplicator.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
 
 class KisTileDataStoreIterator;
@@ -54,17 +56,36 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+
+        qint64 swapBytesWritten;
+        qint64 numSwappedOutTiles;
+        qint64 numSwappedInTiles;
+        qint64 numSwapOutBatches;
+
+        qint64 deduplicatedSize;
+        qint64 numDeduplicatedTiles;
+
+        qint64 uniformTilesSize;
+        qint64 numUniformTiles;
+
+        qint64 packedTilesSize;
+        qint64 numPackedTiles;
+        qint64 numBrokenPackedTiles;
     };
 
     MemoryStatistics memoryStatistics();
 
     /**
-     * Returns total number of tiles present: in memory
-     * or in a swap file
+     * Returns total number of tiles present: in memory,
+     * in a swap file, sharing memory with other tiles,
+     * compacted into a single pixel or not yet unpacked
+     * after lazy loading
      */
     inline qint32 numTiles() const
     {
-        return m_numTiles.loadAcquire() + m_swappedStore.numTiles();
+        return m_numTiles.loadAcquire() + m_swappedStore.numTiles() +
+            m_deduplicator.numDeduplicatedTiles() + m_numUniformTiles.loadAcquire() +
+            m_numPackedTiles.loadAcquire();
     }
 
     /**
@@ -82,10 +103,14 @@ public:
 
     /**
      * \see m_memoryMetric
+     *
+     * The compressed data of the packed tiles is counted as well,
+     * so it is taken into account by the swapper's limits
      */
     inline qint64 memoryMetric() const
     {
-        return m_memoryMetric.loadAcquire();
+        return m_memoryMetric.loadAcquire() +
+            m_packedDataSize.loadAcquire() / (KisTileData::WIDTH * KisTileData::HEIGHT);
     }
 
     KisTileDataStoreIterator* beginIteration();
@@ -97,11 +122,26 @@ public:
     KisTileDataStoreClockIterator* beginClockIteration();
     void endIteration(KisTileDataStoreClockIterator* iterator);
 
-    inline KisTileData* createDefaultTileData(qint32 pixelSize, const quint8 *defPixel)
+    inline KisTileData* createDefaultTileData(qint32 pixelSize, const quint8 *defPixel,
+                                              qint32 tileSize = KisTileData::WIDTH)
     {
-        return allocTileData(pixelSize, defPixel);
+        return allocTileData(pixelSize, defPixel, tileSize);
     }
 
+    /**
+     * Creates a tile data that keeps a copy of \p packedData, the
+     * tile compressed by KisTileCompressor2::compressTileData(), and
+     * doesn't allocate any memory for the pixels. The data is
+     * unpacked when the tile data is accessed for the first time,
+     * so the tiles that are never touched cost only their
+     * compressed size.
+     *
+     * Used for lazy loading of the documents.
+     */
+    KisTileData* createPackedTileData(qint32 pixelSize,
+                                      const quint8 *packedData, qint32 packedDataSize,
+                                      qint32 tileSize = KisTileData::WIDTH);
+
     // Called by The Memento Manager after every commit
     inline void kickPooler()
     {
@@ -118,6 +158,34 @@ public:
      */
     bool trySwapTileData(KisTileData *td);
 
+    /**
+     * Try swap out a batch of tile data objects. The tiles that are
+     * being accessed at the moment are skipped. Returns the metric
+     * of the memory freed.
+     */
+    qint64 trySwapTileDataBatch(const QVector<KisTileData*> &tiles);
+
+    /**
+     * Walks through the tile data objects present in memory and
+     * compacts the ones that are filled with a single color into a
+     * single pixel. The rest of the tiles are hashed and the
+     * identical ones are made share their memory. Each kind of
+     * compaction is enabled separately in the config.
+     *
+     * Not more than \p maxCheckedTiles tiles are visited during one
+     * call, the next call continues from the place where the
+     * previous one stopped. The tiles accessed since the previous
+     * visit are skipped.
+     *
+     * Called by the swapper before swapping, when the memory is above
+     * the soft limit. Like the swapped-out tiles, the compacted ones
+     * have no data until the tile is locked, so without the memory
+     * pressure the data of the unlocked tiles stays available.
+     *
+     * \see KisTileDataDeduplicator
+     */
+    void compactTileData(int maxCheckedTiles = 1024);
+
 
     /**
      * WARN: The following three method are only for usage
@@ -140,15 +208,53 @@ public:
      */
     void ensureTileDataLoaded(KisTileData *td);
 
+    /**
+     * Returns true if there is at least one tile data
+     * swapped out to the disk. It is used as a cheap check
+     * before doing any prefetching work.
+     */
+    inline bool hasSwappedTiles() const
+    {
+        return m_swappedStore.numTiles() > 0;
+    }
+
+    /**
+     * Returns true if \p td is swapped out to the disk. Deduplicated,
+     * uniform and packed tile data have no memory on purpose, so they
+     * are not considered swapped out and are never prefetched.
+     *
+     * The check is done without locking, so it is only a hint.
+     */
+    inline bool isTileDataSwappedOut(KisTileData *td) const
+    {
+        return !td->data() && !td->m_dedupSource &&
+            !td->m_uniformPixel && !td->m_packedData;
+    }
+
+    /**
+     * Schedules loading of a swapped-out \p td on one of the prefetch
+     * threads. The call returns immediately. When the iterator
+     * actually reaches the tile data, it will either be already
+     * present in memory or ensureTileDataLoaded() will wait for
+     * the ongoing unpacking to complete.
+     *
+     * PRECONDITIONS: the caller guarantees that \p td will not be
+     *                destroyed while the call is in progress
+     */
+    void prefetchTileData(KisTileData *td);
+
     void registerTileData(KisTileData *td);
     void unregisterTileData(KisTileData *td);
 
 private:
-    KisTileData *allocTileData(qint32 pixelSize, const quint8 *defPixel);
+    KisTileData *allocTileData(qint32 pixelSize, const quint8 *defPixel, qint32 tileSize);
 
     inline void registerTileDataImp(KisTileData *td);
     inline void unregisterTileDataImp(KisTileData *td);
     void freeRegisteredTiles();
+    void compactTileDataImpl(int budget, bool compactUniform, bool deduplicate, bool skipRecentTiles);
+    inline void advanceClockIndex(QAtomicInt &clockIndex, int removedTileNumber);
+    inline void makeTileDataUniform(KisTileData *td);
 
     friend class DeadlockyThread;
     friend class KisLowMemoryTests;
@@ -160,15 +266,29 @@ private:
     void testingResumePooler();
 
     friend class KisLowMemoryBenchmark;
+    friend class KisDatamanagerBenchmark;
     void testingRereadConfig();
+    void testingWaitForPrefetch();
+    void testingDeduplicate();
+    void testingCompactUniformTiles();
 private:
     KisTileDataPooler m_pooler;
     KisTileDataSwapper m_swapper;
 
+    /**
+     * Worker threads that unpack swapped-out tiles ahead of
+     * the iterators. \see prefetchTileData()
+     */
+    QThreadPool m_prefetchPool;
+
     friend class KisTileDataStoreTest;
     friend class KisTileDataPoolerTest;
     KisSwappedDataStore m_swappedStore;
 
+    KisTileDataDeduplicator m_deduplicator;
+
+    bool m_compactUniformTiles;
+
     /**
      * This metric is used for computing the volume
      * of memory occupied by tile data objects.
@@ -178,6 +298,45 @@ private:
     QAtomicInt m_memoryMetric;
     QAtomicInt m_counter;
     QAtomicInt m_clockIndex;
+
+    /**
+     * The position where the next compaction pass starts
+     * \see compactTileData()
+     */
+    QAtomicInt m_compactionClockIndex;
+
+    /**
+     * The number and the metric of the tile data objects
+     * compacted into a single pixel
+     */
+    QAtomicInt m_numUniformTiles;
+    QAtomicInt m_uniformMemoryMetric;
+
+    /**
+     * The number and the metric of the tile data objects
+     * that are still packed after lazy loading
+     */
+    QAtomicInt m_numPackedTiles;
+    QAtomicInt m_packedMemoryMetric;
+
+    /**
+     * The number of bytes of the compressed data kept by the packed
+     * tiles. It is not a metric, because the compressed tiles are
+     * usually much smaller than the metric unit.
+     */
+    QAtomicInteger<qint64> m_packedDataSize;
+
+    /**
+     * The number of the lazily loaded tiles that could not be
+     * unpacked on the first access
+     */
+    QAtomicInt m_numBrokenPackedTiles;
+
+    /**
+     * Decompressors used for unpacking of the lazily loaded tiles
+     */
+    KisLocklessStack<KisTileCompressor2*> m_packedDecompressors;
+
     ConcurrentMap<int, KisTileData*> m_tileDataMap;
     QReadWriteLock m_iteratorLock;
 };
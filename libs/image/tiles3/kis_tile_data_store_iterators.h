@@ -73,6 +73,15 @@ public:
         return m_store->trySwapTileData(td);
     }
 
+    inline qint64 trySwapOut(const QVector<KisTileData*> &tiles)
+    {
+        while (m_iterator.isValid() && tiles.contains(m_iterator.getValue())) {
+            m_iterator.next();
+        }
+
+        return m_store->trySwapTileDataBatch(tiles);
+    }
+
 private:
     ConcurrentMap<int, KisTileData*> &m_map;
     ConcurrentMap<int, KisTileData*>::Iterator m_iterator;
@@ -148,6 +157,15 @@ public:
         return m_store->trySwapTileData(td);
     }
 
+    inline qint64 trySwapOut(const QVector<KisTileData*> &tiles)
+    {
+        while (m_iterator.isValid() && tiles.contains(m_iterator.getValue())) {
+            m_iterator.next();
+        }
+
+        return m_store->trySwapTileDataBatch(tiles);
+    }
+
 private:
     friend class KisTileDataStore;
     inline int getFinalPosition()
@@ -22,6 +22,7 @@
 #include "kis_shared.h"
 #include "kis_shared_ptr.h"
 #include "3rdparty/lock_free_map/concurrent_map.h"
+#include "kis_lockless_stack.h"
 #include "kis_tile.h"
 #include "kis_debug.h"
 
@@ -127,6 +128,55 @@ private:
         TileType *d;
     };
 
+    /**
+     * Releasing the tile data may free it and take the store's locks,
+     * which shouldn't happen while the QSBR is processing the grace
+     * period. So the reclaimer only moves the data into a queue, which
+     * is released later. \see releaseRetiredDefaultTileData()
+     */
+    struct DefaultTileDataReclaimer {
+        DefaultTileDataReclaimer(KisTileData *data, KisLocklessStack<KisTileData*> *queue)
+            : d(data), m_queue(queue) {}
+
+        void destroy()
+        {
+            m_queue->push(d);
+            delete this;
+        }
+
+    private:
+        KisTileData *d;
+        KisLocklessStack<KisTileData*> *m_queue;
+    };
+
+    inline void releaseRetiredDefaultTileData()
+    {
+        KisTileData *data = 0;
+        while (m_retiredDefaultTileData.pop(data)) {
+            data->release();
+        }
+    }
+
+    /**
+     * Creates a temporary tile with default data. The default tile data
+     * is read without any locks, it can be replaced in the meantime, but
+     * the old one is released by the QSBR only after all the readers
+     * have unlocked the raw pointer access.
+     */
+    inline TileTypeSP createDefaultTile(qint32 col, qint32 row)
+    {
+        m_map.getGC().lockRawPointerAccess();
+        KisTileData *defaultTileData = m_defaultTileData.loadAcquire();
+        defaultTileData->ref();
+        m_map.getGC().unlockRawPointerAccess();
+
+        // tile creation may take locks, so do it with no raw pointers held
+        TileTypeSP tile = new TileType(col, row, defaultTileData, 0);
+        defaultTileData->deref();
+
+        return tile;
+    }
+
     inline quint32 calculateHash(qint32 col, qint32 row)
     {
 #ifdef SANITY_CHECK
@@ -188,17 +238,26 @@ private:
 private:
     typedef ConcurrentMap<quint32, TileType*> LockFreeTileMap;
     typedef typename LockFreeTileMap::Mutator LockFreeTileMapMutator;
-    mutable LockFreeTileMap m_map;
 
     /**
-     * We still need something to guard changes in m_defaultTileData,
-     * otherwise there will be concurrent read/writes, resulting in broken memory.
+     * The default tile data objects that have passed the grace period
+     * and are waiting to be released. Declared before m_map, so that
+     * it outlives the map's QSBR.
      */
-    QReadWriteLock m_defaultPixelDataLock;
+    KisLocklessStack<KisTileData*> m_retiredDefaultTileData;
+
+    mutable LockFreeTileMap m_map;
+
     mutable QReadWriteLock m_iteratorLock;
 
     QAtomicInt m_numTiles;
-    KisTileData *m_defaultTileData;
+
+    /**
+     * The default tile data is replaced atomically and the old one
+     * is released through the map's QSBR, so the readers don't need
+     * any lock to access it. \see createDefaultTile()
+     */
+    QAtomicPointer<KisTileData> m_defaultTileData;
     KisMementoManager *m_mementoManager;
 };
 
@@ -267,7 +326,7 @@ template <class T>
 KisTileHashTableTraits2<T>::KisTileHashTableTraits2(const KisTileHashTableTraits2<T> &ht, KisMementoManager *mm)
     : KisTileHashTableTraits2(mm)
 {
-    setDefaultTileData(ht.m_defaultTileData);
+    setDefaultTileData(ht.m_defaultTileData.loadAcquire());
 
     QWriteLocker locker(&ht.m_iteratorLock);
     typename ConcurrentMap<quint32, TileType*>::Iterator iter(ht.m_map);
@@ -284,6 +343,10 @@ KisTileHashTableTraits2<T>::~KisTileHashTableTraits2()
 {
     clear();
     setDefaultTileData(0);
+
+    // no readers are left, so all the retired data can be released now
+    m_map.getGC().flush();
+    releaseRetiredDefaultTileData();
 }
 
 template<class T>
@@ -322,10 +385,7 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getT
         // raw-pointer lock held
         m_map.getGC().unlockRawPointerAccess();
 
-        {
-            QReadLocker locker(&m_defaultPixelDataLock);
-            tile = new TileType(col, row, m_defaultTileData, 0);
-        }
+        tile = createDefaultTile(col, row);
 
         TileTypeSP::ref(&tile, tile.data());
         TileType *discardedTile = 0;
@@ -385,8 +445,7 @@ typename KisTileHashTableTraits2<T>::TileTypeSP KisTileHashTableTraits2<T>::getR
     existingTile = tile;
 
     if (!existingTile) {
-        QReadLocker locker(&m_defaultPixelDataLock);
-        tile = new TileType(col, row, m_defaultTileData, 0);
+        tile = createDefaultTile(col, row);
     }
 
     m_map.getGC().update();
@@ -445,24 +504,26 @@ void KisTileHashTableTraits2<T>::clear()
 template <class T>
 inline void KisTileHashTableTraits2<T>::setDefaultTileData(KisTileData *defaultTileData)
 {
-    QWriteLocker locker(&m_defaultPixelDataLock);
-
-    if (m_defaultTileData) {
-        m_defaultTileData->release();
-        m_defaultTileData = 0;
-    }
-
     if (defaultTileData) {
         defaultTileData->acquire();
-        m_defaultTileData = defaultTileData;
     }
+
+    KisTileData *oldTileData = m_defaultTileData.fetchAndStoreOrdered(defaultTileData);
+
+    if (oldTileData) {
+        // someone might still be creating a tile from the old data
+        m_map.getGC().enqueue(&DefaultTileDataReclaimer::destroy,
+                              new DefaultTileDataReclaimer(oldTileData, &m_retiredDefaultTileData));
+    }
+
+    m_map.getGC().update();
+    releaseRetiredDefaultTileData();
 }
 
 template <class T>
 inline KisTileData* KisTileHashTableTraits2<T>::defaultTileData()
 {
-    QReadLocker locker(&m_defaultPixelDataLock);
-    return m_defaultTileData;
+    return m_defaultTileData.loadAcquire();
 }
 
 template <class T>
@@ -20,6 +20,8 @@
 
 #include <QRect>
 #include <QVector>
+#include <QThread>
+#include <QtConcurrent>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
@@ -30,11 +32,13 @@
 #include "swap/kis_tile_compressor_factory.h"
 
 #include "kis_paint_device_writer.h"
+#include "kis_lockless_stack.h"
 
 #include "kis_global.h"
+#include "kis_assert.h"
 
 
-/* The data area is divided into tiles each say 64x64 pixels (defined at compiletime)
+/* The data area is divided into tiles each say 64x64 pixels (defined per data manager)
  * The tiles are laid out in a matrix that can have negative indexes.
  * The matrix grows automatically if needed (a call for writeacces to a tile
  * outside the current extent)
@@ -43,8 +47,12 @@
  */
 
 KisTiledDataManager::KisTiledDataManager(quint32 pixelSize,
-                                         const quint8 *defaultPixel)
+                                         const quint8 *defaultPixel,
+                                         qint32 tileSize)
 {
+    initTileSize(tileSize > 0 ? tileSize : KisTileData::WIDTH);
+    initUniqueId();
+
     /* See comment in destructor for details */
     m_mementoManager = new KisMementoManager();
     m_hashTable = new KisTileHashTable(m_mementoManager);
@@ -57,6 +65,9 @@ KisTiledDataManager::KisTiledDataManager(quint32 pixelSize,
 KisTiledDataManager::KisTiledDataManager(const KisTiledDataManager &dm)
     : KisShared()
 {
+    initTileSize(dm.m_tileWidth);
+    initUniqueId();
+
     /* See comment in destructor for details */
 
     /* We do not clone the history of the device, there is no usecase for it */
@@ -90,6 +101,40 @@ KisTiledDataManager::~KisTiledDataManager()
     delete[] m_defaultPixel;
 }
 
+void KisTiledDataManager::initTileSize(qint32 tileSize)
+{
+    KIS_SAFE_ASSERT_RECOVER(isValidTileSize(tileSize)) {
+        tileSize = KisTileData::WIDTH;
+    }
+
+    m_tileWidth = tileSize;
+    m_tileHeight = tileSize;
+
+    m_tileWidthShift = 0;
+    while ((1 << m_tileWidthShift) < m_tileWidth) {
+        m_tileWidthShift++;
+    }
+    m_tileHeightShift = m_tileWidthShift;
+
+    m_extentManager.setTileSize(m_tileWidth, m_tileHeight);
+}
+
+void KisTiledDataManager::initUniqueId()
+{
+    static QAtomicInteger<quint64> s_lastId;
+    m_uniqueId = s_lastId.fetchAndAddRelaxed(1) + 1;
+}
+
+bool KisTiledDataManager::isValidTileSize(qint32 tileSize)
+{
+    /**
+     * The tiles smaller than the default ones cannot be
+     * expressed in the store's memory metric
+     */
+    return tileSize >= KisTileData::WIDTH && tileSize <= 256 &&
+        !(tileSize & (tileSize - 1));
+}
+
 void KisTiledDataManager::setDefaultPixel(const quint8 *defaultPixel)
 {
     QWriteLocker locker(&m_lock);
@@ -98,15 +143,31 @@ void KisTiledDataManager::setDefaultPixel(const quint8 *defaultPixel)
 
 void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
 {
-    KisTileData *td = KisTileDataStore::instance()->createDefaultTileData(pixelSize(), defaultPixel);
+    KisTileData *td = KisTileDataStore::instance()->createDefaultTileData(pixelSize(), defaultPixel, m_tileWidth);
     m_hashTable->setDefaultTileData(td);
     m_mementoManager->setDefaultTileData(td);
 
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
+    notifyDataChanged();
 }
 
 bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
 {
+    if (m_tileWidth != KisTileData::WIDTH || m_tileHeight != KisTileData::HEIGHT) {
+        /**
+         * The tiles are always saved in the default size, so that
+         * the files could be opened by the older versions of Krita
+         */
+        KisTiledDataManager dm(m_pixelSize, m_defaultPixel, KisTileData::WIDTH);
+
+        {
+            QReadLocker locker(&m_lock);
+            dm.bitBlt(this, extent());
+        }
+
+        return dm.write(store);
+    }
+
     QReadLocker locker(&m_lock);
 
     bool retval = true;
@@ -121,24 +182,125 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
     }
 
 
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
+
     KisTileHashTableConstIterator iter(m_hashTable);
     KisTileSP tile;
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
-
     while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
-        }
+        tiles.append(tile);
         iter.next();
     }
 
+    return retval && writeTilesConcurrently(tiles, store);
+}
+
+namespace {
+
+class KisBufferPaintDeviceWriter : public KisPaintDeviceWriter
+{
+public:
+    KisBufferPaintDeviceWriter(QByteArray &buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    bool write(const QByteArray &data) override {
+        m_buffer.append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_buffer.append(data, length);
+        return true;
+    }
+
+private:
+    QByteArray &m_buffer;
+};
+
+struct TileSerializationJob {
+    KisTileSP tile;
+    QByteArray data;
+    bool result = false;
+};
+
+}
+
+bool KisTiledDataManager::writeTilesConcurrently(const QVector<KisTileSP> &tiles,
+                                                 KisPaintDeviceWriter &store)
+{
+    KisLocklessStack<KisAbstractTileCompressorSP> compressorsPool;
+
+    auto serializeTile = [&compressorsPool] (TileSerializationJob &job) {
+        KisAbstractTileCompressorSP compressor;
+        if (!compressorsPool.pop(compressor)) {
+            compressor = KisTileCompressorFactory::create(CURRENT_VERSION);
+        }
+
+        job.data.clear();
+        KisBufferPaintDeviceWriter writer(job.data);
+        job.result = compressor->writeTile(job.tile, writer);
+
+        compressorsPool.push(compressor);
+    };
+
+    /**
+     * The tiles are compressed in batches on all the available
+     * cores, while the main thread streams the previous batch into
+     * the store. The order of the tiles in the stream is kept the
+     * same as in the serial version, so the files are bit-exact.
+     *
+     * The batch size limits the amount of memory kept in the
+     * intermediate buffers.
+     */
+    const int batchSize = 16 * qMax(1, QThread::idealThreadCount());
+
+    QVector<TileSerializationJob> currentBatch;
+    QVector<TileSerializationJob> nextBatch;
+    QFuture<void> nextBatchFuture;
+
+    auto startBatch = [&] (int start, QVector<TileSerializationJob> &batch) {
+        const int size = qMin(batchSize, tiles.size() - start);
+        batch.resize(size);
+        for (int i = 0; i < size; i++) {
+            batch[i].tile = tiles[start + i];
+        }
+        nextBatchFuture = QtConcurrent::map(batch, serializeTile);
+    };
+
+    bool retval = true;
+
+    if (!tiles.isEmpty()) {
+        startBatch(0, nextBatch);
+    }
+
+    for (int start = 0; start < tiles.size(); start += batchSize) {
+        nextBatchFuture.waitForFinished();
+        std::swap(currentBatch, nextBatch);
+
+        const int nextStart = start + batchSize;
+        if (nextStart < tiles.size()) {
+            startBatch(nextStart, nextBatch);
+        }
+
+        Q_FOREACH (const TileSerializationJob &job, currentBatch) {
+            retval = job.result && store.write(job.data);
+            if (!retval) {
+                warnFile << "Failed to write tile";
+                break;
+            }
+        }
+
+        if (!retval) break;
+    }
+
+    nextBatchFuture.waitForFinished();
+
     return retval;
 }
-bool KisTiledDataManager::read(QIODevice *stream)
+bool KisTiledDataManager::read(QIODevice *stream, bool lazy)
 {
     clear();
 
@@ -156,6 +318,7 @@ bool KisTiledDataManager::read(QIODevice *stream)
 
     quint32 numTiles;
     qint32 tilesVersion = LEGACY_VERSION;
+    qint32 tileSize = KisTileData::WIDTH;
 
     if (line[0] == 'V') {
         QList<QByteArray> lineItems = line.split(' ');
@@ -165,7 +328,7 @@ bool KisTiledDataManager::read(QIODevice *stream)
 
         tilesVersion = lineItems.takeFirst().toInt();
 
-        if(!processTilesHeader(stream, numTiles))
+        if(!processTilesHeader(stream, numTiles, tileSize))
             return false;
     }
     else {
@@ -175,17 +338,49 @@ bool KisTiledDataManager::read(QIODevice *stream)
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(tilesVersion);
 
+    /**
+     * The tiles of a different size are read into a temporary
+     * data manager and then copied into this one
+     */
+    KisTiledDataManagerSP tilesSource;
+    if (tileSize != m_tileWidth) {
+        tilesSource = new KisTiledDataManager(m_pixelSize, m_defaultPixel, tileSize);
+    }
+
     bool readSuccess = true;
     for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
+        /**
+         * The tiles of a different size are copied into this data
+         * manager right away, so there is no point in keeping them
+         * packed
+         */
+        const bool result = tilesSource ?
+            compressor->readTile(stream, tilesSource.data()) :
+            lazy ?
+            compressor->readTileLazily(stream, this) :
+            compressor->readTile(stream, this);
+
+        if (!result) {
             readSuccess = false;
         }
     }
 
+    if (tilesSource) {
+        bitBlt(tilesSource.data(), tilesSource->extent());
+    }
+
     m_mementoManager->commit();
     return readSuccess;
 }
 
+void KisTiledDataManager::addTile(qint32 col, qint32 row, KisTileData *td)
+{
+    KisTileSP tile = KisTileSP(new KisTile(col, row, td, m_mementoManager));
+    m_hashTable->addTile(tile);
+    m_extentManager.notifyTileAdded(col, row);
+    notifyDataChanged();
+}
+
 bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles)
 {
     QString buffer;
@@ -196,8 +391,8 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
                      "PIXELSIZE %4\n"
                      "DATA %5\n")
         .arg(CURRENT_VERSION)
-        .arg(KisTileData::WIDTH)
-        .arg(KisTileData::HEIGHT)
+        .arg(m_tileWidth)
+        .arg(m_tileHeight)
         .arg(pixelSize())
         .arg(numTiles);
 
@@ -214,7 +409,7 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
     } while(0)                                                  \
 
 
-bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTiles)
+bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTiles, qint32 &tileSize)
 {
     /**
      * We assume that there is only one version of this header
@@ -234,11 +429,13 @@ bool KisTiledDataManager::processTilesHeader(QIODevice *stream, quint32 &numTile
         takeOneLine(stream, maxLineLength, keyword, value);
 
         if (keyword == "TILEWIDTH") {
-            if(value != KisTileData::WIDTH)
+            if(!isValidTileSize(value))
                 goto wrongString;
+            tileSize = value;
         }
         else if (keyword == "TILEHEIGHT") {
-            if(value != KisTileData::HEIGHT)
+            // only square tiles are supported
+            if(value != tileSize)
                 goto wrongString;
         }
         else if (keyword == "PIXELSIZE") {
@@ -272,8 +469,8 @@ void KisTiledDataManager::purge(const QRect& area)
 {
     QList<KisTileSP> tilesToDelete;
     {
-        const qint32 tileDataSize = KisTileData::HEIGHT * KisTileData::WIDTH * pixelSize();
         KisTileData *tileData = m_hashTable->defaultTileData();
+        const qint32 tileDataSize = tileData->dataSize();
         tileData->blockSwapping();
         const quint8 *defaultData = tileData->data();
 
@@ -343,27 +540,27 @@ void KisTiledDataManager::clear(QRect clearRect, const quint8 *clearPixel)
     qint32 firstRow = yToRow(clearRect.top());
     qint32 lastRow = yToRow(clearRect.bottom());
 
-    const quint32 rowStride = KisTileData::WIDTH * pixelSize;
+    const quint32 rowStride = m_tileWidth * pixelSize;
 
     // Generate one row
     quint8 *clearPixelData = 0;
-    quint32 maxRunLength = qMin(clearRect.width(), KisTileData::WIDTH);
+    quint32 maxRunLength = qMin(clearRect.width(), m_tileWidth);
     clearPixelData = duplicatePixel(maxRunLength, clearPixel);
 
     KisTileData *td = 0;
     if (!pixelBytesAreDefault &&
-        clearRect.width() >= KisTileData::WIDTH &&
-        clearRect.height() >= KisTileData::HEIGHT) {
+        clearRect.width() >= m_tileWidth &&
+        clearRect.height() >= m_tileHeight) {
 
-        td = KisTileDataStore::instance()->createDefaultTileData(pixelSize, clearPixel);
+        td = KisTileDataStore::instance()->createDefaultTileData(pixelSize, clearPixel, m_tileWidth);
         td->acquire();
     }
 
     for (qint32 row = firstRow; row <= lastRow; ++row) {
         for (qint32 column = firstColumn; column <= lastColumn; ++column) {
 
-            QRect tileRect(column*KisTileData::WIDTH, row*KisTileData::HEIGHT,
-                           KisTileData::WIDTH, KisTileData::HEIGHT);
+            QRect tileRect(column * m_tileWidth, row * m_tileHeight,
+                           m_tileWidth, m_tileHeight);
             QRect clearTileRect = clearRect & tileRect;
 
             if (clearTileRect == tileRect) {
@@ -410,6 +607,8 @@ void KisTiledDataManager::clear(QRect clearRect, const quint8 *clearPixel)
 
     if (td) td->release();
     delete[] clearPixelData;
+
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::clear(QRect clearRect, quint8 clearValue)
@@ -433,6 +632,7 @@ void KisTiledDataManager::clear()
 {
     m_hashTable->clear();
     m_extentManager.clear();
+    notifyDataChanged();
 }
 
 
@@ -441,11 +641,16 @@ void KisTiledDataManager::bitBltImpl(KisTiledDataManager *srcDM, const QRect &re
 {
     if (rect.isEmpty()) return;
 
+    if (srcDM->m_tileWidth != m_tileWidth || srcDM->m_tileHeight != m_tileHeight) {
+        bitBltPixelsImpl<useOldSrcData>(srcDM, rect);
+        return;
+    }
+
     const qint32 pixelSize = this->pixelSize();
     const bool defaultPixelsCoincide =
         !memcmp(srcDM->defaultPixel(), m_defaultPixel, pixelSize);
 
-    const quint32 rowStride = KisTileData::WIDTH * pixelSize;
+    const quint32 rowStride = m_tileWidth * pixelSize;
 
     qint32 firstColumn = xToCol(rect.left());
     qint32 lastColumn = xToCol(rect.right());
@@ -463,8 +668,8 @@ void KisTiledDataManager::bitBltImpl(KisTiledDataManager *srcDM, const QRect &re
                 srcDM->getOldTile(column, row, srcTileExists) :
                 srcDM->getReadOnlyTileLazy(column, row, srcTileExists);
 
-            QRect tileRect(column*KisTileData::WIDTH, row*KisTileData::HEIGHT,
-                           KisTileData::WIDTH, KisTileData::HEIGHT);
+            QRect tileRect(column * m_tileWidth, row * m_tileHeight,
+                           m_tileWidth, m_tileHeight);
             QRect cloneTileRect = rect & tileRect;
 
             if (cloneTileRect == tileRect) {
@@ -518,6 +723,11 @@ void KisTiledDataManager::bitBltRoughImpl(KisTiledDataManager *srcDM, const QRec
 {
     if (rect.isEmpty()) return;
 
+    if (srcDM->m_tileWidth != m_tileWidth || srcDM->m_tileHeight != m_tileHeight) {
+        bitBltPixelsImpl<useOldSrcData>(srcDM, rect);
+        return;
+    }
+
     const qint32 pixelSize = this->pixelSize();
     const bool defaultPixelsCoincide =
         !memcmp(srcDM->defaultPixel(), m_defaultPixel, pixelSize);
@@ -564,24 +774,80 @@ void KisTiledDataManager::bitBltRoughImpl(KisTiledDataManager *srcDM, const QRec
     }
 }
 
+template<bool useOldSrcData>
+void KisTiledDataManager::bitBltPixelsImpl(KisTiledDataManager *srcDM, const QRect &rect)
+{
+    /**
+     * The tiles of the data managers have different sizes, so
+     * they cannot be shared. Copy the source tiles pixel-wise.
+     */
+
+    const qint32 pixelSize = this->pixelSize();
+    const qint32 srcRowStride = srcDM->m_tileWidth * pixelSize;
+    const bool defaultPixelsCoincide =
+        !memcmp(srcDM->defaultPixel(), m_defaultPixel, pixelSize);
+
+    qint32 firstColumn = srcDM->xToCol(rect.left());
+    qint32 lastColumn = srcDM->xToCol(rect.right());
+
+    qint32 firstRow = srcDM->yToRow(rect.top());
+    qint32 lastRow = srcDM->yToRow(rect.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+
+            bool srcTileExists = false;
+
+            KisTileSP srcTile = useOldSrcData ?
+                srcDM->getOldTile(column, row, srcTileExists) :
+                srcDM->getReadOnlyTileLazy(column, row, srcTileExists);
+
+            const QRect srcTileRect = srcTile->extent();
+            const QRect cloneRect = rect & srcTileRect;
+
+            if (!srcTileExists && defaultPixelsCoincide) {
+                clear(cloneRect, m_defaultPixel);
+                continue;
+            }
+
+            srcTile->lockForRead();
+
+            const quint8 *srcIt = srcTile->data() +
+                (cloneRect.y() - srcTileRect.y()) * srcRowStride +
+                (cloneRect.x() - srcTileRect.x()) * pixelSize;
+
+            writeBytesBody(srcIt,
+                           cloneRect.x(), cloneRect.y(),
+                           cloneRect.width(), cloneRect.height(),
+                           srcRowStride);
+
+            srcTile->unlockForRead();
+        }
+    }
+}
+
 void KisTiledDataManager::bitBlt(KisTiledDataManager *srcDM, const QRect &rect)
 {
     bitBltImpl<false>(srcDM, rect);
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::bitBltOldData(KisTiledDataManager *srcDM, const QRect &rect)
 {
     bitBltImpl<true>(srcDM, rect);
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::bitBltRough(KisTiledDataManager *srcDM, const QRect &rect)
 {
     bitBltRoughImpl<false>(srcDM, rect);
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::bitBltRoughOldData(KisTiledDataManager *srcDM, const QRect &rect)
 {
     bitBltRoughImpl<true>(srcDM, rect);
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::setExtent(qint32 x, qint32 y, qint32 w, qint32 h)
@@ -621,10 +887,10 @@ void KisTiledDataManager::setExtent(QRect newRect)
                 quint8* ptr;
 
                 /* FIXME: make it faster */
-                for (int y = 0; y < KisTileData::HEIGHT; y++) {
-                    for (int x = 0; x < KisTileData::WIDTH; x++) {
+                for (int y = 0; y < m_tileHeight; y++) {
+                    for (int x = 0; x < m_tileWidth; x++) {
                         if (!intersection.contains(x, y)) {
-                            ptr = data + pixelSize * (y * KisTileData::WIDTH + x);
+                            ptr = data + pixelSize * (y * m_tileWidth + x);
                             memcpy(ptr, m_defaultPixel, pixelSize);
                         }
                     }
@@ -637,6 +903,8 @@ void KisTiledDataManager::setExtent(QRect newRect)
             }
         }
     }
+
+    notifyDataChanged();
 }
 
 void KisTiledDataManager::recalculateExtent()
@@ -751,9 +1019,9 @@ qint32 KisTiledDataManager::numContiguousColumns(qint32 x, qint32 minY, qint32 m
     Q_UNUSED(maxY);
 
     if (x >= 0) {
-        numColumns = KisTileData::WIDTH - (x % KisTileData::WIDTH);
+        numColumns = m_tileWidth - (x % m_tileWidth);
     } else {
-        numColumns = ((-x - 1) % KisTileData::WIDTH) + 1;
+        numColumns = ((-x - 1) % m_tileWidth) + 1;
     }
 
     return numColumns;
@@ -767,9 +1035,9 @@ qint32 KisTiledDataManager::numContiguousRows(qint32 y, qint32 minX, qint32 maxX
     Q_UNUSED(maxX);
 
     if (y >= 0) {
-        numRows = KisTileData::HEIGHT - (y % KisTileData::HEIGHT);
+        numRows = m_tileHeight - (y % m_tileHeight);
     } else {
-        numRows = ((-y - 1) % KisTileData::HEIGHT) + 1;
+        numRows = ((-y - 1) % m_tileHeight) + 1;
     }
 
     return numRows;
@@ -780,10 +1048,54 @@ qint32 KisTiledDataManager::rowStride(qint32 x, qint32 y) const
     Q_UNUSED(x);
     Q_UNUSED(y);
 
-    return KisTileData::WIDTH * pixelSize();
+    return m_tileWidth * pixelSize();
 }
 
 void KisTiledDataManager::releaseInternalPools()
 {
     KisTileData::releaseInternalPools();
 }
+
+void KisTiledDataManager::prefetchRect(const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    prefetchTiles(xToCol(rect.left()), yToRow(rect.top()),
+                  xToCol(rect.right()), yToRow(rect.bottom()));
+}
+
+void KisTiledDataManager::prefetchTiles(qint32 leftCol, qint32 topRow, qint32 rightCol, qint32 bottomRow)
+{
+    if (!KisTileDataStore::instance()->hasSwappedTiles()) return;
+
+    /**
+     * There are no tiles outside the extent, so there is no need to
+     * look them up in the hash table
+     */
+    const QRect extentRect = m_extentManager.extent();
+    if (extentRect.isEmpty()) return;
+
+    leftCol = qMax(leftCol, xToCol(extentRect.left()));
+    rightCol = qMin(rightCol, xToCol(extentRect.right()));
+    topRow = qMax(topRow, yToRow(extentRect.top()));
+    bottomRow = qMin(bottomRow, yToRow(extentRect.bottom()));
+
+    const bool hasOldTiles = m_mementoManager->hasCurrentMemento();
+
+    for (qint32 row = topRow; row <= bottomRow; row++) {
+        for (qint32 col = leftCol; col <= rightCol; col++) {
+            KisTileSP tile = m_hashTable->getExistingTile(col, row);
+            if (tile) {
+                tile->prefetchTileData();
+            }
+
+            if (!hasOldTiles) continue;
+
+            bool existingTile = false;
+            KisTileSP oldTile = m_mementoManager->getCommitedTile(col, row, existingTile);
+            if (existingTile && oldTile && oldTile != tile) {
+                oldTile->prefetchTileData();
+            }
+        }
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <QtGlobal>
 #include <QVector>
+#include <QAtomicInteger>
 #include <KisRegion.h>
 
 #include <kis_shared.h>
@@ -73,7 +74,15 @@ private:
 protected:
     /*FIXME:*/
 public:
-    KisTiledDataManager(quint32 pixelSize, const quint8 *defPixel);
+    /**
+     * Creates a data manager with tiles of \p tileSize x \p tileSize
+     * pixels. The size should be a power of two from 64 to 256.
+     * Big tiles reduce the overhead of the tiles on huge static
+     * layers, small tiles suit better the devices that are painted
+     * on with small dabs. Zero means the default tile size,
+     * KisTileData::WIDTH.
+     */
+    KisTiledDataManager(quint32 pixelSize, const quint8 *defPixel, qint32 tileSize = 0);
     virtual ~KisTiledDataManager();
     KisTiledDataManager(const KisTiledDataManager &dm);
     KisTiledDataManager & operator=(const KisTiledDataManager &dm);
@@ -121,6 +130,7 @@ public:
             if (newTile) {
                 m_extentManager.notifyTileAdded(col, row);
             }
+            notifyDataChanged();
             return tile;
 
         } else {
@@ -169,6 +179,7 @@ public:
 
         QWriteLocker locker(&m_lock);
         m_mementoManager->rollback(m_hashTable, memento);
+        notifyDataChanged();
         const quint8 *defaultPixel = memento->oldDefaultPixel();
         if(memcmp(m_defaultPixel, defaultPixel, m_pixelSize)) {
             setDefaultPixelImpl(defaultPixel);
@@ -180,6 +191,7 @@ public:
 
         QWriteLocker locker(&m_lock);
         m_mementoManager->rollforward(m_hashTable, memento);
+        notifyDataChanged();
         const quint8 *defaultPixel = memento->newDefaultPixel();
         if(memcmp(m_defaultPixel, defaultPixel, m_pixelSize)) {
             setDefaultPixelImpl(defaultPixel);
@@ -204,12 +216,62 @@ public:
 
     static void releaseInternalPools();
 
+    /**
+     * The id of the data manager, unique within the process. The copies
+     * of the data manager get their own ids.
+     */
+    inline quint64 uniqueId() const {
+        return m_uniqueId;
+    }
+
+    /**
+     * The counter is incremented every time the data of the manager may
+     * be changed: a tile is fetched for writing, the tiles are cleared,
+     * blitted or read, the default pixel is changed or the history is
+     * rolled back or forward. If the value has not changed since some
+     * moment in the past, the data is guaranteed to be unchanged.
+     *
+     * \see uniqueId()
+     */
+    inline quint64 writeGeneration() const {
+        return m_writeGeneration.loadAcquire();
+    }
+
+    /**
+     * The size of the tiles of the data manager in pixels
+     */
+    inline qint32 tileWidth() const {
+        return m_tileWidth;
+    }
+
+    inline qint32 tileHeight() const {
+        return m_tileHeight;
+    }
+
+    /**
+     * Returns true if \p tileSize can be used for a data manager
+     */
+    static bool isValidTileSize(qint32 tileSize);
+
+    /**
+     * Asks the tile data store to load all swapped-out tiles
+     * touched by \p rect in the background. Iterators call it for
+     * the tiles they are going to visit next, so that the tiles are
+     * unpacked in parallel on the prefetch threads instead of being
+     * faulted in one by one by the painting thread.
+     *
+     * The call is cheap when nothing has been swapped out.
+     */
+    void prefetchRect(const QRect &rect);
+
 protected:
     /**
-     * Reads and writes the tiles 
+     * Reads and writes the tiles. When \p lazy is set, the tiles are
+     * kept compressed in memory until they are accessed for the
+     * first time, see KisTileDataStore::createPackedTileData()
      */
     bool write(KisPaintDeviceWriter &store);
-    bool read(QIODevice *stream);
+    bool read(QIODevice *stream, bool lazy = false);
 
     void purge(const QRect& area);
 
@@ -348,10 +410,19 @@ private:
     KisMementoManager *m_mementoManager;
     quint8* m_defaultPixel;
     qint32 m_pixelSize;
+
+    qint32 m_tileWidth;
+    qint32 m_tileHeight;
+    qint32 m_tileWidthShift;
+    qint32 m_tileHeightShift;
+
     KisTiledExtentManager m_extentManager;
 
     mutable QReadWriteLock m_lock;
 
+    quint64 m_uniqueId;
+    QAtomicInteger<quint64> m_writeGeneration;
+
 private:
     // Allow compression routines to calculate (col,row) coordinates
     // and pixel size
@@ -360,11 +431,25 @@ private:
     qint32 xToCol(qint32 x) const;
     qint32 yToRow(qint32 y) const;
 
+    /**
+     * Puts a tile with the tile data \p td at (\p col, \p row),
+     * used by the compressors for reading the packed tiles
+     */
+    void addTile(qint32 col, qint32 row, KisTileData *td);
+
 private:
+    void initTileSize(qint32 tileSize);
+    void initUniqueId();
+
+    inline void notifyDataChanged() {
+        m_writeGeneration.fetchAndAddRelaxed(1);
+    }
+
     void setDefaultPixelImpl(const quint8 *defPixel);
 
     bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
-    bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
+    bool writeTilesConcurrently(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store);
+    bool processTilesHeader(QIODevice *stream, quint32 &numTiles, qint32 &tileSize);
 
     qint32 divideRoundDown(qint32 x, const qint32 y) const;
 
@@ -372,10 +457,18 @@ private:
 
     quint8* duplicatePixel(qint32 num, const quint8 *pixel);
 
+    /**
+     * The same as prefetchRect(), but in tile coordinates
+     * (all the bounds are inclusive)
+     */
+    void prefetchTiles(qint32 leftCol, qint32 topRow, qint32 rightCol, qint32 bottomRow);
+
     template<bool useOldSrcData>
         void bitBltImpl(KisTiledDataManager *srcDM, const QRect &rect);
     template<bool useOldSrcData>
         void bitBltRoughImpl(KisTiledDataManager *srcDM, const QRect &rect);
+    template<bool useOldSrcData>
+        void bitBltPixelsImpl(KisTiledDataManager *srcDM, const QRect &rect);
 
     void writeBytesBody(const quint8 *data,
                         qint32 x, qint32 y,
@@ -412,14 +505,19 @@ inline qint32 KisTiledDataManager::divideRoundDown(qint32 x, const qint32 y) con
            -(((-x - 1) / y) + 1);
 }
 
+/**
+ * The tile size is always a power of two, so the arithmetic shift
+ * is equivalent to divideRoundDown(), but doesn't need a division
+ */
+
 inline qint32 KisTiledDataManager::xToCol(qint32 x) const
 {
-    return divideRoundDown(x, KisTileData::WIDTH);
+    return x >> m_tileWidthShift;
 }
 
 inline qint32 KisTiledDataManager::yToRow(qint32 y) const
 {
-    return divideRoundDown(y, KisTileData::HEIGHT);
+    return y >> m_tileHeightShift;
 }
 
 // during development the following line helps to check the interface is correct
@@ -33,7 +33,7 @@ KisVLineIterator2::KisVLineIterator2(KisDataManager *dataManager, qint32 x, qint
     Q_ASSERT(h > 0); // for us, to warn us when abusing the iterators
     if (h < 1) h = 1;  // for release mode, to make sure there's always at least one pixel read.
 
-    m_lineStride = m_pixelSize * KisTileData::WIDTH;
+    m_lineStride = m_pixelSize * tileWidth();
 
     m_x = x;
     m_y = y;
@@ -55,12 +55,16 @@ KisVLineIterator2::KisVLineIterator2(KisDataManager *dataManager, qint32 x, qint
     m_column = xToCol(m_x);
     m_xInTile = calcXInTile(m_x, m_column);
 
-    m_topInTopmostTile = m_top - m_topRow * KisTileData::WIDTH;
+    m_topInTopmostTile = m_top - m_topRow * tileHeight();
 
     m_tilesCacheSize = m_bottomRow - m_topRow + 1;
     m_tilesCache.resize(m_tilesCacheSize);
 
-    m_tileSize = m_lineStride * KisTileData::HEIGHT;
+    m_tileSize = m_lineStride * tileHeight();
+
+    // ask the store to unpack the first two columns in the background,
+    // if they have been swapped out
+    prefetchTiles(m_column, m_topRow, m_column + 1, m_bottomRow);
 
     // let's preallocate first row
     for (int i = 0; i < m_tilesCacheSize; i++){
@@ -118,11 +122,12 @@ void KisVLineIterator2::nextColumn()
     m_y = m_top;
     ++m_x;
 
-    if (++m_xInTile < KisTileData::HEIGHT) {
+    if (++m_xInTile < tileWidth()) {
         /* do nothing, usual case */
     } else {
         ++m_column;
         m_xInTile = 0;
+        prefetchTiles(m_column + 1, m_topRow, m_column + 1, m_bottomRow);
         preallocateTiles();
     }
     m_index = 0;
@@ -197,7 +202,7 @@ void KisVLineIterator2::switchToTile(qint32 yInTile)
     m_oldData = m_tilesCache[m_index].oldData;
     m_data += offset_row;
     m_dataBottom = m_data + m_tileSize;
-    int offset_col = m_pixelSize * yInTile * KisTileData::WIDTH;
+    int offset_col = m_pixelSize * yInTile * tileWidth();
     m_data  += offset_col;
     m_oldData += offset_row + offset_col;
 }
@@ -25,3 +25,8 @@ KisAbstractTileCompressor::KisAbstractTileCompressor()
 KisAbstractTileCompressor::~KisAbstractTileCompressor()
 {
 }
+
+bool KisAbstractTileCompressor::readTileLazily(QIODevice *stream, KisTiledDataManager *dm)
+{
+    return readTile(stream, dm);
+}
@@ -55,6 +55,15 @@ public:
      */
     virtual bool readTile(QIODevice *stream, KisTiledDataManager *dm) = 0;
 
+    /**
+     * The same as readTile(), but the compressor is allowed to keep
+     * the tile packed until someone accesses it. The default
+     * implementation just reads the tile.
+     *
+     * \see KisTileDataStore::createPackedTileData()
+     */
+    virtual bool readTileLazily(QIODevice *stream, KisTiledDataManager *dm);
+
     /**
      * Compresses a \p tileData and writes it into the \p buffer.
      * The buffer must be at least tileDataBufferSize() bytes long.
@@ -102,6 +111,14 @@ protected:
     inline qint32 pixelSize(KisTiledDataManager *dm) {
         return dm->pixelSize();
     }
+
+    inline qint32 tileDataSize(KisTiledDataManager *dm) {
+        return dm->pixelSize() * dm->tileWidth() * dm->tileHeight();
+    }
+
+    inline void addTile(KisTiledDataManager *dm, qint32 col, qint32 row, KisTileData *td) {
+        dm->addTile(col, row, td);
+    }
 };
 
 #endif /* __KIS_ABSTRACT_TILE_COMPRESSOR_H */
@@ -20,7 +20,6 @@
 #include "kis_paint_device_writer.h"
 #include <QIODevice>
 
-#define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
 KisLegacyTileCompressor::KisLegacyTileCompressor()
 {
@@ -32,7 +31,7 @@ KisLegacyTileCompressor::~KisLegacyTileCompressor()
 
 bool KisLegacyTileCompressor::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
+    const qint32 tileDataSize = tile->tileData()->dataSize();
 
     const qint32 bufferSize = maxHeaderLength() + 1;
     QScopedArrayPointer<quint8> headerBuffer(new quint8[bufferSize]);
@@ -54,7 +53,7 @@ bool KisLegacyTileCompressor::writeTile(KisTileSP tile, KisPaintDeviceWriter &st
 
 bool KisLegacyTileCompressor::readTile(QIODevice *stream, KisTiledDataManager *dm)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
+    const qint32 tileDataSize = this->tileDataSize(dm);
 
     const qint32 bufferSize = maxHeaderLength() + 1;
     quint8 *headerBuffer = new quint8[bufferSize];
@@ -83,7 +82,7 @@ void KisLegacyTileCompressor::compressTileData(KisTileData *tileData,
                                                qint32 &bytesWritten)
 {
     bytesWritten = 0;
-    const qint32 tileDataSize = TILE_DATA_SIZE(tileData->pixelSize());
+    const qint32 tileDataSize = tileData->dataSize();
     Q_UNUSED(bufferSize);
     Q_ASSERT(bufferSize >= tileDataSize);
     memcpy(buffer, tileData->data(), tileDataSize);
@@ -94,7 +93,7 @@ bool KisLegacyTileCompressor::decompressTileData(quint8 *buffer,
                                                  qint32 bufferSize,
                                                  KisTileData *tileData)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(tileData->pixelSize());
+    const qint32 tileDataSize = tileData->dataSize();
     if (bufferSize >= tileDataSize) {
         memcpy(tileData->data(), buffer, tileDataSize);
         return true;
@@ -104,7 +103,7 @@ bool KisLegacyTileCompressor::decompressTileData(quint8 *buffer,
 
 qint32 KisLegacyTileCompressor::tileDataBufferSize(KisTileData *tileData)
 {
-    return TILE_DATA_SIZE(tileData->pixelSize());
+    return tileData->dataSize();
 }
 
 inline qint32 KisLegacyTileCompressor::maxHeaderLength()
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_swap_compression_factory.h"
+
+#include <config-swap-compression.h>
+
+#include "kis_debug.h"
+#include "kis_image_config.h"
+#include "kis_lzf_compression.h"
+
+#ifdef HAVE_LZ4
+#include "kis_lz4_compression.h"
+#endif
+
+#ifdef HAVE_ZSTD
+#include "kis_zstd_compression.h"
+#endif
+
+
+KisAbstractCompression* KisSwapCompressionFactory::create(Type type, int level)
+{
+    Q_UNUSED(level);
+
+    if (!isAvailable(type)) {
+        warnTiles << "Swap compression" << typeToString(type)
+                  << "is not available, falling back to LZF";
+        type = LZF;
+    }
+
+    switch (type) {
+#ifdef HAVE_LZ4
+    case LZ4:
+        return new KisLz4Compression();
+#endif
+#ifdef HAVE_ZSTD
+    case ZSTD:
+        return new KisZstdCompression(level);
+#endif
+    default:
+        return new KisLzfCompression();
+    }
+}
+
+KisAbstractCompression* KisSwapCompressionFactory::createFromConfig()
+{
+    KisImageConfig config(true);
+    return create(stringToType(config.swapCompression()),
+                  config.swapCompressionLevel());
+}
+
+bool KisSwapCompressionFactory::isAvailable(Type type)
+{
+    switch (type) {
+    case LZF:
+        return true;
+    case LZ4:
+#ifdef HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    case ZSTD:
+#ifdef HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+QList<KisSwapCompressionFactory::Type> KisSwapCompressionFactory::availableTypes()
+{
+    QList<Type> types;
+
+    Q_FOREACH (Type type, QList<Type>() << LZF << LZ4 << ZSTD) {
+        if (isAvailable(type)) {
+            types << type;
+        }
+    }
+
+    return types;
+}
+
+QString KisSwapCompressionFactory::typeToString(Type type)
+{
+    switch (type) {
+    case LZ4:
+        return "lz4";
+    case ZSTD:
+        return "zstd";
+    case LZF:
+        break;
+    }
+
+    return "lzf";
+}
+
+KisSwapCompressionFactory::Type KisSwapCompressionFactory::stringToType(const QString &name)
+{
+    const QString lowerName = name.toLower();
+
+    return lowerName == "lz4" ? LZ4 :
+        lowerName == "zstd" ? ZSTD :
+        LZF;
+}
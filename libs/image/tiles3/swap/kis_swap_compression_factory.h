@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_SWAP_COMPRESSION_FACTORY_H
+#define __KIS_SWAP_COMPRESSION_FACTORY_H
+
+#include "kritaimage_export.h"
+
+#include <QList>
+#include <QString>
+
+class KisAbstractCompression;
+
+/**
+ * Creates compression backends for KisSwappedDataStore. LZF is always
+ * available, LZ4 and Zstd only when Krita has been built with the
+ * corresponding libraries.
+ */
+class KRITAIMAGE_EXPORT KisSwapCompressionFactory
+{
+public:
+    enum Type {
+        LZF = 0,
+        LZ4,
+        ZSTD
+    };
+
+    /**
+     * Creates a compression of type \p type. \p level is used by Zstd
+     * only. If the requested backend is not available, LZF is
+     * returned instead.
+     */
+    static KisAbstractCompression* create(Type type, int level);
+
+    /**
+     * Creates a compression selected by the user in KisImageConfig
+     */
+    static KisAbstractCompression* createFromConfig();
+
+    static bool isAvailable(Type type);
+    static QList<Type> availableTypes();
+
+    static QString typeToString(Type type);
+    static Type stringToType(const QString &name);
+
+private:
+    KisSwapCompressionFactory();
+};
+
+#endif /* __KIS_SWAP_COMPRESSION_FACTORY_H */
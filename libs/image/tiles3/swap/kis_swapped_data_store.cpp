@@ -21,12 +21,19 @@
 #include "kis_memory_window.h"
 #include "kis_image_config.h"
 
+#include <QtConcurrent>
+
 #include "kis_tile_compressor_2.h"
+#include "kis_swap_compression_factory.h"
 
 //#define COMPRESSOR_VERSION 2
 
 KisSwappedDataStore::KisSwappedDataStore()
-    : m_memoryMetric(0)
+    : m_memoryMetric(0),
+      m_numSwappedOut(0),
+      m_numSwappedIn(0),
+      m_numSwapOutBatches(0),
+      m_bytesWritten(0)
 {
     KisImageConfig config(true);
     const quint64 maxSwapSize = config.maxSwapSize() * MiB;
@@ -36,12 +43,19 @@ KisSwappedDataStore::KisSwappedDataStore()
     m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
     m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
-    // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    m_compressionType = KisSwapCompressionFactory::stringToType(config.swapCompression());
+    m_compressionLevel = config.swapCompressionLevel();
+
+    m_compressor = createCompressor();
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
 {
+    KisTileCompressor2 *compressor = 0;
+    while (m_compressorsPool.pop(compressor)) {
+        delete compressor;
+    }
+
     delete m_compressor;
     delete m_swapSpace;
     delete m_allocator;
@@ -84,12 +98,98 @@ bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
     td->releaseMemory();
     td->setSwapChunk(chunk);
 
-    m_memoryMetric += td->pixelSize();
+    m_memoryMetric += td->memoryMetric();
+    m_numSwappedOut++;
+    m_bytesWritten += bytesWritten;
 
     return true;
 }
 
+namespace {
+struct CompressionJob {
+    KisTileData *td;
+    QByteArray buffer;
+    qint32 bytesWritten;
+};
+}
+
+int KisSwappedDataStore::trySwapOutTileDataBatch(const QVector<KisTileData*> &tiles)
+{
+    if (tiles.isEmpty()) return 0;
+
+    QVector<CompressionJob> jobs(tiles.size());
+    for (int i = 0; i < tiles.size(); i++) {
+        Q_ASSERT(tiles[i]->data());
+        jobs[i].td = tiles[i];
+        jobs[i].bytesWritten = 0;
+    }
+
+    /**
+     * Compression is the most expensive part of the swapping,
+     * so do it in parallel without holding the store-wide lock.
+     * Every thread takes its own compressor from the pool.
+     */
+    QtConcurrent::blockingMap(jobs, [this] (CompressionJob &job) {
+        KisTileCompressor2 *compressor = 0;
+        if (!m_compressorsPool.pop(compressor)) {
+            compressor = createCompressor();
+        }
+
+        job.buffer.resize(compressor->tileDataBufferSize(job.td));
+        compressor->compressTileData(job.td,
+                                     (quint8*) job.buffer.data(), job.buffer.size(),
+                                     job.bytesWritten);
+
+        m_compressorsPool.push(compressor);
+    });
+
+    QMutexLocker locker(&m_lock);
+
+    /**
+     * The chunks are allocated one after another, so the allocator
+     * is likely to place them in a contiguous region of the swap
+     * file and the window is written sequentially.
+     */
+    int numSwappedOut = 0;
+
+    Q_FOREACH (const CompressionJob &job, jobs) {
+        KisChunk chunk = m_allocator->getChunk(job.bytesWritten);
+        quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
+        if (!ptr) {
+            qWarning() << "swap out of tile failed";
+            m_allocator->freeChunk(chunk);
+            continue;
+        }
+        memcpy(ptr, job.buffer.constData(), job.bytesWritten);
+
+        job.td->releaseMemory();
+        job.td->setSwapChunk(chunk);
+
+        m_memoryMetric += job.td->memoryMetric();
+        m_bytesWritten += job.bytesWritten;
+        numSwappedOut++;
+    }
+
+    m_numSwappedOut += numSwappedOut;
+    m_numSwapOutBatches++;
+
+    return numSwappedOut;
+}
+
+KisTileCompressor2* KisSwappedDataStore::createCompressor() const
+{
+    return new KisTileCompressor2(
+        KisSwapCompressionFactory::create(m_compressionType, m_compressionLevel));
+}
+
 void KisSwappedDataStore::swapInTileData(KisTileData *td)
+{
+    QByteArray buffer;
+    fetchTileData(td, buffer);
+    unpackTileData(td, buffer);
+}
+
+void KisSwappedDataStore::fetchTileData(KisTileData *td, QByteArray &buffer)
 {
     Q_ASSERT(!td->data());
     QMutexLocker locker(&m_lock);
@@ -103,10 +203,25 @@ void KisSwappedDataStore::swapInTileData(KisTileData *td)
 
     quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
     Q_ASSERT(ptr);
-    m_compressor->decompressTileData(ptr, chunk.size(), td);
+    buffer = QByteArray((const char*)ptr, chunk.size());
     m_allocator->freeChunk(chunk);
 
-    m_memoryMetric -= td->pixelSize();
+    m_memoryMetric -= td->memoryMetric();
+    m_numSwappedIn++;
+}
+
+void KisSwappedDataStore::unpackTileData(KisTileData *td, const QByteArray &buffer)
+{
+    Q_ASSERT(td->data());
+
+    KisTileCompressor2 *decompressor = 0;
+    if (!m_compressorsPool.pop(decompressor)) {
+        decompressor = createCompressor();
+    }
+
+    decompressor->decompressTileData((quint8*)buffer.constData(), buffer.size(), td);
+
+    m_compressorsPool.push(decompressor);
 }
 
 void KisSwappedDataStore::forgetTileData(KisTileData *td)
@@ -116,7 +231,7 @@ void KisSwappedDataStore::forgetTileData(KisTileData *td)
     m_allocator->freeChunk(td->swapChunk());
     td->setSwapChunk(KisChunk());
 
-    m_memoryMetric -= td->pixelSize();
+    m_memoryMetric -= td->memoryMetric();
 }
 
 qint64 KisSwappedDataStore::totalMemoryMetric() const
@@ -124,6 +239,26 @@ qint64 KisSwappedDataStore::totalMemoryMetric() const
     return m_memoryMetric;
 }
 
+qint64 KisSwappedDataStore::numSwappedOut() const
+{
+    return m_numSwappedOut;
+}
+
+qint64 KisSwappedDataStore::numSwappedIn() const
+{
+    return m_numSwappedIn;
+}
+
+qint64 KisSwappedDataStore::numSwapOutBatches() const
+{
+    return m_numSwapOutBatches;
+}
+
+qint64 KisSwappedDataStore::bytesWritten() const
+{
+    return m_bytesWritten;
+}
+
 void KisSwappedDataStore::debugStatistics()
 {
     m_allocator->sanityCheck();
@@ -23,11 +23,16 @@
 
 #include <QMutex>
 #include <QByteArray>
+#include <QVector>
+
+#include "tiles3/kis_lockless_stack.h"
+#include "kis_swap_compression_factory.h"
 
 
 class QMutex;
 class KisTileData;
 class KisAbstractTileCompressor;
+class KisTileCompressor2;
 class KisChunkAllocator;
 class KisMemoryWindow;
 
@@ -50,6 +55,21 @@ public:
      */
     bool trySwapOutTileData(KisTileData *td);
 
+    /**
+     * Swap out a batch of tile data objects at once. The tiles are
+     * compressed in parallel outside the store-wide lock, after that
+     * the swap chunks are allocated and written sequentially in one
+     * go, which keeps the swap file access pattern linear.
+     *
+     * Returns the number of tile data objects swapped out. The tiles
+     * that could not be written keep their data and swap chunk is
+     * not set for them, so the caller can check them individually
+     * with KisTileData::data().
+     * LOCKING: the locks on all the tile data objects should be taken
+     *          by the caller before making a call.
+     */
+    int trySwapOutTileDataBatch(const QVector<KisTileData*> &tiles);
+
     /**
      * Restore the data of a \a td basing on information
      * stored in the swap file.
@@ -58,6 +78,27 @@ public:
      */
     void swapInTileData(KisTileData *td);
 
+    /**
+     * The first stage of swapInTileData(). Allocates memory for \a td
+     * and moves its compressed data from the swap file into \p buffer.
+     * The data of \a td is *not initialized* after the call, the caller
+     * must call unpackTileData() before unlocking the tile data.
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    void fetchTileData(KisTileData *td, QByteArray &buffer);
+
+    /**
+     * The second stage of swapInTileData(). Decompresses \p buffer,
+     * fetched by fetchTileData(), into \a td.
+     *
+     * The method doesn't take the store-wide lock, so different tile
+     * data objects can be unpacked concurrently.
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    void unpackTileData(KisTileData *td, const QByteArray &buffer);
+
     /**
      * Forget all the information linked with the tile data.
      * This should be done before deleting of the tile data,
@@ -71,21 +112,54 @@ public:
      */
     qint64 totalMemoryMetric() const;
 
+    /**
+     * Total number of tile data objects swapped out/in since the
+     * store was created
+     */
+    qint64 numSwappedOut() const;
+    qint64 numSwappedIn() const;
+
+    /**
+     * Number of batches written by trySwapOutTileDataBatch()
+     */
+    qint64 numSwapOutBatches() const;
+
+    /**
+     * Total size of the compressed data written to the swap file
+     */
+    qint64 bytesWritten() const;
+
     /**
      * Some debugging output
      */
     void debugStatistics();
 
+private:
+    KisTileCompressor2* createCompressor() const;
+
 private:
     QByteArray m_buffer;
     KisAbstractTileCompressor *m_compressor;
 
+    KisSwapCompressionFactory::Type m_compressionType;
+    int m_compressionLevel;
+
+    /**
+     * Compressors used for (un)packing the data outside m_lock
+     */
+    KisLocklessStack<KisTileCompressor2*> m_compressorsPool;
+
     KisChunkAllocator *m_allocator;
     KisMemoryWindow *m_swapSpace;
 
     QMutex m_lock;
 
     qint64 m_memoryMetric;
+
+    qint64 m_numSwappedOut;
+    qint64 m_numSwappedIn;
+    qint64 m_numSwapOutBatches;
+    qint64 m_bytesWritten;
 };
 
 #endif /* __KIS_SWAPPED_DATA_STORE_H */
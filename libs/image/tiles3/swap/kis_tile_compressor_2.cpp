@@ -20,14 +20,18 @@
 #include "kis_lzf_compression.h"
 #include <QIODevice>
 #include "kis_paint_device_writer.h"
-#define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
 const QString KisTileCompressor2::m_compressionName = "LZF";
 
 
 KisTileCompressor2::KisTileCompressor2()
+    : KisTileCompressor2(new KisLzfCompression())
+{
+}
+
+KisTileCompressor2::KisTileCompressor2(KisAbstractCompression *compression)
+    : m_compression(compression)
 {
-    m_compression = new KisLzfCompression();
 }
 
 KisTileCompressor2::~KisTileCompressor2()
@@ -37,15 +41,28 @@ KisTileCompressor2::~KisTileCompressor2()
 
 bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
-    prepareStreamingBuffer(tileDataSize);
-
     qint32 bytesWritten;
 
-    tile->lockForRead();
-    compressTileData(tile->tileData(), (quint8*)m_streamingBuffer.data(),
-                     m_streamingBuffer.size(), bytesWritten);
-    tile->unlockForRead();
+    /**
+     * The tiles that have been loaded lazily and haven't been
+     * touched since then are written as they are, without
+     * unpacking them. The tile data is not accessed before the
+     * tile is locked, because COW may replace and free it.
+     */
+    QByteArray packedData;
+    const char *data = 0;
+
+    if (tile->copyPackedData(&packedData)) {
+        data = packedData.constData();
+        bytesWritten = packedData.size();
+    } else {
+        tile->lockForRead();
+        prepareStreamingBuffer(tile->tileData()->dataSize());
+        compressTileData(tile->tileData(), (quint8*)m_streamingBuffer.data(),
+                         m_streamingBuffer.size(), bytesWritten);
+        tile->unlockForRead();
+        data = m_streamingBuffer.constData();
+    }
 
     QString header = getHeader(tile, bytesWritten);
     bool retval = true;
@@ -53,18 +70,16 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
     if (!retval) {
         warnFile << "Failed to write the tile header";
     }
-    retval = store.write(m_streamingBuffer.data(), bytesWritten);
+    retval = store.write(data, bytesWritten);
     if (!retval) {
         warnFile << "Failed to write the tile datak";
     }
     return retval;
 }
 
-bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
+bool KisTileCompressor2::readHeader(QIODevice *stream, KisTiledDataManager *dm,
+                                    qint32 *col, qint32 *row, qint32 *dataSize)
 {
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
-    prepareStreamingBuffer(tileDataSize);
-
     QByteArray header = stream->readLine(maxHeaderLength());
 
     QList<QByteArray> headerItems = header.trimmed().split(',');
@@ -72,23 +87,77 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         qint32 x = headerItems.takeFirst().toInt();
         qint32 y = headerItems.takeFirst().toInt();
         QString compressionName = headerItems.takeFirst();
-        qint32 dataSize = headerItems.takeFirst().toInt();
+        *dataSize = headerItems.takeFirst().toInt();
 
         Q_ASSERT(headerItems.isEmpty());
         Q_ASSERT(compressionName == m_compressionName);
 
-        qint32 row = yToRow(dm, y);
-        qint32 col = xToCol(dm, x);
+        *row = yToRow(dm, y);
+        *col = xToCol(dm, x);
+
+        return true;
+    }
+    return false;
+}
+
+bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
+{
+    const qint32 tileDataSize = this->tileDataSize(dm);
+    prepareStreamingBuffer(tileDataSize);
+
+    qint32 col, row, dataSize;
+    if (!readHeader(stream, dm, &col, &row, &dataSize)) return false;
 
-        KisTileSP tile = dm->getTile(col, row, true);
+    KisTileSP tile = dm->getTile(col, row, true);
 
-        stream->read(m_streamingBuffer.data(), dataSize);
+    stream->read(m_streamingBuffer.data(), dataSize);
 
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlockForWrite();
-        return res;
+    tile->lockForWrite();
+    bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
+    tile->unlockForWrite();
+    return res;
+}
+
+bool KisTileCompressor2::readTileLazily(QIODevice *stream, KisTiledDataManager *dm)
+{
+    const qint32 tileDataSize = this->tileDataSize(dm);
+    prepareStreamingBuffer(tileDataSize);
+
+    qint32 col, row, dataSize;
+    if (!readHeader(stream, dm, &col, &row, &dataSize)) return false;
+
+    if (dataSize <= 0 || dataSize > m_streamingBuffer.size() ||
+        stream->read(m_streamingBuffer.data(), dataSize) != dataSize) {
+
+        return false;
+    }
+
+    /**
+     * The tile is unpacked only when someone accesses it, so only
+     * the cheap checks are done here, the stream itself is checked
+     * on the first access
+     */
+    if (!validateTileData((quint8*)m_streamingBuffer.data(), dataSize, tileDataSize)) {
+        return false;
+    }
+
+    KisTileData *td = KisTileDataStore::instance()->
+        createPackedTileData(pixelSize(dm), (const quint8*)m_streamingBuffer.constData(),
+                             dataSize, dm->tileWidth());
+
+    addTile(dm, col, row, td);
+    return true;
+}
+
+bool KisTileCompressor2::validateTileData(const quint8 *buffer, qint32 bufferSize, qint32 tileDataSize)
+{
+    if (buffer[0] == COMPRESSED_DATA_FLAG) {
+        // compressTileData() stores the data compressed only if it gets smaller
+        return bufferSize > 1 && bufferSize <= tileDataSize;
+    } else if (buffer[0] == RAW_DATA_FLAG) {
+        return bufferSize == tileDataSize + 1;
     }
+
     return false;
 }
 
@@ -115,7 +184,7 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
                                           qint32 &bytesWritten)
 {
     const qint32 pixelSize = tileData->pixelSize();
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+    const qint32 tileDataSize = tileData->dataSize();
     qint32 compressedBytes;
 
     Q_UNUSED(bufferSize);
@@ -129,7 +198,7 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
     compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
                                               (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
 
-    if(compressedBytes < tileDataSize) {
+    if(compressedBytes > 0 && compressedBytes < tileDataSize) {
         buffer[0] = COMPRESSED_DATA_FLAG;
         memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
@@ -146,7 +215,7 @@ bool KisTileCompressor2::decompressTileData(quint8 *buffer,
                                             KisTileData *tileData)
 {
     const qint32 pixelSize = tileData->pixelSize();
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+    const qint32 tileDataSize = tileData->dataSize();
 
     if(buffer[0] == COMPRESSED_DATA_FLAG) {
         prepareWorkBuffers(tileDataSize);
@@ -172,7 +241,7 @@ bool KisTileCompressor2::decompressTileData(quint8 *buffer,
 
 qint32 KisTileCompressor2::tileDataBufferSize(KisTileData *tileData)
 {
-    return TILE_DATA_SIZE(tileData->pixelSize()) + 1;
+    return tileData->dataSize() + 1;
 }
 
 inline qint32 KisTileCompressor2::maxHeaderLength()
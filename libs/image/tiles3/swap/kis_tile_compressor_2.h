@@ -27,10 +27,23 @@ class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
     KisTileCompressor2();
+
+    /**
+     * Creates a compressor that uses \p compression for packing
+     * the tile data. The compressor takes ownership of the object.
+     *
+     * NOTE: the stream format used by writeTile()/readTile() is
+     *       defined to be LZF, so a custom compression should be
+     *       used for swapping (compressTileData()/decompressTileData())
+     *       only.
+     */
+    KisTileCompressor2(KisAbstractCompression *compression);
+
     ~KisTileCompressor2() override;
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
     bool readTile(QIODevice *io, KisTiledDataManager *dm) override;
+    bool readTileLazily(QIODevice *io, KisTiledDataManager *dm) override;
 
 
     void compressTileData(KisTileData *tileData,quint8 *buffer,
@@ -45,6 +58,14 @@ private:
     qint32 maxHeaderLength();
 
     QString getHeader(KisTileSP tile, qint32 compressedSize);
+    bool readHeader(QIODevice *stream, KisTiledDataManager *dm,
+                    qint32 *col, qint32 *row, qint32 *dataSize);
+
+    /**
+     * Checks the flag byte of the packed \p buffer and that its size
+     * fits a tile of \p tileDataSize bytes. The data is not unpacked.
+     */
+    static bool validateTileData(const quint8 *buffer, qint32 bufferSize, qint32 tileDataSize);
 
     void prepareWorkBuffers(qint32 tileDataSize);
     void prepareStreamingBuffer(qint32 tileDataSize);
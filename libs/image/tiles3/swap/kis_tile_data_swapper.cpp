@@ -29,6 +29,7 @@
 
 const qint32 KisTileDataSwapper::TIMEOUT = -1;
 const qint32 KisTileDataSwapper::DELAY = 0.7 * SEC;
+const qint32 KisTileDataSwapper::BATCH_SIZE = 256;
 
 //#define DEBUG_SWAPPER
 
@@ -125,6 +126,16 @@ void KisTileDataSwapper::doJob()
     DEBUG_VALUE(m_d->limits.softLimitThreshold());
     DEBUG_VALUE(m_d->limits.hardLimitThreshold());
 
+    if(memoryMetric > m_d->limits.softLimitThreshold()) {
+        /**
+         * Compacting uniform and duplicated tiles doesn't need any
+         * disk I/O, so try it before swapping anything out
+         */
+        DEBUG_ACTION("\t compaction");
+        m_d->store->compactTileData();
+        memoryMetric = m_d->store->memoryMetric();
+        DEBUG_VALUE(memoryMetric);
+    }
 
     if(memoryMetric > m_d->limits.softLimitThreshold()) {
         qint32 softFree =  memoryMetric - m_d->limits.softLimit();
@@ -198,6 +209,16 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
     qint64 freedMetric = 0;
     QList<KisTileData*> additionalCandidates;
 
+    /**
+     * The victims are collected into batches. Every batch is
+     * compressed by a pool of threads and written into the swap
+     * file sequentially by KisSwappedDataStore. The batch is
+     * flushed earlier if it is already enough to reach the goal.
+     */
+    QVector<KisTileData*> batch;
+    batch.reserve(BATCH_SIZE);
+    qint64 batchMetric = 0;
+
     typename strategy::iterator *iter =
         strategy::beginIteration(m_d->store);
 
@@ -211,8 +232,15 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
         if (!strategy::isInteresting(item)) continue;
 
         if (strategy::swapOutFirst(item)) {
-            if (iter->trySwapOut(item)) {
-                freedMetric += item->pixelSize();
+            batch.append(item);
+            batchMetric += item->memoryMetric();
+
+            if (batch.size() >= BATCH_SIZE ||
+                freedMetric + batchMetric >= needToFreeMetric) {
+
+                freedMetric += iter->trySwapOut(batch);
+                batch.clear();
+                batchMetric = 0;
             }
         }
         else {
@@ -225,11 +253,22 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
     Q_FOREACH (item, additionalCandidates) {
         if (freedMetric >= needToFreeMetric) break;
 
-        if (iter->trySwapOut(item)) {
-            freedMetric += item->pixelSize();
+        batch.append(item);
+        batchMetric += item->memoryMetric();
+
+        if (batch.size() >= BATCH_SIZE ||
+            freedMetric + batchMetric >= needToFreeMetric) {
+
+            freedMetric += iter->trySwapOut(batch);
+            batch.clear();
+            batchMetric = 0;
         }
     }
 
+    if (!batch.isEmpty()) {
+        freedMetric += iter->trySwapOut(batch);
+    }
+
     strategy::endIteration(m_d->store, iter);
 
     return freedMetric;
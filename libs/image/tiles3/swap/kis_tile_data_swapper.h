@@ -52,6 +52,7 @@ private:
 private:
     static const qint32 TIMEOUT;
     static const qint32 DELAY;
+    static const qint32 BATCH_SIZE;
 
 private:
     struct Private;
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_zstd_compression.h"
+
+#include <zstd.h>
+#include <QtGlobal>
+
+
+KisZstdCompression::KisZstdCompression(int level)
+    : m_level(qBound(minLevel(), level, maxLevel())),
+      m_compressionContext(ZSTD_createCCtx()),
+      m_decompressionContext(ZSTD_createDCtx())
+{
+}
+
+KisZstdCompression::~KisZstdCompression()
+{
+    ZSTD_freeCCtx(m_compressionContext);
+    ZSTD_freeDCtx(m_decompressionContext);
+}
+
+qint32 KisZstdCompression::compress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength)
+{
+    if (!input || !output || inputLength <= 0) return 0;
+
+    const size_t result =
+        ZSTD_compressCCtx(m_compressionContext,
+                          output, outputLength,
+                          input, inputLength,
+                          m_level);
+
+    return !ZSTD_isError(result) ? qint32(result) : 0;
+}
+
+qint32 KisZstdCompression::decompress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength)
+{
+    if (!input || !output || inputLength <= 0) return 0;
+
+    const size_t result =
+        ZSTD_decompressDCtx(m_decompressionContext,
+                            output, outputLength,
+                            input, inputLength);
+
+    return !ZSTD_isError(result) ? qint32(result) : 0;
+}
+
+qint32 KisZstdCompression::outputBufferSize(qint32 dataSize)
+{
+    return ZSTD_compressBound(dataSize);
+}
+
+int KisZstdCompression::level() const
+{
+    return m_level;
+}
+
+int KisZstdCompression::defaultLevel()
+{
+    /**
+     * Level 3 is the default of the library itself and is still
+     * fast enough to keep up with the swapper.
+     */
+    return 3;
+}
+
+int KisZstdCompression::minLevel()
+{
+    return 1;
+}
+
+int KisZstdCompression::maxLevel()
+{
+    return ZSTD_maxCLevel();
+}
@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_ZSTD_COMPRESSION_H
+#define __KIS_ZSTD_COMPRESSION_H
+
+#include "kis_abstract_compression.h"
+
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+/**
+ * A wrapper around the Zstandard library. It is slower than LZF on
+ * compression, but gives much better ratio, which makes sense when
+ * the swap file size is the limiting factor.
+ *
+ * The object keeps its own compression/decompression contexts, so,
+ * as any other KisAbstractCompression, it should not be used from
+ * several threads concurrently.
+ */
+class KRITAIMAGE_EXPORT KisZstdCompression : public KisAbstractCompression
+{
+public:
+    /**
+     * \param level the compression level passed to Zstd. Values
+     *              outside of the range supported by the library
+     *              are clamped.
+     */
+    KisZstdCompression(int level = defaultLevel());
+    ~KisZstdCompression() override;
+
+    qint32 compress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength) override;
+    qint32 decompress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength) override;
+
+    qint32 outputBufferSize(qint32 dataSize) override;
+
+    int level() const;
+
+    static int defaultLevel();
+    static int minLevel();
+    static int maxLevel();
+
+private:
+    int m_level;
+    ZSTD_CCtx *m_compressionContext;
+    ZSTD_DCtx *m_decompressionContext;
+};
+
+#endif /* __KIS_ZSTD_COMPRESSION_H */
@@ -218,4 +218,66 @@ void KisLowMemoryTests::hangingTilesTest()
     dstTile = 0;
 }
 
+void KisLowMemoryTests::prefetchSwappedTilesTest()
+{
+    const int NUM_TILES_X = 8;
+    const int NUM_TILES_Y = 8;
+    const QRect rect(0, 0, NUM_TILES_X * 64, NUM_TILES_Y * 64);
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    /**
+     * The tiles should not be uniform, otherwise the store may
+     * compact them instead of swapping out
+     */
+    auto tileContent = [] (int col, int row) {
+        QByteArray content(64 * 64, char(1 + row * NUM_TILES_X + col));
+        for (int i = 0; i < content.size(); i += 2) {
+            content[i] = char(255 - row * NUM_TILES_X - col);
+        }
+        return content;
+    };
+
+    for (int row = 0; row < NUM_TILES_Y; row++) {
+        for (int col = 0; col < NUM_TILES_X; col++) {
+            QByteArray content = tileContent(col, row);
+            dm.writeBytes((quint8*)content.data(), col * 64, row * 64, 64, 64);
+        }
+    }
+
+    KisTileDataStore::instance()->debugSwapAll();
+
+    QList<KisTileSP> tiles;
+    int numSwappedTiles = 0;
+
+    for (int row = 0; row < NUM_TILES_Y; row++) {
+        for (int col = 0; col < NUM_TILES_X; col++) {
+            KisTileSP tile = dm.getTile(col, row, false);
+            tiles << tile;
+
+            if (!tile->tileData()->data()) {
+                numSwappedTiles++;
+            }
+        }
+    }
+
+    QVERIFY(numSwappedTiles > 0);
+
+    dm.prefetchRect(rect);
+    KisTileDataStore::instance()->testingWaitForPrefetch();
+
+    Q_FOREACH (KisTileSP tile, tiles) {
+        QVERIFY(tile->tileData()->data());
+    }
+
+    for (int row = 0; row < NUM_TILES_Y; row++) {
+        for (int col = 0; col < NUM_TILES_X; col++) {
+            QByteArray buffer(64 * 64, 0);
+            dm.readBytes((quint8*)buffer.data(), col * 64, row * 64, 64, 64);
+            QCOMPARE(buffer, tileContent(col, row));
+        }
+    }
+}
+
 QTEST_MAIN(KisLowMemoryTests)
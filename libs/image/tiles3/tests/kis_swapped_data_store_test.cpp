@@ -27,6 +27,7 @@
 #include "tiles_test_utils.h"
 
 #include "tiles3/kis_tile_data_store.h"
+#include "tiles3/swap/kis_swap_compression_factory.h"
 
 
 #define COLUMN2COLOR(col) (col%255)
@@ -131,5 +132,112 @@ void KisSwappedDataStoreTest::testRandomAccess()
         delete tileDataList[i];
 }
 
+void KisSwappedDataStoreTest::testCompressionBackends_data()
+{
+    QTest::addColumn<QString>("compression");
+
+    Q_FOREACH (KisSwapCompressionFactory::Type type, KisSwapCompressionFactory::availableTypes()) {
+        const QString name = KisSwapCompressionFactory::typeToString(type);
+        QTest::newRow(name.toLatin1()) << name;
+    }
+}
+
+void KisSwappedDataStoreTest::testCompressionBackends()
+{
+    QFETCH(QString, compression);
+
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[] = {128, 128, 128, 255};
+    const qint32 NUM_TILES = 1000;
+    const qint32 tileDataSize = pixelSize * TILESIZE;
+
+    KisImageConfig config(false);
+    const QString oldCompression = config.swapCompression();
+    config.setMaxSwapSize(40);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+    config.setSwapCompression(compression);
+
+    KisSwappedDataStore store;
+
+    config.setSwapCompression(oldCompression);
+
+    QList<KisTileData*> tileDataList;
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = new KisTileData(pixelSize, defaultPixel, KisTileDataStore::instance());
+
+        // half of the tiles are compressible, the other half is noise
+        quint8 *ptr = td->data();
+        for(qint32 j = 0; j < tileDataSize; j++) {
+            ptr[j] = i % 2 ? quint8(qrand()) : quint8(j / 256 + i);
+        }
+
+        tileDataList.append(td);
+    }
+
+    QList<QByteArray> referenceData;
+    Q_FOREACH (KisTileData *td, tileDataList) {
+        referenceData.append(QByteArray((const char*)td->data(), tileDataSize));
+        QVERIFY(store.trySwapOutTileData(td));
+        QVERIFY(!td->data());
+    }
+
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = tileDataList[i];
+        store.swapInTileData(td);
+        QVERIFY(!memcmp(td->data(), referenceData[i].constData(), tileDataSize));
+    }
+
+    qDeleteAll(tileDataList);
+}
+
+void KisSwappedDataStoreTest::testBatchSwapOut()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 128;
+    const qint32 NUM_TILES = 1000;
+    const qint32 BATCH_SIZE = 100;
+
+    KisImageConfig config(false);
+    config.setMaxSwapSize(4);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+
+
+    KisSwappedDataStore store;
+
+    QVector<KisTileData*> tileDataList;
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = new KisTileData(pixelSize, &defaultPixel, KisTileDataStore::instance());
+        memset(td->data(), COLUMN2COLOR(i), TILESIZE);
+        tileDataList.append(td);
+    }
+
+    for(qint32 i = 0; i < NUM_TILES; i += BATCH_SIZE) {
+        // FIXME: take a lock of the tile data
+        QCOMPARE(store.trySwapOutTileDataBatch(tileDataList.mid(i, BATCH_SIZE)), BATCH_SIZE);
+    }
+
+    QCOMPARE(store.numSwappedOut(), qint64(NUM_TILES));
+    QCOMPARE(store.numSwapOutBatches(), qint64(NUM_TILES / BATCH_SIZE));
+    QCOMPARE(store.totalMemoryMetric(), qint64(NUM_TILES * pixelSize));
+
+    store.debugStatistics();
+
+    for(qint32 i = 0; i < NUM_TILES; i++) {
+        KisTileData *td = tileDataList[i];
+        QVERIFY(!td->data());
+
+        // FIXME: take a lock of the tile data
+        store.swapInTileData(td);
+        QVERIFY(memoryIsFilled(COLUMN2COLOR(i), td->data(), TILESIZE));
+    }
+
+    QCOMPARE(store.numSwappedIn(), qint64(NUM_TILES));
+    QCOMPARE(store.totalMemoryMetric(), qint64(0));
+
+    qDeleteAll(tileDataList);
+}
+
 QTEST_MAIN(KisSwappedDataStoreTest)
 
@@ -33,6 +33,9 @@ private:
 private Q_SLOTS:
     void testRoundTrip();
     void testRandomAccess();
+    void testCompressionBackends_data();
+    void testCompressionBackends();
+    void testBatchSwapOut();
 
 };
 
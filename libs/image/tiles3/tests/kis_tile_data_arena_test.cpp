@@ -0,0 +1,266 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_data_arena_test.h"
+
+#include <QTest>
+#include <QThread>
+#include <QSemaphore>
+
+#include "tiles3/kis_tile_data_arena.h"
+
+static const int BLOB_SIZE = 4 * 64 * 64;
+
+void KisTileDataArenaTest::testAllocateFree()
+{
+    KisTileDataArena arena(BLOB_SIZE);
+
+    QVector<quint8*> blobs;
+    for (int i = 0; i < 300; i++) {
+        quint8 *ptr = arena.allocate();
+        QVERIFY(ptr);
+
+        memset(ptr, i & 0xff, BLOB_SIZE);
+        blobs << ptr;
+
+        QVERIFY(arena.nodeOf(ptr) >= 0);
+        QVERIFY(arena.nodeOf(ptr) < arena.numNodes());
+    }
+
+    QVERIFY(arena.allocatedMemory() >= qint64(300) * BLOB_SIZE);
+
+    // check that no blobs overlap
+    for (int i = 0; i < blobs.size(); i++) {
+        QCOMPARE(int(blobs[i][0]), i & 0xff);
+        QCOMPARE(int(blobs[i][BLOB_SIZE - 1]), i & 0xff);
+    }
+
+    const qint64 allocatedMemory = arena.allocatedMemory();
+
+    Q_FOREACH (quint8 *ptr, blobs) {
+        arena.free(ptr);
+    }
+
+    // the freed blobs should be reused
+    for (int i = 0; i < 300; i++) {
+        blobs[i] = arena.allocate();
+    }
+
+    // the thread might have migrated to another node in the meantime
+    if (arena.numNodes() == 1) {
+        QCOMPARE(arena.allocatedMemory(), allocatedMemory);
+    }
+
+    Q_FOREACH (quint8 *ptr, blobs) {
+        arena.free(ptr);
+    }
+}
+
+void KisTileDataArenaTest::testPurge()
+{
+    KisTileDataArena arena(BLOB_SIZE);
+
+    QVector<quint8*> blobs;
+    for (int i = 0; i < 300; i++) {
+        blobs << arena.allocate();
+    }
+
+    // a used blob holds its slab
+    quint8 *usedBlob = blobs.takeLast();
+
+    Q_FOREACH (quint8 *ptr, blobs) {
+        arena.free(ptr);
+    }
+
+    arena.flushThreadCaches();
+
+    const qint64 allocatedMemory = arena.allocatedMemory();
+    const qint64 releasedMemory = arena.purge();
+
+    QVERIFY(releasedMemory > 0);
+    QVERIFY(arena.allocatedMemory() > 0);
+    QCOMPARE(arena.allocatedMemory(), allocatedMemory - releasedMemory);
+
+    arena.free(usedBlob);
+    arena.flushThreadCaches();
+
+    arena.purge();
+    QCOMPARE(arena.allocatedMemory(), qint64(0));
+}
+
+class ArenaAllocationThread : public QThread
+{
+public:
+    ArenaAllocationThread(KisTileDataArena *arena, int numBlobs, bool freeBlobs)
+        : m_arena(arena),
+          m_numBlobs(numBlobs),
+          m_freeBlobs(freeBlobs)
+    {
+    }
+
+    void run() override {
+        m_blobs.reserve(m_numBlobs);
+
+        for (int i = 0; i < m_numBlobs; i++) {
+            if (m_arena) {
+                m_blobs << m_arena->allocate();
+            } else {
+                m_blobs << (quint8*) malloc(BLOB_SIZE);
+            }
+
+            // touch the memory to make the OS actually map it
+            m_blobs.last()[0] = 1;
+        }
+
+        if (m_freeBlobs) {
+            Q_FOREACH (quint8 *ptr, m_blobs) {
+                if (m_arena) {
+                    m_arena->free(ptr);
+                } else {
+                    free(ptr);
+                }
+            }
+            m_blobs.clear();
+        }
+    }
+
+    QVector<quint8*> blobs() const {
+        return m_blobs;
+    }
+
+private:
+    KisTileDataArena *m_arena;
+    int m_numBlobs;
+    bool m_freeBlobs;
+    QVector<quint8*> m_blobs;
+};
+
+void KisTileDataArenaTest::testCrossThreadFree()
+{
+    KisTileDataArena arena(BLOB_SIZE);
+
+    ArenaAllocationThread thread(&arena, 300, false);
+    thread.start();
+    thread.wait();
+
+    Q_FOREACH (quint8 *ptr, thread.blobs()) {
+        QVERIFY(arena.nodeOf(ptr) >= 0);
+        QVERIFY(arena.nodeOf(ptr) < arena.numNodes());
+
+        // the blob returns to the node it has been allocated on
+        arena.free(ptr);
+    }
+
+    arena.flushThreadCaches();
+    arena.purge();
+
+    QCOMPARE(arena.allocatedMemory(), qint64(0));
+}
+
+/**
+ * Frees its blobs into its cache and keeps running until
+ * it is explicitly released
+ */
+class ArenaCachingThread : public QThread
+{
+public:
+    ArenaCachingThread(KisTileDataArena *arena, const QVector<quint8*> &blobs)
+        : m_arena(arena),
+          m_blobs(blobs)
+    {
+    }
+
+    void run() override {
+        Q_FOREACH (quint8 *ptr, m_blobs) {
+            m_arena->free(ptr);
+        }
+
+        blobsFreed.release();
+        canExit.acquire();
+    }
+
+    QSemaphore blobsFreed;
+    QSemaphore canExit;
+
+private:
+    KisTileDataArena *m_arena;
+    QVector<quint8*> m_blobs;
+};
+
+void KisTileDataArenaTest::testFlushOtherThreadCaches()
+{
+    KisTileDataArena arena(BLOB_SIZE);
+
+    QVector<quint8*> blobs;
+    for (int i = 0; i < 300; i++) {
+        blobs << arena.allocate();
+    }
+
+    // the blobs are allocated by the main thread, but end up
+    // in the cache of the other one
+    ArenaCachingThread thread(&arena, blobs);
+    thread.start();
+    thread.blobsFreed.acquire();
+
+    arena.flushThreadCaches();
+    arena.purge();
+
+    QCOMPARE(arena.allocatedMemory(), qint64(0));
+
+    thread.canExit.release();
+    thread.wait();
+}
+
+void KisTileDataArenaTest::benchmarkAllocation_data()
+{
+    QTest::addColumn<int>("numThreads");
+    QTest::addColumn<bool>("useArena");
+
+    for (int numThreads = 1; numThreads <= 16; numThreads *= 2) {
+        QTest::newRow(QString("arena, %1 threads").arg(numThreads).toLatin1()) << numThreads << true;
+        QTest::newRow(QString("malloc, %1 threads").arg(numThreads).toLatin1()) << numThreads << false;
+    }
+}
+
+void KisTileDataArenaTest::benchmarkAllocation()
+{
+    QFETCH(int, numThreads);
+    QFETCH(bool, useArena);
+
+    KisTileDataArena arena(BLOB_SIZE);
+
+    QBENCHMARK {
+        QVector<ArenaAllocationThread*> threads;
+
+        for (int i = 0; i < numThreads; i++) {
+            threads << new ArenaAllocationThread(useArena ? &arena : 0, 4096, true);
+        }
+
+        Q_FOREACH (ArenaAllocationThread *thread, threads) {
+            thread->start();
+        }
+
+        Q_FOREACH (ArenaAllocationThread *thread, threads) {
+            thread->wait();
+        }
+
+        qDeleteAll(threads);
+    }
+}
+
+QTEST_MAIN(KisTileDataArenaTest)
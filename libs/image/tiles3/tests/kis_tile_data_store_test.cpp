@@ -24,6 +24,7 @@
 #include "kis_image_config.h"
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/kis_tile.h"
 #include "tiles_test_utils.h"
 
 #include "tiles3/kis_tile_data_store.h"
@@ -188,5 +189,105 @@ void KisTileDataStoreTest::testSwapping()
     }
 }
 
+void KisTileDataStoreTest::testDeduplication()
+{
+    // the test tiles are uniform, don't let the swapper compact them
+    KisImageConfig config(false);
+    const bool compactUniformTiles = config.enableUniformTileCompaction();
+    config.setEnableUniformTileCompaction(false);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->testingRereadConfig();
+    store->debugClear();
+
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 128;
+    quint8 otherPixel = 64;
+
+    KisTileData *td1 = new KisTileData(pixelSize, &defaultPixel, store, false);
+    store->registerTileData(td1);
+    KisTileData *td2 = new KisTileData(pixelSize, &defaultPixel, store, false);
+    store->registerTileData(td2);
+    KisTileData *td3 = new KisTileData(pixelSize, &otherPixel, store, false);
+    store->registerTileData(td3);
+
+    KisTileSP tile1 = new KisTile(0, 0, td1, 0);
+    KisTileSP tile2 = new KisTile(1, 0, td2, 0);
+    KisTileSP tile3 = new KisTile(2, 0, td3, 0);
+
+    store->testingDeduplicate();
+
+    QCOMPARE(store->memoryStatistics().numDeduplicatedTiles, qint64(1));
+    QCOMPARE(store->numTilesInMemory(), 2);
+    QCOMPARE(store->numTiles(), 3);
+
+    // exactly one of the identical tiles should have lost its data
+    QVERIFY(!td1->data() != !td2->data());
+    QVERIFY(td3->data());
+
+    KisTileData *source = td1->data() ? td1 : td2;
+    KisTileSP dedupTile = td1->data() ? tile2 : tile1;
+
+    // the prefetcher must not restore the memory saved by deduplication
+    dedupTile->prefetchTileData();
+    store->testingWaitForPrefetch();
+    QVERIFY(!dedupTile->tileData()->data());
+
+    // the tile keeps its tile data, the data is restored from the source
+    KisTileData *dedupTileData = dedupTile->tileData();
+
+    dedupTile->lockForRead();
+    QCOMPARE(dedupTile->tileData(), dedupTileData);
+    QVERIFY(memoryIsFilled(defaultPixel, dedupTile->data(), TILESIZE));
+    dedupTile->unlockForRead();
+
+    QCOMPARE(store->memoryStatistics().numDeduplicatedTiles, qint64(0));
+    QCOMPARE(store->numTilesInMemory(), 3);
+    QCOMPARE(store->numTiles(), 3);
+
+    // writing into the restored data doesn't touch the source
+    dedupTile->lockForWrite();
+    memset(dedupTile->data(), otherPixel, TILESIZE);
+    dedupTile->unlockForWrite();
+
+    QVERIFY(memoryIsFilled(defaultPixel, source->data(), TILESIZE));
+
+    // the tile data without any tiles is restored from the source
+    KisTileData *td4 = new KisTileData(pixelSize, &otherPixel, store, false);
+    store->registerTileData(td4);
+    td4->acquire();
+
+    store->testingDeduplicate();
+
+    QCOMPARE(store->memoryStatistics().numDeduplicatedTiles, qint64(2));
+
+    KisTileData *dedupData = 0;
+    Q_FOREACH (KisTileData *td, QList<KisTileData*>() << td3 << dedupTile->tileData() << td4) {
+        if (!td->data()) {
+            dedupData = td;
+            break;
+        }
+    }
+    QVERIFY(dedupData);
+
+    dedupData->blockSwapping();
+    QVERIFY(memoryIsFilled(otherPixel, dedupData->data(), TILESIZE));
+    dedupData->unblockSwapping();
+
+    QCOMPARE(store->memoryStatistics().numDeduplicatedTiles, qint64(1));
+
+    td4->release();
+    tile1 = 0;
+    tile2 = 0;
+    tile3 = 0;
+    dedupTile = 0;
+
+    QCOMPARE(store->numTiles(), 0);
+    QCOMPARE(store->memoryStatistics().numDeduplicatedTiles, qint64(0));
+
+    config.setEnableUniformTileCompaction(compactUniformTiles);
+    store->testingRereadConfig();
+}
+
 QTEST_MAIN(KisTileDataStoreTest)
 
@@ -18,8 +18,11 @@
 
 #include "kis_tiled_data_manager_test.h"
 #include <QTest>
+#include <QBuffer>
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "tiles3/kis_random_accessor.h"
 
 #include "tiles_test_utils.h"
 #include "config-limit-long-tests.h"
@@ -539,6 +542,304 @@ void KisTiledDataManagerTest::testUndoSetDefaultPixel()
     QVERIFY(memoryIsFilled(oddPixel2, tile10->data(), TILESIZE));
 }
 
+void KisTiledDataManagerTest::testUniformTileCompaction()
+{
+    KisTileDataStore *store = KisTileDataStore::instance();
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 fillPixel = 128;
+    quint8 clearPixel = 129;
+
+    // written through the usual path, then compacted by the store
+    QRect fillRect(0, 0, 128, 128);
+    QByteArray bytes(fillRect.width() * fillRect.height(), fillPixel);
+    dm.writeBytes((quint8*)bytes.data(), fillRect.x(), fillRect.y(), fillRect.width(), fillRect.height());
+
+    // and the same for the tiles created by clear()
+    QRect clearRect(128, 0, 128, 128);
+    dm.clear(clearRect, &clearPixel);
+
+    store->testingCompactUniformTiles();
+
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 2; row++) {
+            KisTileSP tile = dm.getTile(col, row, false);
+            QVERIFY(!tile->tileData()->data());
+        }
+    }
+
+    QVERIFY(store->memoryStatistics().numUniformTiles >= 5);
+
+    // the data is materialized transparently on access
+    KisRandomAccessor2 accessor(&dm, 0, 0, false, 0);
+
+    accessor.moveTo(10, 10);
+    QCOMPARE(*accessor.rawDataConst(), fillPixel);
+    accessor.moveTo(200, 100);
+    QCOMPARE(*accessor.rawDataConst(), clearPixel);
+
+    QByteArray result(256 * 128, 0);
+    dm.readBytes((quint8*)result.data(), 0, 0, 256, 128);
+
+    for (int y = 0; y < 128; y++) {
+        quint8 *line = (quint8*)result.data() + y * 256;
+        QVERIFY(memoryIsFilled(fillPixel, line, 128));
+        QVERIFY(memoryIsFilled(clearPixel, line + 128, 128));
+    }
+
+    // writing non-uniform content works as usual
+    KisTileSP tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    tile->data()[0] = 1;
+    tile->unlockForWrite();
+
+    store->testingCompactUniformTiles();
+    QVERIFY(tile->tileData()->data());
+}
+
+void KisTiledDataManagerTest::testTileSizes()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel, 256);
+    KisTiledDataManager dstDM(1, &defaultPixel);
+
+    QCOMPARE(srcDM.tileWidth(), 256);
+    QCOMPARE(srcDM.tileHeight(), 256);
+    QCOMPARE(dstDM.tileWidth(), qint32(KisTileData::WIDTH));
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    QRect rect(0,0,512,512);
+    QRect cloneRect(81,80,250,250);
+
+    srcDM.clear(rect, &oddPixel1);
+    dstDM.clear(rect, &oddPixel2);
+
+    QCOMPARE(srcDM.extent(), rect);
+
+    KisTileSP tile = srcDM.getTile(1, 1, false);
+    QCOMPARE(tile->extent(), QRect(256,256,256,256));
+
+    // tiles of different sizes cannot be shared, so pixels are copied
+    dstDM.bitBlt(&srcDM, cloneRect);
+
+    quint8 *buffer = new quint8[rect.width()*rect.height()];
+
+    dstDM.readBytes(buffer, rect.x(), rect.y(), rect.width(), rect.height());
+
+    QVERIFY(checkHole(buffer, oddPixel1, cloneRect,
+                      oddPixel2, rect));
+
+    delete[] buffer;
+}
+
+void KisTiledDataManagerTest::testConcurrentWriteRoundTrip()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    /**
+     * Make sure the number of tiles is big enough to be split
+     * into several batches and every tile has unique content
+     */
+    const QRect rect(-96, -32, 50 * 64, 50 * 64);
+
+    QVector<quint8> buffer(rect.width() * rect.height());
+    for (int y = 0; y < rect.height(); y++) {
+        for (int x = 0; x < rect.width(); x++) {
+            buffer[y * rect.width() + x] = quint8((x / 64) * 7 + (y / 64) * 13 + (x ^ y) % 5);
+        }
+    }
+    srcDM.writeBytes(buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+    QVERIFY(srcDM.write(writer));
+
+    fakeStore.startReading();
+
+    KisTiledDataManager dstDM(1, &defaultPixel);
+    QVERIFY(dstDM.read(fakeStore.device()));
+
+    QCOMPARE(dstDM.extent(), srcDM.extent());
+
+    QVector<quint8> result(rect.width() * rect.height());
+    dstDM.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    QVERIFY(result == buffer);
+}
+
+void KisTiledDataManagerTest::testLazyRead()
+{
+    KisTileDataStore *store = KisTileDataStore::instance();
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    const QRect rect(-64, 0, 4 * 64, 3 * 64);
+    const int numTiles = 12;
+
+    QVector<quint8> buffer(rect.width() * rect.height());
+    for (int y = 0; y < rect.height(); y++) {
+        for (int x = 0; x < rect.width(); x++) {
+            buffer[y * rect.width() + x] = quint8(x * 3 + y * 7);
+        }
+    }
+    srcDM.writeBytes(buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+    QVERIFY(srcDM.write(writer));
+    fakeStore.startReading();
+
+    const qint64 numPackedTiles = store->memoryStatistics().numPackedTiles;
+
+    KisTiledDataManager lazyDM(1, &defaultPixel);
+    QVERIFY(lazyDM.read(fakeStore.device(), true));
+
+    // nothing is unpacked until someone touches the tiles
+    QCOMPARE(lazyDM.extent(), srcDM.extent());
+    QCOMPARE(store->memoryStatistics().numPackedTiles, numPackedTiles + numTiles);
+    QVERIFY(!lazyDM.getTile(0, 0, false)->tileData()->data());
+
+    // the packed tiles are written as they are
+    KoStoreFake fakeStore2;
+    KisFakePaintDeviceWriter writer2(&fakeStore2);
+    QVERIFY(lazyDM.write(writer2));
+    fakeStore2.startReading();
+
+    QCOMPARE(store->memoryStatistics().numPackedTiles, numPackedTiles + numTiles);
+
+    KisTiledDataManager dstDM(1, &defaultPixel);
+    QVERIFY(dstDM.read(fakeStore2.device()));
+
+    QVector<quint8> result(rect.width() * rect.height());
+    dstDM.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(result == buffer);
+
+    // and unpacked transparently on access
+    result.fill(0);
+    lazyDM.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(result == buffer);
+
+    QCOMPARE(store->memoryStatistics().numPackedTiles, numPackedTiles);
+    QVERIFY(lazyDM.getTile(0, 0, false)->tileData()->data());
+}
+
+void KisTiledDataManagerTest::testLazyReadBrokenData()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager srcDM(1, &defaultPixel);
+
+    const QRect rect(0, 0, 64, 64);
+
+    QVector<quint8> buffer(rect.width() * rect.height());
+    for (int y = 0; y < rect.height(); y++) {
+        for (int x = 0; x < rect.width(); x++) {
+            buffer[y * rect.width() + x] = quint8(x / 8 * 10);
+        }
+    }
+    srcDM.writeBytes(buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+    QVERIFY(srcDM.write(writer));
+    fakeStore.startReading();
+
+    QByteArray data = fakeStore.device()->readAll();
+
+    // overwrite the LZF stream of the only tile, keeping its size
+    const int tileDataStart = data.indexOf('\n', data.lastIndexOf("LZF,")) + 1;
+    QVERIFY(tileDataStart > 0);
+    QCOMPARE(int(data[tileDataStart]), 1); // compressed
+    for (int i = tileDataStart + 1; i < data.size(); i++) {
+        data[i] = char(0xff);
+    }
+
+    {
+        QBuffer brokenStream(&data);
+        brokenStream.open(QIODevice::ReadOnly);
+
+        // the stream itself is not checked until the tile is accessed...
+        KisTiledDataManager lazyDM(1, &defaultPixel);
+        QVERIFY(lazyDM.read(&brokenStream, true));
+
+        KisTileDataStore *store = KisTileDataStore::instance();
+        const qint64 numBrokenTiles = store->memoryStatistics().numBrokenPackedTiles;
+
+        // ...and then the broken tile is reported and cleared
+        QVector<quint8> result(rect.width() * rect.height(), 1);
+        lazyDM.readBytes(result.data(), rect.x(), rect.y(), rect.width(), rect.height());
+        QVERIFY(result == QVector<quint8>(rect.width() * rect.height(), 0));
+
+        QCOMPARE(store->memoryStatistics().numBrokenPackedTiles, numBrokenTiles + 1);
+    }
+
+    // the raw data of a wrong size is reported while reading
+    data[tileDataStart] = 0;
+
+    QBuffer brokenStream(&data);
+    brokenStream.open(QIODevice::ReadOnly);
+
+    KisTiledDataManager lazyDM(1, &defaultPixel);
+    QVERIFY(!lazyDM.read(&brokenStream, true));
+}
+
+void KisTiledDataManagerTest::testWriteGeneration()
+{
+    quint8 defaultPixel = 0;
+    quint8 oddPixel = 128;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    const QRect rect(0, 0, 64, 64);
+    QVector<quint8> buffer(rect.width() * rect.height(), oddPixel);
+
+    quint64 generation = dm.writeGeneration();
+
+    // reading does not change anything
+    dm.readBytes(buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    dm.getTile(0, 0, false);
+    QCOMPARE(dm.writeGeneration(), generation);
+
+    dm.writeBytes(buffer.data(), rect.x(), rect.y(), rect.width(), rect.height());
+    QVERIFY(dm.writeGeneration() != generation);
+    generation = dm.writeGeneration();
+
+    KisMementoSP memento = dm.getMemento();
+    dm.clear(rect, &oddPixel);
+    dm.commit();
+    QVERIFY(dm.writeGeneration() != generation);
+    generation = dm.writeGeneration();
+
+    dm.rollback(memento);
+    QVERIFY(dm.writeGeneration() != generation);
+    generation = dm.writeGeneration();
+
+    dm.setDefaultPixel(&oddPixel);
+    QVERIFY(dm.writeGeneration() != generation);
+    generation = dm.writeGeneration();
+
+    KisTiledDataManager srcDM(1, &defaultPixel);
+    dm.bitBlt(&srcDM, rect);
+    QVERIFY(dm.writeGeneration() != generation);
+    generation = dm.writeGeneration();
+
+    dm.setExtent(QRect(0, 0, 32, 32));
+    QVERIFY(dm.writeGeneration() != generation);
+
+    // the copies are different data managers
+    KisTiledDataManager copyDM(dm);
+    QVERIFY(copyDM.uniqueId() != dm.uniqueId());
+    QVERIFY(srcDM.uniqueId() != dm.uniqueId());
+
+    generation = dm.writeGeneration();
+    copyDM.clear();
+    QCOMPARE(dm.writeGeneration(), generation);
+}
+
 //#include <valgrind/callgrind.h>
 
 void KisTiledDataManagerTest::benchmarkReadOnlyTileLazy()
@@ -52,6 +52,12 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testUniformTileCompaction();
+    void testTileSizes();
+    void testConcurrentWriteRoundTrip();
+    void testLazyRead();
+    void testLazyReadBrokenData();
+    void testWriteGeneration();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -31,6 +31,26 @@ template<typename _channels_type_,
          typename EnableDummyType = void>
 struct KoAlphaMaskApplicator : public KoAlphaMaskApplicatorBase
 {
+    void applyAlphaU8Mask(quint8 *pixels,
+                          const quint8 *alpha,
+                          qint32 nPixels) const override {
+        KoColorSpaceTrait<
+                _channels_type_,
+                _channels_nb_,
+                _alpha_pos_>::
+                applyAlphaU8Mask(pixels, alpha, nPixels);
+    }
+
+    void applyAlphaNormedFloatMask(quint8 *pixels,
+                                   const float *alpha,
+                                   qint32 nPixels) const override {
+        KoColorSpaceTrait<
+                _channels_type_,
+                _channels_nb_,
+                _alpha_pos_>::
+                applyAlphaNormedFloatMask(pixels, alpha, nPixels);
+    }
+
     void applyInverseNormedFloatMask(quint8 *pixels,
                                      const float *alpha,
                                      qint32 nPixels) const override {
@@ -77,6 +97,65 @@ struct KoAlphaMaskApplicator<
     static constexpr int numChannels = 4;
     static constexpr int alphaPos = 3;
 
+    void applyAlphaU8Mask(quint8 *pixels,
+                          const quint8 *alpha,
+                          qint32 nPixels) const override
+    {
+        const int block1 = nPixels / Vc::float_v::size();
+        const int block2 = nPixels % Vc::float_v::size();
+        const int vectorPixelStride = numChannels * Vc::float_v::size();
+
+        for (int i = 0; i < block1; i++) {
+            const uint_v maskAlpha(alpha);
+
+            uint_v data_i;
+            data_i.load((const quint32*)pixels, Vc::Unaligned);
+
+            const quint32 colorChannelsMask = 0x00FFFFFF;
+
+            const uint_v pixelAlpha_i = multiply(data_i >> 24, maskAlpha);
+            data_i = (data_i & colorChannelsMask) | (pixelAlpha_i << 24);
+            data_i.store((quint32*)pixels, Vc::Unaligned);
+
+            pixels += vectorPixelStride;
+            alpha += Vc::float_v::size();
+        }
+
+        KoColorSpaceTrait<quint8, 4, 3>::
+            applyAlphaU8Mask(pixels, alpha, block2);
+    }
+
+    void applyAlphaNormedFloatMask(quint8 *pixels,
+                                   const float *alpha,
+                                   qint32 nPixels) const override
+    {
+        const int block1 = nPixels / Vc::float_v::size();
+        const int block2 = nPixels % Vc::float_v::size();
+        const int vectorPixelStride = numChannels * Vc::float_v::size();
+
+        for (int i = 0; i < block1; i++) {
+            Vc::float_v maskAlpha(alpha, Vc::Unaligned);
+
+            // the scalar version truncates the mask value as well
+            const uint_v maskAlpha_i = uint_v(int_v(maskAlpha * Vc::float_v(255.0f)));
+
+            uint_v data_i;
+            data_i.load((const quint32*)pixels, Vc::Unaligned);
+
+            const quint32 colorChannelsMask = 0x00FFFFFF;
+
+            const uint_v pixelAlpha_i = multiply(data_i >> 24, maskAlpha_i);
+            data_i = (data_i & colorChannelsMask) | (pixelAlpha_i << 24);
+            data_i.store((quint32*)pixels, Vc::Unaligned);
+
+            pixels += vectorPixelStride;
+            alpha += Vc::float_v::size();
+        }
+
+        KoColorSpaceTrait<quint8, 4, 3>::
+            applyAlphaNormedFloatMask(pixels, alpha, block2);
+    }
+
     void applyInverseNormedFloatMask(quint8 *pixels,
                                      const float *alpha,
                                      qint32 nPixels) const override
@@ -167,6 +246,179 @@ struct KoAlphaMaskApplicator<
     }
 };
 
+/**
+ * Math of alpha channel multiplication for Vc-optimized applicators of
+ * color spaces that don't have a specialized implementation. Integer
+ * channels are processed in uint_v, floating point ones in float_v.
+ * The results are bit-exact with KoColorSpaceTrait's scalar versions.
+ */
+template<typename channels_type, Vc::Implementation _impl>
+struct KoAlphaMaskApplicatorVcOps;
+
+template<Vc::Implementation _impl>
+struct KoAlphaMaskApplicatorVcOps<quint8, _impl>
+{
+    using uint_v = typename KoStreamedMath<_impl>::uint_v;
+    using int_v = typename KoStreamedMath<_impl>::int_v;
+    using value_v = uint_v;
+
+    static inline value_v fromU8Mask(const quint8 *mask) {
+        return uint_v(mask);
+    }
+
+    static inline value_v fromNormedFloatMask(Vc::float_v mask) {
+        return uint_v(int_v(mask * Vc::float_v(255.0f)));
+    }
+
+    static inline value_v multiply(value_v a, value_v b) {
+        const uint_v c = a * b + 0x80u;
+        return ((c >> 8) + c) >> 8;
+    }
+};
+
+template<Vc::Implementation _impl>
+struct KoAlphaMaskApplicatorVcOps<quint16, _impl>
+{
+    using uint_v = typename KoStreamedMath<_impl>::uint_v;
+    using int_v = typename KoStreamedMath<_impl>::int_v;
+    using value_v = uint_v;
+
+    static inline value_v fromU8Mask(const quint8 *mask) {
+        return uint_v(mask) * 257u;
+    }
+
+    static inline value_v fromNormedFloatMask(Vc::float_v mask) {
+        return uint_v(int_v(mask * Vc::float_v(65535.0f)));
+    }
+
+    static inline value_v multiply(value_v a, value_v b) {
+        // doesn't overflow: 0xFFFF * 0xFFFF + 0x8000 + 0xFFFF < 2^32
+        const uint_v c = a * b + 0x8000u;
+        return ((c >> 16) + c) >> 16;
+    }
+};
+
+template<Vc::Implementation _impl>
+struct KoAlphaMaskApplicatorVcOps<float, _impl>
+{
+    using uint_v = typename KoStreamedMath<_impl>::uint_v;
+    using int_v = typename KoStreamedMath<_impl>::int_v;
+    using value_v = Vc::float_v;
+
+    static inline value_v fromU8Mask(const quint8 *mask) {
+        // division (not multiplication by 1/255) is what KoLuts::Uint8ToFloat does
+        return Vc::simd_cast<Vc::float_v>(int_v(uint_v(mask))) / Vc::float_v(255.0f);
+    }
+
+    static inline value_v fromNormedFloatMask(Vc::float_v mask) {
+        return mask;
+    }
+
+    static inline value_v multiply(value_v a, value_v b) {
+        return a * b;
+    }
+};
+
+/**
+ * A generic Vc-optimized applicator for U8, U16 and F32 color spaces.
+ * The alpha channel is gathered from the pixels, multiplied in SIMD
+ * registers and scattered back, so it works for any pixel layout.
+ *
+ * F16 color spaces are not handled, Vc has no conversions for half,
+ * they use the scalar version.
+ */
+template<typename _channels_type_,
+         int _channels_nb_,
+         int _alpha_pos_,
+         Vc::Implementation _impl>
+struct KoAlphaMaskApplicator<
+        _channels_type_, _channels_nb_, _alpha_pos_, _impl,
+        typename std::enable_if<_impl != Vc::ScalarImpl &&
+                                !(std::is_same<_channels_type_, quint8>::value && _channels_nb_ == 4) &&
+                                (std::is_same<_channels_type_, quint8>::value ||
+                                 std::is_same<_channels_type_, quint16>::value ||
+                                 std::is_same<_channels_type_, float>::value)>::type> : public KoAlphaMaskApplicatorBase
+{
+    using Ops = KoAlphaMaskApplicatorVcOps<_channels_type_, _impl>;
+    using Trait = KoColorSpaceTrait<_channels_type_, _channels_nb_, _alpha_pos_>;
+    using int_v = typename KoStreamedMath<_impl>::int_v;
+    using value_v = typename Ops::value_v;
+
+    static inline int_v alphaIndexes() {
+        return int_v(Vc::IndexesFromZero) * _channels_nb_ + _alpha_pos_;
+    }
+
+    template <typename MaskFetcher>
+    static inline void applyMask(quint8 *pixels, qint32 numVectors, MaskFetcher fetchMask) {
+        const int_v indexes = alphaIndexes();
+        const int vectorPixelStride = Trait::pixelSize * Vc::float_v::size();
+
+        for (int i = 0; i < numVectors; i++) {
+            _channels_type_ *data = Trait::nativeArray(pixels);
+
+            value_v pixelAlpha(data, indexes);
+            pixelAlpha = Ops::multiply(pixelAlpha, fetchMask(i));
+            pixelAlpha.scatter(data, indexes);
+
+            pixels += vectorPixelStride;
+        }
+    }
+
+    void applyAlphaU8Mask(quint8 *pixels,
+                          const quint8 *alpha,
+                          qint32 nPixels) const override {
+        const int block1 = nPixels / Vc::float_v::size();
+        const int block2 = nPixels % Vc::float_v::size();
+
+        applyMask(pixels, block1, [alpha] (int i) {
+            return Ops::fromU8Mask(alpha + i * Vc::float_v::size());
+        });
+
+        const int processed = block1 * Vc::float_v::size();
+        Trait::applyAlphaU8Mask(pixels + processed * Trait::pixelSize, alpha + processed, block2);
+    }
+
+    void applyAlphaNormedFloatMask(quint8 *pixels,
+                                   const float *alpha,
+                                   qint32 nPixels) const override {
+        const int block1 = nPixels / Vc::float_v::size();
+        const int block2 = nPixels % Vc::float_v::size();
+
+        applyMask(pixels, block1, [alpha] (int i) {
+            return Ops::fromNormedFloatMask(Vc::float_v(alpha + i * Vc::float_v::size(), Vc::Unaligned));
+        });
+
+        const int processed = block1 * Vc::float_v::size();
+        Trait::applyAlphaNormedFloatMask(pixels + processed * Trait::pixelSize, alpha + processed, block2);
+    }
+
+    void applyInverseNormedFloatMask(quint8 *pixels,
+                                     const float *alpha,
+                                     qint32 nPixels) const override {
+        const int block1 = nPixels / Vc::float_v::size();
+        const int block2 = nPixels % Vc::float_v::size();
+
+        applyMask(pixels, block1, [alpha] (int i) {
+            const Vc::float_v mask(alpha + i * Vc::float_v::size(), Vc::Unaligned);
+            return Ops::fromNormedFloatMask(Vc::float_v(1.0f) - mask);
+        });
+
+        const int processed = block1 * Vc::float_v::size();
+        Trait::applyInverseAlphaNormedFloatMask(pixels + processed * Trait::pixelSize, alpha + processed, block2);
+    }
+
+    void fillInverseAlphaNormedFloatMaskWithColor(quint8 * pixels,
+                                                  const float * alpha,
+                                                  const quint8 *brushColor,
+                                                  qint32 nPixels) const override {
+        Trait::fillInverseAlphaNormedFloatMaskWithColor(pixels, alpha, brushColor, nPixels);
+    }
+
+    void fillGrayBrushWithColor(quint8 *dst, const QRgb *brush, quint8 *brushColor, qint32 nPixels) const override {
+        Trait::fillGrayBrushWithColor(dst, brush, brushColor, nPixels);
+    }
+};
+
 #endif /* HAVE_VC */
 
 #endif // KOALPHAMASKAPPLICATOR_H
@@ -23,37 +23,45 @@
 #include <QList>
 #include <QMutex>
 #include <QThreadStorage>
+#include <QSharedPointer>
+#include <QAtomicInt>
 
 #include <KoColorSpace.h>
+#include "KoColorConversionLut.h"
+#include "KoRgbTrcConversionTransformation.h"
 
 struct KoColorConversionCacheKey {
 
     KoColorConversionCacheKey(const KoColorSpace* _src,
                               const KoColorSpace* _dst,
                               KoColorConversionTransformation::Intent _renderingIntent,
-                              KoColorConversionTransformation::ConversionFlags _conversionFlags)
+                              KoColorConversionTransformation::ConversionFlags _conversionFlags,
+                              bool _allowLut)
         : src(_src)
         , dst(_dst)
         , renderingIntent(_renderingIntent)
         , conversionFlags(_conversionFlags)
+        , allowLut(_allowLut)
     {
     }
 
     bool operator==(const KoColorConversionCacheKey& rhs) const {
         return (*src == *(rhs.src)) && (*dst == *(rhs.dst))
                 && (renderingIntent == rhs.renderingIntent)
-                && (conversionFlags == rhs.conversionFlags);
+                && (conversionFlags == rhs.conversionFlags)
+                && (allowLut == rhs.allowLut);
     }
 
     const KoColorSpace* src;
     const KoColorSpace* dst;
     KoColorConversionTransformation::Intent renderingIntent;
     KoColorConversionTransformation::ConversionFlags conversionFlags;
+    bool allowLut;
 };
 
 uint qHash(const KoColorConversionCacheKey& key)
 {
-    return qHash(key.src) + qHash(key.dst) + qHash(key.renderingIntent) + qHash(key.conversionFlags);
+    return qHash(key.src) + qHash(key.dst) + qHash(key.renderingIntent) + qHash(key.conversionFlags) + qHash(key.allowLut);
 }
 
 struct KoColorConversionCache::CachedTransformation {
@@ -80,6 +88,20 @@ struct KoColorConversionCache::Private {
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*> cache;
     QMutex cacheMutex;
 
+    /**
+     * Lookup tables are shared between all the transformations
+     * created for the same key (one transformation per thread)
+     */
+    QHash< KoColorConversionCacheKey, QSharedPointer<const KoColorConversionLut> > luts;
+
+    /**
+     * The tables are approximate, so they are used only when
+     * explicitly enabled. \see setUseLookupTables()
+     */
+    QAtomicInt useLuts {0};
+
+    KoColorConversionTransformation* createTransformation(const KoColorConversionCacheKey &key);
+
     QThreadStorage<FastPathCacheItem*> fastStorage;
 };
 
@@ -101,7 +123,7 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
                                                                               KoColorConversionTransformation::Intent _renderingIntent,
                                                                               KoColorConversionTransformation::ConversionFlags _conversionFlags)
 {
-    KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags);
+    KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags, d->useLuts.loadAcquire());
 
     FastPathCacheItem *cacheItem =
         d->fastStorage.localData();
@@ -128,7 +150,7 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
         }
     }
     if (!cacheItem) {
-        KoColorConversionTransformation* transfo = src->createColorConverter(dst, _renderingIntent, _conversionFlags);
+        KoColorConversionTransformation* transfo = d->createTransformation(key);
         CachedTransformation* ct = new CachedTransformation(transfo);
         d->cache.insert(key, ct);
         cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
@@ -138,6 +160,16 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
     return cacheItem->second;
 }
 
+void KoColorConversionCache::setUseLookupTables(bool value)
+{
+    d->useLuts.storeRelease(value);
+}
+
+bool KoColorConversionCache::useLookupTables() const
+{
+    return d->useLuts.loadAcquire();
+}
+
 void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
 {
     d->fastStorage.setLocalData(0);
@@ -153,6 +185,38 @@ void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
             ++it;
         }
     }
+
+    for (auto it = d->luts.begin(); it != d->luts.end();) {
+        if (it.key().src == cs || it.key().dst == cs) {
+            it = d->luts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+KoColorConversionTransformation* KoColorConversionCache::Private::createTransformation(const KoColorConversionCacheKey &key)
+{
+    /**
+     * The TRC conversion is both exact and faster than the table,
+     * so it is preferred. KoColorConversionSystem creates it for us.
+     */
+    if (key.allowLut &&
+        !KoRgbTrcConversionTransformation::isSuitable(key.src, key.dst, key.conversionFlags) &&
+        KoColorConversionLut::isSuitable(key.src, key.dst, key.conversionFlags)) {
+        QSharedPointer<const KoColorConversionLut> lut = luts.value(key);
+
+        if (!lut) {
+            lut.reset(KoColorConversionLut::create(key.src, key.dst, key.renderingIntent, key.conversionFlags));
+        }
+
+        if (lut) {
+            luts.insert(key, lut);
+            return new KoLutColorConversionTransformation(lut, key.src, key.dst, key.renderingIntent, key.conversionFlags);
+        }
+    }
+
+    return key.src->createColorConverter(key.dst, key.renderingIntent, key.conversionFlags);
 }
 
 //--------- KoCachedColorConversionTransformation ----------//
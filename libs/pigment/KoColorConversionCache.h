@@ -51,6 +51,15 @@ public:
                                                           KoColorConversionTransformation::Intent _renderingIntent,
                                                           KoColorConversionTransformation::ConversionFlags conversionFlags);
 
+    /**
+     * Enables replacing of the conversions with precomputed lookup
+     * tables (see KoColorConversionLut). The tables are faster, but
+     * approximate, so they are disabled by default. The setting
+     * affects only the converters requested after the call.
+     */
+    void setUseLookupTables(bool value);
+    bool useLookupTables() const;
+
     /**
      * This function is called by the destructor of the color space to
      * warn the cache that any pointers to this color space is going to
@@ -0,0 +1,288 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KoColorConversionLut.h"
+
+#include <utility>
+
+#include <QScopedPointer>
+
+#include <KoColorSpace.h>
+#include <KoColorProfile.h>
+#include <KoColorSpaceMaths.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+namespace {
+
+inline bool isIntegerDepth(const KoID &depthId)
+{
+    return depthId == Integer8BitsColorDepthID || depthId == Integer16BitsColorDepthID;
+}
+
+/**
+ * Fills \p colorPos with the positions of color (non-alpha) channels
+ * of a pixel of \p numChannels channels
+ */
+inline void fetchColorPositions(int numChannels, int alphaPos, int *colorPos)
+{
+    for (int i = 0, j = 0; i < numChannels; i++) {
+        if (i != alphaPos) {
+            colorPos[j++] = i;
+        }
+    }
+}
+
+}
+
+KoColorConversionLut::KoColorConversionLut(int dstColorChannels)
+    : m_dstColorChannels(dstColorChannels)
+{
+}
+
+bool KoColorConversionLut::isSuitable(const KoColorSpace *src,
+                                      const KoColorSpace *dst,
+                                      KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (conversionFlags.testFlag(KoColorConversionTransformation::NoOptimization)) {
+        return false;
+    }
+
+    if (src->colorModelId() != RGBAColorModelID ||
+        !isIntegerDepth(src->colorDepthId()) ||
+        src->channelCount() != 4 ||
+        src->colorChannelCount() != 3) {
+
+        return false;
+    }
+
+    if ((dst->colorModelId() != RGBAColorModelID &&
+         dst->colorModelId() != CMYKAColorModelID &&
+         dst->colorModelId() != GrayAColorModelID) ||
+        !isIntegerDepth(dst->colorDepthId()) ||
+        dst->channelCount() != dst->colorChannelCount() + 1) {
+
+        return false;
+    }
+
+    const KoColorProfile *srcProfile = src->profile();
+    const KoColorProfile *dstProfile = dst->profile();
+
+    if (!srcProfile || !dstProfile) {
+        return false;
+    }
+
+    /**
+     * Linear data has too little precision in shadows to be
+     * interpolated over a regular grid (the ICC engine disables
+     * LCMS's own optimizations for them for the same reason)
+     */
+    if (srcProfile->isLinear() || dstProfile->isLinear()) {
+        return false;
+    }
+
+    // a mere depth conversion, the table would only add an error
+    if (src->colorModelId() == dst->colorModelId() && *srcProfile == *dstProfile) {
+        return false;
+    }
+
+    return true;
+}
+
+KoColorConversionLut* KoColorConversionLut::create(const KoColorSpace *src,
+                                                   const KoColorSpace *dst,
+                                                   KoColorConversionTransformation::Intent renderingIntent,
+                                                   KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    /**
+     * Sample the grid with 16-bit color spaces, so that grid nodes are
+     * placed exactly and the values are not quantized to 8 bits
+     */
+    const KoColorSpace *src16 =
+        registry->colorSpace(src->colorModelId().id(), Integer16BitsColorDepthID.id(), src->profile());
+    const KoColorSpace *dst16 =
+        registry->colorSpace(dst->colorModelId().id(), Integer16BitsColorDepthID.id(), dst->profile());
+
+    if (!src16 || !dst16) {
+        return 0;
+    }
+
+    QScopedPointer<KoColorConversionTransformation> sampler(
+        src16->createColorConverter(dst16, renderingIntent,
+                                    conversionFlags | KoColorConversionTransformation::NoOptimization));
+
+    if (!sampler) {
+        return 0;
+    }
+
+    const int numNodes = gridSize * gridSize * gridSize;
+    const int srcChannels = src16->channelCount();
+    const int dstChannels = dst16->channelCount();
+    const int dstColorChannels = dst16->colorChannelCount();
+
+    int srcColorPos[3];
+    fetchColorPositions(srcChannels, src16->alphaPos(), srcColorPos);
+
+    int dstColorPos[4];
+    fetchColorPositions(dstChannels, dst16->alphaPos(), dstColorPos);
+
+    QVector<quint16> srcNodes(numNodes * srcChannels);
+    QVector<quint16> dstNodes(numNodes * dstChannels);
+
+    quint16 *srcPtr = srcNodes.data();
+    for (int i0 = 0; i0 < gridSize; i0++) {
+        for (int i1 = 0; i1 < gridSize; i1++) {
+            for (int i2 = 0; i2 < gridSize; i2++) {
+                srcPtr[srcColorPos[0]] = quint16(qRound(i0 * 65535.0 / (gridSize - 1)));
+                srcPtr[srcColorPos[1]] = quint16(qRound(i1 * 65535.0 / (gridSize - 1)));
+                srcPtr[srcColorPos[2]] = quint16(qRound(i2 * 65535.0 / (gridSize - 1)));
+                srcPtr[src16->alphaPos()] = 0xFFFF;
+                srcPtr += srcChannels;
+            }
+        }
+    }
+
+    sampler->transform(reinterpret_cast<const quint8*>(srcNodes.constData()),
+                       reinterpret_cast<quint8*>(dstNodes.data()),
+                       numNodes);
+
+    KoColorConversionLut *lut = new KoColorConversionLut(dstColorChannels);
+    lut->m_table.resize(numNodes * dstColorChannels);
+
+    const quint16 *dstPtr = dstNodes.constData();
+    float *tablePtr = lut->m_table.data();
+
+    for (int i = 0; i < numNodes; i++) {
+        for (int ch = 0; ch < dstColorChannels; ch++) {
+            *tablePtr++ = dstPtr[dstColorPos[ch]];
+        }
+        dstPtr += dstChannels;
+    }
+
+    return lut;
+}
+
+template <typename src_channel_t, typename dst_channel_t>
+void KoColorConversionLut::transform(const quint8 *srcU8, quint8 *dstU8, qint32 nPixels,
+                                     int srcAlphaPos, int dstAlphaPos) const
+{
+    const src_channel_t *src = reinterpret_cast<const src_channel_t*>(srcU8);
+    dst_channel_t *dst = reinterpret_cast<dst_channel_t*>(dstU8);
+
+    const int dstChannels = m_dstColorChannels + 1;
+
+    int srcColorPos[3];
+    fetchColorPositions(4, srcAlphaPos, srcColorPos);
+
+    int dstColorPos[4];
+    fetchColorPositions(dstChannels, dstAlphaPos, dstColorPos);
+
+    const int strides[3] = {
+        gridSize * gridSize * m_dstColorChannels,
+        gridSize * m_dstColorChannels,
+        m_dstColorChannels
+    };
+
+    const float srcToGrid = float(gridSize - 1) / KoColorSpaceMathsTraits<src_channel_t>::unitValue;
+    const float tableToDst = float(KoColorSpaceMathsTraits<dst_channel_t>::unitValue) / 65535.0f;
+
+    const float *table = m_table.constData();
+
+    for (qint32 i = 0; i < nPixels; i++) {
+        float frac[3];
+        int offset = 0;
+
+        for (int axis = 0; axis < 3; axis++) {
+            const float pos = src[srcColorPos[axis]] * srcToGrid;
+            const int index = qMin(int(pos), gridSize - 2);
+            frac[axis] = pos - index;
+            offset += index * strides[axis];
+        }
+
+        /**
+         * Tetrahedral interpolation: sort the axes by their fractions
+         * and walk from the base node of the cube to the opposite one
+         * along the edges of the tetrahedron containing the point.
+         */
+        int a = 0;
+        int b = 1;
+        int c = 2;
+
+        if (frac[a] < frac[b]) std::swap(a, b);
+        if (frac[b] < frac[c]) std::swap(b, c);
+        if (frac[a] < frac[b]) std::swap(a, b);
+
+        const float *p0 = table + offset;
+        const float *p1 = p0 + strides[a];
+        const float *p2 = p1 + strides[b];
+        const float *p3 = p2 + strides[c];
+
+        const float fa = frac[a];
+        const float fb = frac[b];
+        const float fc = frac[c];
+
+        for (int ch = 0; ch < m_dstColorChannels; ch++) {
+            const float value =
+                p0[ch] +
+                fa * (p1[ch] - p0[ch]) +
+                fb * (p2[ch] - p1[ch]) +
+                fc * (p3[ch] - p2[ch]);
+
+            dst[dstColorPos[ch]] = dst_channel_t(value * tableToDst + 0.5f);
+        }
+
+        dst[dstAlphaPos] = KoColorSpaceMaths<src_channel_t, dst_channel_t>::scaleToA(src[srcAlphaPos]);
+
+        src += 4;
+        dst += dstChannels;
+    }
+}
+
+// --- KoLutColorConversionTransformation ---
+
+KoLutColorConversionTransformation::KoLutColorConversionTransformation(QSharedPointer<const KoColorConversionLut> lut,
+                                                                       const KoColorSpace *srcCs,
+                                                                       const KoColorSpace *dstCs,
+                                                                       Intent renderingIntent,
+                                                                       ConversionFlags conversionFlags)
+    : KoColorConversionTransformation(srcCs, dstCs, renderingIntent, conversionFlags),
+      m_lut(lut),
+      m_srcAlphaPos(srcCs->alphaPos()),
+      m_dstAlphaPos(dstCs->alphaPos())
+{
+    const bool srcIs8Bit = srcCs->colorDepthId() == Integer8BitsColorDepthID;
+    const bool dstIs8Bit = dstCs->colorDepthId() == Integer8BitsColorDepthID;
+
+    if (srcIs8Bit) {
+        m_transformFunc = dstIs8Bit ?
+            &KoColorConversionLut::transform<quint8, quint8> :
+            &KoColorConversionLut::transform<quint8, quint16>;
+    } else {
+        m_transformFunc = dstIs8Bit ?
+            &KoColorConversionLut::transform<quint16, quint8> :
+            &KoColorConversionLut::transform<quint16, quint16>;
+    }
+}
+
+void KoLutColorConversionTransformation::transform(const quint8 *src, quint8 *dst, qint32 nPixels) const
+{
+    ((*m_lut).*m_transformFunc)(src, dst, nPixels, m_srcAlphaPos, m_dstAlphaPos);
+}
@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef _KO_COLOR_CONVERSION_LUT_H_
+#define _KO_COLOR_CONVERSION_LUT_H_
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include "KoColorConversionTransformation.h"
+
+class KoColorSpace;
+
+/**
+ * A precomputed 3D lookup table of a color conversion from a
+ * three-channel integer color space (RGB U8/U16) into an integer
+ * destination color space (RGB, CMYK or Gray U8/U16).
+ *
+ * The table is sampled once from a 16-bit version of the conversion
+ * and then evaluated with tetrahedral interpolation, which is much
+ * cheaper than running the full ICC pipeline for every pixel. Alpha
+ * channel is not part of the table, it is just copied over.
+ *
+ * The interpolated values may differ from the exact conversion by up
+ * to 2 LSB, so the tables are used only when the user enables them in
+ * the color management preferences, see
+ * KoColorSpaceRegistry::setUseColorConversionLookupTables().
+ *
+ * The table does not depend on the color spaces' channel semantics:
+ * its axes follow the memory order of the source color channels and
+ * its values follow the memory order of the destination ones.
+ *
+ * This class is not part of public API, and can be changed without notice.
+ */
+class KoColorConversionLut
+{
+public:
+    /**
+     * The number of grid points per axis. The same as LCMS uses for
+     * its own precalculated 3-channel transforms.
+     */
+    static const int gridSize = 33;
+
+    /**
+     * @return true if the conversion from \p src to \p dst can be
+     * replaced with a lookup table without visible loss of precision.
+     * Conversions requested with NoOptimization flag and conversions
+     * from/to linear profiles are never replaced.
+     */
+    static bool isSuitable(const KoColorSpace *src,
+                           const KoColorSpace *dst,
+                           KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    /**
+     * Samples the conversion from \p src to \p dst into a new table.
+     * Returns null if the sampling conversion cannot be created.
+     */
+    static KoColorConversionLut* create(const KoColorSpace *src,
+                                        const KoColorSpace *dst,
+                                        KoColorConversionTransformation::Intent renderingIntent,
+                                        KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    /**
+     * Converts \p nPixels pixels of \p src_channel_t channels into
+     * \p dst_channel_t ones. The color spaces must have the same layout
+     * as the ones the table has been created for (they may differ in
+     * the depth only).
+     */
+    template <typename src_channel_t, typename dst_channel_t>
+    void transform(const quint8 *src, quint8 *dst, qint32 nPixels,
+                   int srcAlphaPos, int dstAlphaPos) const;
+
+private:
+    KoColorConversionLut(int dstColorChannels);
+
+private:
+    const int m_dstColorChannels;
+
+    // color values of the destination in 16-bit range
+    QVector<float> m_table;
+};
+
+/**
+ * A color conversion that is evaluated with a (shared) KoColorConversionLut
+ */
+class KoLutColorConversionTransformation : public KoColorConversionTransformation
+{
+public:
+    KoLutColorConversionTransformation(QSharedPointer<const KoColorConversionLut> lut,
+                                       const KoColorSpace *srcCs,
+                                       const KoColorSpace *dstCs,
+                                       Intent renderingIntent,
+                                       ConversionFlags conversionFlags);
+
+    void transform(const quint8 *src, quint8 *dst, qint32 nPixels) const override;
+
+private:
+    typedef void (KoColorConversionLut::*TransformFunc)(const quint8*, quint8*, qint32, int, int) const;
+
+    QSharedPointer<const KoColorConversionLut> m_lut;
+    TransformFunc m_transformFunc;
+    int m_srcAlphaPos;
+    int m_dstAlphaPos;
+};
+
+#endif
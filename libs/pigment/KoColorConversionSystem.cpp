@@ -29,6 +29,7 @@
 #include "KoColorSpace.h"
 #include "KoCopyColorConversionTransformation.h"
 #include "KoMultipleColorConversionTransformation.h"
+#include "KoRgbTrcConversionTransformation.h"
 
 
 KoColorConversionSystem::KoColorConversionSystem(RegistryInterface *registryInterface)
@@ -238,6 +239,10 @@ KoColorConversionTransformation* KoColorConversionSystem::createColorConverter(c
     if (*srcColorSpace == *dstColorSpace) {
         return new KoCopyColorConversionTransformation(srcColorSpace);
     }
+    // linear <-> sRGB and pure depth conversions don't need the ICC engine
+    if (KoRgbTrcConversionTransformation::isSuitable(srcColorSpace, dstColorSpace, conversionFlags)) {
+        return new KoRgbTrcConversionTransformation(srcColorSpace, dstColorSpace, renderingIntent, conversionFlags);
+    }
     dbgPigmentCCS << srcColorSpace->id() << (srcColorSpace->profile() ? srcColorSpace->profile()->name() : "default");
     dbgPigmentCCS << dstColorSpace->id() << (dstColorSpace->profile() ? dstColorSpace->profile()->name() : "default");
     Path path = findBestPath(
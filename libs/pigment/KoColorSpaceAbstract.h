@@ -35,6 +35,7 @@
 #include "KoConvolutionOpImpl.h"
 #include "KoInvertColorTransformation.h"
 #include "KoAlphaMaskApplicatorFactory.h"
+#include "KoMixColorsOpFactory.h"
 #include "KoColorModelStandardIdsUtils.h"
 
 /**
@@ -55,7 +56,9 @@ public:
 
 public:
     KoColorSpaceAbstract(const QString &id, const QString &name)
-        : KoColorSpace(id, name, new KoMixColorsOpImpl< _CSTrait>(), new KoConvolutionOpImpl< _CSTrait>()),
+        : KoColorSpace(id, name,
+                       KoMixColorsOpFactory::create(colorDepthIdForChannelType<typename _CSTrait::channels_type>(), _CSTrait::channels_nb, _CSTrait::alpha_pos),
+                       new KoConvolutionOpImpl< _CSTrait>()),
           m_alphaMaskApplicator(KoAlphaMaskApplicatorFactory::create(colorDepthIdForChannelType<typename _CSTrait::channels_type>(), _CSTrait::channels_nb, _CSTrait::alpha_pos))
     {
     }
@@ -126,7 +129,7 @@ public:
     }
 
     void applyAlphaU8Mask(quint8 * pixels, const quint8 * alpha, qint32 nPixels) const override {
-        _CSTrait::applyAlphaU8Mask(pixels, alpha, nPixels);
+        m_alphaMaskApplicator->applyAlphaU8Mask(pixels, alpha, nPixels);
     }
 
     void applyInverseAlphaU8Mask(quint8 * pixels, const quint8 * alpha, qint32 nPixels) const override {
@@ -134,7 +137,7 @@ public:
     }
 
     void applyAlphaNormedFloatMask(quint8 * pixels, const float * alpha, qint32 nPixels) const override {
-        _CSTrait::applyAlphaNormedFloatMask(pixels, alpha, nPixels);
+        m_alphaMaskApplicator->applyAlphaNormedFloatMask(pixels, alpha, nPixels);
     }
 
     void applyInverseNormedFloatMask(quint8 * pixels, const float * alpha, qint32 nPixels) const override {
@@ -801,6 +801,16 @@ KoColorConversionCache* KoColorSpaceRegistry::colorConversionCache() const
     return d->colorConversionCache;
 }
 
+void KoColorSpaceRegistry::setUseColorConversionLookupTables(bool value)
+{
+    d->colorConversionCache->setUseLookupTables(value);
+}
+
+bool KoColorSpaceRegistry::useColorConversionLookupTables() const
+{
+    return d->colorConversionCache->useLookupTables();
+}
+
 const KoColorSpace* KoColorSpaceRegistry::permanentColorspace(const KoColorSpace* _colorSpace)
 {
     if (_colorSpace->d->deletability != NotOwnedByRegistry) {
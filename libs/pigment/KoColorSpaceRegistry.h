@@ -366,6 +366,14 @@ public:
      */
     KoColorConversionCache* colorConversionCache() const;
 
+    /**
+     * Allows the cached color conversions to be replaced with
+     * precomputed lookup tables. The tables are faster, but
+     * approximate, so this is disabled by default.
+     */
+    void setUseColorConversionLookupTables(bool value);
+    bool useColorConversionLookupTables() const;
+
     /**
      * @return a permanent colorspace owned by the registry, of the same type and profile
      *         as the one given in argument
@@ -0,0 +1,326 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDMIXCOLORSOP_H
+#define KOOPTIMIZEDMIXCOLORSOP_H
+
+#include <type_traits>
+
+#include "KoMixColorsOpImpl.h"
+#include "KoColorSpaceTraits.h"
+#include "KoVcMultiArchBuildSupport.h"
+
+
+template<typename _channels_type_,
+         int _channels_nb_,
+         int _alpha_pos_,
+         Vc::Implementation _impl,
+         typename EnableDummyType = void>
+struct KoOptimizedMixColorsOp
+    : public KoMixColorsOpImpl<KoColorSpaceTrait<_channels_type_, _channels_nb_, _alpha_pos_>>
+{
+};
+
+#ifdef HAVE_VC
+
+#include "KoStreamedMath.h"
+
+/**
+ * Vectorized version of KoMixColorsOpImpl for RGBA-like color spaces
+ * (four channels, alpha being the last one).
+ *
+ * The source pixels are accumulated in blocks of Vc::float_v::size(),
+ * one pixel per lane, and the lanes are summed up only after the whole
+ * input has been processed. Integer channels are accumulated exactly,
+ * so the result is bit-exact to the scalar version.
+ */
+template<typename _channels_type_, Vc::Implementation _impl>
+struct KoOptimizedMixColorsOp<
+        _channels_type_, 4, 3, _impl,
+        typename std::enable_if<_impl != Vc::ScalarImpl &&
+                                (std::is_same<_channels_type_, quint8>::value ||
+                                 std::is_same<_channels_type_, quint16>::value ||
+                                 std::is_same<_channels_type_, float>::value)>::type>
+    : public KoMixColorsOp
+{
+    using channels_type = _channels_type_;
+    using Trait = KoColorSpaceTrait<channels_type, 4, 3>;
+    using compositetype = typename KoColorSpaceMathsTraits<channels_type>::compositetype;
+
+    /**
+     * 8-bit totals fit into 32-bit integers, exactly like in the scalar
+     * version. Wider channels are accumulated in doubles, which is still
+     * exact for 16-bit integers.
+     */
+    using accumulator_type =
+        typename std::conditional<std::is_same<channels_type, quint8>::value,
+                                  qint32, double>::type;
+    using accumulator_v = Vc::SimdArray<accumulator_type, Vc::float_v::size()>;
+    using uint_v = typename KoStreamedMath<_impl>::uint_v;
+    using int_v = typename KoStreamedMath<_impl>::int_v;
+
+    static constexpr int numChannels = 4;
+    static constexpr int alphaPos = 3;
+    static constexpr int vectorSize = Vc::float_v::size();
+
+    void mixColors(const quint8 * const* colors, const qint16 *weights, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl(ArrayOfPointers(colors), WeightsWrapper(weights), nColors, dst);
+    }
+
+    void mixColors(const quint8 *colors, const qint16 *weights, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl(PointerToArray(colors, Trait::pixelSize), WeightsWrapper(weights), nColors, dst);
+    }
+
+    void mixColors(const quint8 * const* colors, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl(ArrayOfPointers(colors), NoWeightsSurrogate(nColors), nColors, dst);
+    }
+
+    void mixColors(const quint8 *colors, quint32 nColors, quint8 *dst) const override {
+        mixColorsImpl(PointerToArray(colors, Trait::pixelSize), NoWeightsSurrogate(nColors), nColors, dst);
+    }
+
+private:
+    struct ArrayOfPointers {
+        ArrayOfPointers(const quint8 * const* colors)
+            : m_colors(colors)
+        {
+        }
+
+        const quint8* getPixel() const {
+            return *m_colors;
+        }
+
+        void nextPixel() {
+            m_colors++;
+        }
+
+    private:
+        const quint8 * const * m_colors;
+    };
+
+    struct PointerToArray {
+        PointerToArray(const quint8 *colors, int pixelSize)
+            : m_colors(colors),
+              m_pixelSize(pixelSize)
+        {
+        }
+
+        const quint8* getPixel() const {
+            return m_colors;
+        }
+
+        void nextPixel() {
+            m_colors += m_pixelSize;
+        }
+
+    private:
+        const quint8 *m_colors;
+        const int m_pixelSize;
+    };
+
+    struct WeightsWrapper
+    {
+        WeightsWrapper(const qint16 *weights)
+            : m_weights(weights)
+        {
+        }
+
+        inline void nextPixel() {
+            m_weights++;
+        }
+
+        inline accumulator_type weight() const {
+            return *m_weights;
+        }
+
+        inline void premultiplyAlphaWithWeight(compositetype &alpha) const {
+            alpha *= *m_weights;
+        }
+
+        inline int normalizeFactor() const {
+            return 255;
+        }
+
+    private:
+        const qint16 *m_weights;
+    };
+
+    struct NoWeightsSurrogate
+    {
+        NoWeightsSurrogate(int numPixels)
+            : m_numPixles(numPixels)
+        {
+        }
+
+        inline void nextPixel() {
+        }
+
+        inline accumulator_type weight() const {
+            return 1;
+        }
+
+        inline void premultiplyAlphaWithWeight(compositetype &) const {
+        }
+
+        inline int normalizeFactor() const {
+            return m_numPixles;
+        }
+
+    private:
+        const int m_numPixles;
+    };
+
+    /**
+     * 8-bit pixels are fetched as a single 32-bit word per lane and
+     * split into channels with vector shifts
+     */
+    template<class AbstractSource, class WeightsWrapper>
+    static inline void loadBlock(AbstractSource &source, WeightsWrapper &weightsWrapper,
+                                 accumulator_v *channels, accumulator_v &weights,
+                                 std::true_type /* isU8 */)
+    {
+        quint32 pixels[vectorSize];
+        accumulator_type pixelWeights[vectorSize];
+
+        for (int i = 0; i < vectorSize; i++) {
+            pixels[i] = *reinterpret_cast<const quint32*>(source.getPixel());
+            pixelWeights[i] = weightsWrapper.weight();
+
+            source.nextPixel();
+            weightsWrapper.nextPixel();
+        }
+
+        const uint_v data_i(pixels, Vc::Unaligned);
+        const quint32 mask(0xFF);
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            channels[ch] = Vc::simd_cast<accumulator_v>(int_v((data_i >> (8 * ch)) & mask));
+        }
+
+        weights = accumulator_v(pixelWeights, Vc::Unaligned);
+    }
+
+    template<class AbstractSource, class WeightsWrapper>
+    static inline void loadBlock(AbstractSource &source, WeightsWrapper &weightsWrapper,
+                                 accumulator_v *channels, accumulator_v &weights,
+                                 std::false_type /* isU8 */)
+    {
+        accumulator_type pixels[numChannels][vectorSize];
+        accumulator_type pixelWeights[vectorSize];
+
+        for (int i = 0; i < vectorSize; i++) {
+            const channels_type *color = Trait::nativeArray(source.getPixel());
+
+            for (int ch = 0; ch < numChannels; ch++) {
+                pixels[ch][i] = color[ch];
+            }
+            pixelWeights[i] = weightsWrapper.weight();
+
+            source.nextPixel();
+            weightsWrapper.nextPixel();
+        }
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            channels[ch] = accumulator_v(pixels[ch], Vc::Unaligned);
+        }
+
+        weights = accumulator_v(pixelWeights, Vc::Unaligned);
+    }
+
+    template<class AbstractSource, class WeightsWrapper>
+    void mixColorsImpl(AbstractSource source, WeightsWrapper weightsWrapper, quint32 nColors, quint8 *dst) const {
+        accumulator_v totals_v[numChannels - 1];
+        accumulator_v totalAlpha_v(Vc::Zero);
+
+        for (int i = 0; i < numChannels - 1; i++) {
+            totals_v[i] = accumulator_v(Vc::Zero);
+        }
+
+        const quint32 numBlocks = nColors / vectorSize;
+
+        for (quint32 block = 0; block < numBlocks; block++) {
+            accumulator_v channels[numChannels];
+            accumulator_v weights;
+
+            loadBlock(source, weightsWrapper, channels, weights,
+                      std::is_same<channels_type, quint8>());
+
+            const accumulator_v alphaTimesWeight = channels[alphaPos] * weights;
+
+            for (int i = 0; i < numChannels - 1; i++) {
+                totals_v[i] += channels[i] * alphaTimesWeight;
+            }
+
+            totalAlpha_v += alphaTimesWeight;
+        }
+
+        compositetype totals[numChannels - 1];
+        compositetype totalAlpha = totalAlpha_v.sum();
+
+        for (int i = 0; i < numChannels - 1; i++) {
+            totals[i] = totals_v[i].sum();
+        }
+
+        // accumulate the tail in the same way KoMixColorsOpImpl does
+        for (quint32 pixel = numBlocks * vectorSize; pixel < nColors; pixel++) {
+            const channels_type *color = Trait::nativeArray(source.getPixel());
+            compositetype alphaTimesWeight = color[alphaPos];
+
+            weightsWrapper.premultiplyAlphaWithWeight(alphaTimesWeight);
+
+            for (int i = 0; i < numChannels - 1; i++) {
+                totals[i] += color[i] * alphaTimesWeight;
+            }
+
+            totalAlpha += alphaTimesWeight;
+            source.nextPixel();
+            weightsWrapper.nextPixel();
+        }
+
+        const int sumOfWeights = weightsWrapper.normalizeFactor();
+
+        if (totalAlpha > KoColorSpaceMathsTraits<channels_type>::unitValue * sumOfWeights) {
+            totalAlpha = KoColorSpaceMathsTraits<channels_type>::unitValue * sumOfWeights;
+        }
+
+        channels_type *dstColor = Trait::nativeArray(dst);
+
+        if (totalAlpha > 0) {
+            for (int i = 0; i < numChannels - 1; i++) {
+                compositetype v = totals[i] / totalAlpha;
+
+                if (v > KoColorSpaceMathsTraits<channels_type>::max) {
+                    v = KoColorSpaceMathsTraits<channels_type>::max;
+                }
+                if (v < KoColorSpaceMathsTraits<channels_type>::min) {
+                    v = KoColorSpaceMathsTraits<channels_type>::min;
+                }
+                dstColor[i] = v;
+            }
+
+            dstColor[alphaPos] = totalAlpha / sumOfWeights;
+        } else {
+            memset(dst, 0, Trait::pixelSize);
+        }
+    }
+};
+
+#endif /* HAVE_VC */
+
+#endif // KOOPTIMIZEDMIXCOLORSOP_H
@@ -0,0 +1,277 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KoRgbTrcConversionTransformation.h"
+
+#include <cmath>
+
+#include <KoColorSpace.h>
+#include <KoColorProfile.h>
+#include <KoColorSpaceMaths.h>
+#include <KoColorModelStandardIds.h>
+#include <KoLut.h>
+#include "KoBgrColorSpaceTraits.h"
+#include "KoRgbColorSpaceTraits.h"
+
+namespace {
+
+inline float srgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float linearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+template <typename channel_t>
+struct KoSrgbToLinearFunction {
+    inline float operator()(channel_t value) const {
+        return srgbToLinear(KoColorSpaceMaths<channel_t, float>::scaleToA(value));
+    }
+};
+
+template <typename channel_t>
+struct KoLinearToSrgbFunction {
+    inline float operator()(channel_t value) const {
+        return linearToSrgb(KoColorSpaceMaths<channel_t, float>::scaleToA(value));
+    }
+};
+
+/**
+ * Integer channels are decoded with a table holding all the possible
+ * values, the same way KoLuts does it
+ */
+template <typename channel_t, template <typename> class Function>
+struct TrcLut {
+    typedef Ko::FullLut<Function<channel_t>, float, channel_t> LutType;
+
+    static const LutType& instance() {
+        static const LutType lut;
+        return lut;
+    }
+};
+
+/**
+ * Float channels in [0, 1] range are decoded with a table keyed by the
+ * bits of the float value. The relative error of the key is about 3e-5,
+ * which gives less than 1e-4 relative error for the sRGB curve. The
+ * values outside the range (HDR or negative ones) are evaluated directly.
+ */
+template <template <typename> class Function>
+struct TrcLut<float, Function> {
+    typedef Ko::Lut<Function<float>, float, float> LutType;
+
+    static const LutType& instance() {
+        static const LutType lut(Ko::LutKey<float>(0.0f, 1.0f, 0.00002f));
+        return lut;
+    }
+};
+
+template <typename channel_t>
+struct IdentityDecoder {
+    inline float operator()(channel_t value) const {
+        return KoColorSpaceMaths<channel_t, float>::scaleToA(value);
+    }
+};
+
+template <typename channel_t, template <typename> class Function>
+struct TrcDecoder {
+    TrcDecoder() : m_lut(TrcLut<channel_t, Function>::instance()) {}
+
+    inline float operator()(channel_t value) const {
+        return m_lut(value);
+    }
+
+private:
+    const typename TrcLut<channel_t, Function>::LutType &m_lut;
+};
+
+template <class SrcTraits, class DstTraits, class Decoder>
+void convertPixels(const quint8 *src, quint8 *dst, qint32 nPixels)
+{
+    typedef typename SrcTraits::channels_type src_channel_t;
+    typedef typename DstTraits::channels_type dst_channel_t;
+
+    Decoder decoder;
+
+    for (qint32 i = 0; i < nPixels; i++) {
+        const src_channel_t *s = SrcTraits::nativeArray(src);
+        dst_channel_t *d = DstTraits::nativeArray(dst);
+
+        d[DstTraits::red_pos] = KoColorSpaceMaths<float, dst_channel_t>::scaleToA(decoder(s[SrcTraits::red_pos]));
+        d[DstTraits::green_pos] = KoColorSpaceMaths<float, dst_channel_t>::scaleToA(decoder(s[SrcTraits::green_pos]));
+        d[DstTraits::blue_pos] = KoColorSpaceMaths<float, dst_channel_t>::scaleToA(decoder(s[SrcTraits::blue_pos]));
+        d[DstTraits::alpha_pos] = KoColorSpaceMaths<src_channel_t, dst_channel_t>::scaleToA(s[SrcTraits::alpha_pos]);
+
+        src += SrcTraits::pixelSize;
+        dst += DstTraits::pixelSize;
+    }
+}
+
+typedef void (*ConversionFunc)(const quint8*, quint8*, qint32);
+
+template <class SrcTraits, class DstTraits>
+ConversionFunc selectConversionFunc(KoRgbTrcConversionTransformation::Trc srcTrc,
+                                    KoRgbTrcConversionTransformation::Trc dstTrc)
+{
+    typedef typename SrcTraits::channels_type src_channel_t;
+
+    if (srcTrc == dstTrc) {
+        return &convertPixels<SrcTraits, DstTraits, IdentityDecoder<src_channel_t>>;
+    } else if (srcTrc == KoRgbTrcConversionTransformation::SrgbTrc) {
+        return &convertPixels<SrcTraits, DstTraits, TrcDecoder<src_channel_t, KoSrgbToLinearFunction>>;
+    } else {
+        return &convertPixels<SrcTraits, DstTraits, TrcDecoder<src_channel_t, KoLinearToSrgbFunction>>;
+    }
+}
+
+template <class SrcTraits>
+ConversionFunc selectConversionFunc(const KoID &dstDepth,
+                                    KoRgbTrcConversionTransformation::Trc srcTrc,
+                                    KoRgbTrcConversionTransformation::Trc dstTrc)
+{
+    if (dstDepth == Integer8BitsColorDepthID) {
+        return selectConversionFunc<SrcTraits, KoBgrU8Traits>(srcTrc, dstTrc);
+    } else if (dstDepth == Integer16BitsColorDepthID) {
+        return selectConversionFunc<SrcTraits, KoBgrU16Traits>(srcTrc, dstTrc);
+    } else {
+        return selectConversionFunc<SrcTraits, KoRgbF32Traits>(srcTrc, dstTrc);
+    }
+}
+
+/**
+ * RGBA U8 and U16 color spaces store pixels in BGRA order, RGBA F32
+ * stores them in RGBA order
+ */
+inline bool isSupportedColorSpace(const KoColorSpace *cs)
+{
+    return cs->colorModelId() == RGBAColorModelID &&
+        (cs->colorDepthId() == Integer8BitsColorDepthID ||
+         cs->colorDepthId() == Integer16BitsColorDepthID ||
+         cs->colorDepthId() == Float32BitsColorDepthID) &&
+        cs->channelCount() == 4 &&
+        cs->profile();
+}
+
+inline bool fuzzyCompare(const QVector<qreal> &lhs, const QVector<qreal> &rhs, qreal tolerance)
+{
+    if (lhs.size() != rhs.size()) return false;
+
+    for (int i = 0; i < lhs.size(); i++) {
+        if (qAbs(lhs[i] - rhs[i]) > tolerance) return false;
+    }
+
+    return true;
+}
+
+bool haveSamePrimaries(const KoColorProfile *lhs, const KoColorProfile *rhs)
+{
+    /**
+     * The colorants of the same color space may come in slightly
+     * different precision from V2 and V4 profiles
+     */
+    const qreal tolerance = 0.001;
+
+    return lhs->hasColorants() && rhs->hasColorants() &&
+        fuzzyCompare(lhs->getColorantsXYZ(), rhs->getColorantsXYZ(), tolerance) &&
+        fuzzyCompare(lhs->getWhitePointXYZ(), rhs->getWhitePointXYZ(), tolerance);
+}
+
+}
+
+KoRgbTrcConversionTransformation::Trc KoRgbTrcConversionTransformation::detectTrc(const KoColorProfile *profile)
+{
+    if (!profile || !profile->hasColorants() || !profile->hasTRC()) {
+        return UnknownTrc;
+    }
+
+    if (profile->isLinear()) {
+        return LinearTrc;
+    }
+
+    /**
+     * The tone curves are not exposed by KoColorProfile, so just sample
+     * them and compare against the sRGB one. The tolerance is small
+     * enough to tell sRGB from a pure 2.2 gamma and big enough to accept
+     * the tabulated curves of V2 profiles.
+     */
+    const int numSamples = 32;
+    const qreal tolerance = 0.0001;
+
+    QVector<qreal> value(3);
+
+    for (int i = 0; i <= numSamples; i++) {
+        const qreal x = qreal(i) / numSamples;
+        value.fill(x);
+        profile->linearizeFloatValue(value);
+
+        const qreal expected = srgbToLinear(x);
+
+        for (int chan = 0; chan < 3; chan++) {
+            if (qAbs(value[chan] - expected) > tolerance) {
+                return UnknownTrc;
+            }
+        }
+    }
+
+    return SrgbTrc;
+}
+
+bool KoRgbTrcConversionTransformation::isSuitable(const KoColorSpace *src,
+                                                  const KoColorSpace *dst,
+                                                  KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (conversionFlags.testFlag(KoColorConversionTransformation::NoOptimization)) {
+        return false;
+    }
+
+    if (!isSupportedColorSpace(src) || !isSupportedColorSpace(dst)) {
+        return false;
+    }
+
+    return detectTrc(src->profile()) != UnknownTrc &&
+        detectTrc(dst->profile()) != UnknownTrc &&
+        haveSamePrimaries(src->profile(), dst->profile());
+}
+
+KoRgbTrcConversionTransformation::KoRgbTrcConversionTransformation(const KoColorSpace *srcCs,
+                                                                   const KoColorSpace *dstCs,
+                                                                   Intent renderingIntent,
+                                                                   ConversionFlags conversionFlags)
+    : KoColorConversionTransformation(srcCs, dstCs, renderingIntent, conversionFlags)
+{
+    const Trc srcTrc = detectTrc(srcCs->profile());
+    const Trc dstTrc = detectTrc(dstCs->profile());
+    const KoID dstDepth = dstCs->colorDepthId();
+
+    if (srcCs->colorDepthId() == Integer8BitsColorDepthID) {
+        m_conversionFunc = selectConversionFunc<KoBgrU8Traits>(dstDepth, srcTrc, dstTrc);
+    } else if (srcCs->colorDepthId() == Integer16BitsColorDepthID) {
+        m_conversionFunc = selectConversionFunc<KoBgrU16Traits>(dstDepth, srcTrc, dstTrc);
+    } else {
+        m_conversionFunc = selectConversionFunc<KoRgbF32Traits>(dstDepth, srcTrc, dstTrc);
+    }
+}
+
+void KoRgbTrcConversionTransformation::transform(const quint8 *src, quint8 *dst, qint32 nPixels) const
+{
+    m_conversionFunc(src, dst, nPixels);
+}
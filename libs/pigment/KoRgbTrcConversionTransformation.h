@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef _KO_RGB_TRC_CONVERSION_TRANSFORMATION_H_
+#define _KO_RGB_TRC_CONVERSION_TRANSFORMATION_H_
+
+#include "KoColorConversionTransformation.h"
+
+#include "kritapigment_export.h"
+
+class KoColorProfile;
+
+/**
+ * A fast color conversion between RGBA U8, U16 and F32 color spaces
+ * whose profiles share the same primaries and white point and differ
+ * only in the tone reproduction curve (TRC), which must be either
+ * linear or the standard sRGB one.
+ *
+ * These are the conversions Krita does all the time between the
+ * painting color space, the filters and the OCIO display. None of
+ * them needs the full ICC pipeline: the color channels are just
+ * linearized or delinearized through precomputed tables (see KoLut.h)
+ * and rescaled into the destination depth.
+ *
+ * KoColorConversionSystem creates this transformation automatically
+ * when isSuitable() returns true.
+ */
+class KRITAPIGMENT_EXPORT KoRgbTrcConversionTransformation : public KoColorConversionTransformation
+{
+public:
+    enum Trc {
+        UnknownTrc,
+        LinearTrc,
+        SrgbTrc
+    };
+
+    /**
+     * Checks the curves of the \p profile against the well-known
+     * TRCs. The curves of all the three channels must be the same.
+     */
+    static Trc detectTrc(const KoColorProfile *profile);
+
+    /**
+     * @return true if the conversion from \p src to \p dst can be done
+     * by this transformation. Conversions requested with NoOptimization
+     * flag are never replaced.
+     */
+    static bool isSuitable(const KoColorSpace *src,
+                           const KoColorSpace *dst,
+                           KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    KoRgbTrcConversionTransformation(const KoColorSpace *srcCs,
+                                     const KoColorSpace *dstCs,
+                                     Intent renderingIntent,
+                                     ConversionFlags conversionFlags);
+
+    void transform(const quint8 *src, quint8 *dst, qint32 nPixels) const override;
+
+private:
+    typedef void (*ConversionFunc)(const quint8*, quint8*, qint32);
+    ConversionFunc m_conversionFunc;
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KoAlphaMaskApplicatorBenchmark.h"
+
+#include <QTest>
+#include <QScopedPointer>
+#include <KoColorSpaceTraits.h>
+#include <KoColorModelStandardIds.h>
+#include <KoAlphaMaskApplicatorFactory.h>
+
+// the size of a 256x256 brush dab
+#define NB_PIXELS 65536
+#define NB_RUNS 10
+
+namespace {
+
+template <typename channels_type>
+void applyScalar(int numChannels, bool floatMask, quint8 *pixels, const quint8 *u8Mask, const float *normedMask, int nPixels)
+{
+    if (numChannels == 4) {
+        typedef KoColorSpaceTrait<channels_type, 4, 3> Trait;
+        if (floatMask) {
+            Trait::applyAlphaNormedFloatMask(pixels, normedMask, nPixels);
+        } else {
+            Trait::applyAlphaU8Mask(pixels, u8Mask, nPixels);
+        }
+    } else {
+        typedef KoColorSpaceTrait<channels_type, 2, 1> Trait;
+        if (floatMask) {
+            Trait::applyAlphaNormedFloatMask(pixels, normedMask, nPixels);
+        } else {
+            Trait::applyAlphaU8Mask(pixels, u8Mask, nPixels);
+        }
+    }
+}
+
+int channelSizeForDepth(const QString &depthId)
+{
+    return depthId == Integer8BitsColorDepthID.id() ? 1 :
+           depthId == Integer16BitsColorDepthID.id() ? 2 : 4;
+}
+
+KoID depthIdFromString(const QString &depthId)
+{
+    return depthId == Integer8BitsColorDepthID.id() ? Integer8BitsColorDepthID :
+           depthId == Integer16BitsColorDepthID.id() ? Integer16BitsColorDepthID :
+           Float32BitsColorDepthID;
+}
+
+}
+
+void KoAlphaMaskApplicatorBenchmark::benchmarkApplyMask_data()
+{
+    QTest::addColumn<QString>("depthId");
+    QTest::addColumn<int>("numChannels");
+    QTest::addColumn<bool>("floatMask");
+    QTest::addColumn<bool>("optimized");
+
+    QStringList depths;
+    depths << Integer8BitsColorDepthID.id() << Integer16BitsColorDepthID.id() << Float32BitsColorDepthID.id();
+
+    Q_FOREACH (const QString &depth, depths) {
+        for (int numChannels = 2; numChannels <= 4; numChannels += 2) {
+            for (int floatMask = 0; floatMask <= 1; floatMask++) {
+                const QString name = QString("%1-%2-%3")
+                    .arg(depth)
+                    .arg(numChannels == 4 ? "rgba" : "graya")
+                    .arg(floatMask ? "float-mask" : "u8-mask");
+
+                QTest::newRow(QString("%1-scalar").arg(name).toLatin1().data()) << depth << numChannels << bool(floatMask) << false;
+                QTest::newRow(QString("%1-optimized").arg(name).toLatin1().data()) << depth << numChannels << bool(floatMask) << true;
+            }
+        }
+    }
+}
+
+void KoAlphaMaskApplicatorBenchmark::benchmarkApplyMask()
+{
+    QFETCH(QString, depthId);
+    QFETCH(int, numChannels);
+    QFETCH(bool, floatMask);
+    QFETCH(bool, optimized);
+
+    QScopedPointer<KoAlphaMaskApplicatorBase> applicator(
+        KoAlphaMaskApplicatorFactory::create(depthIdFromString(depthId), numChannels, numChannels - 1));
+
+    const int pixelSize = channelSizeForDepth(depthId) * numChannels;
+
+    QByteArray pixels(NB_PIXELS * pixelSize, 0);
+    QVector<quint8> u8Mask(NB_PIXELS);
+    QVector<float> normedMask(NB_PIXELS);
+
+    qsrand(1);
+
+    if (depthId == Float32BitsColorDepthID.id()) {
+        float *ptr = reinterpret_cast<float*>(pixels.data());
+        for (int i = 0; i < NB_PIXELS * numChannels; i++) {
+            ptr[i] = float(qrand()) / RAND_MAX;
+        }
+    } else {
+        for (int i = 0; i < pixels.size(); i++) {
+            pixels[i] = char(qrand() & 0xFF);
+        }
+    }
+
+    for (int i = 0; i < NB_PIXELS; i++) {
+        u8Mask[i] = quint8(qrand() & 0xFF);
+        normedMask[i] = float(qrand()) / RAND_MAX;
+    }
+
+    quint8 *pixelsPtr = reinterpret_cast<quint8*>(pixels.data());
+
+    QBENCHMARK {
+        for (int i = 0; i < NB_RUNS; i++) {
+            if (optimized) {
+                if (floatMask) {
+                    applicator->applyAlphaNormedFloatMask(pixelsPtr, normedMask.constData(), NB_PIXELS);
+                } else {
+                    applicator->applyAlphaU8Mask(pixelsPtr, u8Mask.constData(), NB_PIXELS);
+                }
+            } else if (depthId == Integer8BitsColorDepthID.id()) {
+                applyScalar<quint8>(numChannels, floatMask, pixelsPtr, u8Mask.constData(), normedMask.constData(), NB_PIXELS);
+            } else if (depthId == Integer16BitsColorDepthID.id()) {
+                applyScalar<quint16>(numChannels, floatMask, pixelsPtr, u8Mask.constData(), normedMask.constData(), NB_PIXELS);
+            } else {
+                applyScalar<float>(numChannels, floatMask, pixelsPtr, u8Mask.constData(), normedMask.constData(), NB_PIXELS);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(KoAlphaMaskApplicatorBenchmark)
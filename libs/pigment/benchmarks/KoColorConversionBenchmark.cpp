@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "KoColorConversionBenchmark.h"
+
+#include <QTest>
+#include <QScopedPointer>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorSpace.h>
+#include <KoColorProfile.h>
+#include <KoColorModelStandardIds.h>
+#include <KoRgbTrcConversionTransformation.h>
+
+#define NB_PIXELS 1000000
+
+namespace {
+
+/**
+ * Returns some gamma-encoded RGB profile different from the default
+ * one, it plays the role of a display profile
+ */
+const KoColorProfile* findDisplayLikeProfile(const KoColorSpace *srcCs)
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+    const QString csId = registry->colorSpaceId(RGBAColorModelID, srcCs->colorDepthId());
+
+    Q_FOREACH (const KoColorProfile *profile, registry->profilesFor(csId)) {
+        if (!profile->isLinear() && !(*profile == *srcCs->profile())) {
+            return profile;
+        }
+    }
+
+    return 0;
+}
+
+}
+
+void KoColorConversionBenchmark::benchmarkConversion_data()
+{
+    QTest::addColumn<QString>("srcDepthID");
+    QTest::addColumn<QString>("dstModelID");
+    QTest::addColumn<QString>("dstDepthID");
+    QTest::addColumn<bool>("useCache");
+
+    QList<QStringList> conversions;
+    conversions << (QStringList() << Integer8BitsColorDepthID.id() << RGBAColorModelID.id() << Integer8BitsColorDepthID.id());
+    conversions << (QStringList() << Integer16BitsColorDepthID.id() << RGBAColorModelID.id() << Integer8BitsColorDepthID.id());
+    conversions << (QStringList() << Integer8BitsColorDepthID.id() << CMYKAColorModelID.id() << Integer8BitsColorDepthID.id());
+    conversions << (QStringList() << Integer16BitsColorDepthID.id() << CMYKAColorModelID.id() << Integer16BitsColorDepthID.id());
+    conversions << (QStringList() << Integer8BitsColorDepthID.id() << GrayAColorModelID.id() << Integer8BitsColorDepthID.id());
+
+    Q_FOREACH (const QStringList &conv, conversions) {
+        const QString name = QString("rgb%1-%2%3").arg(conv[0]).arg(conv[1]).arg(conv[2]);
+
+        QTest::newRow(QString("%1-direct").arg(name).toLatin1().data()) << conv[0] << conv[1] << conv[2] << false;
+        QTest::newRow(QString("%1-cached").arg(name).toLatin1().data()) << conv[0] << conv[1] << conv[2] << true;
+    }
+}
+
+void KoColorConversionBenchmark::benchmarkConversion()
+{
+    QFETCH(QString, srcDepthID);
+    QFETCH(QString, dstModelID);
+    QFETCH(QString, dstDepthID);
+    QFETCH(bool, useCache);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcCs = registry->colorSpace(RGBAColorModelID.id(), srcDepthID, 0);
+    QVERIFY(srcCs);
+
+    const KoColorSpace *dstCs = 0;
+
+    if (dstModelID == RGBAColorModelID.id()) {
+        const KoColorProfile *profile = findDisplayLikeProfile(srcCs);
+        if (!profile) {
+            QSKIP("No second RGB profile is installed");
+        }
+        dstCs = registry->colorSpace(dstModelID, dstDepthID, profile);
+    } else {
+        dstCs = registry->colorSpace(dstModelID, dstDepthID, 0);
+    }
+
+    if (!dstCs) {
+        QSKIP("Destination color space is not available");
+    }
+
+    QByteArray src(NB_PIXELS * srcCs->pixelSize(), 0);
+    QByteArray dst(NB_PIXELS * dstCs->pixelSize(), 0);
+
+    qsrand(1);
+    for (int i = 0; i < src.size(); i++) {
+        src[i] = char(qrand() & 0xFF);
+    }
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+
+    const quint8 *srcPtr = reinterpret_cast<const quint8*>(src.constData());
+    quint8 *dstPtr = reinterpret_cast<quint8*>(dst.data());
+
+    if (useCache) {
+        // goes through KoColorConversionCache and, hence, uses a lookup table when possible
+        const bool useLookupTables = registry->useColorConversionLookupTables();
+        registry->setUseColorConversionLookupTables(true);
+
+        QBENCHMARK {
+            srcCs->convertPixelsTo(srcPtr, dstPtr, dstCs, NB_PIXELS, intent, flags);
+        }
+
+        registry->setUseColorConversionLookupTables(useLookupTables);
+    } else {
+        QScopedPointer<KoColorConversionTransformation> transform(srcCs->createColorConverter(dstCs, intent, flags));
+
+        QBENCHMARK {
+            transform->transform(srcPtr, dstPtr, NB_PIXELS);
+        }
+    }
+}
+
+void KoColorConversionBenchmark::benchmarkTrcConversion_data()
+{
+    QTest::addColumn<QString>("srcDepthID");
+    QTest::addColumn<bool>("srcLinear");
+    QTest::addColumn<QString>("dstDepthID");
+    QTest::addColumn<bool>("dstLinear");
+    QTest::addColumn<bool>("useIcc");
+
+    QList<QVariantList> conversions;
+    conversions << (QVariantList() << Integer8BitsColorDepthID.id() << false << Integer16BitsColorDepthID.id() << true);
+    conversions << (QVariantList() << Integer16BitsColorDepthID.id() << true << Integer8BitsColorDepthID.id() << false);
+    conversions << (QVariantList() << Integer8BitsColorDepthID.id() << false << Float32BitsColorDepthID.id() << true);
+    conversions << (QVariantList() << Float32BitsColorDepthID.id() << true << Integer8BitsColorDepthID.id() << false);
+    conversions << (QVariantList() << Integer16BitsColorDepthID.id() << true << Float32BitsColorDepthID.id() << true);
+    conversions << (QVariantList() << Integer8BitsColorDepthID.id() << false << Integer16BitsColorDepthID.id() << false);
+
+    Q_FOREACH (const QVariantList &conv, conversions) {
+        const QString name = QString("%1%2-%3%4")
+            .arg(conv[0].toString()).arg(conv[1].toBool() ? "linear" : "srgb")
+            .arg(conv[2].toString()).arg(conv[3].toBool() ? "linear" : "srgb");
+
+        QTest::newRow(QString("%1-icc").arg(name).toLatin1().data())
+            << conv[0].toString() << conv[1].toBool() << conv[2].toString() << conv[3].toBool() << true;
+        QTest::newRow(QString("%1-fast").arg(name).toLatin1().data())
+            << conv[0].toString() << conv[1].toBool() << conv[2].toString() << conv[3].toBool() << false;
+    }
+}
+
+void KoColorConversionBenchmark::benchmarkTrcConversion()
+{
+    QFETCH(QString, srcDepthID);
+    QFETCH(bool, srcLinear);
+    QFETCH(QString, dstDepthID);
+    QFETCH(bool, dstLinear);
+    QFETCH(bool, useIcc);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorProfile *srgbProfile = registry->rgb8()->profile();
+    const KoColorProfile *linearProfile = registry->profileByName("sRGB-elle-V2-g10.icc");
+
+    if (!linearProfile) {
+        QSKIP("Linear sRGB profile is not installed");
+    }
+
+    const KoColorSpace *srcCs = registry->colorSpace(RGBAColorModelID.id(), srcDepthID, srcLinear ? linearProfile : srgbProfile);
+    const KoColorSpace *dstCs = registry->colorSpace(RGBAColorModelID.id(), dstDepthID, dstLinear ? linearProfile : srgbProfile);
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+    if (useIcc) {
+        flags |= KoColorConversionTransformation::NoOptimization;
+    } else if (!KoRgbTrcConversionTransformation::isSuitable(srcCs, dstCs, flags)) {
+        QSKIP("The profiles are not recognized as sRGB/linear pair");
+    }
+
+    QByteArray src(NB_PIXELS * srcCs->pixelSize(), 0);
+    QByteArray dst(NB_PIXELS * dstCs->pixelSize(), 0);
+
+    qsrand(1);
+    if (srcDepthID == Float32BitsColorDepthID.id()) {
+        float *ptr = reinterpret_cast<float*>(src.data());
+        for (int i = 0; i < NB_PIXELS * 4; i++) {
+            ptr[i] = float(qrand()) / RAND_MAX;
+        }
+    } else {
+        for (int i = 0; i < src.size(); i++) {
+            src[i] = char(qrand() & 0xFF);
+        }
+    }
+
+    QScopedPointer<KoColorConversionTransformation> transform(
+        srcCs->createColorConverter(dstCs, KoColorConversionTransformation::internalRenderingIntent(), flags));
+
+    const quint8 *srcPtr = reinterpret_cast<const quint8*>(src.constData());
+    quint8 *dstPtr = reinterpret_cast<quint8*>(dst.data());
+
+    QBENCHMARK {
+        transform->transform(srcPtr, dstPtr, NB_PIXELS);
+    }
+}
+
+QTEST_GUILESS_MAIN(KoColorConversionBenchmark)
@@ -20,10 +20,15 @@
 
 #include "../compositeops/KoCompositeOpAlphaDarken.h"
 #include "../compositeops/KoCompositeOpOver.h"
+#include "../compositeops/KoCompositeOpCopy2.h"
+#include "../compositeops/KoAlphaDarkenParamsWrapper.h"
 #include <KoOptimizedCompositeOpFactory.h>
 
 #include <KoColorSpaceTraits.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+#include <KoCompositeOpRegistry.h>
+#include <KoConfig.h>
 
 #include <QTest>
 
@@ -39,11 +44,11 @@ const int TILES_IN_WIDTH = IMG_WIDTH / TILE_WIDTH;
 const int TILES_IN_HEIGHT = IMG_HEIGHT / TILE_HEIGHT;
 
 
-#define COMPOSITE_BENCHMARK \
+#define COMPOSITE_BENCHMARK_PIXEL(pixelSize) \
         for (int y = 0; y < TILES_IN_HEIGHT; y++){                                              \
             for (int x = 0; x < TILES_IN_WIDTH; x++) {                                           \
-                const int rowStride = IMG_WIDTH * KoBgrU8Traits::pixelSize;  \
-                const int bufOffset = y * rowStride + x * TILE_WIDTH * KoBgrU8Traits::pixelSize;  \
+                const int rowStride = IMG_WIDTH * (pixelSize);  \
+                const int bufOffset = y * rowStride + x * TILE_WIDTH * (pixelSize);  \
                 compositeOp->composite(m_dstBuffer + bufOffset, rowStride,      \
                                       m_srcBuffer + bufOffset, rowStride,      \
                                       m_mskBuffer + bufOffset, rowStride,                                                            \
@@ -52,9 +57,12 @@ const int TILES_IN_HEIGHT = IMG_HEIGHT / TILE_HEIGHT;
             }                                                                                   \
         }
 
+#define COMPOSITE_BENCHMARK COMPOSITE_BENCHMARK_PIXEL(KoBgrU8Traits::pixelSize)
+
 void KoCompositeOpsBenchmark::initTestCase()
 {
-    const int bufLen = IMG_HEIGHT * IMG_WIDTH * KoBgrU8Traits::pixelSize;
+    // big enough for 16-bit per channel pixels as well
+    const int bufLen = IMG_HEIGHT * IMG_WIDTH * KoBgrU16Traits::pixelSize;
 
     m_dstBuffer = new quint8[bufLen];
     m_srcBuffer = new quint8[bufLen];
@@ -66,7 +74,7 @@ void KoCompositeOpsBenchmark::init()
 {
     qsrand(42);
 
-    for (int i = 0; i < int(IMG_WIDTH * IMG_HEIGHT * KoBgrU8Traits::pixelSize); i++) {
+    for (int i = 0; i < int(IMG_WIDTH * IMG_HEIGHT * KoBgrU16Traits::pixelSize); i++) {
         const int randVal = qrand();
 
         m_srcBuffer[i] = randVal & 0x0000FF;
@@ -108,5 +116,85 @@ void KoCompositeOpsBenchmark::benchmarkCompositeAlphaDarkenCreamy()
     }
 }
 
+void KoCompositeOpsBenchmark::benchmarkCompositeU16_data()
+{
+    QTest::addColumn<QString>("compositeOpId");
+    QTest::addColumn<bool>("useOptimized");
+
+    QStringList ids;
+    ids << COMPOSITE_OVER << "alphadarken-hard" << "alphadarken-creamy" << COMPOSITE_COPY;
+
+    Q_FOREACH (const QString &id, ids) {
+        QTest::newRow(QString("%1-legacy").arg(id).toLatin1().data()) << id << false;
+        QTest::newRow(QString("%1-optimized").arg(id).toLatin1().data()) << id << true;
+    }
+}
+
+template<class Traits>
+KoCompositeOp* createLegacy64Op(const QString &id, const KoColorSpace *cs)
+{
+    return
+        id == COMPOSITE_OVER ? static_cast<KoCompositeOp*>(new KoCompositeOpOver<Traits>(cs)) :
+        id == "alphadarken-hard" ? static_cast<KoCompositeOp*>(new KoCompositeOpAlphaDarken<Traits, KoAlphaDarkenParamsWrapperHard>(cs)) :
+        id == "alphadarken-creamy" ? static_cast<KoCompositeOp*>(new KoCompositeOpAlphaDarken<Traits, KoAlphaDarkenParamsWrapperCreamy>(cs)) :
+        static_cast<KoCompositeOp*>(new KoCompositeOpCopy2<Traits>(cs));
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeU16()
+{
+    QFETCH(QString, compositeOpId);
+    QFETCH(bool, useOptimized);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+
+    QScopedPointer<KoCompositeOp> compositeOp(
+        !useOptimized ? createLegacy64Op<KoBgrU16Traits>(compositeOpId, cs) :
+        compositeOpId == COMPOSITE_OVER ? KoOptimizedCompositeOpFactory::createOverOpU16(cs) :
+        compositeOpId == "alphadarken-hard" ? KoOptimizedCompositeOpFactory::createAlphaDarkenOpHardU16(cs) :
+        compositeOpId == "alphadarken-creamy" ? KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamyU16(cs) :
+        KoOptimizedCompositeOpFactory::createCopyOpU16(cs));
+
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK_PIXEL(KoBgrU16Traits::pixelSize)
+    }
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeF16_data()
+{
+    benchmarkCompositeU16_data();
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeF16()
+{
+#ifdef HAVE_OPENEXR
+    QFETCH(QString, compositeOpId);
+    QFETCH(bool, useOptimized);
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), Float16BitsColorDepthID.id(), 0);
+
+    // random bits are not valid half values, so refill the buffers
+    half *src = reinterpret_cast<half*>(m_srcBuffer);
+    half *dst = reinterpret_cast<half*>(m_dstBuffer);
+    for (int i = 0; i < IMG_WIDTH * IMG_HEIGHT * 4; i++) {
+        src[i] = half(float(qrand() & 0xFFFF) / 65535.0f);
+        dst[i] = half(float(qrand() & 0xFFFF) / 65535.0f);
+    }
+
+    QScopedPointer<KoCompositeOp> compositeOp(
+        !useOptimized ? createLegacy64Op<KoRgbF16Traits>(compositeOpId, cs) :
+        compositeOpId == COMPOSITE_OVER ? KoOptimizedCompositeOpFactory::createOverOpF16(cs) :
+        compositeOpId == "alphadarken-hard" ? KoOptimizedCompositeOpFactory::createAlphaDarkenOpHardF16(cs) :
+        compositeOpId == "alphadarken-creamy" ? KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamyF16(cs) :
+        KoOptimizedCompositeOpFactory::createCopyOpF16(cs));
+
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK_PIXEL(KoRgbF16Traits::pixelSize)
+    }
+#else
+    QSKIP("Krita is built without OpenEXR, half float colorspaces are not available");
+#endif
+}
+
 
 QTEST_GUILESS_MAIN(KoCompositeOpsBenchmark)
@@ -34,6 +34,12 @@ private Q_SLOTS:
     void benchmarkCompositeAlphaDarkenHard();
     void benchmarkCompositeAlphaDarkenCreamy();
 
+    void benchmarkCompositeU16_data();
+    void benchmarkCompositeU16();
+
+    void benchmarkCompositeF16_data();
+    void benchmarkCompositeF16();
+
 private:
     quint8 * m_dstBuffer;
     quint8 * m_srcBuffer;
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include "KoMixColorsOpBenchmark.h"
+
+#include <QTest>
+#include <QScopedPointer>
+#include <KoColorSpaceTraits.h>
+#include <KoColorModelStandardIds.h>
+#include <KoMixColorsOpImpl.h>
+#include <KoMixColorsOpFactory.h>
+
+// the size of a 64x64 smudge dab
+#define NB_COLORS 4096
+#define NB_MIXES 100
+
+namespace {
+
+template <typename channels_type>
+KoMixColorsOp* createMixColorsOp(const KoID &depthId, bool optimized)
+{
+    return optimized ?
+        KoMixColorsOpFactory::create(depthId, 4, 3) :
+        new KoMixColorsOpImpl<KoColorSpaceTrait<channels_type, 4, 3>>();
+}
+
+KoMixColorsOp* createMixColorsOp(const QString &depthId, bool optimized)
+{
+    if (depthId == Integer8BitsColorDepthID.id()) {
+        return createMixColorsOp<quint8>(Integer8BitsColorDepthID, optimized);
+    } else if (depthId == Integer16BitsColorDepthID.id()) {
+        return createMixColorsOp<quint16>(Integer16BitsColorDepthID, optimized);
+    }
+
+    return createMixColorsOp<float>(Float32BitsColorDepthID, optimized);
+}
+
+int pixelSizeForDepth(const QString &depthId)
+{
+    return depthId == Integer8BitsColorDepthID.id() ? 4 :
+           depthId == Integer16BitsColorDepthID.id() ? 8 : 16;
+}
+
+}
+
+void KoMixColorsOpBenchmark::benchmarkMixColors_data()
+{
+    QTest::addColumn<QString>("depthId");
+    QTest::addColumn<bool>("optimized");
+    QTest::addColumn<bool>("useWeights");
+    QTest::addColumn<bool>("usePointers");
+
+    QStringList depths;
+    depths << Integer8BitsColorDepthID.id() << Integer16BitsColorDepthID.id() << Float32BitsColorDepthID.id();
+
+    Q_FOREACH (const QString &depth, depths) {
+        for (int weighted = 0; weighted <= 1; weighted++) {
+            for (int pointers = 0; pointers <= 1; pointers++) {
+                const QString name = QString("%1-%2-%3")
+                    .arg(depth)
+                    .arg(weighted ? "weighted" : "unweighted")
+                    .arg(pointers ? "pointers" : "array");
+
+                QTest::newRow(QString("%1-scalar").arg(name).toLatin1().data()) << depth << false << bool(weighted) << bool(pointers);
+                QTest::newRow(QString("%1-optimized").arg(name).toLatin1().data()) << depth << true << bool(weighted) << bool(pointers);
+            }
+        }
+    }
+}
+
+void KoMixColorsOpBenchmark::benchmarkMixColors()
+{
+    QFETCH(QString, depthId);
+    QFETCH(bool, optimized);
+    QFETCH(bool, useWeights);
+    QFETCH(bool, usePointers);
+
+    QScopedPointer<KoMixColorsOp> op(createMixColorsOp(depthId, optimized));
+    const int pixelSize = pixelSizeForDepth(depthId);
+
+    QByteArray colors(NB_COLORS * pixelSize, 0);
+    QVector<const quint8*> colorPtrs(NB_COLORS);
+    QVector<qint16> weights(NB_COLORS);
+    quint8 dst[16];
+
+    qsrand(1);
+
+    if (depthId == Float32BitsColorDepthID.id()) {
+        float *ptr = reinterpret_cast<float*>(colors.data());
+        for (int i = 0; i < NB_COLORS * 4; i++) {
+            ptr[i] = float(qrand()) / RAND_MAX;
+        }
+    } else {
+        for (int i = 0; i < colors.size(); i++) {
+            colors[i] = char(qrand() & 0xFF);
+        }
+    }
+
+    for (int i = 0; i < NB_COLORS; i++) {
+        colorPtrs[i] = reinterpret_cast<const quint8*>(colors.constData()) + i * pixelSize;
+        weights[i] = qrand() % 2;
+    }
+
+    const quint8 *colorsPtr = reinterpret_cast<const quint8*>(colors.constData());
+
+    QBENCHMARK {
+        for (int i = 0; i < NB_MIXES; i++) {
+            if (useWeights && usePointers) {
+                op->mixColors(colorPtrs.constData(), weights.constData(), NB_COLORS, dst);
+            } else if (useWeights) {
+                op->mixColors(colorsPtr, weights.constData(), NB_COLORS, dst);
+            } else if (usePointers) {
+                op->mixColors(colorPtrs.constData(), NB_COLORS, dst);
+            } else {
+                op->mixColors(colorsPtr, NB_COLORS, dst);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(KoMixColorsOpBenchmark)
@@ -62,6 +62,16 @@ struct OptimizedOpsSelector
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return new KoCompositeOpOver<Traits>(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<Traits>(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
 template<>
@@ -75,6 +85,12 @@ struct OptimizedOpsSelector<KoBgrU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoBgrU8Traits>(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        return KoOptimizedCompositeOpFactory::createGenericOp32(cs, id, description, category);
+    }
 };
 
 template<>
@@ -88,6 +104,17 @@ struct OptimizedOpsSelector<KoLabU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoLabU8Traits>(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        // the optimized generic ops expect RGB channels, so Lab uses the scalar ones
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
 template<>
@@ -112,8 +139,64 @@ struct OptimizedOpsSelector<KoRgbF32Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp128(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoRgbF32Traits>(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        return KoOptimizedCompositeOpFactory::createGenericOp128(cs, id, description, category);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoBgrU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamyU16(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHardU16(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOpU16(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOpU16(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
 };
 
+#ifdef HAVE_OPENEXR
+
+template<>
+struct OptimizedOpsSelector<KoRgbF16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return useCreamyAlphaDarken() ?
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpCreamyF16(cs) :
+            KoOptimizedCompositeOpFactory::createAlphaDarkenOpHardF16(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOpF16(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createCopyOpF16(cs);
+    }
+    static KoCompositeOp* createGenericOp(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category) {
+        Q_UNUSED(cs);
+        Q_UNUSED(id);
+        Q_UNUSED(description);
+        Q_UNUSED(category);
+        return 0;
+    }
+};
+
+#endif
+
 template<class Traits>
 struct AddGeneralOps<Traits, true>
 {
@@ -123,13 +206,17 @@ struct AddGeneralOps<Traits, true>
 
      template<CompositeFunc func>
      static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-         cs->addCompositeOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category));
+         KoCompositeOp *op = OptimizedOpsSelector<Traits>::createGenericOp(cs, id, description, category);
+         if (!op) {
+             op = new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category);
+         }
+         cs->addCompositeOp(op);
      }
 
      static void add(KoColorSpace* cs) {
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createOverOp(cs));
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createAlphaDarkenOp(cs));
-         cs->addCompositeOp(new KoCompositeOpCopy2<Traits>(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createCopyOp(cs));
          cs->addCompositeOp(new KoCompositeOpErase<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpBehind<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationIn<Traits>(cs));
@@ -245,7 +332,11 @@ struct AddRGBOps<Traits, true>
     template<void compositeFunc(Arg, Arg, Arg, Arg&, Arg&, Arg&)>
 
     static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-        cs->addCompositeOp(new KoCompositeOpGenericHSL<Traits, compositeFunc>(cs, id, description, category));
+        KoCompositeOp *op = OptimizedOpsSelector<Traits>::createGenericOp(cs, id, description, category);
+        if (!op) {
+            op = new KoCompositeOpGenericHSL<Traits, compositeFunc>(cs, id, description, category);
+        }
+        cs->addCompositeOp(op);
     }
 
     static void add(KoColorSpace* cs) {
@@ -0,0 +1,302 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDCOMPOSITEOP64_H
+#define KOOPTIMIZEDCOMPOSITEOP64_H
+
+#include <KoConfig.h>
+
+#include "KoColorSpaceTraits.h"
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoCompositeOpOver.h"
+#include "KoCompositeOpCopy2.h"
+#include "KoCompositeOpAlphaDarken.h"
+#include "KoStreamedMath.h"
+#include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpAlphaDarken128.h"
+#include "KoOptimizedCompositeOpCopy128.h"
+
+
+/**
+ * Converts Vc::float_v::size() 64-bit pixels (4 channels, 16 bit per
+ * channel) into normalized float pixels and back
+ */
+template<typename channels_type>
+struct KoStreamedPixelConverter64;
+
+template<>
+struct KoStreamedPixelConverter64<quint16>
+{
+    template<int numPixels>
+    static ALWAYS_INLINE void toFloat(const quint8 *src, float *dst) {
+        const quint16 *s = reinterpret_cast<const quint16*>(src);
+        const float uint16MaxRec1 = 1.0f / 65535.0f;
+
+        for (int i = 0; i < 4 * numPixels; i++) {
+            dst[i] = float(s[i]) * uint16MaxRec1;
+        }
+    }
+
+    template<int numPixels>
+    static ALWAYS_INLINE void fromFloat(const float *src, quint8 *dst) {
+        quint16 *d = reinterpret_cast<quint16*>(dst);
+
+        for (int i = 0; i < 4 * numPixels; i++) {
+            d[i] = quint16(qBound(0.0f, src[i], 1.0f) * 65535.0f + 0.5f);
+        }
+    }
+};
+
+#ifdef HAVE_OPENEXR
+
+template<>
+struct KoStreamedPixelConverter64<half>
+{
+    template<int numPixels>
+    static ALWAYS_INLINE void toFloat(const quint8 *src, float *dst) {
+        const half *s = reinterpret_cast<const half*>(src);
+
+        for (int i = 0; i < 4 * numPixels; i++) {
+            dst[i] = float(s[i]);
+        }
+    }
+
+    template<int numPixels>
+    static ALWAYS_INLINE void fromFloat(const float *src, quint8 *dst) {
+        half *d = reinterpret_cast<half*>(dst);
+
+        for (int i = 0; i < 4 * numPixels; i++) {
+            d[i] = half(src[i]);
+        }
+    }
+};
+
+#endif
+
+/**
+ * Lets a 128-bit floating point compositor process 64-bit pixels. The
+ * pixels are unpacked into aligned float buffers, composited by the
+ * vector code of \p Compositor128 and packed back.
+ *
+ * The single-pixel path reuses the vector code as well (the rest of
+ * the lanes are filled with transparent pixels), so both paths give
+ * exactly the same results.
+ */
+template<typename channels_type, class Compositor128>
+struct KoStreamedCompositor64Adapter {
+    typedef typename Compositor128::ParamsWrapper ParamsWrapper;
+    typedef KoStreamedPixelConverter64<channels_type> Converter;
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(src_aligned);
+
+        const int vectorSize = Vc::float_v::size();
+
+        alignas(64) float srcBuf[4 * vectorSize];
+        alignas(64) float dstBuf[4 * vectorSize];
+
+        Converter::template toFloat<vectorSize>(src, srcBuf);
+        Converter::template toFloat<vectorSize>(dst, dstBuf);
+
+        Compositor128::template compositeVector<haveMask, true, _impl>(reinterpret_cast<const quint8*>(srcBuf),
+                                                                       reinterpret_cast<quint8*>(dstBuf),
+                                                                       mask, opacity, oparams);
+
+        Converter::template fromFloat<vectorSize>(dstBuf, dst);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const int vectorSize = Vc::float_v::size();
+
+        alignas(64) float srcBuf[4 * vectorSize] = {0};
+        alignas(64) float dstBuf[4 * vectorSize] = {0};
+        quint8 maskBuf[vectorSize] = {0};
+
+        Converter::template toFloat<1>(src, srcBuf);
+        Converter::template toFloat<1>(dst, dstBuf);
+
+        if (haveMask) {
+            maskBuf[0] = *mask;
+        }
+
+        Compositor128::template compositeVector<haveMask, true, _impl>(reinterpret_cast<const quint8*>(srcBuf),
+                                                                       reinterpret_cast<quint8*>(dstBuf),
+                                                                       maskBuf, opacity, oparams);
+
+        Converter::template fromFloat<1>(dstBuf, dst);
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces (U16 or F16) with alpha channel placed at the last
+ * channel of the pixel: C1_C2_C3_A. The compositing with channel flags
+ * is delegated to \p LegacyOp.
+ */
+template<Vc::Implementation _impl, class Traits, class Compositor128, class LegacyOp, bool useFlow>
+class KoOptimizedCompositeOp64Impl : public KoCompositeOp
+{
+    typedef KoStreamedCompositor64Adapter<typename Traits::channels_type, Compositor128> Compositor;
+
+public:
+    KoOptimizedCompositeOp64Impl(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
+        : KoCompositeOp(cs, id, description, category),
+          m_legacyOp(cs)
+    {
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            if (params.maskRowStart) {
+                KoStreamedMath<_impl>::template genericComposite64<true, useFlow, Compositor>(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite64<false, useFlow, Compositor>(params);
+            }
+        } else {
+            m_legacyOp.composite(params);
+        }
+    }
+
+private:
+    LegacyOp m_legacyOp;
+};
+
+template<Vc::Implementation _impl, class Traits>
+class KoOptimizedCompositeOpOver64
+    : public KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                          OverCompositor128<float, float, false, true>,
+                                          KoCompositeOpOver<Traits>, false>
+{
+public:
+    KoOptimizedCompositeOpOver64(const KoColorSpace* cs)
+        : KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                       OverCompositor128<float, float, false, true>,
+                                       KoCompositeOpOver<Traits>, false>(cs, COMPOSITE_OVER, i18n("Normal"), KoCompositeOp::categoryMix()) {}
+};
+
+template<Vc::Implementation _impl, class Traits, class ParamsWrapper>
+class KoOptimizedCompositeOpAlphaDarken64
+    : public KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                          AlphaDarkenCompositor128<float, quint32, ParamsWrapper>,
+                                          KoCompositeOpAlphaDarken<Traits, ParamsWrapper>, true>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarken64(const KoColorSpace* cs)
+        : KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                       AlphaDarkenCompositor128<float, quint32, ParamsWrapper>,
+                                       KoCompositeOpAlphaDarken<Traits, ParamsWrapper>, true>(cs, COMPOSITE_ALPHA_DARKEN, i18n("Alpha darken"), KoCompositeOp::categoryMix()) {}
+};
+
+template<Vc::Implementation _impl, class Traits>
+class KoOptimizedCompositeOpCopy64
+    : public KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                          CopyCompositor128,
+                                          KoCompositeOpCopy2<Traits>, false>
+{
+public:
+    KoOptimizedCompositeOpCopy64(const KoColorSpace* cs)
+        : KoOptimizedCompositeOp64Impl<_impl, Traits,
+                                       CopyCompositor128,
+                                       KoCompositeOpCopy2<Traits>, false>(cs, COMPOSITE_COPY, i18n("Copy"), KoCompositeOp::categoryMisc()) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOverU16 : public KoOptimizedCompositeOpOver64<_impl, KoBgrU16Traits>
+{
+public:
+    KoOptimizedCompositeOpOverU16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpOver64<_impl, KoBgrU16Traits>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHardU16
+    : public KoOptimizedCompositeOpAlphaDarken64<_impl, KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenHardU16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpAlphaDarken64<_impl, KoBgrU16Traits, KoAlphaDarkenParamsWrapperHard>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamyU16
+    : public KoOptimizedCompositeOpAlphaDarken64<_impl, KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenCreamyU16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpAlphaDarken64<_impl, KoBgrU16Traits, KoAlphaDarkenParamsWrapperCreamy>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopyU16 : public KoOptimizedCompositeOpCopy64<_impl, KoBgrU16Traits>
+{
+public:
+    KoOptimizedCompositeOpCopyU16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpCopy64<_impl, KoBgrU16Traits>(cs) {}
+};
+
+#ifdef HAVE_OPENEXR
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOverF16 : public KoOptimizedCompositeOpOver64<_impl, KoRgbF16Traits>
+{
+public:
+    KoOptimizedCompositeOpOverF16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpOver64<_impl, KoRgbF16Traits>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHardF16
+    : public KoOptimizedCompositeOpAlphaDarken64<_impl, KoRgbF16Traits, KoAlphaDarkenParamsWrapperHard>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenHardF16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpAlphaDarken64<_impl, KoRgbF16Traits, KoAlphaDarkenParamsWrapperHard>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamyF16
+    : public KoOptimizedCompositeOpAlphaDarken64<_impl, KoRgbF16Traits, KoAlphaDarkenParamsWrapperCreamy>
+{
+public:
+    KoOptimizedCompositeOpAlphaDarkenCreamyF16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpAlphaDarken64<_impl, KoRgbF16Traits, KoAlphaDarkenParamsWrapperCreamy>(cs) {}
+};
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopyF16 : public KoOptimizedCompositeOpCopy64<_impl, KoRgbF16Traits>
+{
+public:
+    KoOptimizedCompositeOpCopyF16(const KoColorSpace* cs)
+        : KoOptimizedCompositeOpCopy64<_impl, KoRgbF16Traits>(cs) {}
+};
+
+#endif
+
+#endif // KOOPTIMIZEDCOMPOSITEOP64_H
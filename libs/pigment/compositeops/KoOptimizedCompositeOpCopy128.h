@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPCOPY128_H
+#define KOOPTIMIZEDCOMPOSITEOPCOPY128_H
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+
+/**
+ * A vectorized version of KoCompositeOpCopy2 for pixels consisting
+ * of four normalized floating point channels with alpha channel
+ * placed last. Only the case with all the channel flags set is
+ * supported.
+ *
+ * The compositor has no single-pixel path, so it can be used only via
+ * KoStreamedCompositor64Adapter, which provides one.
+ */
+struct CopyCompositor128 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    struct Pixel {
+        float red;
+        float green;
+        float blue;
+        float alpha;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v opacity_vec(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            opacity_vec *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        if ((opacity_vec == zeroValue).isFull()) {
+            return;
+        }
+
+        const Pixel *sp = reinterpret_cast<const Pixel*>(src);
+        Pixel *dp = reinterpret_cast<Pixel*>(dst);
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+        Vc::float_v src_alpha;
+
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> data(const_cast<Pixel*>(sp));
+        tie(src_c1, src_c2, src_c3, src_alpha) = data[indexes];
+
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> dataDest(dp);
+
+        const Vc::float_m fullOpacity = opacity_vec == oneValue;
+
+        if (fullOpacity.isFull()) {
+            dataDest[indexes] = tie(src_c1, src_c2, src_c3, src_alpha);
+            return;
+        }
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+        Vc::float_v dst_alpha;
+
+        tie(dst_c1, dst_c2, dst_c3, dst_alpha) = dataDest[indexes];
+
+        /**
+         * The most fundamental OVER algorithm: premultiply,
+         * blend and then unmultiply the channels
+         */
+        const Vc::float_v new_alpha = dst_alpha + (src_alpha - dst_alpha) * opacity_vec;
+        const Vc::float_m empty = new_alpha == zeroValue;
+        const Vc::float_v newAlphaRec = oneValue / new_alpha;
+
+        Vc::float_v dstMult = dst_c1 * dst_alpha;
+        Vc::float_v result = (dstMult + (src_c1 * src_alpha - dstMult) * opacity_vec) * newAlphaRec;
+        dst_c1 = Vc::iif(fullOpacity, src_c1, Vc::iif(empty, dst_c1, result));
+
+        dstMult = dst_c2 * dst_alpha;
+        result = (dstMult + (src_c2 * src_alpha - dstMult) * opacity_vec) * newAlphaRec;
+        dst_c2 = Vc::iif(fullOpacity, src_c2, Vc::iif(empty, dst_c2, result));
+
+        dstMult = dst_c3 * dst_alpha;
+        result = (dstMult + (src_c3 * src_alpha - dstMult) * opacity_vec) * newAlphaRec;
+        dst_c3 = Vc::iif(fullOpacity, src_c3, Vc::iif(empty, dst_c3, result));
+
+        dataDest[indexes] = tie(dst_c1, dst_c2, dst_c3, new_alpha);
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPCOPY128_H
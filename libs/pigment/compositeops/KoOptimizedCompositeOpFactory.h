@@ -22,6 +22,10 @@
 
 #include "kritapigment_export.h"
 
+#include <KoConfig.h>
+
+#include <QString>
+
 class KoCompositeOp;
 class KoColorSpace;
 
@@ -46,6 +50,29 @@ public:
     static KoCompositeOp* createAlphaDarkenOpHard128(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOpCreamy128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    static KoCompositeOp* createAlphaDarkenOpHardU16(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOpCreamyU16(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOpU16(const KoColorSpace *cs);
+    static KoCompositeOp* createCopyOpU16(const KoColorSpace *cs);
+
+#ifdef HAVE_OPENEXR
+    static KoCompositeOp* createAlphaDarkenOpHardF16(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOpCreamyF16(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOpF16(const KoColorSpace *cs);
+    static KoCompositeOp* createCopyOpF16(const KoColorSpace *cs);
+#endif
+
+    /**
+     * Create an optimized version of a generic blend-function-based
+     * composite op \p id for RGBA8 (createGenericOp32) or RGBA-F32
+     * (createGenericOp128) colorspace. Returns null if the op has no
+     * optimized implementation or the CPU doesn't support vector
+     * instructions. In such a case the caller should create a usual
+     * KoCompositeOpGenericSC or KoCompositeOpGenericHSL.
+     */
+    static KoCompositeOp* createGenericOp32(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createGenericOp128(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
@@ -26,6 +26,9 @@
 #include "KoOptimizedCompositeOpAlphaDarken128.h"
 #include "KoOptimizedCompositeOpOver32.h"
 #include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpGeneric32.h"
+#include "KoOptimizedCompositeOpGeneric128.h"
+#include "KoOptimizedCompositeOp64.h"
 
 #include <QString>
 #include "DebugPigment.h"
@@ -85,3 +88,148 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoOptimizedCompositeOpOver128<Vc::CurrentImplementation::current()>(param);
 }
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHardU16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHardU16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenHardU16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamyU16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamyU16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenCreamyU16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOverU16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOverU16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpOverU16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopyU16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopyU16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpCopyU16<Vc::CurrentImplementation::current()>(param);
+}
+
+#ifdef HAVE_OPENEXR
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHardF16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenHardF16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenHardF16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamyF16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarkenCreamyF16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpAlphaDarkenCreamyF16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOverF16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOverF16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpOverF16<Vc::CurrentImplementation::current()>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopyF16>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpCopyF16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return new KoOptimizedCompositeOpCopyF16<Vc::CurrentImplementation::current()>(param);
+}
+
+#endif
+
+namespace {
+
+template<template<Vc::Implementation I, class BlendFunc> class CompositeOp>
+KoCompositeOp* createGenericOp(const KoGenericCompositeOpParams &param)
+{
+    using namespace KoStreamedBlendFunctions;
+
+    constexpr Vc::Implementation impl = Vc::CurrentImplementation::current();
+    const QString &id = param.id;
+
+#define CREATE_SEPARABLE(compositeId, func) \
+    if (id == compositeId) { \
+        return new CompositeOp<impl, Separable<func>>(param.cs, id, param.description, param.category); \
+    }
+
+#define CREATE_NON_SEPARABLE(compositeId, func) \
+    if (id == compositeId) { \
+        return new CompositeOp<impl, func>(param.cs, id, param.description, param.category); \
+    }
+
+    CREATE_SEPARABLE(COMPOSITE_MULT, Multiply);
+    CREATE_SEPARABLE(COMPOSITE_SCREEN, Screen);
+    CREATE_SEPARABLE(COMPOSITE_DARKEN, Darken);
+    CREATE_SEPARABLE(COMPOSITE_LIGHTEN, Lighten);
+    CREATE_SEPARABLE(COMPOSITE_DIFF, Difference);
+    CREATE_SEPARABLE(COMPOSITE_EQUIVALENCE, Equivalence);
+    CREATE_SEPARABLE(COMPOSITE_EXCLUSION, Exclusion);
+    CREATE_SEPARABLE(COMPOSITE_HARD_LIGHT, HardLight);
+    CREATE_SEPARABLE(COMPOSITE_OVERLAY, Overlay);
+    CREATE_SEPARABLE(COMPOSITE_SOFT_LIGHT_PHOTOSHOP, SoftLight);
+    CREATE_SEPARABLE(COMPOSITE_SOFT_LIGHT_SVG, SoftLightSvg);
+    CREATE_SEPARABLE(COMPOSITE_DODGE, ColorDodge);
+    CREATE_SEPARABLE(COMPOSITE_BURN, ColorBurn);
+    CREATE_SEPARABLE(COMPOSITE_ADD, Addition);
+    CREATE_SEPARABLE(COMPOSITE_LINEAR_DODGE, Addition);
+    CREATE_SEPARABLE(COMPOSITE_LINEAR_BURN, LinearBurn);
+    CREATE_SEPARABLE(COMPOSITE_SUBTRACT, Subtract);
+    CREATE_SEPARABLE(COMPOSITE_INVERSE_SUBTRACT, InverseSubtract);
+    CREATE_SEPARABLE(COMPOSITE_DIVIDE, Divide);
+    CREATE_SEPARABLE(COMPOSITE_LINEAR_LIGHT, LinearLight);
+    CREATE_SEPARABLE(COMPOSITE_PIN_LIGHT, PinLight);
+    CREATE_SEPARABLE(COMPOSITE_GRAIN_MERGE, GrainMerge);
+    CREATE_SEPARABLE(COMPOSITE_GRAIN_EXTRACT, GrainExtract);
+    CREATE_SEPARABLE(COMPOSITE_ALLANON, Allanon);
+    CREATE_SEPARABLE(COMPOSITE_GEOMETRIC_MEAN, GeometricMean);
+
+    CREATE_NON_SEPARABLE(COMPOSITE_COLOR, Color);
+    CREATE_NON_SEPARABLE(COMPOSITE_HUE, Hue);
+    CREATE_NON_SEPARABLE(COMPOSITE_SATURATION, Saturation);
+    CREATE_NON_SEPARABLE(COMPOSITE_LUMINIZE, Luminosity);
+    CREATE_NON_SEPARABLE(COMPOSITE_INC_LUMINOSITY, IncreaseLuminosity);
+    CREATE_NON_SEPARABLE(COMPOSITE_DEC_LUMINOSITY, DecreaseLuminosity);
+
+#undef CREATE_SEPARABLE
+#undef CREATE_NON_SEPARABLE
+
+    return 0;
+}
+
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<4>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createGenericOp<KoOptimizedCompositeOpGeneric32>(param);
+}
+
+template<>
+template<>
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::ReturnType
+KoOptimizedGenericCompositeOpFactoryPerArch<16>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createGenericOp<KoOptimizedCompositeOpGeneric128>(param);
+}
@@ -23,6 +23,7 @@
 
 #include <compositeops/KoVcMultiArchBuildSupport.h>
 
+#include <QString>
 
 class KoCompositeOp;
 class KoColorSpace;
@@ -46,6 +47,30 @@ class KoOptimizedCompositeOpAlphaDarkenCreamy128;
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver128;
 
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHardU16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamyU16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOverU16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopyU16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenHardF16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarkenCreamyF16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOverF16;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpCopyF16;
+
 template<template<Vc::Implementation I> class CompositeOp>
 struct KoOptimizedCompositeOpFactoryPerArch
 {
@@ -56,5 +81,33 @@ struct KoOptimizedCompositeOpFactoryPerArch
     static ReturnType create(ParamType param);
 };
 
+/**
+ * Everything needed to create a composite op based on a generic blend
+ * function. The blend function is selected by \p id.
+ */
+struct KoGenericCompositeOpParams
+{
+    const KoColorSpace *cs;
+    QString id;
+    QString description;
+    QString category;
+};
+
+/**
+ * Creates an optimized version of a generic composite op for pixels
+ * of \p pixelSize bytes (4 for RGBA8 and 16 for RGBA-F32). Returns
+ * null if there is no optimized implementation for the requested op
+ * (scalar implementation is never created by this factory).
+ */
+template<int pixelSize>
+struct KoOptimizedGenericCompositeOpFactoryPerArch
+{
+    typedef const KoGenericCompositeOpParams& ParamType;
+    typedef KoCompositeOp* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType param);
+};
+
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORYPERARCH_H */
@@ -0,0 +1,191 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERIC128_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERIC128_H
+
+#include "KoColorSpaceTraits.h"
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+#include "KoOptimizedCompositeOpGenericFunctions.h"
+
+
+/**
+ * A floating point version of GenericCompositor32. The channels
+ * are stored in R_G_B_A order and are not clamped after blending,
+ * exactly like the scalar ops do for floating point colorspaces.
+ */
+template<class BlendFunc>
+struct GenericCompositor128 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    struct Pixel {
+        float red;
+        float green;
+        float blue;
+        float alpha;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Pixel *sp = reinterpret_cast<const Pixel*>(src);
+        Pixel *dp = reinterpret_cast<Pixel*>(dst);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha;
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> data(const_cast<Pixel*>(sp));
+        tie(src_c1, src_c2, src_c3, src_alpha) = data[indexes];
+
+        src_alpha *= Vc::float_v(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha;
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> dataDest(dp);
+        tie(dst_c1, dst_c2, dst_c3, dst_alpha) = dataDest[indexes];
+
+        Vc::float_v res_c1 = dst_c1;
+        Vc::float_v res_c2 = dst_c2;
+        Vc::float_v res_c3 = dst_c3;
+
+        BlendFunc::compose(src_c1, src_c2, src_c3, res_c1, res_c2, res_c3);
+
+        Vc::float_v new_alpha;
+
+        if ((dst_alpha == oneValue).isFull()) {
+            new_alpha = oneValue;
+
+            dst_c1 += src_alpha * (res_c1 - dst_c1);
+            dst_c2 += src_alpha * (res_c2 - dst_c2);
+            dst_c3 += src_alpha * (res_c3 - dst_c3);
+        } else {
+            new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+
+            const Vc::float_v srcOnly = src_alpha * (oneValue - dst_alpha);
+            const Vc::float_v dstOnly = dst_alpha * (oneValue - src_alpha);
+            const Vc::float_v both = src_alpha * dst_alpha;
+
+            /**
+             * new_alpha can have *some* zero values, the pixels
+             * should stay unchanged there
+             */
+            const Vc::float_m empty = new_alpha == zeroValue;
+            const Vc::float_v newAlphaRec = oneValue / new_alpha;
+
+            dst_c1 = Vc::iif(empty, dst_c1, (dstOnly * dst_c1 + srcOnly * src_c1 + both * res_c1) * newAlphaRec);
+            dst_c2 = Vc::iif(empty, dst_c2, (dstOnly * dst_c2 + srcOnly * src_c2 + both * res_c2) * newAlphaRec);
+            dst_c3 = Vc::iif(empty, dst_c3, (dstOnly * dst_c3 + srcOnly * src_c3 + both * res_c3) * newAlphaRec);
+        }
+
+        dataDest[indexes] = tie(dst_c1, dst_c2, dst_c3, new_alpha);
+    }
+
+    // \see docs in GenericCompositor32
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const int vectorSize = Vc::float_v::size();
+
+        alignas(64) Pixel srcBuf[vectorSize] = {};
+        alignas(64) Pixel dstBuf[vectorSize] = {};
+        quint8 maskBuf[vectorSize] = {0};
+
+        KoStreamedMathFunctions::copyPixel<16>(src, reinterpret_cast<quint8*>(srcBuf));
+        KoStreamedMathFunctions::copyPixel<16>(dst, reinterpret_cast<quint8*>(dstBuf));
+
+        if (haveMask) {
+            maskBuf[0] = *mask;
+        }
+
+        compositeVector<haveMask, true, _impl>(reinterpret_cast<const quint8*>(srcBuf),
+                                               reinterpret_cast<quint8*>(dstBuf),
+                                               maskBuf, opacity, oparams);
+
+        KoStreamedMathFunctions::copyPixel<16>(reinterpret_cast<const quint8*>(dstBuf), dst);
+    }
+};
+
+/**
+ * An optimized version of the generic composite ops for the use in
+ * 128-bit RGBA floating point colorspaces. The compositing with
+ * channel flags is delegated to the original scalar op.
+ */
+template<Vc::Implementation _impl, class BlendFunc>
+class KoOptimizedCompositeOpGeneric128 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpGeneric128(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
+        : KoCompositeOp(cs, id, description, category),
+          m_scalarOp(cs, id, description, category)
+    {
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            if (params.maskRowStart) {
+                KoStreamedMath<_impl>::template genericComposite128<true, false, GenericCompositor128<BlendFunc> >(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite128<false, false, GenericCompositor128<BlendFunc> >(params);
+            }
+        } else {
+            m_scalarOp.composite(params);
+        }
+    }
+
+private:
+    typename BlendFunc::template ScalarOp<KoRgbF32Traits> m_scalarOp;
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERIC128_H
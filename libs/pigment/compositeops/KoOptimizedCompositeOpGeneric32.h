@@ -0,0 +1,215 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
+
+#include "KoColorSpaceTraits.h"
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+#include "KoOptimizedCompositeOpGenericFunctions.h"
+
+
+/**
+ * A compositor for any blend function from KoStreamedBlendFunctions
+ * namespace. It implements the same math as KoCompositeOpGenericSC
+ * and KoCompositeOpGenericHSL do:
+ *
+ *   newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha
+ *   dst = ((1 - srcAlpha) * dstAlpha * dst +
+ *          (1 - dstAlpha) * srcAlpha * src +
+ *          srcAlpha * dstAlpha * f(src, dst)) / newAlpha
+ *
+ * The color channels are expected to be stored in C1_C2_C3_A order,
+ * where C1 is red, C2 is green and C3 is blue (after reading the
+ * pixel as a little-endian 32-bit integer).
+ */
+template<class BlendFunc>
+struct GenericCompositor32 {
+    struct ParamsWrapper {
+        ParamsWrapper(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint8Max((float)255.0);
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        src_alpha *= Vc::float_v(opacity) * uint8MaxRec1;
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<true>(dst) * uint8MaxRec1;
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        KoStreamedMath<_impl>::template fetch_colors_32<src_aligned>(src, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::template fetch_colors_32<true>(dst, dst_c1, dst_c2, dst_c3);
+
+        src_c1 *= uint8MaxRec1;
+        src_c2 *= uint8MaxRec1;
+        src_c3 *= uint8MaxRec1;
+
+        dst_c1 *= uint8MaxRec1;
+        dst_c2 *= uint8MaxRec1;
+        dst_c3 *= uint8MaxRec1;
+
+        Vc::float_v res_c1 = dst_c1;
+        Vc::float_v res_c2 = dst_c2;
+        Vc::float_v res_c3 = dst_c3;
+
+        BlendFunc::compose(src_c1, src_c2, src_c3, res_c1, res_c2, res_c3);
+
+        // integer colorspaces cannot store out-of-range values
+        res_c1 = Vc::min(Vc::max(res_c1, zeroValue), oneValue);
+        res_c2 = Vc::min(Vc::max(res_c2, zeroValue), oneValue);
+        res_c3 = Vc::min(Vc::max(res_c3, zeroValue), oneValue);
+
+        Vc::float_v new_alpha;
+
+        if ((dst_alpha == oneValue).isFull()) {
+            /**
+             * The most common case: painting on an opaque
+             * surface is just a linear interpolation
+             */
+            new_alpha = oneValue;
+
+            dst_c1 += src_alpha * (res_c1 - dst_c1);
+            dst_c2 += src_alpha * (res_c2 - dst_c2);
+            dst_c3 += src_alpha * (res_c3 - dst_c3);
+        } else {
+            new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+
+            const Vc::float_v srcOnly = src_alpha * (oneValue - dst_alpha);
+            const Vc::float_v dstOnly = dst_alpha * (oneValue - src_alpha);
+            const Vc::float_v both = src_alpha * dst_alpha;
+
+            /**
+             * new_alpha can have *some* zero values, the pixels
+             * should stay unchanged there
+             */
+            const Vc::float_m empty = new_alpha == zeroValue;
+            const Vc::float_v newAlphaRec = oneValue / new_alpha;
+
+            dst_c1 = Vc::iif(empty, dst_c1, (dstOnly * dst_c1 + srcOnly * src_c1 + both * res_c1) * newAlphaRec);
+            dst_c2 = Vc::iif(empty, dst_c2, (dstOnly * dst_c2 + srcOnly * src_c2 + both * res_c2) * newAlphaRec);
+            dst_c3 = Vc::iif(empty, dst_c3, (dstOnly * dst_c3 + srcOnly * src_c3 + both * res_c3) * newAlphaRec);
+        }
+
+        KoStreamedMath<_impl>::write_channels_32(dst,
+                                                 new_alpha * uint8Max,
+                                                 dst_c1 * uint8Max,
+                                                 dst_c2 * uint8Max,
+                                                 dst_c3 * uint8Max);
+    }
+
+    /**
+     * The blend functions may be quite complicated, so instead of
+     * duplicating them in scalar form, we just put the pixel into the
+     * first lane of a vector and process it with the vector code. It
+     * happens only on the unaligned borders of the rows.
+     */
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const ParamsWrapper &oparams)
+    {
+        const int vectorSize = Vc::float_v::size();
+
+        alignas(64) quint32 srcBuf[vectorSize] = {0};
+        alignas(64) quint32 dstBuf[vectorSize] = {0};
+        quint8 maskBuf[vectorSize] = {0};
+
+        srcBuf[0] = *reinterpret_cast<const quint32*>(src);
+        dstBuf[0] = *reinterpret_cast<const quint32*>(dst);
+
+        if (haveMask) {
+            maskBuf[0] = *mask;
+        }
+
+        compositeVector<haveMask, true, _impl>(reinterpret_cast<const quint8*>(srcBuf),
+                                               reinterpret_cast<quint8*>(dstBuf),
+                                               maskBuf, opacity, oparams);
+
+        *reinterpret_cast<quint32*>(dst) = dstBuf[0];
+    }
+};
+
+/**
+ * An optimized version of the generic composite ops for the use in
+ * 4 byte RGB colorspaces with alpha channel placed at the last
+ * byte of the pixel. The compositing with channel flags is
+ * delegated to the original scalar op.
+ */
+template<Vc::Implementation _impl, class BlendFunc>
+class KoOptimizedCompositeOpGeneric32 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpGeneric32(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
+        : KoCompositeOp(cs, id, description, category),
+          m_scalarOp(cs, id, description, category)
+    {
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if (params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            if (params.maskRowStart) {
+                KoStreamedMath<_impl>::template genericComposite32<true, false, GenericCompositor32<BlendFunc> >(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite32<false, false, GenericCompositor32<BlendFunc> >(params);
+            }
+        } else {
+            m_scalarOp.composite(params);
+        }
+    }
+
+private:
+    typename BlendFunc::template ScalarOp<KoBgrU8Traits> m_scalarOp;
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERIC32_H
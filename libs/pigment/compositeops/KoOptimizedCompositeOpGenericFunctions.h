@@ -0,0 +1,396 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERICFUNCTIONS_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERICFUNCTIONS_H
+
+#include <limits>
+
+#include "KoStreamedMath.h"
+#include "KoCompositeOpGeneric.h"
+#include "KoCompositeOpFunctions.h"
+
+/**
+ * Vectorized counterparts of the blend functions from
+ * KoCompositeOpFunctions.h. All the functions work with the
+ * channel values normalized into [0.0, 1.0] range and follow the
+ * floating point version of the scalar functions, that is, they do
+ * *not* clamp the result. The 8-bit compositor clamps the values
+ * itself before packing them back into bytes.
+ *
+ * Every functor also exports ScalarOp<Traits> type, which is the
+ * original scalar composite op. It is used for compositing with
+ * channel flags or locked alpha, which are not supported by the
+ * vectorized code.
+ */
+namespace KoStreamedBlendFunctions {
+
+typedef Vc::float_v::AsArg VArg;
+
+/**
+ * Adapts a separable blend function, which processes each channel
+ * independently, to the three-channel interface used by the
+ * compositors
+ */
+template<class Func>
+struct Separable
+{
+    template<class Traits>
+    using ScalarOp = KoCompositeOpGenericSC<Traits, &Func::template scalar<typename Traits::channels_type>>;
+
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        dr = Func::compose(sr, dr);
+        dg = Func::compose(sg, dg);
+        db = Func::compose(sb, db);
+    }
+};
+
+struct Multiply {
+    template<class T> static T scalar(T src, T dst) { return cfMultiply<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return s * d;
+    }
+};
+
+struct Screen {
+    template<class T> static T scalar(T src, T dst) { return cfScreen<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return s + d - s * d;
+    }
+};
+
+struct Darken {
+    template<class T> static T scalar(T src, T dst) { return cfDarkenOnly<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return Vc::min(s, d);
+    }
+};
+
+struct Lighten {
+    template<class T> static T scalar(T src, T dst) { return cfLightenOnly<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return Vc::max(s, d);
+    }
+};
+
+struct Difference {
+    template<class T> static T scalar(T src, T dst) { return cfDifference<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return Vc::abs(s - d);
+    }
+};
+
+struct Equivalence {
+    template<class T> static T scalar(T src, T dst) { return cfEquivalence<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return Vc::abs(d - s);
+    }
+};
+
+struct Exclusion {
+    template<class T> static T scalar(T src, T dst) { return cfExclusion<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v x = s * d;
+        return d + s - (x + x);
+    }
+};
+
+struct HardLight {
+    template<class T> static T scalar(T src, T dst) { return cfHardLight<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v s2 = s + s;
+        const Vc::float_v screenSrc = s2 - Vc::float_v(Vc::One);
+        return Vc::iif(s > Vc::float_v(0.5f),
+                       screenSrc + d - screenSrc * d,
+                       s2 * d);
+    }
+};
+
+struct Overlay {
+    template<class T> static T scalar(T src, T dst) { return cfOverlay<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return HardLight::compose(d, s);
+    }
+};
+
+struct SoftLight {
+    template<class T> static T scalar(T src, T dst) { return cfSoftLight<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v one(Vc::One);
+        const Vc::float_v s2 = s + s;
+        return Vc::iif(s > Vc::float_v(0.5f),
+                       d + (s2 - one) * (Vc::sqrt(d) - d),
+                       d - (one - s2) * d * (one - d));
+    }
+};
+
+struct SoftLightSvg {
+    template<class T> static T scalar(T src, T dst) { return cfSoftLightSvg<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v one(Vc::One);
+        const Vc::float_v s2 = s + s;
+        const Vc::float_v D =
+            Vc::iif(d > Vc::float_v(0.25f),
+                    Vc::sqrt(d),
+                    ((Vc::float_v(16.0f) * d - Vc::float_v(12.0f)) * d + Vc::float_v(4.0f)) * d);
+        return Vc::iif(s > Vc::float_v(0.5f),
+                       d + (s2 - one) * (D - d),
+                       d - (one - s2) * d * (one - d));
+    }
+};
+
+struct ColorDodge {
+    template<class T> static T scalar(T src, T dst) { return cfColorDodge<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v one(Vc::One);
+        return Vc::iif(s == one, one, d / (one - s));
+    }
+};
+
+struct ColorBurn {
+    template<class T> static T scalar(T src, T dst) { return cfColorBurn<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v one(Vc::One);
+        const Vc::float_v invDst = one - d;
+        Vc::float_v result = Vc::iif(s < invDst, Vc::float_v(Vc::Zero), one - invDst / s);
+        return Vc::iif(d == one, one, result);
+    }
+};
+
+struct Addition {
+    template<class T> static T scalar(T src, T dst) { return cfAddition<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return s + d;
+    }
+};
+
+struct LinearBurn {
+    template<class T> static T scalar(T src, T dst) { return cfLinearBurn<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return s + d - Vc::float_v(Vc::One);
+    }
+};
+
+struct Subtract {
+    template<class T> static T scalar(T src, T dst) { return cfSubtract<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return d - s;
+    }
+};
+
+struct InverseSubtract {
+    template<class T> static T scalar(T src, T dst) { return cfInverseSubtract<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return d - (Vc::float_v(Vc::One) - s);
+    }
+};
+
+struct Divide {
+    template<class T> static T scalar(T src, T dst) { return cfDivide<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v zero(Vc::Zero);
+        const Vc::float_v one(Vc::One);
+        return Vc::iif(s == zero, Vc::iif(d == zero, zero, one), d / s);
+    }
+};
+
+struct LinearLight {
+    template<class T> static T scalar(T src, T dst) { return cfLinearLight<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return s + s + d - Vc::float_v(Vc::One);
+    }
+};
+
+struct PinLight {
+    template<class T> static T scalar(T src, T dst) { return cfPinLight<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        const Vc::float_v s2 = s + s;
+        return Vc::max(s2 - Vc::float_v(Vc::One), Vc::min(d, s2));
+    }
+};
+
+struct GrainMerge {
+    template<class T> static T scalar(T src, T dst) { return cfGrainMerge<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return d + s - Vc::float_v(0.5f);
+    }
+};
+
+struct GrainExtract {
+    template<class T> static T scalar(T src, T dst) { return cfGrainExtract<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return d - s + Vc::float_v(0.5f);
+    }
+};
+
+struct Allanon {
+    template<class T> static T scalar(T src, T dst) { return cfAllanon<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return (s + d) * Vc::float_v(0.5f);
+    }
+};
+
+struct GeometricMean {
+    template<class T> static T scalar(T src, T dst) { return cfGeometricMean<T>(src, dst); }
+    static ALWAYS_INLINE Vc::float_v compose(VArg s, VArg d) {
+        return Vc::sqrt(s * d);
+    }
+};
+
+/**
+ * HSY helpers, the vectorized versions of the functions
+ * from KoColorSpaceMaths.h
+ */
+namespace HSY {
+
+static ALWAYS_INLINE Vc::float_v getLightness(VArg r, VArg g, VArg b) {
+    return Vc::float_v(0.299f) * r + Vc::float_v(0.587f) * g + Vc::float_v(0.114f) * b;
+}
+
+static ALWAYS_INLINE Vc::float_v getSaturation(VArg r, VArg g, VArg b) {
+    return Vc::max(r, Vc::max(g, b)) - Vc::min(r, Vc::min(g, b));
+}
+
+static ALWAYS_INLINE void addLightness(Vc::float_v &r, Vc::float_v &g, Vc::float_v &b, VArg light) {
+    const Vc::float_v zero(Vc::Zero);
+    const Vc::float_v one(Vc::One);
+
+    r += light;
+    g += light;
+    b += light;
+
+    const Vc::float_v l = getLightness(r, g, b);
+    const Vc::float_v n = Vc::min(r, Vc::min(g, b));
+    const Vc::float_v x = Vc::max(r, Vc::max(g, b));
+
+    const Vc::float_m underflow = n < zero;
+    if (!underflow.isEmpty()) {
+        const Vc::float_v iln = l / (l - n);
+        r = Vc::iif(underflow, l + (r - l) * iln, r);
+        g = Vc::iif(underflow, l + (g - l) * iln, g);
+        b = Vc::iif(underflow, l + (b - l) * iln, b);
+    }
+
+    const Vc::float_m overflow =
+        (x > one) && ((x - l) > Vc::float_v(std::numeric_limits<float>::epsilon()));
+
+    if (!overflow.isEmpty()) {
+        const Vc::float_v ixl = (one - l) / (x - l);
+        r = Vc::iif(overflow, l + (r - l) * ixl, r);
+        g = Vc::iif(overflow, l + (g - l) * ixl, g);
+        b = Vc::iif(overflow, l + (b - l) * ixl, b);
+    }
+}
+
+static ALWAYS_INLINE void setLightness(Vc::float_v &r, Vc::float_v &g, Vc::float_v &b, VArg light) {
+    addLightness(r, g, b, light - getLightness(r, g, b));
+}
+
+/**
+ * The scalar version sorts the channels and rescales the middle
+ * one. Rescaling all the channels by the chroma gives exactly the
+ * same result (including the ties), but doesn't need any branching.
+ */
+static ALWAYS_INLINE void setSaturation(Vc::float_v &r, Vc::float_v &g, Vc::float_v &b, VArg sat) {
+    const Vc::float_v zero(Vc::Zero);
+
+    const Vc::float_v n = Vc::min(r, Vc::min(g, b));
+    const Vc::float_v chroma = Vc::max(r, Vc::max(g, b)) - n;
+    const Vc::float_m hasChroma = chroma > zero;
+    const Vc::float_v scale = sat / chroma;
+
+    r = Vc::iif(hasChroma, (r - n) * scale, zero);
+    g = Vc::iif(hasChroma, (g - n) * scale, zero);
+    b = Vc::iif(hasChroma, (b - n) * scale, zero);
+}
+
+}
+
+template<void compositeFunc(float, float, float, float&, float&, float&)>
+struct NonSeparable
+{
+    template<class Traits>
+    using ScalarOp = KoCompositeOpGenericHSL<Traits, compositeFunc>;
+};
+
+struct Color : public NonSeparable<&cfColor<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        const Vc::float_v lum = HSY::getLightness(dr, dg, db);
+        dr = sr;
+        dg = sg;
+        db = sb;
+        HSY::setLightness(dr, dg, db, lum);
+    }
+};
+
+struct Luminosity : public NonSeparable<&cfLightness<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        HSY::setLightness(dr, dg, db, HSY::getLightness(sr, sg, sb));
+    }
+};
+
+struct IncreaseLuminosity : public NonSeparable<&cfIncreaseLightness<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        HSY::addLightness(dr, dg, db, HSY::getLightness(sr, sg, sb));
+    }
+};
+
+struct DecreaseLuminosity : public NonSeparable<&cfDecreaseLightness<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        HSY::addLightness(dr, dg, db, HSY::getLightness(sr, sg, sb) - Vc::float_v(Vc::One));
+    }
+};
+
+struct Hue : public NonSeparable<&cfHue<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        const Vc::float_v sat = HSY::getSaturation(dr, dg, db);
+        const Vc::float_v lum = HSY::getLightness(dr, dg, db);
+        dr = sr;
+        dg = sg;
+        db = sb;
+        HSY::setSaturation(dr, dg, db, sat);
+        HSY::setLightness(dr, dg, db, lum);
+    }
+};
+
+struct Saturation : public NonSeparable<&cfSaturation<HSYType, float>>
+{
+    static ALWAYS_INLINE void compose(VArg sr, VArg sg, VArg sb,
+                                      Vc::float_v &dr, Vc::float_v &dg, Vc::float_v &db) {
+        const Vc::float_v sat = HSY::getSaturation(sr, sg, sb);
+        const Vc::float_v lum = HSY::getLightness(dr, dg, db);
+        HSY::setSaturation(dr, dg, db, sat);
+        HSY::setLightness(dr, dg, db, lum);
+    }
+};
+
+}
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERICFUNCTIONS_H
@@ -103,6 +103,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite_novector<useMask, useFlow, Compositor, 16>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64_novector(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite_novector<useMask, useFlow, Compositor, 8>(params);
+}
+
 static inline quint8 round_float_to_uint(float value) {
     return quint8(value + float(0.5));
 }
@@ -382,6 +388,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite<useMask, useFlow, Compositor, 16>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite<useMask, useFlow, Compositor, 8>(params);
+}
+
 };
 
 namespace KoStreamedMathFunctions {
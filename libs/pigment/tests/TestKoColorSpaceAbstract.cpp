@@ -2,8 +2,13 @@
 
 #include "KoColorSpaceAbstract.h"
 #include "KoColorSpaceTraits.h"
+#include "KoMixColorsOpFactory.h"
+#include "KoAlphaMaskApplicatorFactory.h"
+#include "KoColorModelStandardIds.h"
 
+#include <algorithm>
 #include <cfloat>
+#include <random>
 
 #include <QTest>
 
@@ -385,5 +390,201 @@ void TestKoColorSpaceAbstract::testMixColorsOpU8NoAlphaLinear()
     QCOMPARE(outputPixel[COLOR_CHANNEL_2], mixOpNoAlphaExpectedColor(pixel1[COLOR_CHANNEL_2], pixel2[COLOR_CHANNEL_2], weights));
 }
 
+template <typename T>
+bool mixOpPixelsEqual(const T *pixel1, const T *pixel2)
+{
+    return std::equal(pixel1, pixel1 + 4, pixel2);
+}
+
+template <>
+bool mixOpPixelsEqual(const float *pixel1, const float *pixel2)
+{
+    for (int i = 0; i < 4; i++) {
+        if (qAbs(pixel1[i] - pixel2[i]) > 1e-6f * qMax(1.0f, qAbs(pixel1[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename channels_type>
+void testOptimizedMixColorsOpImpl(const KoID &depthId)
+{
+    typedef KoColorSpaceTrait<channels_type, 4, 3> Trait;
+    typedef KoColorSpaceMathsTraits<channels_type> MathsTraits;
+
+    QScopedPointer<KoMixColorsOp> scalarOp(new KoMixColorsOpImpl<Trait>());
+    QScopedPointer<KoMixColorsOp> optimizedOp(KoMixColorsOpFactory::create(depthId, 4, 3));
+
+    const int maxColors = 37;
+
+    QVector<channels_type> pixels(maxColors * Trait::channels_nb);
+    QVector<const quint8*> pixelPtrs(maxColors);
+    QVector<qint16> weights(maxColors);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> channelDistribution(0.0, 1.0);
+    std::uniform_int_distribution<int> weightDistribution(0, 255 / 8);
+
+    for (int i = 0; i < maxColors; i++) {
+        channels_type *pixel = pixels.data() + i * Trait::channels_nb;
+
+        for (int ch = 0; ch < int(Trait::channels_nb); ch++) {
+            pixel[ch] = channels_type(channelDistribution(generator) * double(MathsTraits::unitValue));
+        }
+
+        // fully transparent pixels must not affect the color
+        if (i % 5 == 2) {
+            pixel[Trait::alpha_pos] = MathsTraits::zeroValue;
+        }
+
+        pixelPtrs[i] = reinterpret_cast<const quint8*>(pixel);
+        weights[i] = weightDistribution(generator);
+    }
+
+    const QVector<int> numColors({1, 3, 8, 16, 17, 25, maxColors});
+    const quint8 *colors = reinterpret_cast<const quint8*>(pixels.constData());
+
+    Q_FOREACH (int nColors, numColors) {
+        channels_type scalarPixel[4];
+        channels_type optimizedPixel[4];
+
+        quint8 *scalarDst = reinterpret_cast<quint8*>(scalarPixel);
+        quint8 *optimizedDst = reinterpret_cast<quint8*>(optimizedPixel);
+
+        scalarOp->mixColors(pixelPtrs.constData(), weights.constData(), nColors, scalarDst);
+        optimizedOp->mixColors(pixelPtrs.constData(), weights.constData(), nColors, optimizedDst);
+        QVERIFY2(mixOpPixelsEqual(scalarPixel, optimizedPixel), qPrintable(QString("pointers, weights, %1 colors").arg(nColors)));
+
+        scalarOp->mixColors(colors, weights.constData(), nColors, scalarDst);
+        optimizedOp->mixColors(colors, weights.constData(), nColors, optimizedDst);
+        QVERIFY2(mixOpPixelsEqual(scalarPixel, optimizedPixel), qPrintable(QString("array, weights, %1 colors").arg(nColors)));
+
+        scalarOp->mixColors(pixelPtrs.constData(), nColors, scalarDst);
+        optimizedOp->mixColors(pixelPtrs.constData(), nColors, optimizedDst);
+        QVERIFY2(mixOpPixelsEqual(scalarPixel, optimizedPixel), qPrintable(QString("pointers, no weights, %1 colors").arg(nColors)));
+
+        scalarOp->mixColors(colors, nColors, scalarDst);
+        optimizedOp->mixColors(colors, nColors, optimizedDst);
+        QVERIFY2(mixOpPixelsEqual(scalarPixel, optimizedPixel), qPrintable(QString("array, no weights, %1 colors").arg(nColors)));
+    }
+}
+
+void TestKoColorSpaceAbstract::testOptimizedMixColorsOp_data()
+{
+    QTest::addColumn<QString>("depthId");
+
+    QTest::newRow("U8") << Integer8BitsColorDepthID.id();
+    QTest::newRow("U16") << Integer16BitsColorDepthID.id();
+    QTest::newRow("F32") << Float32BitsColorDepthID.id();
+}
+
+void TestKoColorSpaceAbstract::testOptimizedMixColorsOp()
+{
+    QFETCH(QString, depthId);
+
+    if (depthId == Integer8BitsColorDepthID.id()) {
+        testOptimizedMixColorsOpImpl<quint8>(Integer8BitsColorDepthID);
+    } else if (depthId == Integer16BitsColorDepthID.id()) {
+        testOptimizedMixColorsOpImpl<quint16>(Integer16BitsColorDepthID);
+    } else {
+        testOptimizedMixColorsOpImpl<float>(Float32BitsColorDepthID);
+    }
+}
+template <typename channels_type, int channels_nb, int alpha_pos>
+void testOptimizedAlphaMaskApplicatorImpl(const KoID &depthId)
+{
+    typedef KoColorSpaceTrait<channels_type, channels_nb, alpha_pos> Trait;
+    typedef KoColorSpaceMathsTraits<channels_type> MathsTraits;
+
+    QScopedPointer<KoAlphaMaskApplicatorBase> applicator(
+        KoAlphaMaskApplicatorFactory::create(depthId, channels_nb, alpha_pos));
+
+    // odd size to check processing of the tail that doesn't fit into a vector
+    const int maxPixels = 67;
+
+    QVector<channels_type> pixels(maxPixels * channels_nb);
+    QVector<quint8> u8Mask(maxPixels);
+    QVector<float> floatMask(maxPixels);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> channelDistribution(0.0, 1.0);
+    std::uniform_int_distribution<int> maskDistribution(0, 255);
+
+    for (int i = 0; i < pixels.size(); i++) {
+        pixels[i] = channels_type(channelDistribution(generator) * double(MathsTraits::unitValue));
+    }
+
+    for (int i = 0; i < maxPixels; i++) {
+        u8Mask[i] = maskDistribution(generator);
+        floatMask[i] = float(channelDistribution(generator));
+    }
+
+    // check the corner cases explicitly
+    u8Mask[0] = 0;
+    u8Mask[1] = 255;
+    floatMask[0] = 0.0f;
+    floatMask[1] = 1.0f;
+
+    const QVector<int> numPixels({1, 7, 8, 16, 17, 33, maxPixels});
+
+    Q_FOREACH (int nPixels, numPixels) {
+        QVector<channels_type> scalarPixels = pixels;
+        QVector<channels_type> optimizedPixels = pixels;
+
+        quint8 *scalarDst = reinterpret_cast<quint8*>(scalarPixels.data());
+        quint8 *optimizedDst = reinterpret_cast<quint8*>(optimizedPixels.data());
+
+        Trait::applyAlphaU8Mask(scalarDst, u8Mask.constData(), nPixels);
+        applicator->applyAlphaU8Mask(optimizedDst, u8Mask.constData(), nPixels);
+        QVERIFY2(scalarPixels == optimizedPixels, qPrintable(QString("U8 mask, %1 pixels").arg(nPixels)));
+
+        Trait::applyAlphaNormedFloatMask(scalarDst, floatMask.constData(), nPixels);
+        applicator->applyAlphaNormedFloatMask(optimizedDst, floatMask.constData(), nPixels);
+        QVERIFY2(scalarPixels == optimizedPixels, qPrintable(QString("float mask, %1 pixels").arg(nPixels)));
+
+        Trait::applyInverseAlphaNormedFloatMask(scalarDst, floatMask.constData(), nPixels);
+        applicator->applyInverseNormedFloatMask(optimizedDst, floatMask.constData(), nPixels);
+        QVERIFY2(scalarPixels == optimizedPixels, qPrintable(QString("inverted float mask, %1 pixels").arg(nPixels)));
+    }
+}
+
+void TestKoColorSpaceAbstract::testOptimizedAlphaMaskApplicator_data()
+{
+    QTest::addColumn<QString>("depthId");
+    QTest::addColumn<int>("numChannels");
+
+    QTest::newRow("U8-rgba") << Integer8BitsColorDepthID.id() << 4;
+    QTest::newRow("U16-rgba") << Integer16BitsColorDepthID.id() << 4;
+    QTest::newRow("F32-rgba") << Float32BitsColorDepthID.id() << 4;
+    QTest::newRow("U8-graya") << Integer8BitsColorDepthID.id() << 2;
+    QTest::newRow("U16-graya") << Integer16BitsColorDepthID.id() << 2;
+    QTest::newRow("F32-graya") << Float32BitsColorDepthID.id() << 2;
+}
+
+void TestKoColorSpaceAbstract::testOptimizedAlphaMaskApplicator()
+{
+    QFETCH(QString, depthId);
+    QFETCH(int, numChannels);
+
+    if (numChannels == 4) {
+        if (depthId == Integer8BitsColorDepthID.id()) {
+            testOptimizedAlphaMaskApplicatorImpl<quint8, 4, 3>(Integer8BitsColorDepthID);
+        } else if (depthId == Integer16BitsColorDepthID.id()) {
+            testOptimizedAlphaMaskApplicatorImpl<quint16, 4, 3>(Integer16BitsColorDepthID);
+        } else {
+            testOptimizedAlphaMaskApplicatorImpl<float, 4, 3>(Float32BitsColorDepthID);
+        }
+    } else {
+        if (depthId == Integer8BitsColorDepthID.id()) {
+            testOptimizedAlphaMaskApplicatorImpl<quint8, 2, 1>(Integer8BitsColorDepthID);
+        } else if (depthId == Integer16BitsColorDepthID.id()) {
+            testOptimizedAlphaMaskApplicatorImpl<quint16, 2, 1>(Integer16BitsColorDepthID);
+        } else {
+            testOptimizedAlphaMaskApplicatorImpl<float, 2, 1>(Float32BitsColorDepthID);
+        }
+    }
+}
+
 
 QTEST_GUILESS_MAIN(TestKoColorSpaceAbstract)
@@ -11,6 +11,10 @@ private Q_SLOTS:
     void testMixColorsOpF32();
     void testMixColorsOpU8NoAlpha();
     void testMixColorsOpU8NoAlphaLinear();
+    void testOptimizedMixColorsOp_data();
+    void testOptimizedMixColorsOp();
+    void testOptimizedAlphaMaskApplicator_data();
+    void testOptimizedAlphaMaskApplicator();
 };
 
 #endif
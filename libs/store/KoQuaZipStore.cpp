@@ -21,6 +21,8 @@
 
 #include <StoreDebug.h>
 
+#include <limits>
+
 #include <zlib.h>
 #include <quazip.h>
 #include <quazipfile.h>
@@ -32,6 +34,8 @@
 #include <QTextCodec>
 #include <QByteArray>
 #include <QBuffer>
+#include <QFile>
+#include <QPointer>
 
 #include <KConfig>
 #include <KSharedConfig>
@@ -45,11 +49,75 @@ struct KoQuaZipStore::Private {
     QuaZip *archive {0};
     QuaZipFile *currentFile {0};
     int compressionLevel {Z_DEFAULT_COMPRESSION};
+    bool storedEntries {false};
     bool usingSaveFile {false};
     QByteArray cache;
     QBuffer buffer;
+
+    /**
+     * When reading from a local file, the stored entries are read
+     * directly from the memory-mapped archive
+     */
+    QPointer<QFile> mappedFile;
+    uchar *mappedData {0};
+    qint64 mappedSize {0};
+    bool mappingFailed {false};
+    QBuffer *mappedStream {0};
+
+    QIODevice* openMappedStream(const QuaZipFileInfo64 &info);
+    void unmapArchive();
 };
 
+QIODevice* KoQuaZipStore::Private::openMappedStream(const QuaZipFileInfo64 &info)
+{
+    if (info.compressionMethod != 0 || mappingFailed) return 0;
+
+    if (!mappedData) {
+        QFile *file = qobject_cast<QFile*>(archive->getIoDevice());
+
+        if (!file) {
+            mappingFailed = true;
+            return 0;
+        }
+
+        mappedSize = file->size();
+        mappedData = file->map(0, mappedSize);
+
+        if (!mappedData) {
+            mappingFailed = true;
+            return 0;
+        }
+
+        mappedFile = file;
+    }
+
+    const qint64 offset = qint64(unzGetCurrentFileZStreamPos64(archive->getUnzFile()));
+    const qint64 size = qint64(info.uncompressedSize);
+
+    if (offset <= 0 || offset + size > mappedSize) return 0;
+
+    // QByteArray cannot address entries of 2 GiB and larger
+    if (size > std::numeric_limits<int>::max()) return 0;
+
+    mappedStream = new QBuffer();
+    mappedStream->setData(QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData + offset), size));
+    mappedStream->open(QIODevice::ReadOnly);
+
+    return mappedStream;
+}
+
+void KoQuaZipStore::Private::unmapArchive()
+{
+    delete mappedStream;
+    mappedStream = 0;
+
+    if (mappedData && mappedFile) {
+        mappedFile->unmap(mappedData);
+    }
+    mappedData = 0;
+    mappedSize = 0;
+}
+
 
 KoQuaZipStore::KoQuaZipStore(const QString &_filename, KoStore::Mode _mode, const QByteArray &appIdentification, bool writeMimetype)
     : KoStore(_mode, writeMimetype)
@@ -78,6 +146,11 @@ KoQuaZipStore::~KoQuaZipStore()
         dd->currentFile->close();
     }
 
+    if (d->stream == dd->mappedStream) {
+        d->stream = 0;
+    }
+    dd->unmapArchive();
+
     if (!d->finalized) {
         finalize();
     }
@@ -86,6 +159,11 @@ KoQuaZipStore::~KoQuaZipStore()
     delete dd->currentFile;
 }
 
+void KoQuaZipStore::setStoredEntriesEnabled(bool enabled)
+{
+    dd->storedEntries = enabled;
+}
+
 void KoQuaZipStore::setCompressionEnabled(bool enabled)
 {
 
@@ -188,7 +266,10 @@ bool KoQuaZipStore::openWrite(const QString &name)
     dd->currentFile = new QuaZipFile(dd->archive);
     QuaZipNewInfo newInfo(fixedPath);
     newInfo.setPermissions(QFileDevice::ReadOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
-    bool r = dd->currentFile->open(QIODevice::WriteOnly, newInfo, 0, 0, Z_DEFLATED, dd->compressionLevel);
+    const int method =
+        dd->storedEntries && dd->compressionLevel == Z_NO_COMPRESSION ? 0 : Z_DEFLATED;
+
+    bool r = dd->currentFile->open(QIODevice::WriteOnly, newInfo, 0, 0, method, dd->compressionLevel);
     if (!r) {
         qWarning() << "Could not open" << name << dd->currentFile->getZipError();
     }
@@ -230,7 +311,14 @@ bool KoQuaZipStore::openRead(const QString &name)
         qWarning() << "\t\t\tBut could not open!!!" << dd->archive->getZipError();
         return false;
     }
-    d->stream = dd->currentFile;
+
+    QuaZipFileInfo64 info;
+    if (dd->currentFile->getFileInfo(&info) && dd->openMappedStream(info)) {
+        d->stream = dd->mappedStream;
+    } else {
+        d->stream = dd->currentFile;
+    }
+
     d->size = dd->currentFile->size();
     return true;
 }
@@ -254,6 +342,10 @@ bool KoQuaZipStore::closeRead()
 {
     Q_D(KoStore);
     d->stream = 0;
+
+    delete dd->mappedStream;
+    dd->mappedStream = 0;
+
     return true;
 }
 
@@ -289,3 +381,64 @@ bool KoQuaZipStore::fileExists(const QString &absPath) const
 
     return dd->archive->getFileNameList().contains(fixedPath);
 }
+
+bool KoQuaZipStore::doCopyRawFile(KoStore *source, const QString &sourceName, const QString &destName)
+{
+    KoQuaZipStore *zipSource = dynamic_cast<KoQuaZipStore*>(source);
+    if (!zipSource) return false;
+
+    QuaZip *sourceArchive = zipSource->dd->archive;
+
+    if (!sourceArchive->setCurrentFile(sourceName)) {
+        warnStore << "Could not find" << sourceName << "in the source archive";
+        return false;
+    }
+
+    QuaZipFileInfo64 info;
+    if (!sourceArchive->getCurrentFileInfo(&info)) {
+        return false;
+    }
+
+    int method = 0;
+    int level = 0;
+
+    QByteArray rawData;
+
+    {
+        QuaZipFile sourceFile(sourceArchive);
+        if (!sourceFile.open(QIODevice::ReadOnly, &method, &level, true)) {
+            warnStore << "Could not open" << sourceName << "for raw reading" << sourceFile.getZipError();
+            return false;
+        }
+
+        rawData = sourceFile.readAll();
+        sourceFile.close();
+
+        if (sourceFile.getZipError() != ZIP_OK ||
+            rawData.size() != qint64(info.compressedSize)) {
+
+            warnStore << "Could not read raw data of" << sourceName;
+            return false;
+        }
+    }
+
+    /**
+     * The entry is written in raw mode, so zlib just puts the data
+     * into the archive with the CRC and the size of the original
+     * entry, without decompressing and compressing it again.
+     */
+    QuaZipFile destFile(dd->archive);
+    QuaZipNewInfo newInfo(destName);
+    newInfo.setPermissions(QFileDevice::ReadOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+    newInfo.uncompressedSize = info.uncompressedSize;
+
+    if (!destFile.open(QIODevice::WriteOnly, newInfo, 0, info.crc, method, level, true)) {
+        qWarning() << "Could not open" << destName << "for raw writing" << destFile.getZipError();
+        return false;
+    }
+
+    bool r = destFile.write(rawData) == rawData.size();
+    destFile.close();
+
+    return r && destFile.getZipError() == ZIP_OK;
+}
@@ -37,6 +37,7 @@ public:
     ~KoQuaZipStore() override;
 
     void setCompressionEnabled(bool enabled) override;
+    void setStoredEntriesEnabled(bool enabled) override;
     qint64 write(const char* _data, qint64 _len) override;
 
     QStringList directoryList() const override;
@@ -51,6 +52,7 @@ protected:
     bool enterRelativeDirectory(const QString& dirName) override;
     bool enterAbsoluteDirectory(const QString& path) override;
     bool fileExists(const QString& absPath) const override;
+    bool doCopyRawFile(KoStore *source, const QString &sourceName, const QString &destName) override;
 
 private:
     struct Private;
@@ -394,6 +394,41 @@ bool KoStorePrivate::enterDirectoryInternal(const QString &directory)
     return false;
 }
 
+bool KoStore::copyRawFile(KoStore *source, const QString &sourceName, const QString &destName)
+{
+    Q_D(KoStore);
+
+    if (d->mode != Write || !source || source->mode() != Read) {
+        return false;
+    }
+
+    if (d->isOpen || source->isOpen()) {
+        warnStore << "KoStore: cannot copy raw data while a file is opened";
+        return false;
+    }
+
+    const QString destFileName = d->toExternalNaming(destName);
+
+    if (d->filesList.contains(destFileName)) {
+        warnStore << "KoStore: Duplicate filename" << destFileName;
+        return false;
+    }
+
+    const QString sourceFileName = source->d_func()->toExternalNaming(sourceName);
+
+    if (!doCopyRawFile(source, sourceFileName, destFileName)) {
+        return false;
+    }
+
+    d->filesList.append(destFileName);
+    return true;
+}
+
+bool KoStore::doCopyRawFile(KoStore * /*source*/, const QString & /*sourceName*/, const QString & /*destName*/)
+{
+    return false;
+}
+
 bool KoStore::hasFile(const QString& fileName) const
 {
     Q_D(const KoStore);
@@ -417,6 +452,10 @@ void KoStore::setCompressionEnabled(bool /*e*/)
 {
 }
 
+void KoStore::setStoredEntriesEnabled(bool /*e*/)
+{
+}
+
 void KoStore::setSubstitution(const QString &name, const QString &substitution)
 {
     Q_D(KoStore);
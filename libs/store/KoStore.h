@@ -211,6 +211,18 @@ public:
      */
     bool extractFile(const QString &sourceName, QByteArray &data);
 
+    /**
+     * Copies the file \p sourceName of the \p source store into this
+     * store as \p destName without decompressing and recompressing its
+     * data. The \p source store must be opened for reading and this
+     * store for writing.
+     *
+     * @return false if the file could not be copied, e.g. when the
+     *         backends do not support copying of raw data. The caller
+     *         is expected to write the file in the usual way then.
+     */
+    bool copyRawFile(KoStore *source, const QString &sourceName, const QString &destName);
+
     //@{
     /// See QIODevice
     bool seek(qint64 pos);
@@ -230,6 +242,15 @@ public:
      */
     virtual void setCompressionEnabled(bool e);
 
+    /**
+     * When compression is disabled, write the files as "stored" entries,
+     * i.e. without wrapping the data into deflate blocks. The data of such
+     * entries lies in the archive as it is, so when reading it can be taken
+     * directly from the memory-mapped archive. Only supported by the ZIP
+     * backend.
+     */
+    virtual void setStoredEntriesEnabled(bool e);
+
     /// When reading, in the paths in the store where name occurs, substitution is used.
     void setSubstitution(const QString &name, const QString &substitution);
 
@@ -287,6 +308,15 @@ protected:
      */
     virtual bool fileExists(const QString &absPath) const = 0;
 
+    /**
+     * Copy the raw data of the file \p sourceName of the \p source store
+     * into the file \p destName of this store. Called by copyRawFile()
+     * with both names converted into the "absolute path" form.
+     * The default implementation doesn't support raw copying.
+     * @return true on success
+     */
+    virtual bool doCopyRawFile(KoStore *source, const QString &sourceName, const QString &destName);
+
 protected:
     KoStorePrivate *d_ptr;
 
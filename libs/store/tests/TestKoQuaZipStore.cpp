@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "TestKoQuaZipStore.h"
+
+#include <KoStore.h>
+
+#include <QTest>
+#include <QBuffer>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+namespace {
+
+QByteArray testData(int size, bool compressible)
+{
+    QByteArray data(size, '\0');
+    quint32 seed = 1;
+
+    for (int i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = compressible ? char(i / 1024) : char(seed >> 16);
+    }
+
+    return data;
+}
+
+void writeFile(KoStore *store, const QString &name, const QByteArray &data, bool compressed)
+{
+    store->setCompressionEnabled(compressed);
+    QVERIFY(store->open(name));
+    QCOMPARE(store->write(data), qint64(data.size()));
+    QVERIFY(store->close());
+    store->setCompressionEnabled(true);
+}
+
+QByteArray readFile(KoStore *store, const QString &name)
+{
+    QByteArray data;
+    store->extractFile(name, data);
+    return data;
+}
+
+}
+
+void TestKoQuaZipStore::testCopyRawFile()
+{
+    const QByteArray compressibleData = testData(300000, true);
+    const QByteArray randomData = testData(100000, false);
+
+    QByteArray sourceBuffer;
+
+    {
+        QBuffer buffer(&sourceBuffer);
+        buffer.open(QIODevice::WriteOnly);
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(!store->bad());
+
+        writeFile(store.data(), "image/layers/layer1", compressibleData, true);
+        writeFile(store.data(), "image/layers/layer2", randomData, false);
+        QVERIFY(store->finalize());
+    }
+
+    QByteArray destBuffer;
+
+    {
+        QBuffer sourceDevice(&sourceBuffer);
+        sourceDevice.open(QIODevice::ReadOnly);
+        QScopedPointer<KoStore> source(KoStore::createStore(&sourceDevice, KoStore::Read, "", KoStore::Zip));
+        QVERIFY(!source->bad());
+
+        QBuffer destDevice(&destBuffer);
+        destDevice.open(QIODevice::WriteOnly);
+        QScopedPointer<KoStore> dest(KoStore::createStore(&destDevice, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(!dest->bad());
+
+        // the entries may be renamed while copying
+        QVERIFY(dest->copyRawFile(source.data(), "image/layers/layer1", "image/layers/layer3"));
+        QVERIFY(dest->copyRawFile(source.data(), "image/layers/layer2", "image/layers/layer1"));
+
+        // duplicates are not allowed, the same as with open()
+        QVERIFY(!dest->copyRawFile(source.data(), "image/layers/layer2", "image/layers/layer1"));
+
+        QVERIFY(dest->finalize());
+    }
+
+    QBuffer destDevice(&destBuffer);
+    destDevice.open(QIODevice::ReadOnly);
+    QScopedPointer<KoStore> dest(KoStore::createStore(&destDevice, KoStore::Read, "", KoStore::Zip));
+    QVERIFY(!dest->bad());
+
+    QVERIFY(!dest->hasFile("image/layers/layer2"));
+    QVERIFY(readFile(dest.data(), "image/layers/layer3") == compressibleData);
+    QVERIFY(readFile(dest.data(), "image/layers/layer1") == randomData);
+}
+
+void TestKoQuaZipStore::testCopyRawFileMissing()
+{
+    QByteArray sourceBuffer;
+
+    {
+        QBuffer buffer(&sourceBuffer);
+        buffer.open(QIODevice::WriteOnly);
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Write, "application/x-test", KoStore::Zip));
+        writeFile(store.data(), "image/layers/layer1", testData(1000, true), true);
+        QVERIFY(store->finalize());
+    }
+
+    QBuffer sourceDevice(&sourceBuffer);
+    sourceDevice.open(QIODevice::ReadOnly);
+    QScopedPointer<KoStore> source(KoStore::createStore(&sourceDevice, KoStore::Read, "", KoStore::Zip));
+
+    QByteArray destBuffer;
+    QBuffer destDevice(&destBuffer);
+    destDevice.open(QIODevice::WriteOnly);
+    QScopedPointer<KoStore> dest(KoStore::createStore(&destDevice, KoStore::Write, "application/x-test", KoStore::Zip));
+
+    QVERIFY(!dest->copyRawFile(source.data(), "image/layers/layer2", "image/layers/layer2"));
+
+    // the name is still free, so the file can be written in the usual way
+    writeFile(dest.data(), "image/layers/layer2", testData(1000, false), true);
+    QVERIFY(dest->finalize());
+}
+
+void TestKoQuaZipStore::testStoredEntriesMapped()
+{
+    const QByteArray layerData = testData(200000, false);
+    const QByteArray xmlData = testData(50000, true);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(&file, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(!store->bad());
+        store->setStoredEntriesEnabled(true);
+
+        writeFile(store.data(), "image/layers/layer1", layerData, false);
+        writeFile(store.data(), "maindoc.xml", xmlData, true);
+        QVERIFY(store->finalize());
+    }
+
+    file.close();
+    QVERIFY(file.open());
+
+    QScopedPointer<KoStore> store(KoStore::createStore(&file, KoStore::Read, "", KoStore::Zip));
+    QVERIFY(!store->bad());
+
+    // stored entries are read directly from the mapped file
+    QVERIFY(store->open("image/layers/layer1"));
+    QVERIFY(qobject_cast<QBuffer*>(store->device()));
+    QCOMPARE(store->size(), qint64(layerData.size()));
+    QVERIFY(store->device()->readAll() == layerData);
+    QVERIFY(store->close());
+
+    // compressed ones are inflated as usual
+    QVERIFY(store->open("maindoc.xml"));
+    QVERIFY(!qobject_cast<QBuffer*>(store->device()));
+    QVERIFY(store->device()->readAll() == xmlData);
+    QVERIFY(store->close());
+
+    QVERIFY(readFile(store.data(), "image/layers/layer1") == layerData);
+}
+
+QTEST_GUILESS_MAIN(TestKoQuaZipStore)
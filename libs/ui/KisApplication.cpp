@@ -69,6 +69,7 @@
 #include <kis_icon.h>
 #include "kis_splash_screen.h"
 #include "kis_config.h"
+#include "kis_image_config.h"
 #include "flake/kis_shape_selection.h"
 #include <filter/kis_filter.h>
 #include <filter/kis_filter_registry.h>
@@ -387,7 +388,8 @@ void KisApplication::loadPlugins()
 
     KoShapeRegistry* r = KoShapeRegistry::instance();
     r->add(new KisShapeSelectionFactory());
-    KoColorSpaceRegistry::instance();
+    KoColorSpaceRegistry::instance()->setUseColorConversionLookupTables(
+        KisImageConfig(true).useColorConversionLookupTables());
     KisActionRegistry::instance();
     KisFilterRegistry::instance();
     KisGeneratorRegistry::instance();
@@ -95,6 +95,8 @@
 #include <kis_layer.h>
 #include <kis_name_server.h>
 #include <kis_paint_layer.h>
+#include <kis_paint_device.h>
+#include <kis_datamanager.h>
 #include <kis_painter.h>
 #include <kis_selection.h>
 #include <kis_fill_painter.h>
@@ -352,6 +354,47 @@ public:
     QString documentStorageID {QUuid::createUuid().toString()};
     KisResourceStorageSP documentResourceStorage;
 
+    /**
+     * The data of a paint layer is unchanged if its paint device still
+     * uses the same data manager and the data manager has not been
+     * written to since the moment the state was recorded
+     */
+    struct LayerDataState {
+        quint64 dataManagerId = 0;
+        quint64 writeGeneration = 0;
+
+        bool operator==(const LayerDataState &rhs) const {
+            return dataManagerId == rhs.dataManagerId &&
+                writeGeneration == rhs.writeGeneration;
+        }
+    };
+
+    static QHash<QUuid, LayerDataState> collectLayerDataStates(KisNodeSP root);
+
+    /**
+     * The state of the .kra file written by the last successful save.
+     * The pixel data of the layers that have not been changed since
+     * then is copied from this file by the next save as it is.
+     */
+    struct LastSavedFileState {
+        QString fileName;
+        QDateTime lastModified;
+        qint64 fileSize = -1;
+        QHash<QUuid, LayerDataState> layerDataStates;
+        QHash<QUuid, QString> layerDataEntries;
+    };
+
+    LastSavedFileState lastSavedFileState;
+
+    // the following members are used in the cloned document only
+    QHash<QUuid, LayerDataState> savingLayerDataStates;
+    QString reusableLayerDataFile;
+    QHash<QUuid, QString> reusableLayerDataEntries;
+    QHash<QUuid, QString> savedLayerDataEntries;
+
+    void prepareReusableLayerData(Private *clone) const;
+    void updateLastSavedFileState(const QString &fileName, const Private &clone);
+
     void syncDecorationsWrapperLayerState();
 
     void setImageAndInitIdleWatcher(KisImageSP _image) {
@@ -411,6 +454,78 @@ void KisDocument::Private::syncDecorationsWrapperLayerState()
     image->endStroke(id);
 }
 
+QHash<QUuid, KisDocument::Private::LayerDataState> KisDocument::Private::collectLayerDataStates(KisNodeSP root)
+{
+    QHash<QUuid, LayerDataState> states;
+
+    KisLayerUtils::recursiveApplyNodes(root,
+        [&states] (KisNodeSP node) {
+            if (!dynamic_cast<KisPaintLayer*>(node.data())) return;
+
+            KisDataManagerSP dataManager = node->paintDevice()->dataManager();
+
+            LayerDataState state;
+            state.dataManagerId = dataManager->uniqueId();
+            state.writeGeneration = dataManager->writeGeneration();
+            states.insert(node->uuid(), state);
+        });
+
+    return states;
+}
+
+void KisDocument::Private::prepareReusableLayerData(Private *clone) const
+{
+    /**
+     * The image is locked here, so the states cannot be changed
+     * until the clone is created
+     */
+    clone->savingLayerDataStates = collectLayerDataStates(image->root());
+
+    KisConfig cfg(true);
+    if (!cfg.reuseUnchangedLayerData() || lastSavedFileState.fileName.isEmpty()) return;
+
+    /**
+     * The file could have been overwritten by someone else since our
+     * last save, then nothing can be reused.
+     */
+    QFileInfo info(lastSavedFileState.fileName);
+    if (!info.exists() ||
+        info.lastModified() != lastSavedFileState.lastModified ||
+        info.size() != lastSavedFileState.fileSize) {
+
+        return;
+    }
+
+    for (auto it = lastSavedFileState.layerDataEntries.constBegin();
+         it != lastSavedFileState.layerDataEntries.constEnd(); ++it) {
+
+        auto savedState = lastSavedFileState.layerDataStates.constFind(it.key());
+        auto currentState = clone->savingLayerDataStates.constFind(it.key());
+
+        if (savedState != lastSavedFileState.layerDataStates.constEnd() &&
+            currentState != clone->savingLayerDataStates.constEnd() &&
+            *savedState == *currentState) {
+
+            clone->reusableLayerDataEntries.insert(it.key(), it.value());
+        }
+    }
+
+    if (!clone->reusableLayerDataEntries.isEmpty()) {
+        clone->reusableLayerDataFile = lastSavedFileState.fileName;
+    }
+}
+
+void KisDocument::Private::updateLastSavedFileState(const QString &fileName, const Private &clone)
+{
+    QFileInfo info(fileName);
+
+    lastSavedFileState.fileName = info.absoluteFilePath();
+    lastSavedFileState.lastModified = info.lastModified();
+    lastSavedFileState.fileSize = info.size();
+    lastSavedFileState.layerDataStates = clone.savingLayerDataStates;
+    lastSavedFileState.layerDataEntries = clone.savedLayerDataEntries;
+}
+
 void KisDocument::Private::copyFrom(const Private &rhs, KisDocument *q)
 {
     copyFromImpl(rhs, q, KisDocument::REPLACE);
@@ -865,7 +980,10 @@ KisDocument* KisDocument::lockAndCloneForSaving()
         return 0;
     }
 
-    return new KisDocument(*this);
+    KisDocument *doc = new KisDocument(*this);
+    d->prepareReusableLayerData(doc->d);
+
+    return doc;
 }
 
 KisDocument *KisDocument::lockAndCreateSnapshot()
@@ -1097,6 +1215,8 @@ void KisDocument::slotChildCompletedSavingInBackground(KisImportExportErrorCode
 
     if (d->backgroundSaveJob.flags & KritaUtils::SaveInAutosaveMode) {
         d->backgroundSaveDocument->d->isAutosaving = false;
+    } else if (status.isOk() && d->backgroundSaveJob.mimeType == nativeFormatMimeType()) {
+        d->updateLastSavedFileState(d->backgroundSaveJob.filePath, *d->backgroundSaveDocument->d);
     }
 
     d->backgroundSaveDocument.take()->deleteLater();
@@ -2279,6 +2399,7 @@ void KisDocument::setCurrentImage(KisImageSP image, bool forceInitialUpdate)
     }
 
     d->setImageAndInitIdleWatcher(image);
+    d->lastSavedFileState = Private::LastSavedFileState();
     d->image->setUndoStore(new KisDocumentUndoStore(this));
     d->shapeController->setImage(image);
     setModified(false);
@@ -2317,6 +2438,21 @@ bool KisDocument::isAutosaving() const
     return d->isAutosaving;
 }
 
+QString KisDocument::reusableLayerDataFile() const
+{
+    return d->reusableLayerDataFile;
+}
+
+QHash<QUuid, QString> KisDocument::reusableLayerDataEntries() const
+{
+    return d->reusableLayerDataEntries;
+}
+
+void KisDocument::setSavedLayerDataEntries(const QHash<QUuid, QString> &entries)
+{
+    d->savedLayerDataEntries = entries;
+}
+
 QString KisDocument::exportErrorToUserMessage(KisImportExportErrorCode status, const QString &errorMessage)
 {
     return errorMessage.isEmpty() ? status.errorMessage() : errorMessage;
@@ -24,6 +24,8 @@
 #include <QDateTime>
 #include <QTransform>
 #include <QList>
+#include <QHash>
+#include <QUuid>
 
 #include <klocalizedstring.h>
 
@@ -545,6 +547,23 @@ public:
 
     bool isAutosaving() const;
 
+    /**
+     * The name of the .kra file written by the previous save of the
+     * document and the entries of this file that contain the pixel data
+     * of the layers that have not been changed since then, mapped by the
+     * layers' uuids. The saver can copy these entries into the new file
+     * as they are. Valid in the document cloned for saving only.
+     */
+    QString reusableLayerDataFile() const;
+    QHash<QUuid, QString> reusableLayerDataEntries() const;
+
+    /**
+     * Called by the .kra saver to report the entries of the saved file
+     * that contain the pixel data of the layers, so that the next save
+     * could reuse them
+     */
+    void setSavedLayerDataEntries(const QHash<QUuid, QString> &entries);
+
 public:
 
     QString localFilePath() const;
@@ -222,6 +222,9 @@ GeneralTab::GeneralTab(QWidget *_parent, const char *_name)
     m_chkCompressKra->setChecked(cfg.compressKra());
     chkZip64->setChecked(cfg.useZip64());
     m_chkTrimKra->setChecked(cfg.trimKra());
+    m_chkReuseUnchangedLayerData->setChecked(cfg.reuseUnchangedLayerData());
+    m_chkStoreKraLayersUncompressed->setChecked(cfg.storeKraLayersUncompressed());
+    m_chkLoadKraLayersLazily->setChecked(cfg.loadKraLayersLazily());
 
     m_backupFileCheckBox->setChecked(cfg.backupFile());
     cmbBackupFileLocation->setCurrentIndex(cfg.readEntry<int>("backupfilelocation", 0));
@@ -311,6 +314,9 @@ void GeneralTab::setDefault()
     m_chkCanvasMessages->setChecked(cfg.showCanvasMessages(true));
     m_chkCompressKra->setChecked(cfg.compressKra(true));
     m_chkTrimKra->setChecked(cfg.trimKra(true));
+    m_chkReuseUnchangedLayerData->setChecked(cfg.reuseUnchangedLayerData(true));
+    m_chkStoreKraLayersUncompressed->setChecked(cfg.storeKraLayersUncompressed(true));
+    m_chkLoadKraLayersLazily->setChecked(cfg.loadKraLayersLazily(true));
     chkZip64->setChecked(cfg.useZip64(true));
     m_chkHiDPI->setChecked(false);
     m_chkHiDPI->setChecked(true);
@@ -406,6 +412,21 @@ bool GeneralTab::trimKra()
     return m_chkTrimKra->isChecked();
 }
 
+bool GeneralTab::reuseUnchangedLayerData()
+{
+    return m_chkReuseUnchangedLayerData->isChecked();
+}
+
+bool GeneralTab::storeKraLayersUncompressed()
+{
+    return m_chkStoreKraLayersUncompressed->isChecked();
+}
+
+bool GeneralTab::loadKraLayersLazily()
+{
+    return m_chkLoadKraLayersLazily->isChecked();
+}
+
 bool GeneralTab::useZip64()
 {
     return chkZip64->isChecked();
@@ -584,6 +605,7 @@ ColorSettingsTab::ColorSettingsTab(QWidget *parent, const char *name)
     m_page->chkAllowLCMSOptimization->setChecked(cfg.allowLCMSOptimization());
     m_page->chkForcePaletteColor->setChecked(cfg.forcePaletteColors());
     KisImageConfig cfgImage(true);
+    m_page->chkUseColorConversionLookupTables->setChecked(cfgImage.useColorConversionLookupTables());
 
     KisProofingConfigurationSP proofingConfig = cfgImage.defaultProofingconfiguration();
     m_page->sldAdaptationState->setMaximum(20);
@@ -710,6 +732,7 @@ void ColorSettingsTab::setDefault()
     m_page->chkBlackpoint->setChecked(cfg.useBlackPointCompensation(true));
     m_page->chkAllowLCMSOptimization->setChecked(cfg.allowLCMSOptimization(true));
     m_page->chkForcePaletteColor->setChecked(cfg.forcePaletteColors(true));
+    m_page->chkUseColorConversionLookupTables->setChecked(cfgImage.useColorConversionLookupTables(true));
     m_page->cmbMonitorIntent->setCurrentIndex(cfg.monitorRenderIntent(true));
     m_page->chkUseSystemMonitorProfile->setChecked(cfg.useSystemMonitorProfile(true));
     QAbstractButton *button = m_pasteBehaviourGroup.button(cfg.pasteBehaviour(true));
@@ -1679,6 +1702,9 @@ bool KisDlgPreferences::editPreferences()
         cfg.setShowCanvasMessages(m_general->showCanvasMessages());
         cfg.setCompressKra(m_general->compressKra());
         cfg.setTrimKra(m_general->trimKra());
+        cfg.setReuseUnchangedLayerData(m_general->reuseUnchangedLayerData());
+        cfg.setStoreKraLayersUncompressed(m_general->storeKraLayersUncompressed());
+        cfg.setLoadKraLayersLazily(m_general->loadKraLayersLazily());
         cfg.setUseZip64(m_general->useZip64());
 
         const QString configPath = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
@@ -1733,6 +1759,8 @@ bool KisDlgPreferences::editPreferences()
                                           m_colorSettings->m_page->ckbProofBlackPoint->isChecked(),
                                           m_colorSettings->m_page->gamutAlarm->color(),
                                           (double)m_colorSettings->m_page->sldAdaptationState->value()/20);
+        cfgImage.setUseColorConversionLookupTables(m_colorSettings->m_page->chkUseColorConversionLookupTables->isChecked());
+        KoColorSpaceRegistry::instance()->setUseColorConversionLookupTables(cfgImage.useColorConversionLookupTables());
         cfg.setUseBlackPointCompensation(m_colorSettings->m_page->chkBlackpoint->isChecked());
         cfg.setAllowLCMSOptimization(m_colorSettings->m_page->chkAllowLCMSOptimization->isChecked());
         cfg.setForcePaletteColors(m_colorSettings->m_page->chkForcePaletteColor->isChecked());
@@ -86,6 +86,9 @@ public:
     bool showCanvasMessages();
     bool compressKra();
     bool trimKra();
+    bool reuseUnchangedLayerData();
+    bool storeKraLayersUncompressed();
+    bool loadKraLayersLazily();
     bool useZip64();
     bool toolOptionsInDocker();
     bool kineticScrollingEnabled();
@@ -1857,6 +1857,36 @@ void KisConfig::setTrimKra(bool trim)
     m_cfg.writeEntry("TrimKra", trim);
 }
 
+bool KisConfig::reuseUnchangedLayerData(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("ReuseUnchangedLayerDataOnSave", true));
+}
+
+void KisConfig::setReuseUnchangedLayerData(bool reuse)
+{
+    m_cfg.writeEntry("ReuseUnchangedLayerDataOnSave", reuse);
+}
+
+bool KisConfig::storeKraLayersUncompressed(bool defaultValue) const
+{
+    return (defaultValue ? false : m_cfg.readEntry("StoreKraLayersUncompressed", false));
+}
+
+void KisConfig::setStoreKraLayersUncompressed(bool value)
+{
+    m_cfg.writeEntry("StoreKraLayersUncompressed", value);
+}
+
+bool KisConfig::loadKraLayersLazily(bool defaultValue) const
+{
+    return (defaultValue ? false : m_cfg.readEntry("LoadKraLayersLazily", false));
+}
+
+void KisConfig::setLoadKraLayersLazily(bool value)
+{
+    m_cfg.writeEntry("LoadKraLayersLazily", value);
+}
+
 bool KisConfig::toolOptionsInDocker(bool defaultValue) const
 {
     return (defaultValue ? true : m_cfg.readEntry("ToolOptionsInDocker", true));
@@ -533,6 +533,15 @@ public:
     bool trimKra(bool defaultValue = false) const;
     void setTrimKra(bool trim);
 
+    bool reuseUnchangedLayerData(bool defaultValue = false) const;
+    void setReuseUnchangedLayerData(bool reuse);
+
+    bool storeKraLayersUncompressed(bool defaultValue = false) const;
+    void setStoreKraLayersUncompressed(bool value);
+
+    bool loadKraLayersLazily(bool defaultValue = false) const;
+    void setLoadKraLayersLazily(bool value);
+
     bool toolOptionsInDocker(bool defaultValue = false) const;
     void setToolOptionsInDocker(bool inDocker);
 
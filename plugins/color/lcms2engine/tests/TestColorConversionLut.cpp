@@ -0,0 +1,222 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "TestColorConversionLut.h"
+
+#include <QTest>
+#include <QScopedPointer>
+#include "sdk/tests/kistest.h"
+
+#include <lcms2.h>
+
+#include "KoColorSpaceRegistry.h"
+#include "KoColorSpace.h"
+#include "KoColorProfile.h"
+#include "KoColorModelStandardIds.h"
+
+namespace {
+
+/**
+ * A gamma 2.2 RGB profile with wider-than-sRGB primaries, so that the
+ * conversion from sRGB is not an identity
+ */
+const KoColorProfile* createWideGamutProfile()
+{
+    cmsCIExyY whitePoint = {0.3127, 0.3290, 1.0};
+    cmsCIExyYTRIPLE primaries = {{0.64, 0.33, 1.0}, {0.21, 0.71, 1.0}, {0.15, 0.06, 1.0}};
+
+    cmsToneCurve *gamma = cmsBuildGamma(0, 2.2);
+    cmsToneCurve *curves[3] = {gamma, gamma, gamma};
+    cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+    cmsFreeToneCurve(gamma);
+
+    cmsMLU *description = cmsMLUalloc(0, 1);
+    cmsMLUsetASCII(description, "en", "US", "TestColorConversionLut wide gamut");
+    cmsWriteTag(profile, cmsSigProfileDescriptionTag, description);
+    cmsMLUfree(description);
+
+    cmsUInt32Number size = 0;
+    cmsSaveProfileToMem(profile, 0, &size);
+    QByteArray data(size, 0);
+    cmsSaveProfileToMem(profile, data.data(), &size);
+    cmsCloseProfile(profile);
+
+    return KoColorSpaceRegistry::instance()->createColorProfile(RGBAColorModelID.id(), Integer16BitsColorDepthID.id(), data);
+}
+
+const KoColorProfile* wideGamutProfile()
+{
+    static const KoColorProfile *profile = createWideGamutProfile();
+    return profile;
+}
+
+QByteArray randomPixels(const KoColorSpace *cs, int numPixels)
+{
+    QByteArray data(numPixels * cs->pixelSize(), 0);
+
+    qsrand(1);
+    for (int i = 0; i < data.size(); i++) {
+        data[i] = char(qrand() & 0xFF);
+    }
+
+    return data;
+}
+
+template <typename channel_t>
+int maxDifference(const QByteArray &lhs, const QByteArray &rhs)
+{
+    const channel_t *p1 = reinterpret_cast<const channel_t*>(lhs.constData());
+    const channel_t *p2 = reinterpret_cast<const channel_t*>(rhs.constData());
+    const int numChannels = lhs.size() / sizeof(channel_t);
+
+    int result = 0;
+    for (int i = 0; i < numChannels; i++) {
+        result = qMax(result, qAbs(int(p1[i]) - int(p2[i])));
+    }
+    return result;
+}
+
+}
+
+void TestColorConversionLut::testLutConversion_data()
+{
+    QTest::addColumn<QString>("srcDepth");
+    QTest::addColumn<QString>("dstModel");
+    QTest::addColumn<QString>("dstDepth");
+
+    QTest::newRow("rgb8-rgb8") << Integer8BitsColorDepthID.id() << RGBAColorModelID.id() << Integer8BitsColorDepthID.id();
+    QTest::newRow("rgb8-rgb16") << Integer8BitsColorDepthID.id() << RGBAColorModelID.id() << Integer16BitsColorDepthID.id();
+    QTest::newRow("rgb16-rgb8") << Integer16BitsColorDepthID.id() << RGBAColorModelID.id() << Integer8BitsColorDepthID.id();
+    QTest::newRow("rgb16-rgb16") << Integer16BitsColorDepthID.id() << RGBAColorModelID.id() << Integer16BitsColorDepthID.id();
+    QTest::newRow("rgb8-gray8") << Integer8BitsColorDepthID.id() << GrayAColorModelID.id() << Integer8BitsColorDepthID.id();
+    QTest::newRow("rgb16-gray16") << Integer16BitsColorDepthID.id() << GrayAColorModelID.id() << Integer16BitsColorDepthID.id();
+}
+
+void TestColorConversionLut::testLutConversion()
+{
+    QFETCH(QString, srcDepth);
+    QFETCH(QString, dstModel);
+    QFETCH(QString, dstDepth);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcCs = registry->colorSpace(RGBAColorModelID.id(), srcDepth, QString());
+    const KoColorSpace *dstCs = dstModel == RGBAColorModelID.id() ?
+        registry->colorSpace(dstModel, dstDepth, wideGamutProfile()) :
+        registry->colorSpace(dstModel, dstDepth, QString());
+
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    const int numPixels = 4096;
+    const QByteArray src = randomPixels(srcCs, numPixels);
+
+    QByteArray expected(numPixels * dstCs->pixelSize(), 0);
+    QByteArray actual(numPixels * dstCs->pixelSize(), 0);
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+
+    // the direct ICC transform
+    QScopedPointer<KoColorConversionTransformation> transform(srcCs->createColorConverter(dstCs, intent, flags));
+    transform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                         reinterpret_cast<quint8*>(expected.data()),
+                         numPixels);
+
+    // goes through the conversion cache, that is through the lookup table
+    registry->setUseColorConversionLookupTables(true);
+    srcCs->convertPixelsTo(reinterpret_cast<const quint8*>(src.constData()),
+                           reinterpret_cast<quint8*>(actual.data()),
+                           dstCs, numPixels, intent, flags);
+    registry->setUseColorConversionLookupTables(false);
+
+    if (dstDepth == Integer8BitsColorDepthID.id()) {
+        QVERIFY(maxDifference<quint8>(actual, expected) <= 2);
+    } else {
+        QVERIFY(maxDifference<quint16>(actual, expected) <= 2 * 257);
+    }
+}
+
+void TestColorConversionLut::testNoOptimizationIsExact()
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcCs = registry->rgb8();
+    const KoColorSpace *dstCs = registry->colorSpace(RGBAColorModelID.id(), Integer8BitsColorDepthID.id(), wideGamutProfile());
+
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    const int numPixels = 4096;
+    const QByteArray src = randomPixels(srcCs, numPixels);
+
+    QByteArray expected(numPixels * dstCs->pixelSize(), 0);
+    QByteArray actual(numPixels * dstCs->pixelSize(), 0);
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::IntentPerceptual;
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::NoOptimization;
+
+    QScopedPointer<KoColorConversionTransformation> transform(srcCs->createColorConverter(dstCs, intent, flags));
+    transform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                         reinterpret_cast<quint8*>(expected.data()),
+                         numPixels);
+
+    registry->setUseColorConversionLookupTables(true);
+    srcCs->convertPixelsTo(reinterpret_cast<const quint8*>(src.constData()),
+                           reinterpret_cast<quint8*>(actual.data()),
+                           dstCs, numPixels, intent, flags);
+    registry->setUseColorConversionLookupTables(false);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestColorConversionLut::testLutsAreDisabledByDefault()
+{
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+    QVERIFY(!registry->useColorConversionLookupTables());
+
+    const KoColorSpace *srcCs = registry->rgb8();
+    const KoColorSpace *dstCs = registry->colorSpace(RGBAColorModelID.id(), Integer8BitsColorDepthID.id(), wideGamutProfile());
+
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    const int numPixels = 4096;
+    const QByteArray src = randomPixels(srcCs, numPixels);
+
+    QByteArray expected(numPixels * dstCs->pixelSize(), 0);
+    QByteArray actual(numPixels * dstCs->pixelSize(), 0);
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+
+    QScopedPointer<KoColorConversionTransformation> transform(srcCs->createColorConverter(dstCs, intent, flags));
+    transform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                         reinterpret_cast<quint8*>(expected.data()),
+                         numPixels);
+
+    // image conversions must stay exact
+    srcCs->convertPixelsTo(reinterpret_cast<const quint8*>(src.constData()),
+                           reinterpret_cast<quint8*>(actual.data()),
+                           dstCs, numPixels, intent, flags);
+
+    QCOMPARE(actual, expected);
+}
+
+KISTEST_MAIN(TestColorConversionLut)
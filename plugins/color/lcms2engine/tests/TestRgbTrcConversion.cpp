@@ -0,0 +1,260 @@
+/*
+ *  Copyright (c) 2020 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "TestRgbTrcConversion.h"
+
+#include <QTest>
+#include <QScopedPointer>
+#include "sdk/tests/kistest.h"
+
+#include <lcms2.h>
+
+#include "KoColorSpaceRegistry.h"
+#include "KoColorSpace.h"
+#include "KoColorProfile.h"
+#include "KoColorModelStandardIds.h"
+#include "KoRgbTrcConversionTransformation.h"
+
+namespace {
+
+/**
+ * Creates an RGB profile with sRGB primaries and the specified tone
+ * curve, so that all the profiles differ in TRC only
+ */
+const KoColorProfile* createProfile(cmsToneCurve *curve, const char *name)
+{
+    cmsCIExyY whitePoint = {0.3127, 0.3290, 1.0};
+    cmsCIExyYTRIPLE primaries = {{0.64, 0.33, 1.0}, {0.30, 0.60, 1.0}, {0.15, 0.06, 1.0}};
+
+    cmsToneCurve *curves[3] = {curve, curve, curve};
+    cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+    cmsFreeToneCurve(curve);
+
+    cmsMLU *description = cmsMLUalloc(0, 1);
+    cmsMLUsetASCII(description, "en", "US", name);
+    cmsWriteTag(profile, cmsSigProfileDescriptionTag, description);
+    cmsMLUfree(description);
+
+    cmsUInt32Number size = 0;
+    cmsSaveProfileToMem(profile, 0, &size);
+    QByteArray data(size, 0);
+    cmsSaveProfileToMem(profile, data.data(), &size);
+    cmsCloseProfile(profile);
+
+    return KoColorSpaceRegistry::instance()->createColorProfile(RGBAColorModelID.id(), Integer16BitsColorDepthID.id(), data);
+}
+
+const KoColorProfile* srgbProfile()
+{
+    static const cmsFloat64Number params[5] = {2.4, 1.0 / 1.055, 0.055 / 1.055, 1.0 / 12.92, 0.04045};
+    static const KoColorProfile *profile =
+        createProfile(cmsBuildParametricToneCurve(0, 4, params), "TestRgbTrcConversion sRGB");
+    return profile;
+}
+
+const KoColorProfile* linearProfile()
+{
+    static const KoColorProfile *profile =
+        createProfile(cmsBuildGamma(0, 1.0), "TestRgbTrcConversion linear");
+    return profile;
+}
+
+const KoColorProfile* gamma22Profile()
+{
+    static const KoColorProfile *profile =
+        createProfile(cmsBuildGamma(0, 2.2), "TestRgbTrcConversion gamma 2.2");
+    return profile;
+}
+
+QByteArray randomPixels(const KoColorSpace *cs, int numPixels)
+{
+    QByteArray data(numPixels * cs->pixelSize(), 0);
+
+    qsrand(1);
+
+    if (cs->colorDepthId() == Float32BitsColorDepthID) {
+        float *ptr = reinterpret_cast<float*>(data.data());
+        for (int i = 0; i < numPixels * 4; i++) {
+            ptr[i] = float(qrand()) / RAND_MAX;
+        }
+    } else {
+        for (int i = 0; i < data.size(); i++) {
+            data[i] = char(qrand() & 0xFF);
+        }
+    }
+
+    return data;
+}
+
+template <typename channel_t>
+qreal maxDifference(const QByteArray &lhs, const QByteArray &rhs)
+{
+    const channel_t *p1 = reinterpret_cast<const channel_t*>(lhs.constData());
+    const channel_t *p2 = reinterpret_cast<const channel_t*>(rhs.constData());
+    const int numChannels = lhs.size() / sizeof(channel_t);
+
+    qreal result = 0;
+    for (int i = 0; i < numChannels; i++) {
+        result = qMax(result, qAbs(qreal(p1[i]) - qreal(p2[i])));
+    }
+    return result;
+}
+
+}
+
+void TestRgbTrcConversion::testDetectTrc()
+{
+    QCOMPARE(KoRgbTrcConversionTransformation::detectTrc(srgbProfile()), KoRgbTrcConversionTransformation::SrgbTrc);
+    QCOMPARE(KoRgbTrcConversionTransformation::detectTrc(linearProfile()), KoRgbTrcConversionTransformation::LinearTrc);
+    QCOMPARE(KoRgbTrcConversionTransformation::detectTrc(gamma22Profile()), KoRgbTrcConversionTransformation::UnknownTrc);
+
+    // the default profile has a tabulated sRGB curve
+    const KoColorProfile *defaultProfile = KoColorSpaceRegistry::instance()->rgb8()->profile();
+    QCOMPARE(KoRgbTrcConversionTransformation::detectTrc(defaultProfile), KoRgbTrcConversionTransformation::SrgbTrc);
+}
+
+void TestRgbTrcConversion::testConversion_data()
+{
+    QTest::addColumn<QString>("srcDepth");
+    QTest::addColumn<bool>("srcLinear");
+    QTest::addColumn<QString>("dstDepth");
+    QTest::addColumn<bool>("dstLinear");
+
+    const QStringList depths = {Integer8BitsColorDepthID.id(), Integer16BitsColorDepthID.id(), Float32BitsColorDepthID.id()};
+
+    Q_FOREACH (const QString &srcDepth, depths) {
+        Q_FOREACH (const QString &dstDepth, depths) {
+            for (int i = 0; i < 4; i++) {
+                const bool srcLinear = i & 0x1;
+                const bool dstLinear = i & 0x2;
+
+                if (srcDepth == dstDepth && srcLinear == dstLinear) continue;
+
+                const QString name = QString("%1%2-%3%4")
+                    .arg(srcDepth).arg(srcLinear ? "linear" : "srgb")
+                    .arg(dstDepth).arg(dstLinear ? "linear" : "srgb");
+
+                QTest::newRow(name.toLatin1().data()) << srcDepth << srcLinear << dstDepth << dstLinear;
+            }
+        }
+    }
+}
+
+void TestRgbTrcConversion::testConversion()
+{
+    QFETCH(QString, srcDepth);
+    QFETCH(bool, srcLinear);
+    QFETCH(QString, dstDepth);
+    QFETCH(bool, dstLinear);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcCs = registry->colorSpace(RGBAColorModelID.id(), srcDepth, srcLinear ? linearProfile() : srgbProfile());
+    const KoColorSpace *dstCs = registry->colorSpace(RGBAColorModelID.id(), dstDepth, dstLinear ? linearProfile() : srgbProfile());
+
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+
+    QVERIFY(KoRgbTrcConversionTransformation::isSuitable(srcCs, dstCs, flags));
+    QVERIFY(!KoRgbTrcConversionTransformation::isSuitable(srcCs, dstCs, flags | KoColorConversionTransformation::NoOptimization));
+
+    const int numPixels = 4096;
+    const QByteArray src = randomPixels(srcCs, numPixels);
+
+    QByteArray expected(numPixels * dstCs->pixelSize(), 0);
+    QByteArray actual(numPixels * dstCs->pixelSize(), 0);
+
+    // the ICC transform
+    QScopedPointer<KoColorConversionTransformation> iccTransform(
+        srcCs->createColorConverter(dstCs, intent, flags | KoColorConversionTransformation::NoOptimization));
+    iccTransform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                            reinterpret_cast<quint8*>(expected.data()),
+                            numPixels);
+
+    // the fast path
+    QScopedPointer<KoColorConversionTransformation> fastTransform(
+        srcCs->createColorConverter(dstCs, intent, flags));
+    QVERIFY(dynamic_cast<KoRgbTrcConversionTransformation*>(fastTransform.data()));
+
+    fastTransform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                             reinterpret_cast<quint8*>(actual.data()),
+                             numPixels);
+
+    if (dstDepth == Integer8BitsColorDepthID.id()) {
+        QVERIFY(maxDifference<quint8>(actual, expected) <= 1);
+    } else if (dstDepth == Integer16BitsColorDepthID.id()) {
+        QVERIFY(maxDifference<quint16>(actual, expected) <= 8);
+    } else {
+        QVERIFY(maxDifference<float>(actual, expected) <= 0.001);
+    }
+}
+
+void TestRgbTrcConversion::testCachedConversion_data()
+{
+    testConversion_data();
+}
+
+void TestRgbTrcConversion::testCachedConversion()
+{
+    QFETCH(QString, srcDepth);
+    QFETCH(bool, srcLinear);
+    QFETCH(QString, dstDepth);
+    QFETCH(bool, dstLinear);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *srcCs = registry->colorSpace(RGBAColorModelID.id(), srcDepth, srcLinear ? linearProfile() : srgbProfile());
+    const KoColorSpace *dstCs = registry->colorSpace(RGBAColorModelID.id(), dstDepth, dstLinear ? linearProfile() : srgbProfile());
+
+    QVERIFY(srcCs);
+    QVERIFY(dstCs);
+
+    const KoColorConversionTransformation::Intent intent = KoColorConversionTransformation::internalRenderingIntent();
+    const KoColorConversionTransformation::ConversionFlags flags = KoColorConversionTransformation::internalConversionFlags();
+
+    const int numPixels = 4096;
+    const QByteArray src = randomPixels(srcCs, numPixels);
+
+    QByteArray expected(numPixels * dstCs->pixelSize(), 0);
+    QByteArray actual(numPixels * dstCs->pixelSize(), 0);
+
+    QScopedPointer<KoColorConversionTransformation> fastTransform(
+        srcCs->createColorConverter(dstCs, intent, flags));
+    fastTransform->transform(reinterpret_cast<const quint8*>(src.constData()),
+                             reinterpret_cast<quint8*>(expected.data()),
+                             numPixels);
+
+    // the conversion cache should prefer the exact path over
+    // the lookup tables, even when the latter are enabled
+    const bool useLookupTables = registry->useColorConversionLookupTables();
+    registry->setUseColorConversionLookupTables(true);
+
+    srcCs->convertPixelsTo(reinterpret_cast<const quint8*>(src.constData()),
+                           reinterpret_cast<quint8*>(actual.data()),
+                           dstCs, numPixels, intent, flags);
+
+    registry->setUseColorConversionLookupTables(useLookupTables);
+
+    QCOMPARE(actual, expected);
+}
+
+KISTEST_MAIN(TestRgbTrcConversion)
@@ -68,7 +68,7 @@ void HistogramDockerDock::setCanvas(KoCanvasBase * canvas)
 
         m_imageIdleWatcher->setTrackedImage(m_canvas->image());
 
-        connect(m_canvas->image(), SIGNAL(sigImageUpdated(QRect)), this, SLOT(startUpdateCanvasProjection()), Qt::UniqueConnection);
+        connect(m_canvas->image(), SIGNAL(sigImageUpdated(QRect)), this, SLOT(slotImageUpdated(QRect)), Qt::UniqueConnection);
         connect(m_canvas->image(), SIGNAL(sigColorSpaceChanged(const KoColorSpace*)), this, SLOT(sigColorSpaceChanged(const KoColorSpace*)), Qt::UniqueConnection);
         m_imageIdleWatcher->startCountdown();
     }
@@ -88,6 +88,13 @@ void HistogramDockerDock::startUpdateCanvasProjection()
     }
 }
 
+void HistogramDockerDock::slotImageUpdated(const QRect &rc)
+{
+    // track the dirty areas even when hidden, the histogram is recalculated incrementally
+    m_histogramWidget->addDirtyRect(rc);
+    startUpdateCanvasProjection();
+}
+
 void HistogramDockerDock::showEvent(QShowEvent *event)
 {
     Q_UNUSED(event);
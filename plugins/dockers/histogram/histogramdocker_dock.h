@@ -43,6 +43,7 @@ public:
 
 public Q_SLOTS:
     void startUpdateCanvasProjection();
+    void slotImageUpdated(const QRect &rc);
     void sigColorSpaceChanged(const KoColorSpace* cs);
     void updateHistogram();
 
@@ -18,7 +18,6 @@
 
 #include "histogramdockerwidget.h"
 
-#include <QThread>
 #include <QVector>
 #include <limits>
 #include <algorithm>
@@ -30,13 +29,14 @@
 #include "KoChannelInfo.h"
 #include "kis_paint_device.h"
 #include "KoColorSpace.h"
-#include "kis_iterator_ng.h"
 #include "kis_canvas2.h"
+#include "kis_image.h"
 
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_colorSpace(0), m_smoothHistogram(true)
+    : QLabel(parent, f), m_histogram(new KisIncrementalHistogram()), m_colorSpace(0), m_smoothHistogram(true)
 {
     setObjectName(name);
+    connect(m_histogram.data(), &KisIncrementalHistogram::sigHistogramUpdated, this, &HistogramDockerWidget::receiveNewHistogram);
 }
 
 HistogramDockerWidget::~HistogramDockerWidget()
@@ -47,29 +47,43 @@ HistogramDockerWidget::~HistogramDockerWidget()
 void HistogramDockerWidget::updateHistogram(KisCanvas2* canvas)
 {
     if (canvas) {
-        KisPaintDeviceSP paintDevice = canvas->image()->projection();
-        QRect bounds = canvas->image()->bounds();
-
-        // remember to save the color space to paint the histogram data!
-        m_colorSpace = paintDevice->colorSpace();
+        KisImageSP image = canvas->image();
+        KisPaintDeviceSP paintDevice = image->projection();
+        QRect bounds = image->bounds();
+
+        /**
+         * The projection device may be replaced (e.g. in Isolate Mode),
+         * so we cannot trust the partial histograms of the old one
+         */
+        if (KisPaintDeviceSP(m_lastProjection) != paintDevice) {
+            m_histogram->invalidateAll();
+            m_lastProjection = paintDevice;
+        }
 
         KisPaintDeviceSP m_devClone = new KisPaintDevice(paintDevice->colorSpace());
 
         m_devClone->makeCloneFrom(paintDevice, bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, bounds);
-        connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
-        connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
-        workerThread->start();
+        // only the dirty parts of the clone are recalculated on the updater threads
+        m_histogram->startUpdate(image, m_devClone, bounds);
     } else {
+        m_histogram->invalidateAll();
+        m_lastProjection = KisPaintDeviceWSP();
         m_histogramData.clear();
         update();
     }
 }
 
-void HistogramDockerWidget::receiveNewHistogram(HistVector *histogramData)
+void HistogramDockerWidget::addDirtyRect(const QRect &rc)
+{
+    m_histogram->addDirtyRect(rc);
+}
+
+void HistogramDockerWidget::receiveNewHistogram()
 {
-    m_histogramData = *histogramData;
+    // remember to save the color space to paint the histogram data!
+    m_colorSpace = m_histogram->colorSpace();
+    m_histogramData = m_histogram->histogram();
     update();
 }
 
@@ -150,45 +164,3 @@ void HistogramDockerWidget::paintEvent(QPaintEvent *event)
         }
     }
 }
-
-void HistogramComputationThread::run()
-{
-    const KoColorSpace *cs = m_dev->colorSpace();
-    quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
-
-    quint32 imageSize = m_bounds.width() * m_bounds.height();
-    quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
-
-    //allocate space for the histogram data
-    bins.resize((int)channelCount);
-    for (auto &bin : bins) {
-        bin.resize(std::numeric_limits<quint8>::max() + 1);
-    }
-
-    QRect bounds = m_dev->exactBounds();
-    if (bounds.isEmpty())
-        return;
-
-    quint32 toSkip = nSkip;
-
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
-
-    int numConseqPixels = it.nConseqPixels();
-    while (it.nextPixels(numConseqPixels)) {
-
-        numConseqPixels = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < numConseqPixels; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
-            }
-            pixel += pixelSize;
-        }
-    }
-
-    emit resultReady(&bins);
-}
@@ -23,33 +23,13 @@
 #include <QObject>
 #include <QWidget>
 #include <QLabel>
-#include <QThread>
 #include "kis_types.h"
-#include <vector>
+#include "KisIncrementalHistogram.h"
 
 class KisCanvas2;
 class KoColorSpace;
 
-typedef std::vector<std::vector<quint32> > HistVector; //Don't use QVector here - it's too slow for this purpose
-
-
-class HistogramComputationThread : public QThread
-{
-    Q_OBJECT
-public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
-    {}
-
-    void run() override;
-
-Q_SIGNALS:
-    void resultReady(HistVector*);
-
-private:
-    KisPaintDeviceSP m_dev;
-    QRect m_bounds;
-    HistVector bins;
-};
+typedef KisIncrementalHistogram::HistVector HistVector; //Don't use QVector here - it's too slow for this purpose
 
 
 class HistogramDockerWidget : public QLabel
@@ -71,9 +51,19 @@ public Q_SLOTS:
      * Isolate Mode or when opening an image with a single layer.
      */
     void updateHistogram(KisCanvas2* canvas);
-    void receiveNewHistogram(HistVector*);
+
+    /**
+     * @brief addDirtyRect marks the area of the projection that should be
+     * recalculated on the next call to updateHistogram()
+     */
+    void addDirtyRect(const QRect &rc);
+
+private Q_SLOTS:
+    void receiveNewHistogram();
 
 private:
+    KisIncrementalHistogramSP m_histogram;
+    KisPaintDeviceWSP m_lastProjection;
     HistVector m_histogramData;
     const KoColorSpace* m_colorSpace;
     bool m_smoothHistogram;
@@ -20,6 +20,7 @@
 #include "kra_converter.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QScopedPointer>
 #include <QUrl>
@@ -38,6 +39,7 @@
 #include <kis_png_converter.h>
 #include <KisDocument.h>
 #include <kis_clone_layer.h>
+#include <kis_config.h>
 
 static const char CURRENT_DTD_VERSION[] = "2.0";
 
@@ -90,6 +92,9 @@ KisImportExportErrorCode KraConverter::buildImage(QIODevice *io)
         return ImportExportCodes::FileFormatIncorrect;
     }
 
+    QElapsedTimer loadingTime;
+    loadingTime.start();
+
     bool success = false;
     {
         if (m_store->hasFile("root") || m_store->hasFile("maindoc.xml")) {   // Fallback to "old" file format (maindoc.xml)
@@ -115,7 +120,12 @@ KisImportExportErrorCode KraConverter::buildImage(QIODevice *io)
                 m_doc->documentInfo()->load(doc);
             }
         }
+        const qint64 xmlTime = loadingTime.elapsed();
+
         success = completeLoading(m_store);
+
+        dbgFile << "XML parsed in" << xmlTime << "ms,"
+                << "binary data loaded in" << loadingTime.elapsed() - xmlTime << "ms";
     }
 
     fixCloneLayers(m_image, m_image->root());
@@ -148,6 +158,8 @@ KisImportExportErrorCode KraConverter::buildFile(QIODevice *io, const QString &f
         return ImportExportCodes::CannotCreateFile;
     }
 
+    m_store->setStoredEntriesEnabled(KisConfig(true).storeKraLayersUncompressed());
+
     setProgress(20);
 
     m_kraSaver = new KisKraSaver(m_doc, filename);
@@ -166,10 +178,29 @@ KisImportExportErrorCode KraConverter::buildFile(QIODevice *io, const QString &f
         qWarning() << "saving key frames failed";
     }
     setProgress(60);
+    /**
+     * The pixel data of the layers that have not been changed since the
+     * previous save is copied from the previously saved file. The store
+     * should be closed before QSaveFile replaces the file, so it lives
+     * in this scope only.
+     */
+    QScopedPointer<KoStore> reusableDataStore;
+
+    const QString reusableDataFile = m_doc->reusableLayerDataFile();
+    if (!reusableDataFile.isEmpty()) {
+        reusableDataStore.reset(KoStore::createStore(reusableDataFile, KoStore::Read, "", KoStore::Zip));
+
+        if (!reusableDataStore->bad()) {
+            m_kraSaver->setReusableLayerData(reusableDataStore.data(), m_doc->reusableLayerDataEntries());
+        }
+    }
+
     result = m_kraSaver->saveBinaryData(m_store, m_image, m_doc->url().toLocalFile(), true, m_doc->isAutosaving());
     if (!result) {
         qWarning() << "saving binary data failed";
     }
+
+    m_doc->setSavedLayerDataEntries(m_kraSaver->savedLayerDataEntries());
     setProgress(70);
     result = m_kraSaver->savePalettes(m_store, m_image, m_doc->url().toLocalFile());
     if (!result) {
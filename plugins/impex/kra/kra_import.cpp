@@ -21,9 +21,11 @@
 
 #include <kpluginfactory.h>
 #include <QFileInfo>
+#include <QElapsedTimer>
 
 #include <KisDocument.h>
 #include <kis_image.h>
+#include <kis_debug.h>
 
 #include "kra_converter.h"
 
@@ -42,7 +44,12 @@ KisImportExportErrorCode KraImport::convert(KisDocument *document, QIODevice *io
     KraConverter kraConverter(document);
     KisImportExportErrorCode result = kraConverter.buildImage(io);
     if (result.isOk()) {
+        QElapsedTimer projectionTime;
+        projectionTime.start();
+
         document->setCurrentImage(kraConverter.image());
+
+        dbgFile << "Projection built in" << projectionTime.elapsed() << "ms";
         if (kraConverter.activeNodes().size() > 0) {
             document->setPreActivatedNode(kraConverter.activeNodes()[0]);
         }
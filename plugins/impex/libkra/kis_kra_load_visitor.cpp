@@ -28,6 +28,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QMessageBox>
+#include <QtConcurrent>
 
 #include <KoMD5Generator.h>
 #include <KoColorSpaceRegistry.h>
@@ -37,6 +38,7 @@
 #include <KoColorSpace.h>
 #include <KoShapeControllerBase.h>
 #include <KisGlobalResourcesInterface.h>
+#include <kis_config.h>
 
 // kritaimage
 #include <kis_meta_data_io_backend.h>
@@ -73,6 +75,32 @@
 
 using namespace KRA;
 
+namespace {
+/**
+ * The compressed pixel data waiting to be decoded is kept in memory,
+ * so limit how far reading the store can get ahead of the decoding
+ */
+const qint64 maxPendingBytes = 256 * 1024 * 1024;
+}
+
+struct KisKraLoadVisitor::PendingDevice
+{
+    struct Frame {
+        QString location;
+        QByteArray data;
+        std::function<bool(KisPaintDeviceSP, QIODevice*)> read;
+    };
+
+    PendingDevice(KisPaintDeviceSP _device) : device(_device) {}
+
+    KisPaintDeviceSP device;
+    QVector<Frame> frames;
+    qint64 size {0};
+
+    QFuture<void> future;
+    QStringList failedLocations;
+};
+
 QString expandEncodedDirectory(const QString& _intern)
 {
 
@@ -129,6 +157,19 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
         m_store->popDirectory();
     }
     m_syntaxVersion = syntaxVersion;
+
+    /**
+     * In lazy mode the tiles are kept compressed until someone
+     * accesses them, so the layers that are never shown (hidden
+     * ones, inactive animation frames) take almost no memory
+     */
+    m_lazyLoading = KisConfig(true).loadKraLayersLazily();
+}
+
+KisKraLoadVisitor::~KisKraLoadVisitor()
+{
+    // don't let the workers outlive the visitor
+    finishLoading();
 }
 
 void KisKraLoadVisitor::setExternalUri(const QString &uri)
@@ -254,6 +295,9 @@ bool KisKraLoadVisitor::visit(KisAdjustmentLayer* layer)
         KisSelectionSP selection = new KisSelection();
         KisPixelSelectionSP pixelSelection = selection->pixelSelection();
         result = loadPaintDevice(pixelSelection, getLocation(layer, ".selection"));
+
+        // the selection is copied, so its pixels should be ready
+        finishLoading();
         layer->setInternalSelection(selection);
     } else if (m_syntaxVersion == 2) {
         result = loadSelection(getLocation(layer), layer->internalSelection());
@@ -369,14 +413,14 @@ bool KisKraLoadVisitor::visit(KisTransformMask *mask)
 {
     QString location = getLocation(mask, DOT_TRANSFORMCONFIG);
     if (m_store->hasFile(location)) {
-        QByteArray data;
+        QDomDocument doc;
         m_store->open(location);
-        data = m_store->read(m_store->size());
+        const bool hasData = m_store->size() > 0;
+        if (hasData) {
+            doc.setContent(m_store->device());
+        }
         m_store->close();
-        if (!data.isEmpty()) {
-            QDomDocument doc;
-            doc.setContent(data);
-
+        if (hasData) {
             QDomElement rootElement = doc.documentElement();
 
             QDomElement main;
@@ -457,15 +501,44 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
         loadPaintDevice(stroke.dev, fileName);
     }
 
-    mask->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
-
     loadPaintDevice(mask->coloringProjection(), COLORIZE_COLORING_DEVICE);
-    mask->resetCache();
+
+    KisColorizeMaskSP maskSP(mask);
+    m_deferredActions.append([maskSP, strokes] () {
+        maskSP->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
+        maskSP->resetCache();
+    });
 
     m_store->popDirectory();
     return true;
 }
 
+void KisKraLoadVisitor::finishLoading()
+{
+    Q_FOREACH (PendingDeviceSP pending, m_pendingDevices) {
+        pending->future.waitForFinished();
+
+        Q_FOREACH (const QString &location, pending->failedLocations) {
+            m_warningMessages << i18n("Could not read pixel data: %1.", location);
+        }
+
+        if (!pending->failedLocations.isEmpty()) {
+            pending->device->disconnect();
+        }
+    }
+
+    m_pendingDevices.clear();
+    m_numFinishedDevices = 0;
+    m_pendingBytes = 0;
+
+    QVector<std::function<void()>> actions;
+    std::swap(actions, m_deferredActions);
+
+    Q_FOREACH (const std::function<void()> &action, actions) {
+        action();
+    }
+}
+
 QStringList KisKraLoadVisitor::errorMessages() const
 {
     return m_errorMessages;
@@ -478,22 +551,27 @@ QStringList KisKraLoadVisitor::warningMessages() const
 
 struct SimpleDevicePolicy
 {
+    SimpleDevicePolicy(bool lazy)
+        : m_lazy(lazy) {}
+
     bool read(KisPaintDeviceSP dev, QIODevice *stream) {
-        return dev->read(stream);
+        return dev->read(stream, m_lazy);
     }
 
     void setDefaultPixel(KisPaintDeviceSP dev, const KoColor &defaultPixel) const {
         return dev->setDefaultPixel(defaultPixel);
     }
+
+    bool m_lazy;
 };
 
 struct FramedDevicePolicy
 {
-    FramedDevicePolicy(int frameId)
-        :  m_frameId(frameId) {}
+    FramedDevicePolicy(int frameId, bool lazy)
+        :  m_frameId(frameId), m_lazy(lazy) {}
 
     bool read(KisPaintDeviceSP dev, QIODevice *stream) {
-        return dev->framesInterface()->readFrame(stream, m_frameId);
+        return dev->framesInterface()->readFrame(stream, m_frameId, m_lazy);
     }
 
     void setDefaultPixel(KisPaintDeviceSP dev, const KoColor &defaultPixel) const {
@@ -501,8 +579,45 @@ struct FramedDevicePolicy
     }
 
     int m_frameId;
+    bool m_lazy;
 };
 
+void KisKraLoadVisitor::decodePendingDevice(PendingDeviceSP pending)
+{
+    for (auto it = pending->frames.begin(); it != pending->frames.end(); ++it) {
+        QBuffer buffer(&it->data);
+        buffer.open(QIODevice::ReadOnly);
+
+        if (!it->read(pending->device, &buffer)) {
+            pending->failedLocations << it->location;
+        }
+
+        buffer.close();
+        it->data.clear();
+    }
+}
+
+void KisKraLoadVisitor::scheduleDecoding(PendingDeviceSP pending)
+{
+    if (pending->frames.isEmpty()) return;
+
+    /**
+     * The frames of the same device are decoded sequentially,
+     * different devices are decoded concurrently
+     */
+    pending->future = QtConcurrent::run(&KisKraLoadVisitor::decodePendingDevice, pending);
+    m_pendingDevices.append(pending);
+    m_pendingBytes += pending->size;
+
+    while (m_pendingBytes > maxPendingBytes &&
+           m_numFinishedDevices < m_pendingDevices.size()) {
+
+        PendingDeviceSP oldest = m_pendingDevices[m_numFinishedDevices++];
+        oldest->future.waitForFinished();
+        m_pendingBytes -= oldest->size;
+    }
+}
+
 bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString& location)
 {
     // Layer data
@@ -513,8 +628,12 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
         frames = device->framesInterface()->frames();
     }
 
+    PendingDeviceSP pending(new PendingDevice(device));
+
     if (!frameInterface || frames.count() <= 1) {
-        return loadPaintDeviceFrame(device, location, SimpleDevicePolicy());
+        const bool result = loadPaintDeviceFrame(pending, location, SimpleDevicePolicy(m_lazyLoading));
+        scheduleDecoding(pending);
+        return result;
     } else {
         KisRasterKeyframeChannel *keyframeChannel = device->keyframeChannel();
 
@@ -528,19 +647,23 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
                 QString frameFilename = getLocation(keyframeChannel->frameFilename(id));
                 Q_ASSERT(!frameFilename.isEmpty());
 
-                if (!loadPaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id))) {
+                if (!loadPaintDeviceFrame(pending, frameFilename, FramedDevicePolicy(id, m_lazyLoading))) {
                     m_warningMessages << i18n("Could not load keyframe pixel data for frame %1 in %2.", id, location);
                 }
             }
         }
+
+        scheduleDecoding(pending);
     }
 
     return true;
 }
 
 template<class DevicePolicy>
-bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy)
+bool KisKraLoadVisitor::loadPaintDeviceFrame(PendingDeviceSP pending, const QString &location, DevicePolicy policy)
 {
+    KisPaintDeviceSP device = pending->device;
+
     {
         const int pixelSize = device->colorSpace()->pixelSize();
         KoColor color(Qt::transparent, device->colorSpace());
@@ -557,13 +680,42 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
     }
 
     if (m_store->open(location)) {
-        if (!policy.read(device, m_store->device())) {
-            m_warningMessages << i18n("Could not read pixel data: %1.", location);
-            device->disconnect();
+        /**
+         * The store can be read only sequentially, so just fetch the
+         * data here and leave decoding of the tiles to the workers.
+         *
+         * Stored entries of a memory-mapped archive are exposed as a
+         * QBuffer over the mapping, which stays valid until the store
+         * is destroyed, so their data is shared with the workers
+         * without copying.
+         */
+        QBuffer *mappedStream = qobject_cast<QBuffer*>(m_store->device());
+
+        if (!mappedStream && m_store->size() > maxPendingBytes) {
+            /**
+             * Huge entries are decoded right from the store, keeping
+             * them in memory would only double the peak usage
+             */
+            if (!policy.read(device, m_store->device())) {
+                m_warningMessages << i18n("Could not read pixel data: %1.", location);
+                device->disconnect();
+            }
             m_store->close();
             return true;
         }
+
+        PendingDevice::Frame frame;
+        frame.location = location;
+        frame.data = mappedStream ? mappedStream->data() : m_store->read(m_store->size());
+        frame.read = [policy] (KisPaintDeviceSP dev, QIODevice *stream) mutable {
+            return policy.read(dev, stream);
+        };
         m_store->close();
+
+        if (!mappedStream) {
+            pending->size += frame.data.size();
+        }
+        pending->frames.append(frame);
     } else {
         m_warningMessages << i18n("Could not load pixel data: %1.", location);
         return true;
@@ -586,20 +738,26 @@ bool KisKraLoadVisitor::loadProfile(KisPaintDeviceSP device, const QString& loca
 
         QByteArray hash = KoMD5Generator::generateHash(data);
 
+        const KoColorProfile *profile = 0;
+
         if (m_profileCache.contains(hash)) {
-            if (device->setProfile(m_profileCache[hash], 0)) {
-                return true;
-            }
+            profile = m_profileCache[hash];
         }
         else {
             // Create a colorspace with the embedded profile
-            const KoColorProfile *profile = KoColorSpaceRegistry::instance()->createColorProfile(device->colorSpace()->colorModelId().id(), device->colorSpace()->colorDepthId().id(), data);
+            profile = KoColorSpaceRegistry::instance()->createColorProfile(device->colorSpace()->colorModelId().id(), device->colorSpace()->colorDepthId().id(), data);
             m_profileCache[hash] = profile;
-            if (device->setProfile(profile, 0)) {
-                return true;
+        }
+
+        // the profile is assigned to all the data of the device,
+        // so wait until its pixels are decoded
+        m_deferredActions.append([this, device, profile, location] () {
+            if (!device->setProfile(profile, 0)) {
+                m_warningMessages << i18n("Could not load profile: %1.", location);
             }
+        });
 
-        }
+        return true;
     }
     m_warningMessages << i18n("Could not load profile: %1.", location);
     return true;
@@ -608,13 +766,14 @@ bool KisKraLoadVisitor::loadProfile(KisPaintDeviceSP device, const QString& loca
 bool KisKraLoadVisitor::loadFilterConfiguration(KisFilterConfigurationSP kfc, const QString& location)
 {
     if (m_store->hasFile(location)) {
-        QByteArray data;
+        QDomDocument doc;
         m_store->open(location);
-        data = m_store->read(m_store->size());
+        const bool hasData = m_store->size() > 0;
+        if (hasData) {
+            doc.setContent(m_store->device());
+        }
         m_store->close();
-        if (!data.isEmpty()) {
-            QDomDocument doc;
-            doc.setContent(data);
+        if (hasData) {
             QDomElement e = doc.documentElement();
             if (e.tagName() == "filterconfig") {
                 kfc->fromLegacyXML(e);
@@ -690,7 +849,9 @@ bool KisKraLoadVisitor::loadSelection(const QString& location, KisSelectionSP ds
         if (!result) {
             m_warningMessages << i18n("Could not load raster selection %1.", location);
         }
-        pixelSelection->invalidateOutlineCache();
+        m_deferredActions.append([pixelSelection] () {
+            pixelSelection->invalidateOutlineCache();
+        });
     }
 
     // Shape selection
@@ -698,6 +859,9 @@ bool KisKraLoadVisitor::loadSelection(const QString& location, KisSelectionSP ds
     if (m_store->hasFile(shapeSelectionLocation + "/content.svg") ||
         m_store->hasFile(shapeSelectionLocation + "/content.xml")) {
 
+        // the vector selection is rendered into the pixel one
+        finishLoading();
+
         m_store->pushDirectory();
         m_store->enterDirectory(shapeSelectionLocation) ;
 
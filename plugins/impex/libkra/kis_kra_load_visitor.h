@@ -20,8 +20,12 @@
 #ifndef KIS_KRA_LOAD_VISITOR_H_
 #define KIS_KRA_LOAD_VISITOR_H_
 
+#include <functional>
+
 #include <QRect>
 #include <QStringList>
+#include <QSharedPointer>
+#include <QVector>
 
 // kritaimage
 #include "kis_types.h"
@@ -47,6 +51,7 @@ public:
                       QMap<KisNode *, QString> &keyframeFilenames,
                       const QString & name,
                       int syntaxVersion);
+    ~KisKraLoadVisitor() override;
 
 public:
     void setExternalUri(const QString &uri);
@@ -66,15 +71,29 @@ public:
     bool visit(KisSelectionMask *mask) override;
     bool visit(KisColorizeMask *mask) override;
 
+    /**
+     * The pixel data of the paint devices is read from the store
+     * while visiting the nodes, but decoded in the background. Call
+     * this method after the root layer has accepted the visitor to
+     * wait for decoding to finish and complete the initialization
+     * of the nodes that depend on the loaded pixels.
+     */
+    void finishLoading();
+
     QStringList errorMessages() const;
     QStringList warningMessages() const;
 
 private:
+    struct PendingDevice;
+    typedef QSharedPointer<PendingDevice> PendingDeviceSP;
+
+    static void decodePendingDevice(PendingDeviceSP pending);
+    void scheduleDecoding(PendingDeviceSP pending);
 
     bool loadPaintDevice(KisPaintDeviceSP device, const QString& location);
 
     template<class DevicePolicy>
-    bool loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy);
+    bool loadPaintDeviceFrame(PendingDeviceSP pending, const QString &location, DevicePolicy policy);
 
     bool loadProfile(KisPaintDeviceSP device,  const QString& location);
     bool loadFilterConfiguration(KisFilterConfigurationSP kfc, const QString& location);
@@ -103,10 +122,16 @@ private:
     QMap<KisNode *, QString> m_keyframeFilenames;
     QString m_name;
     int m_syntaxVersion;
+    bool m_lazyLoading {false};
     QStringList m_errorMessages;
     QStringList m_warningMessages;
     KoShapeControllerBase *m_shapeController;
     QMap<QByteArray, const KoColorProfile *> m_profileCache;
+
+    QList<PendingDeviceSP> m_pendingDevices;
+    int m_numFinishedDevices {0};
+    qint64 m_pendingBytes {0};
+    QVector<std::function<void()>> m_deferredActions;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
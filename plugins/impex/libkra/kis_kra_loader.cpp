@@ -26,6 +26,7 @@
 
 #include <QUrl>
 #include <QBuffer>
+#include <QElapsedTimer>
 
 #include <KoStore.h>
 #include <KoColorSpaceRegistry.h>
@@ -444,7 +445,16 @@ void KisKraLoader::loadBinaryData(KoStore * store, KisImageSP image, const QStri
         visitor.setExternalUri(uri);
     }
 
+    QElapsedTimer loadingTime;
+    loadingTime.start();
+
     image->rootLayer()->accept(visitor);
+    const qint64 readingTime = loadingTime.elapsed();
+
+    visitor.finishLoading();
+    dbgFile << "Layers data read in" << readingTime << "ms,"
+            << "decoding finished after" << loadingTime.elapsed() - readingTime << "ms more";
+
     if (!visitor.errorMessages().isEmpty()) {
         m_d->errorMessages.append(visitor.errorMessages());
     }
@@ -76,6 +76,7 @@ KisKraSaveVisitor::KisKraSaveVisitor(KoStore *store, const QString & name, QMap<
     , m_name(name)
     , m_nodeFileNames(nodeFileNames)
     , m_writer(new KisStorePaintDeviceWriter(store))
+    , m_reusableDataStore(0)
 {
 }
 
@@ -90,6 +91,17 @@ void KisKraSaveVisitor::setExternalUri(const QString &uri)
     m_uri = uri;
 }
 
+void KisKraSaveVisitor::setReusableLayerData(KoStore *store, const QHash<QUuid, QString> &entries)
+{
+    m_reusableDataStore = store;
+    m_reusableLayerDataEntries = entries;
+}
+
+QHash<QUuid, QString> KisKraSaveVisitor::savedLayerDataEntries() const
+{
+    return m_savedLayerDataEntries;
+}
+
 bool KisKraSaveVisitor::visit(KisExternalLayer * layer)
 {
     bool result = false;
@@ -130,7 +142,7 @@ bool KisKraSaveVisitor::visit(KisExternalLayer * layer)
 
 bool KisKraSaveVisitor::visit(KisPaintLayer *layer)
 {
-    if (!savePaintDevice(layer->paintDevice(), getLocation(layer))) {
+    if (!saveLayerPaintDevice(layer)) {
         m_errorMessages << i18n("Failed to save the pixel data for layer %1.", layer->name());
         return false;
     }
@@ -342,6 +354,35 @@ struct FramedDevicePolicy
     int m_frameId;
 };
 
+bool KisKraSaveVisitor::saveLayerPaintDevice(KisLayer *layer)
+{
+    KisPaintDeviceSP device = layer->paintDevice();
+    const QString location = getLocation(layer);
+
+    KisPaintDeviceFramesInterface *frameInterface = device->framesInterface();
+    if (frameInterface && frameInterface->frames().count() > 1) {
+        // the data of animated layers is never reused
+        return savePaintDevice(device, location);
+    }
+
+    const QString sourceLocation = m_reusableLayerDataEntries.value(layer->uuid());
+
+    if (m_reusableDataStore && !sourceLocation.isEmpty() &&
+        m_store->copyRawFile(m_reusableDataStore, sourceLocation, location)) {
+
+        // the default pixel is tiny, so just write it again
+        if (m_store->open(location + ".defaultpixel")) {
+            m_store->write((char*)device->defaultPixel().data(), device->colorSpace()->pixelSize());
+            m_store->close();
+        }
+    } else if (!savePaintDevice(device, location)) {
+        return false;
+    }
+
+    m_savedLayerDataEntries.insert(layer->uuid(), location);
+    return true;
+}
+
 bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
                                         QString location)
 {
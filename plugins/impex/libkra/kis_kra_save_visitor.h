@@ -22,6 +22,8 @@
 
 #include <QRect>
 #include <QStringList>
+#include <QHash>
+#include <QUuid>
 
 #include "kis_types.h"
 #include "kis_node_visitor.h"
@@ -41,6 +43,20 @@ public:
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * Let the visitor copy the pixel data of the paint layers listed
+     * in \p entries from the \p store of the previously saved file
+     * instead of serializing it again. The entries map the layers'
+     * uuids to the locations of their data in \p store.
+     */
+    void setReusableLayerData(KoStore *store, const QHash<QUuid, QString> &entries);
+
+    /**
+     * @return the locations where the pixel data of the paint layers
+     *         has been saved to, mapped by the layers' uuids
+     */
+    QHash<QUuid, QString> savedLayerDataEntries() const;
+
     bool visit(KisNode*) override {
         return true;
     }
@@ -72,6 +88,7 @@ public:
 
 private:
 
+    bool saveLayerPaintDevice(KisLayer *layer);
     bool savePaintDevice(KisPaintDeviceSP device, QString location);
 
     template<class DevicePolicy>
@@ -93,6 +110,9 @@ private:
     QMap<const KisNode*, QString> m_nodeFileNames;
     KisPaintDeviceWriter *m_writer;
     QStringList m_errorMessages;
+    KoStore *m_reusableDataStore;
+    QHash<QUuid, QString> m_reusableLayerDataEntries;
+    QHash<QUuid, QString> m_savedLayerDataEntries;
 };
 
 #endif // KIS_KRA_SAVE_VISITOR_H_
@@ -77,6 +77,9 @@ public:
     QString imageName;
     QString filename;
     QStringList errorMessages;
+    KoStore *reusableDataStore = 0;
+    QHash<QUuid, QString> reusableLayerDataEntries;
+    QHash<QUuid, QString> savedLayerDataEntries;
 };
 
 KisKraSaver::KisKraSaver(KisDocument* document, const QString &filename)
@@ -247,8 +250,13 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     if (external)
         visitor.setExternalUri(uri);
 
+    if (m_d->reusableDataStore) {
+        visitor.setReusableLayerData(m_d->reusableDataStore, m_d->reusableLayerDataEntries);
+    }
+
     image->rootLayer()->accept(visitor);
 
+    m_d->savedLayerDataEntries = visitor.savedLayerDataEntries();
     m_d->errorMessages.append(visitor.errorMessages());
     if (!m_d->errorMessages.isEmpty()) {
         return false;
@@ -348,6 +356,17 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     return true;
 }
 
+void KisKraSaver::setReusableLayerData(KoStore *store, const QHash<QUuid, QString> &entries)
+{
+    m_d->reusableDataStore = store;
+    m_d->reusableLayerDataEntries = entries;
+}
+
+QHash<QUuid, QString> KisKraSaver::savedLayerDataEntries() const
+{
+    return m_d->savedLayerDataEntries;
+}
+
 QStringList KisKraSaver::errorMessages() const
 {
     return m_d->errorMessages;
@@ -19,6 +19,9 @@
 #ifndef KIS_KRA_SAVER
 #define KIS_KRA_SAVER
 
+#include <QHash>
+#include <QUuid>
+
 #include <kis_types.h>
 
 class KisDocument;
@@ -46,6 +49,20 @@ public:
 
     bool savePalettes(KoStore *store, KisImageSP image, const QString &uri);
 
+    /**
+     * Lets saveBinaryData() copy the pixel data of the unchanged layers
+     * from the \p store of the previously saved file.
+     *
+     * \see KisKraSaveVisitor::setReusableLayerData()
+     */
+    void setReusableLayerData(KoStore *store, const QHash<QUuid, QString> &entries);
+
+    /**
+     * @return the locations where saveBinaryData() has saved the pixel
+     *         data of the paint layers to, mapped by the layers' uuids
+     */
+    QHash<QUuid, QString> savedLayerDataEntries() const;
+
     /// @return a list with everything that went wrong while saving
     QStringList errorMessages() const;
 
@@ -49,6 +49,7 @@
 #include "kis_image_animation_interface.h"
 #include "kis_layer_properties_icons.h"
 #include <KisGlobalResourcesInterface.h>
+#include <kis_config.h>
 
 #include "kis_transform_mask_params_interface.h"
 
@@ -266,6 +267,120 @@ void KisKraSaverTest::testRoundTripLayerStyles()
     QVERIFY(chk.testPassed());
 }
 
+void KisKraSaverTest::testRoundTripManyLayers()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    QRect imageRect(0,0,512,512);
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(new KisSurrogateUndoStore(), imageRect.width(), imageRect.height(), cs, "test image");
+
+    // more layers than threads, so that the devices are decoded concurrently
+    const int numLayers = 32;
+    QVector<KisPaintLayerSP> layers;
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("paint%1").arg(i), OPACITY_OPAQUE_U8);
+        image->addNode(layer);
+
+        layer->paintDevice()->fill(QRect(i * 10, i * 15, 100 + i * 5, 70), KoColor(QColor(i * 8, 255 - i * 8, 128), cs));
+        layer->paintDevice()->setDefaultPixel(KoColor(QColor(0, 0, i * 8, i), cs));
+        layers << layer;
+    }
+
+    KisTransparencyMaskSP mask = new KisTransparencyMask();
+    mask->initSelection(layers.last());
+    mask->selection()->pixelSelection()->select(QRect(50, 50, 200, 200));
+    image->addNode(mask, layers.last());
+
+    doc->setCurrentImage(image);
+    doc->exportDocumentSync(QUrl::fromLocalFile("roundtrip_many_layers.kra"), doc->mimeType());
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat("roundtrip_many_layers.kra"));
+    KisImageSP image2 = doc2->image();
+    image2->waitForDone();
+
+    QCOMPARE(image2->root()->childCount(), quint32(numLayers));
+
+    QPoint errorPoint;
+    KisNodeSP node = image2->root()->firstChild();
+
+    for (int i = 0; i < numLayers; i++) {
+        QVERIFY(node);
+        QCOMPARE(node->name(), layers[i]->name());
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, layers[i]->paintDevice(), node->paintDevice()));
+        QCOMPARE(node->paintDevice()->defaultPixel(), layers[i]->paintDevice()->defaultPixel());
+
+        if (i == numLayers - 1) {
+            KisTransparencyMask *mask2 = dynamic_cast<KisTransparencyMask*>(node->firstChild().data());
+            QVERIFY(mask2);
+            QVERIFY(TestUtil::comparePaintDevices(errorPoint,
+                                                  mask->selection()->pixelSelection(),
+                                                  mask2->selection()->pixelSelection()));
+        }
+
+        node = node->nextSibling();
+    }
+}
+
+void KisKraSaverTest::testReuseUnchangedLayerData()
+{
+    KisConfig cfg(false);
+    const bool oldReuseUnchangedLayerData = cfg.reuseUnchangedLayerData();
+    cfg.setReuseUnchangedLayerData(true);
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    QRect imageRect(0,0,256,256);
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(new KisSurrogateUndoStore(), imageRect.width(), imageRect.height(), cs, "test image");
+
+    KisPaintLayerSP layer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8);
+    layer1->paintDevice()->fill(QRect(10, 10, 100, 100), KoColor(Qt::red, cs));
+    image->addNode(layer1);
+
+    KisPaintLayerSP layer2 = new KisPaintLayer(image, "paint2", OPACITY_OPAQUE_U8);
+    layer2->paintDevice()->fill(QRect(50, 50, 100, 100), KoColor(Qt::green, cs));
+    image->addNode(layer2);
+
+    doc->setCurrentImage(image);
+
+    const QString fileName = "roundtrip_reuse_layer_data.kra";
+    QVERIFY(doc->saveAs(QUrl::fromLocalFile(fileName), KraMimetype.toLatin1(), false));
+    doc->waitForSavingToComplete();
+
+    /**
+     * Write into the device without requesting an update of the layer,
+     * the way Node::setPixelData() of the scripting API does it, and
+     * then refresh the whole graph like Document::refreshProjection()
+     */
+    const QRect writeRect(100, 100, 64, 64);
+    QVector<quint8> bytes(writeRect.width() * writeRect.height() * cs->pixelSize(), 0x7f);
+    layer1->paintDevice()->writeBytes(bytes.data(), writeRect);
+    image->refreshGraph();
+    image->waitForDone();
+
+    // the first save writes the new data, the second one may reuse it
+    for (int i = 0; i < 2; i++) {
+        QVERIFY(doc->saveAs(QUrl::fromLocalFile(fileName), KraMimetype.toLatin1(), false));
+        doc->waitForSavingToComplete();
+
+        QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+        QVERIFY(doc2->loadNativeFormat(fileName));
+        KisImageSP image2 = doc2->image();
+        image2->waitForDone();
+
+        QCOMPARE(image2->root()->childCount(), quint32(2));
+
+        QPoint errorPoint;
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, layer1->paintDevice(), image2->root()->firstChild()->paintDevice()));
+        QVERIFY(TestUtil::comparePaintDevices(errorPoint, layer2->paintDevice(), image2->root()->lastChild()->paintDevice()));
+    }
+
+    cfg.setReuseUnchangedLayerData(oldReuseUnchangedLayerData);
+}
+
 void KisKraSaverTest::testRoundTripAnimation()
 {
     QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
@@ -39,6 +39,9 @@ private Q_SLOTS:
 
     void testRoundTripLayerStyles();
 
+    void testRoundTripManyLayers();
+    void testReuseUnchangedLayerData();
+
     void testRoundTripAnimation();
 
     void testRoundTripColorizeMask();